@@ -29,7 +29,11 @@ bool BlendApp::Initialize()
 
 	ThrowIfFailed(mCommandList->Reset(mMainCmdAllocator.Get(), nullptr));
 
+	// Cooked by Tools/AssetCooker.  Without it every texture is read from its loose file.
+	// The upload heaps hold their own copies, so the pack is not needed after loading.
+	mAssets.Open(L"../../Assets.lpak");
 	LoadTextures();
+	mAssets.Close();
 	BuildRootSignature();
 	BuildLandGeometry();
 	BuildCylinderGeometry();
@@ -109,9 +113,8 @@ void BlendApp::Draw(const GameTimer& gt)
 	DrawRenderItems(mRitemLayer[(UINT)RenderLayer::Opaque]);
 
 	mCommandList->SetPipelineState(mPSOs["alphaTested"].Get());
-	const auto& items = mRitemLayer[(UINT)RenderLayer::AlphaTested];
-	vector<RenderItem*> drawAnimate;
-	drawAnimate.push_back(items[AnimateIdx]);
+	// The bolt's material picks the animation frame.
+	const auto& drawAnimate = mRitemLayer[(UINT)RenderLayer::AlphaTested];
 	DrawRenderItems(drawAnimate);
 
 	mCommandList->SetPipelineState(mPSOs["transparent"].Get());
@@ -305,6 +308,7 @@ void BlendApp::UpdateMaterialCB(const GameTimer& gt)
 			m.Roughness = mat->Roughness;
 			XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
 			XMStoreFloat4x4(&m.MatTransform, XMMatrixTranspose(matTransform));
+			m.DiffuseSlice = mat->DiffuseSlice;
 
 			materialCB->CopyData(mat->MatCBIndex, m);
 			mat->NumFramesDirty--;
@@ -323,42 +327,73 @@ void BlendApp::UpdateAnimate(const GameTimer& gt)
 
 	if (gt.TotalTime() - animateGone >= 1.0 / 60)
 	{
-		AnimateIdx = (AnimateIdx + 1) % 60;
+		AnimateIdx = (AnimateIdx + 1) % mBoltFrames;
 		animateGone = gt.TotalTime();
+
+		auto boltMat = mMaterials["bolt"].get();
+		boltMat->DiffuseSlice = AnimateIdx;
+		boltMat->NumFramesDirty = gFrameResourcesCount;
 	}
 }
 
 void BlendApp::LoadTextures()
 {
-	auto grassTex = std::make_unique<Texture>();
-	grassTex->Name = "grassTex";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/grass.dds",
-		grassTex->Resource, grassTex->UploadHeap));
-
-	auto waterTex = std::make_unique<Texture>();
-	waterTex->Name = "waterTex";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/water1.dds",
-		waterTex->Resource, waterTex->UploadHeap));
-
-	for (int i = 1; i <= 60; i++)
+	// The bolt's frames are one texture array: cooked by Tools/AssetCooker --flipbook, or
+	// joined here from the loose frames.  Each texture is parsed and copied to its upload
+	// heap on worker threads; only the copy commands are recorded here.  Pack entries are
+	// read in place, or expanded into 'storage' if compressed.
+	TextureBatch batch;
+	std::deque<std::vector<std::uint8_t>> storage;
+	auto add = [&](const std::wstring& path)
 	{
-		auto boltTex = std::make_unique<Texture>();
-		boltTex->Name = "bolt" + ToStringAlign(i, 3) + "Tex";
-		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-			mCommandList.Get(), wstring(wstring(L"../../Textures/BoltAnim/Bolt") + ToWStringAlign(i, 3) + L".dds").c_str(),
-			boltTex->Resource, boltTex->UploadHeap));
-		mTextures[boltTex->Name] = std::move(boltTex);
+		const AssetPack::Entry* packed = mAssets.IsOpen() ? mAssets.Find(std::string(path.begin(), path.end())) : nullptr;
+		storage.emplace_back();
+		const void* bytes = packed != nullptr ? mAssets.Bytes(*packed, storage.back()) : nullptr;
+		return bytes != nullptr ? batch.Add(bytes, (size_t)packed->RawSize, path) : batch.Add(path);
+	};
+
+	const size_t grass = add(L"../../Textures/grass.dds");
+	const size_t water = add(L"../../Textures/water1.dds");
+
+	std::string error;
+	size_t bolt;
+	const std::wstring boltPath = L"../../Textures/BoltAnim/Bolt.dds";
+	if (mAssets.IsOpen() && mAssets.Find(std::string(boltPath.begin(), boltPath.end())) != nullptr)
+	{
+		bolt = add(boltPath);
+	}
+	else
+	{
+		storage.emplace_back();
+		if (!Flipbook::Build(Flipbook::FramePaths(L"../../Textures/BoltAnim/Bolt%03d.dds"), storage.back(), &error))
+		{
+			OutputDebugStringA(("BoltAnim: " + error + "\n").c_str());
+			ThrowIfFailed(E_FAIL);
+		}
+		bolt = batch.Add(storage.back().data(), storage.back().size(), boltPath);
+	}
+
+	if (!batch.Load(mD3DDevice.Get(), mCommandList.Get(), &error))
+	{
+		OutputDebugStringA((error + "\n").c_str());
+		ThrowIfFailed(E_FAIL);
 	}
 
-	mTextures[grassTex->Name] = std::move(grassTex);
-	mTextures[waterTex->Name] = std::move(waterTex);
+	const std::pair<const char*, size_t> textures[] = { { "grassTex", grass }, { "waterTex", water }, { "boltTex", bolt } };
+	for (const auto& texture : textures)
+	{
+		auto tex = std::make_unique<Texture>();
+		tex->Name = texture.first;
+		tex->Resource = batch.Get(texture.second).GetTexture();
+		tex->UploadHeap = batch.Get(texture.second).GetUploadHeap();
+		mTextures[tex->Name] = std::move(tex);
+	}
+	mBoltFrames = batch.Get(bolt).GetInfo().ArraySize;
 }
 
 void BlendApp::BuildDescriptorHeaps()
 {
-	UINT numDescriptors = 62;
+	UINT numDescriptors = 3;
 
 	D3D12_DESCRIPTOR_HEAP_DESC desc;
 	desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
@@ -371,32 +406,25 @@ void BlendApp::BuildDescriptorHeaps()
 	// fill the heap with actual descriptors
 	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvHeap->GetCPUDescriptorHandleForHeapStart());
 
-	auto grassTex = mTextures["grassTex"]->Resource;
-	auto waterTex = mTextures["waterTex"]->Resource;
-
+	// Every view is an array, so the shader samples all of them as one; grass and water
+	// are arrays of one slice.
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.Format = grassTex->GetDesc().Format;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.MipLevels = -1;
-	mD3DDevice->CreateShaderResourceView(grassTex.Get(), &srvDesc, hDescriptor);
-
-	// next descriptor
-	hDescriptor.Offset(1, mCbvUavDescriptorSize);
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+	srvDesc.Texture2DArray.MostDetailedMip = 0;
+	srvDesc.Texture2DArray.MipLevels = -1;
+	srvDesc.Texture2DArray.FirstArraySlice = 0;
 
-	srvDesc.Format = waterTex->GetDesc().Format;
-	mD3DDevice->CreateShaderResourceView(waterTex.Get(), &srvDesc, hDescriptor);
-
-	for (int i = 1; i <= 60; i++)
+	const char* names[] = { "grassTex", "waterTex", "boltTex" };
+	for (const char* name : names)
 	{
+		auto tex = mTextures[name]->Resource;
+		srvDesc.Format = tex->GetDesc().Format;
+		srvDesc.Texture2DArray.ArraySize = tex->GetDesc().DepthOrArraySize;
+		mD3DDevice->CreateShaderResourceView(tex.Get(), &srvDesc, hDescriptor);
+
 		// next descriptor
 		hDescriptor.Offset(1, mCbvUavDescriptorSize);
-
-		const string& name = string("bolt") + ToStringAlign(i, 3) + "Tex";
-		auto boltTex = mTextures[name]->Resource;
-		srvDesc.Format = boltTex->GetDesc().Format;
-		mD3DDevice->CreateShaderResourceView(boltTex.Get(), &srvDesc, hDescriptor);
 	}
 }
 
@@ -404,7 +432,7 @@ void BlendApp::BuildRootSignature()
 {
 	CD3DX12_ROOT_PARAMETER slotParameters[4];
 	CD3DX12_DESCRIPTOR_RANGE table1;
-	table1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 62, 0);
+	table1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
 	slotParameters[0].InitAsConstantBufferView(0);
 	slotParameters[1].InitAsConstantBufferView(2);
 	slotParameters[2].InitAsConstantBufferView(1);
@@ -459,21 +487,17 @@ void BlendApp::BuildRenderItems()
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(gridRitem.get());
 
-	for (int i = 1; i <= 60; i++)
-	{
-		string name = string("cylinder") + ToStringAlign(i, 3) + "Geo";
-		auto cylinderRitem = std::make_unique<RenderItem>();
-		XMStoreFloat4x4(&cylinderRitem->World, XMMatrixTranslation(3.0f, 5.0f, -9.0f));
-		cylinderRitem->ObjCBIndex = 1 + i;
-		cylinderRitem->Mat = mMaterials[string("bolt") + ToStringAlign(i, 3)].get();
-		cylinderRitem->Geo = mGeometries[name].get();
-		cylinderRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		cylinderRitem->IndexCount = cylinderRitem->Geo->DrawArgs["cylinder"].IndexCount;
-		cylinderRitem->StartIndexLocation = cylinderRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
-		cylinderRitem->BaseVertexLocation = cylinderRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
-		mRitemLayer[(int)RenderLayer::AlphaTested].push_back(cylinderRitem.get());
-		mAllRitems.push_back(std::move(cylinderRitem));
-	}
+	auto cylinderRitem = std::make_unique<RenderItem>();
+	XMStoreFloat4x4(&cylinderRitem->World, XMMatrixTranslation(3.0f, 5.0f, -9.0f));
+	cylinderRitem->ObjCBIndex = 2;
+	cylinderRitem->Mat = mMaterials["bolt"].get();
+	cylinderRitem->Geo = mGeometries["cylinderGeo"].get();
+	cylinderRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cylinderRitem->IndexCount = cylinderRitem->Geo->DrawArgs["cylinder"].IndexCount;
+	cylinderRitem->StartIndexLocation = cylinderRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
+	cylinderRitem->BaseVertexLocation = cylinderRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+	mRitemLayer[(int)RenderLayer::AlphaTested].push_back(cylinderRitem.get());
+	mAllRitems.push_back(std::move(cylinderRitem));
 
 	mAllRitems.push_back(std::move(wavesRitem));
 	mAllRitems.push_back(std::move(gridRitem));
@@ -550,7 +574,10 @@ void BlendApp::BuildLandGeometry()
 	submesh.IndexCount = (UINT)indices.size();
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
+	MeshBounds::Compute(vertices.data(), vertices.size(), sizeof(Vertex), submesh.Bounds, submesh.Sphere);
 
+	geo->Bounds = submesh.Bounds;
+	geo->Sphere = submesh.Sphere;
 	geo->DrawArgs["grid"] = submesh;
 
 	mGeometries["landGeo"] = std::move(geo);
@@ -558,53 +585,49 @@ void BlendApp::BuildLandGeometry()
 
 void BlendApp::BuildCylinderGeometry()
 {
-	for (int i = 1; i <= 60; i++)
-	{
-		GeometryGenerator geoGen;
-		GeometryGenerator::MeshData cylinder = geoGen.CreateCylinder(10.0f, 10.0f, 15.0f, 30, 2, false, false);
+	GeometryGenerator geoGen;
+	GeometryGenerator::MeshData cylinder = geoGen.CreateCylinder(10.0f, 10.0f, 15.0f, 30, 2, false, false);
 
-		std::vector<Vertex> vertices(cylinder.Vertices.size());
-		for (size_t i = 0; i < cylinder.Vertices.size(); ++i)
-		{
-			vertices[i].Pos = cylinder.Vertices[i].Position;
-			vertices[i].Normal = cylinder.Vertices[i].Normal;
-			vertices[i].TexC = cylinder.Vertices[i].TexC;
-		}
+	std::vector<Vertex> vertices(cylinder.Vertices.size());
+	for (size_t i = 0; i < cylinder.Vertices.size(); ++i)
+	{
+		vertices[i].Pos = cylinder.Vertices[i].Position;
+		vertices[i].Normal = cylinder.Vertices[i].Normal;
+		vertices[i].TexC = cylinder.Vertices[i].TexC;
+	}
 
-		const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
+	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 
-		std::vector<std::uint16_t> indices = cylinder.GetIndices16();
-		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+	std::vector<std::uint16_t> indices = cylinder.GetIndices16();
+	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
-		string name = string("cylinder") + ToStringAlign(i, 3) + "Geo";
-		auto geo = std::make_unique<MeshGeometry>();
-		geo->Name = name;
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = "cylinderGeo";
 
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-		geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(),
-			mCommandList.Get(), geo->VertexBufferCPU.Get(), geo->VertexUploadBuffer);
+	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(),
+		mCommandList.Get(), geo->VertexBufferCPU.Get(), geo->VertexUploadBuffer);
 
-		geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(),
-			mCommandList.Get(), geo->IndexBufferCPU.Get(), geo->IndexUploadBuffer);
+	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(),
+		mCommandList.Get(), geo->IndexBufferCPU.Get(), geo->IndexUploadBuffer);
 
-		geo->VertexStride = sizeof(Vertex);
-		geo->VertexBufferSize = vbByteSize;
-		geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-		geo->IndexBufferSize = ibByteSize;
+	geo->VertexStride = sizeof(Vertex);
+	geo->VertexBufferSize = vbByteSize;
+	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
+	geo->IndexBufferSize = ibByteSize;
 
-		SubmeshGeometry submesh;
-		submesh.IndexCount = (UINT)indices.size();
-		submesh.StartIndexLocation = 0;
-		submesh.BaseVertexLocation = 0;
+	SubmeshGeometry submesh;
+	submesh.IndexCount = (UINT)indices.size();
+	submesh.StartIndexLocation = 0;
+	submesh.BaseVertexLocation = 0;
 
-		geo->DrawArgs["cylinder"] = submesh;
-		mGeometries[name] = std::move(geo);
-	}
+	geo->DrawArgs["cylinder"] = submesh;
+	mGeometries[geo->Name] = std::move(geo);
 }
 
 void BlendApp::BuildWavesGeometry()
@@ -853,20 +876,17 @@ void BlendApp::BuildMaterials()
 	water->FresnelR0 = XMFLOAT3(0.1f, 0.1f, 0.1f);
 	water->Roughness = 0.0f;
 
-	for (int i = 0; i < 60; i++)
-	{
-		auto bolt = std::make_unique<Material>();
-		bolt->Name = string("bolt") + ToStringAlign(i+1, 3);
-		bolt->MatCBIndex = 2 + i;
-		bolt->DiffuseSrvHeapIndex = 2 + i;
-		bolt->DiffuseAlbedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.8f);
-		bolt->FresnelR0 = XMFLOAT3(0.1f, 0.1f, 0.1f);
-		bolt->Roughness = 0.25f;
-		mMaterials[bolt->Name] = std::move(bolt);
-	}
+	auto bolt = std::make_unique<Material>();
+	bolt->Name = "bolt";
+	bolt->MatCBIndex = 2;
+	bolt->DiffuseSrvHeapIndex = 2;
+	bolt->DiffuseAlbedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.8f);
+	bolt->FresnelR0 = XMFLOAT3(0.1f, 0.1f, 0.1f);
+	bolt->Roughness = 0.25f;
 
 	mMaterials["grass"] = std::move(grass);
 	mMaterials["water"] = std::move(water);
+	mMaterials["bolt"] = std::move(bolt);
 }
 
 float BlendApp::GetHillsHeight(float x, float z) const
@@ -926,4 +946,11 @@ void BlendApp::UpdateWaves(const GameTimer& gt)
 
 	// Set the dynamic VB of the wave renderitem to the current frame VB.
 	mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
+
+	// The surface moves every frame, so its bounds do too.
+	auto& wavesSubmesh = mWavesRitem->Geo->DrawArgs["grid"];
+	MeshBounds::Compute(&mWaves->Position(0), mWaves->VertexCount(), sizeof(XMFLOAT3),
+		wavesSubmesh.Bounds, wavesSubmesh.Sphere);
+	mWavesRitem->Geo->Bounds = wavesSubmesh.Bounds;
+	mWavesRitem->Geo->Sphere = wavesSubmesh.Sphere;
 }
@@ -2,12 +2,17 @@
 #include <memory>
 #include <vector>
 #include <array>
+#include <deque>
 #include <DirectXPackedVector.h>
 #include "../../Common/D3DApp.h"
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/MathHelper.h"
+#include "../../Common/MeshBounds.h"
 #include "../../Common/DDSTextureLoader.h"
+#include "../../Common/TextureBatch.h"
+#include "../../Common/AssetPack.h"
+#include "../../Common/Flipbook.h"
 #include "Waves.h"
 
 #define MaxLights 16
@@ -57,6 +62,8 @@ struct MaterialConstant {
 	DirectX::XMFLOAT3 FresnelR0 = { 0.0f, 0.0f, 0.0f };
 	FLOAT Roughness = 0.0f;
 	DirectX::XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
+	UINT DiffuseSlice = 0;
+	DirectX::XMFLOAT3 cbMaterialPad = { 0.0f, 0.0f, 0.0f };
 };
 
 struct Vertex
@@ -95,6 +102,8 @@ struct Material {
 	DirectX::XMFLOAT3 FresnelR0 = { 0.0f, 0.0f, 0.0f };
 	FLOAT Roughness = 0.0f;
 	DirectX::XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
+	// Slice of the diffuse texture array; the bolt's animation frame.
+	UINT DiffuseSlice = 0;
 };
 
 struct Texture {
@@ -196,6 +205,10 @@ private:
 
 	std::unique_ptr<Waves> mWaves;
 
-	int AnimateIdx = 0;
+	AssetPack mAssets;
+
+	// Slices of the bolt's texture array.
+	UINT mBoltFrames = 1;
+	UINT AnimateIdx = 0;
 	double animateGone = 0.0f;
 };
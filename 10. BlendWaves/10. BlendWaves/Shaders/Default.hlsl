@@ -50,9 +50,11 @@ cbuffer cbMaterial : register(b1)
     float3 gFresnelR0;
     float gRoughness;
     float4x4 gMatTransform;
+    uint gDiffuseSlice;
+    float3 cbMaterialPad;
 }
 
-Texture2D gDiffuseMap0 : register(t0);
+Texture2DArray gDiffuseMap0 : register(t0);
 
 SamplerState gsamPointWrap : register(s0);
 SamplerState gsamPointClamp : register(s1);
@@ -103,7 +105,7 @@ PixelOut PS(VertexOut pin) : SV_Target
 {
     pin.NormalW = normalize(pin.NormalW);
     
-    float4 mixTex = gDiffuseMap0.Sample(gsamAnisotropicWrap, pin.TexC);
+    float4 mixTex = gDiffuseMap0.Sample(gsamAnisotropicWrap, float3(pin.TexC, gDiffuseSlice));
     float4 diffuseAlbedo = gDiffuseAlbedo * mixTex;
     
 #ifdef ALPHA_TEST
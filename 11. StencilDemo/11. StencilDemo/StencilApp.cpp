@@ -18,6 +18,8 @@ FrameResource::~FrameResource()
 {
 }
 
+const UINT StencilApp::PlaceholderSrv;
+
 StencilApp::StencilApp(HINSTANCE hInstance): D3DApp(hInstance)
 {
 }
@@ -28,11 +30,21 @@ bool StencilApp::Initialize()
 
 	ThrowIfFailed(mCommandList->Reset(mMainCmdAllocator.Get(), nullptr));
 
+	// Cooked by Tools/AssetCooker.  Without it every asset is read from its loose file,
+	// and the skull is cooked into a content cache in the working directory.
+	mAssets.Open(L"../../Assets.lpak");
+	mCookCache.Open(L"ContentCache", 256ull << 20);
+
+	// The textures and the skull load on the loader's workers while the rest is built, and
+	// are uploaded from Draw() once they have.  Until then materials sample the white
+	// placeholder and the skull's render items draw a box around it.
 	LoadTextures();
+	RequestSkullGeometry();
+
 	BuildRootSignature();
 	BuildMaterials();
 	BuildRoomGeometry();
-	BuildSkullGeometry();
+	BuildSkullProxyGeometry();
 	BuildRenderItems();
 	BuildFrameResource();
 	BuildDescriptorHeaps();
@@ -61,6 +73,11 @@ void StencilApp::Update(const GameTimer& gt)
 		CloseHandle(eventHandle);
 	}
 
+	// Assets whose upload the GPU has finished replace their placeholders from this frame.
+	mLoader.Retire(mFence->GetCompletedValue());
+	if (mAssets.IsOpen() && mLoader.Idle())
+		mAssets.Close();
+
 	UpdateAnimate(gt);
 	OnKeyboardInput(gt);
 
@@ -76,6 +93,11 @@ void StencilApp::Draw(const GameTimer& gt)
 	ThrowIfFailed(cmdAlloc->Reset());
 	ThrowIfFailed(mCommandList->Reset(cmdAlloc.Get(), nullptr));
 
+	// Copies for assets that finished loading, completed by the fence this frame signals.
+	// A few per frame keeps a burst of finished loads from stalling one frame.
+	const size_t maxUploadsPerFrame = 4;
+	mLoader.Pump(mCurrentFence + 1, maxUploadsPerFrame);
+
 	mCommandList->RSSetViewports(1, &mViewport);
 	mCommandList->RSSetScissorRects(1, &mScissorRect);
 
@@ -107,6 +129,9 @@ void StencilApp::Draw(const GameTimer& gt)
 	mCommandList->SetPipelineState(mPSOs["opaque"].Get());
 	DrawRenderItems(mRitemLayer[(UINT)RenderLayer::Opaque]);
 
+	mCommandList->SetPipelineState(mPSOs["highlight"].Get());
+	DrawRenderItems(mRitemLayer[(UINT)RenderLayer::Highlight]);
+
 	mCommandList->OMSetStencilRef(1);
 	mCommandList->SetPipelineState(mPSOs["markStencilMirrors"].Get());
 	DrawRenderItems(mRitemLayer[(UINT)RenderLayer::Mirrors]);
@@ -153,9 +178,37 @@ void StencilApp::OnMouseDown(WPARAM btnState, int x, int y)
 	mLastMousePos.x = x;
 	mLastMousePos.y = y;
 
+	if ((btnState & MK_MBUTTON) != 0)
+		Pick(x, y);
+
 	SetCapture(mHandle);
 }
 
+void StencilApp::Pick(int x, int y)
+{
+	if (!mLoader.IsReady(mSkullRequest))
+		return;
+
+	// Ray through the pixel in view space.
+	float vx = (2.0f * x / mClientWidth - 1.0f) / mProj(0, 0);
+	float vy = (-2.0f * y / mClientHeight + 1.0f) / mProj(1, 1);
+
+	// Into the skull's object space, where the BVH was built.
+	XMMATRIX view = XMLoadFloat4x4(&mView);
+	XMMATRIX world = XMLoadFloat4x4(&mSkullRitem->World);
+	XMMATRIX toLocal = XMMatrixInverse(nullptr, world * view);
+
+	MeshBVH::Ray ray;
+	XMStoreFloat3(&ray.Origin, XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), toLocal));
+	XMStoreFloat3(&ray.Direction, XMVector3TransformNormal(XMVectorSet(vx, vy, 1.0f, 0.0f), toLocal));
+
+	MeshBVH::Hit hit = mSkullBVH.Pick(ray);
+
+	const SubmeshGeometry& skull = mPickedRitem->Geo->DrawArgs["skull"];
+	mPickedRitem->IndexCount = hit.Valid() ? 3 : 0;
+	mPickedRitem->StartIndexLocation = skull.StartIndexLocation + (hit.Valid() ? 3 * hit.Triangle : 0);
+}
+
 void StencilApp::OnMouseUp(WPARAM btnState, int x, int y)
 {
 	ReleaseCapture();
@@ -297,34 +350,96 @@ void StencilApp::UpdateAnimate(const GameTimer& gt)
 
 void StencilApp::LoadTextures()
 {
-	auto bricksTex = std::make_unique<Texture>();
-	bricksTex->Name = "bricksTex";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/bricks3.dds",
-		bricksTex->Resource, bricksTex->UploadHeap));
+	RequestTexture("bricksTex", L"../../Textures/bricks3.dds", 0);
+	RequestTexture("checkboardTex", L"../../Textures/checkboard.dds", 1);
+	RequestTexture("iceTex", L"../../Textures/ice.dds", 2);
 
-	auto checkboardTex = std::make_unique<Texture>();
-	checkboardTex->Name = "checkboardTex";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/checkboard.dds",
-		checkboardTex->Resource, checkboardTex->UploadHeap));
+	// The placeholder, so it is needed before the first frame.
+	LoadTexture("white1x1Tex", L"../../Textures/white1x1.dds");
+}
 
-	auto iceTex = std::make_unique<Texture>();
-	iceTex->Name = "iceTex";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/ice.dds",
-		iceTex->Resource, iceTex->UploadHeap));
+void StencilApp::LoadTexture(const std::string& name, const std::wstring& path)
+{
+	auto tex = std::make_unique<Texture>();
+	tex->Name = name;
+
+	// Entries are named by their relative path, so the same string finds either.  A
+	// compressed entry is expanded into 'storage' first.
+	const AssetPack::Entry* packed = mAssets.IsOpen() ? mAssets.Find(std::string(path.begin(), path.end())) : nullptr;
+	std::vector<std::uint8_t> storage;
+	const void* bytes = packed != nullptr ? mAssets.Bytes(*packed, storage) : nullptr;
+	if (bytes != nullptr)
+	{
+		ThrowIfFailed(DirectX::CreateDDSTextureFromMemory12(mD3DDevice.Get(), mCommandList.Get(),
+			static_cast<const uint8_t*>(bytes), (size_t)packed->RawSize,
+			tex->Resource, tex->UploadHeap));
+	}
+	else
+	{
+		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
+			mCommandList.Get(), path.c_str(),
+			tex->Resource, tex->UploadHeap));
+	}
+
+	mTextures[tex->Name] = std::move(tex);
+}
+
+void StencilApp::RequestTexture(const std::string& name, const std::wstring& path, UINT srvIndex)
+{
+	// The worker parses the DDS, creates the texture and its upload heap, and copies the
+	// pixel rows into the heap straight from the mapped file or the pack entry; only the
+	// copy commands are recorded on the render thread.
+	auto upload = std::make_shared<DDSUpload>();
+
+	AssetLoader::Job job;
+	job.Name = name;
+	job.Load = [this, path, upload](std::string& error)
+	{
+		const AssetPack::Entry* packed = mAssets.IsOpen() ? mAssets.Find(std::string(path.begin(), path.end())) : nullptr;
+		std::vector<std::uint8_t> storage;
+		const void* bytes = packed != nullptr ? mAssets.Bytes(*packed, storage) : nullptr;
+		if (bytes != nullptr)
+			return upload->Prepare(mD3DDevice.Get(), bytes, (size_t)packed->RawSize, 0, &error);
+		return upload->Prepare(mD3DDevice.Get(), path, 0, &error);
+	};
+	job.Upload = [this, name, srvIndex, upload]()
+	{
+		auto tex = std::make_unique<Texture>();
+		tex->Name = name;
+		upload->Record(mCommandList.Get());
+		tex->Resource = upload->GetTexture();
+		tex->UploadHeap = upload->GetUploadHeap();
+
+		// Nothing draws with the slot until Ready, so it can be written while earlier frames
+		// are still in flight.
+		CreateTextureSrv(tex->Resource.Get(), srvIndex);
+		mTextures[name] = std::move(tex);
+	};
+	job.Ready = [this, name, srvIndex]()
+	{
+		mTextures[name]->UploadHeap = nullptr;
+		mSrvReady[srvIndex] = true;
+	};
+	job.Failed = [path](const std::string& error)
+	{
+		std::wstring message = path + L": " + std::wstring(error.begin(), error.end()) + L"\n";
+		OutputDebugString(message.c_str());
+	};
+	mLoader.Request(std::move(job));
+}
 
-	auto white1x1Tex = std::make_unique<Texture>();
-	white1x1Tex->Name = "white1x1Tex";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/white1x1.dds",
-		white1x1Tex->Resource, white1x1Tex->UploadHeap));
+void StencilApp::CreateTextureSrv(ID3D12Resource* texture, UINT srvIndex)
+{
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = texture->GetDesc().Format;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MipLevels = -1;
 
-	mTextures[bricksTex->Name] = std::move(bricksTex);
-	mTextures[checkboardTex->Name] = std::move(checkboardTex);
-	mTextures[iceTex->Name] = std::move(iceTex);
-	mTextures[white1x1Tex->Name] = std::move(white1x1Tex);
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvHeap->GetCPUDescriptorHandleForHeapStart());
+	hDescriptor.Offset(srvIndex, mCbvUavDescriptorSize);
+	mD3DDevice->CreateShaderResourceView(texture, &srvDesc, hDescriptor);
 }
 
 void StencilApp::BuildDescriptorHeaps()
@@ -339,36 +454,11 @@ void StencilApp::BuildDescriptorHeaps()
 
 	ThrowIfFailed(mD3DDevice->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&mSrvHeap)));
 
-	// fill the heap with actual descriptors
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvHeap->GetCPUDescriptorHandleForHeapStart());
-
-	auto bricksTex = mTextures["bricksTex"]->Resource;
-	auto checkboardTex = mTextures["checkboardTex"]->Resource;
-	auto iceTex = mTextures["iceTex"]->Resource;
-	auto white1x1Tex = mTextures["white1x1Tex"]->Resource;
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.Format = bricksTex->GetDesc().Format;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.MipLevels = -1;
-	mD3DDevice->CreateShaderResourceView(bricksTex.Get(), &srvDesc, hDescriptor);
-
-	// next descriptor
-	hDescriptor.Offset(1, mCbvUavDescriptorSize);
-	srvDesc.Format = checkboardTex->GetDesc().Format;
-	mD3DDevice->CreateShaderResourceView(checkboardTex.Get(), &srvDesc, hDescriptor);
-
-	// next descriptor
-	hDescriptor.Offset(1, mCbvUavDescriptorSize);
-	srvDesc.Format = iceTex->GetDesc().Format;
-	mD3DDevice->CreateShaderResourceView(iceTex.Get(), &srvDesc, hDescriptor);
-
-	// next descriptor
-	hDescriptor.Offset(1, mCbvUavDescriptorSize);
-	srvDesc.Format = white1x1Tex->GetDesc().Format;
-	mD3DDevice->CreateShaderResourceView(white1x1Tex.Get(), &srvDesc, hDescriptor);
+	// Slots 0-2 (bricks, checkboard, ice) are written as their textures arrive; until
+	// then DrawRenderItems() binds the placeholder instead.
+	mSrvReady.assign(numDescriptors, false);
+	CreateTextureSrv(mTextures["white1x1Tex"]->Resource.Get(), PlaceholderSrv);
+	mSrvReady[PlaceholderSrv] = true;
 }
 
 void StencilApp::BuildRootSignature()
@@ -483,29 +573,33 @@ void StencilApp::BuildRoomGeometry()
 	mirrorSubmesh.StartIndexLocation = 24;
 	mirrorSubmesh.BaseVertexLocation = 0;
 
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = "roomGeo";
 
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
 	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(),
-		mCommandList.Get(), geo->VertexBufferCPU.Get(), geo->VertexUploadBuffer);
+	// Positions go to their own stream so the mirror-marking and shadow passes fetch
+	// 12 bytes per vertex instead of 32.
+	d3dUtil::CreateSplitVertexBuffers(mD3DDevice.Get(), mCommandList.Get(), *geo,
+		vertices.data(), (UINT)vertices.size());
 
 	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(),
 		mCommandList.Get(), geo->IndexBufferCPU.Get(), geo->IndexUploadBuffer);
 
-	geo->VertexStride = sizeof(Vertex);
-	geo->VertexBufferSize = vbByteSize;
 	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
 	geo->IndexBufferSize = ibByteSize;
 
+	for (auto* submesh : { &floorSubmesh, &wallSubmesh, &mirrorSubmesh })
+	{
+		MeshBounds::ComputeIndexed(vertices.data(), sizeof(Vertex),
+			reinterpret_cast<const std::uint16_t*>(indices.data()) + submesh->StartIndexLocation,
+			submesh->IndexCount, submesh->BaseVertexLocation, submesh->Bounds, submesh->Sphere);
+	}
+	MeshBounds::Compute(vertices.data(), vertices.size(), sizeof(Vertex), geo->Bounds, geo->Sphere);
+
 	geo->DrawArgs["floor"] = floorSubmesh;
 	geo->DrawArgs["wall"] = wallSubmesh;
 	geo->DrawArgs["mirror"] = mirrorSubmesh;
@@ -553,7 +647,7 @@ void StencilApp::BuildRenderItems()
 	skullRitem->TexTransform = MathHelper::Identity4x4();
 	skullRitem->ObjCBIndex = 2;
 	skullRitem->Mat = mMaterials["skullMat"].get();
-	skullRitem->Geo = mGeometries["skullGeo"].get();
+	skullRitem->Geo = mGeometries["skullProxyGeo"].get();
 	skullRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	skullRitem->IndexCount = skullRitem->Geo->DrawArgs["skull"].IndexCount;
 	skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
@@ -576,6 +670,15 @@ void StencilApp::BuildRenderItems()
 	mShadowedSkullRitem = shadowedSkullRitem.get();
 	mRitemLayer[(int)RenderLayer::Shadow].push_back(shadowedSkullRitem.get());
 
+	// The triangle under the cursor after a middle click; nothing is drawn until then.
+	auto pickedRitem = std::make_unique<RenderItem>();
+	*pickedRitem = *skullRitem;
+	pickedRitem->ObjCBIndex = 7;
+	pickedRitem->Mat = mMaterials["highlightMat"].get();
+	pickedRitem->IndexCount = 0;
+	mPickedRitem = pickedRitem.get();
+	mRitemLayer[(int)RenderLayer::Highlight].push_back(pickedRitem.get());
+
 	auto mirrorRitem = std::make_unique<RenderItem>();
 	mirrorRitem->World = MathHelper::Identity4x4();
 	mirrorRitem->TexTransform = MathHelper::Identity4x4();
@@ -596,6 +699,7 @@ void StencilApp::BuildRenderItems()
 	mAllRitems.push_back(std::move(shadowedSkullRitem));
 	mAllRitems.push_back(std::move(mirrorRitem));
 	mAllRitems.push_back(std::move(reflectedFloorRitem));
+	mAllRitems.push_back(std::move(pickedRitem));
 }
 
 void StencilApp::BuildShadersAndInputLayout()
@@ -616,12 +720,20 @@ void StencilApp::BuildShadersAndInputLayout()
 	mShaders["standardVS"] = d3dUtil::CompileShader(L"../../Shaders/Default.hlsl", "VS", "vs_5_0");
 	mShaders["opaquePS"] = d3dUtil::CompileShader(L"../../Shaders/Default.hlsl", "PS", "ps_5_0", defines);
 	mShaders["alphaTestedPS"] = d3dUtil::CompileShader(L"../../Shaders/Default.hlsl", "PS", "ps_5_0", alphaTestDefines);
+	mShaders["positionOnlyVS"] = d3dUtil::CompileShader(L"../../Shaders/Default.hlsl", "PositionOnlyVS", "vs_5_0");
+	mShaders["flatPS"] = d3dUtil::CompileShader(L"../../Shaders/Default.hlsl", "FlatPS", "ps_5_0", defines);
 	
+	// Slot 0 is the packed position stream, slot 1 the remaining attributes.
 	mInputLayout =
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 1, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+	};
+
+	mPositionInputLayout =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
 	};
 }
 
@@ -691,6 +803,11 @@ void StencilApp::BuildPSO()
 
 	markMirrorsPsoDesc.BlendState = mirrorBlendState;
 	markMirrorsPsoDesc.DepthStencilState = mirrorDSS;
+
+	// Only stencil is written, so positions are all the pass reads and no pixel shader runs.
+	markMirrorsPsoDesc.InputLayout = { mPositionInputLayout.data(), (UINT)mPositionInputLayout.size() };
+	markMirrorsPsoDesc.VS = { mShaders["positionOnlyVS"]->GetBufferPointer(), mShaders["positionOnlyVS"]->GetBufferSize() };
+	markMirrorsPsoDesc.PS = { nullptr, 0 };
 	ThrowIfFailed(mD3DDevice->CreateGraphicsPipelineState(&markMirrorsPsoDesc, IID_PPV_ARGS(&mPSOs["markStencilMirrors"])));
 	
 	// PSO for stencil reflections
@@ -729,7 +846,20 @@ void StencilApp::BuildPSO()
 	shadowDSS.FrontFace.StencilFunc = D3D12_COMPARISON_FUNC_EQUAL;
 
 	shadowPsoDesc.DepthStencilState = shadowDSS;
+
+	// The shadow is a flat, fogged material color and needs no normals or texture coordinates.
+	shadowPsoDesc.InputLayout = { mPositionInputLayout.data(), (UINT)mPositionInputLayout.size() };
+	shadowPsoDesc.VS = { mShaders["positionOnlyVS"]->GetBufferPointer(), mShaders["positionOnlyVS"]->GetBufferSize() };
+	shadowPsoDesc.PS = { mShaders["flatPS"]->GetBufferPointer(), mShaders["flatPS"]->GetBufferSize() };
 	ThrowIfFailed(mD3DDevice->CreateGraphicsPipelineState(&shadowPsoDesc, IID_PPV_ARGS(&mPSOs["shadow"])));
+
+	// PSO for the picked triangle, drawn flat over the skull's own depth.
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC highlightPsoDesc = opaquePsoDesc;
+	highlightPsoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+	highlightPsoDesc.InputLayout = { mPositionInputLayout.data(), (UINT)mPositionInputLayout.size() };
+	highlightPsoDesc.VS = { mShaders["positionOnlyVS"]->GetBufferPointer(), mShaders["positionOnlyVS"]->GetBufferSize() };
+	highlightPsoDesc.PS = { mShaders["flatPS"]->GetBufferPointer(), mShaders["flatPS"]->GetBufferSize() };
+	ThrowIfFailed(mD3DDevice->CreateGraphicsPipelineState(&highlightPsoDesc, IID_PPV_ARGS(&mPSOs["highlight"])));
 }
 
 void StencilApp::BuildFrameResource()
@@ -746,9 +876,17 @@ void StencilApp::DrawRenderItems(const vector<RenderItem*>& ritems)
 	auto objCBSize = d3dUtil::CalcConstantBufferSize(sizeof ObjectConstant);
 
 	for (const auto& e : ritems) {
-		auto vbv = e->Geo->VertexBufferView();
 		auto ibv = e->Geo->IndexBufferView();
-		mCommandList->IASetVertexBuffers(0, 1, &vbv);
+		if (e->Geo->HasPositionStream())
+		{
+			D3D12_VERTEX_BUFFER_VIEW vbvs[] = { e->Geo->PositionBufferView(), e->Geo->VertexBufferView() };
+			mCommandList->IASetVertexBuffers(0, _countof(vbvs), vbvs);
+		}
+		else
+		{
+			auto vbv = e->Geo->VertexBufferView();
+			mCommandList->IASetVertexBuffers(0, 1, &vbv);
+		}
 		mCommandList->IASetIndexBuffer(&ibv);
 		mCommandList->IASetPrimitiveTopology(e->PrimitiveType);
 
@@ -763,8 +901,10 @@ void StencilApp::DrawRenderItems(const vector<RenderItem*>& ritems)
 		// SRV heap
 		ID3D12DescriptorHeap* heap[] = { mSrvHeap.Get() };
 		mCommandList->SetDescriptorHeaps(1, heap);
+		// Textures still loading are drawn with the placeholder.
+		UINT srvIndex = mSrvReady[e->Mat->DiffuseSrvHeapIndex] ? e->Mat->DiffuseSrvHeapIndex : PlaceholderSrv;
 		auto handle = CD3DX12_GPU_DESCRIPTOR_HANDLE(mSrvHeap->GetGPUDescriptorHandleForHeapStart());
-		handle.Offset(e->Mat->DiffuseSrvHeapIndex, mCbvUavDescriptorSize);
+		handle.Offset(srvIndex, mCbvUavDescriptorSize);
 		mCommandList->SetGraphicsRootDescriptorTable(3, handle);
 
 		mCommandList->DrawIndexedInstanced(e->IndexCount, 1, e->StartIndexLocation, e->BaseVertexLocation, 0);
@@ -867,86 +1007,258 @@ void StencilApp::BuildMaterials()
 	shadowMat->FresnelR0 = XMFLOAT3(0.001f, 0.001f, 0.001f);
 	shadowMat->Roughness = 0.0f;
 
+	auto highlightMat = std::make_unique<Material>();
+	highlightMat->Name = "highlightMat";
+	highlightMat->MatCBIndex = 5;
+	highlightMat->DiffuseSrvHeapIndex = 3;
+	highlightMat->DiffuseAlbedo = XMFLOAT4(1.0f, 0.2f, 0.1f, 1.0f);
+	highlightMat->FresnelR0 = XMFLOAT3(0.001f, 0.001f, 0.001f);
+	highlightMat->Roughness = 0.0f;
+
 	mMaterials["bricks"] = std::move(bricks);
 	mMaterials["checkertile"] = std::move(checkertile);
 	mMaterials["icemirror"] = std::move(icemirror);
 	mMaterials["skullMat"] = std::move(skullMat);
 	mMaterials["shadowMat"] = std::move(shadowMat);
+	mMaterials["highlightMat"] = std::move(highlightMat);
 }
 
-void StencilApp::BuildSkullGeometry()
+bool StencilApp::CookSkullMesh(std::vector<std::uint8_t>& bytes, std::string& error)
 {
-	std::ifstream fin("../../Models/skull.txt");
-
-	if (!fin)
+	ModelLoader::VertexLayout modelLayout;
+	modelLayout.Stride = sizeof(Vertex);
+	modelLayout.NormalOffset = offsetof(Vertex, Normal);
+
+	std::vector<Vertex> vertices;
+	std::vector<std::uint32_t> indices;
+	ModelLoader::Stats load;
+	if (!ModelLoader::Load(L"../../Models/skull.txt", vertices, indices, modelLayout, &load))
 	{
-		MessageBox(0, L"Models/skull.txt not found.", 0, 0);
-		return;
+		error = "Models/skull.txt: " + load.Error;
+		return false;
 	}
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
+	// Model does not have texture coordinates, so just zero them out.
+	for (auto& v : vertices)
+		v.TexC = { 0.0f, 0.0f };
+
+	MeshWelder::VertexLayout layout;
+	layout.Stride = sizeof(Vertex);
+	layout.NormalOffset = offsetof(Vertex, Normal);
+	layout.TexCOffset = offsetof(Vertex, TexC);
+	MeshWelder::Weld(vertices, indices, layout);
+
+	MeshFile::Source source;
+	source.Vertices = vertices.data();
+	source.VertexCount = vertices.size();
+	source.Layout.Stride = sizeof(Vertex);
+	source.Layout.NormalOffset = offsetof(Vertex, Normal);
+	source.Layout.TexCOffset = offsetof(Vertex, TexC);
+	source.Indices = indices.data();
+	source.IndexCount = indices.size();
+	source.Parts.push_back({ "skull", 0, (std::uint32_t)indices.size() });
+
+	if (!MeshFile::Write(source, MeshFile::Normal | MeshFile::TexC, bytes, &error))
+	{
+		error = "Models/skull.txt: " + error;
+		return false;
+	}
+	return true;
+}
 
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
+void StencilApp::RequestSkullGeometry()
+{
+	// The attribute stream of the file is the Vertex struct without its position.
+	static_assert(offsetof(Vertex, Normal) == sizeof(XMFLOAT3) &&
+		offsetof(Vertex, TexC) == 2 * sizeof(XMFLOAT3) &&
+		sizeof(Vertex) == 2 * sizeof(XMFLOAT3) + sizeof(XMFLOAT2), "Vertex no longer matches MeshFile's attribute order");
+
+	// Opened (or cooked) and its BVH built on a worker; the regions are copied to the GPU
+	// on the render thread straight from the file.
+	struct SkullData
+	{
+		MeshFile File;
+		std::vector<std::uint8_t> Storage;
+		MeshBVH BVH;
+	};
+	auto data = std::make_shared<SkullData>();
 
-	std::vector<Vertex> vertices(vcount);
-	for (UINT i = 0; i < vcount; ++i)
+	AssetLoader::Job job;
+	job.Name = "skull";
+	job.Load = [this, data](std::string& error)
 	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
+		MeshFile& file = data->File;
+		auto usable = [&file]()
+		{
+			return file.GetHeader().Attributes == (MeshFile::Normal | MeshFile::TexC) &&
+				file.FindSubmesh("skull") != nullptr;
+		};
+
+		// Taken from the asset pack when there is one.
+		const AssetPack::Entry* packed = mAssets.IsOpen() ? mAssets.Find("../../Models/skull.lmesh") : nullptr;
+		const void* bytes = packed != nullptr ? mAssets.Bytes(*packed, data->Storage) : nullptr;
+		if (bytes == nullptr || !file.Open(bytes, (size_t)packed->RawSize) || !usable())
+		{
+			// Otherwise cooked from skull.txt (welded), and kept in the content cache under the
+			// hash of skull.txt's bytes, so it is cooked again only when they change.
+			file.Close();
+			std::vector<std::uint8_t>& storage = data->Storage;
+			ContentCache::KeyBuilder builder;
+			builder.Add("StencilDemo skull").Add((std::uint64_t)MeshFile::FileVersion);
+			const std::string key = mCookCache.IsOpen() && builder.AddFile(L"../../Models/skull.txt") ?
+				builder.Key() : std::string();
+
+			const bool cached = !key.empty() && mCookCache.Load(key, storage) &&
+				file.Open(storage.data(), storage.size()) && usable();
+			if (!cached)
+			{
+				file.Close();
+				if (!CookSkullMesh(storage, error))
+					return false;
+				if (!file.Open(storage.data(), storage.size(), &error))
+				{
+					error = "Models/skull.txt: " + error;
+					return false;
+				}
+				if (!key.empty() && mCookCache.Store(key, storage.data(), storage.size()))
+					mCookCache.Trim();
+			}
+		}
 
-		// Model does not have texture coordinates, so just zero them out.
-		vertices[i].TexC = { 0.0f, 0.0f };
-	}
+		// Built over the skull's own index range in file order, so a hit's triangle is an
+		// offset into that range.
+		const MeshFile::Submesh& part = *file.FindSubmesh("skull");
+		std::vector<std::uint32_t> indices = file.WidenIndices();
+		const XMFLOAT3* positions = static_cast<const XMFLOAT3*>(file.Positions()) + part.BaseVertexLocation;
+		data->BVH.Build(positions, sizeof(XMFLOAT3), indices.data() + part.StartIndexLocation, part.IndexCount);
+		return true;
+	};
+	job.Upload = [this, data]()
+	{
+		const MeshFile& file = data->File;
+		const MeshFile::Header& header = file.GetHeader();
+		const MeshFile::Submesh& part = *file.FindSubmesh("skull");
+
+		auto geo = std::make_unique<MeshGeometry>();
+		geo->Name = "skullGeo";
+
+		// The regions go from the mapping straight into the upload heaps; nothing is staged
+		// in CPU blobs.
+		geo->PositionBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(), mCommandList.Get(),
+			file.Positions(), file.PositionBytes(), geo->PositionUploadBuffer);
+		geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(), mCommandList.Get(),
+			file.Attributes(), file.AttributeBytes(), geo->VertexUploadBuffer);
+		geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(), mCommandList.Get(),
+			file.Indices(), file.IndexBytes(), geo->IndexUploadBuffer);
+
+		geo->PositionStride = sizeof(XMFLOAT3);
+		geo->PositionBufferSize = (UINT)file.PositionBytes();
+		geo->VertexStride = header.AttributeStride;
+		geo->VertexBufferSize = (UINT)file.AttributeBytes();
+		geo->IndexFormat = (DXGI_FORMAT)header.IndexFormat;
+		geo->IndexBufferSize = (UINT)file.IndexBytes();
+
+		SubmeshGeometry submesh;
+		submesh.IndexCount = part.IndexCount;
+		submesh.StartIndexLocation = part.StartIndexLocation;
+		submesh.BaseVertexLocation = part.BaseVertexLocation;
+		submesh.Bounds = MeshFile::Bounds(part);
+		submesh.Sphere = MeshFile::Sphere(part);
+
+		geo->Bounds = file.Bounds();
+		geo->Sphere = file.Sphere();
+		geo->DrawArgs["skull"] = submesh;
+
+		mGeometries[geo->Name] = std::move(geo);
+	};
+	job.Ready = [this, data]()
+	{
+		MeshGeometry* geo = mGeometries["skullGeo"].get();
+		geo->PositionUploadBuffer = nullptr;
+		geo->VertexUploadBuffer = nullptr;
+		geo->IndexUploadBuffer = nullptr;
+
+		// The proxy stays alive; frames still in flight may be drawing it.
+		const SubmeshGeometry& skull = geo->DrawArgs["skull"];
+		for (RenderItem* ritem : { mSkullRitem, mReflectedSkullRitem, mShadowedSkullRitem, mPickedRitem })
+		{
+			ritem->Geo = geo;
+			ritem->IndexCount = ritem == mPickedRitem ? 0 : skull.IndexCount;
+			ritem->StartIndexLocation = skull.StartIndexLocation;
+			ritem->BaseVertexLocation = skull.BaseVertexLocation;
+		}
+		mSkullBVH = std::move(data->BVH);
+	};
+	job.Failed = [](const std::string& error)
+	{
+		std::wstring message(error.begin(), error.end());
+		MessageBox(0, message.c_str(), 0, 0);
+	};
+	mSkullRequest = mLoader.Request(std::move(job));
+}
 
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
+void StencilApp::BuildSkullProxyGeometry()
+{
+	// A box around the skull's bounds, drawn by its render items until it has loaded.  The
+	// bounds are read from the cooked skull's header when the pack stores it uncompressed;
+	// otherwise (no pack yet, or an LZ4 entry that would have to be decompressed here) they
+	// fall back to SkullTextBounds.  A stale fallback only misplaces the box.
+	//
+	// Models/skull.txt's bounds (center 0, 3.40, 0.655; extents 3.096, 3.46, 4.48), rounded
+	// outwards.  Update them if the model changes.
+	static const BoundingBox SkullTextBounds(XMFLOAT3(0.0f, 3.4f, 0.65f), XMFLOAT3(3.1f, 3.5f, 4.5f));
 
-	std::vector<std::int32_t> indices(3 * tcount);
-	for (UINT i = 0; i < tcount; ++i)
+	BoundingBox bounds = SkullTextBounds;
+	const AssetPack::Entry* packed = mAssets.IsOpen() ? mAssets.Find("../../Models/skull.lmesh") : nullptr;
+	if (packed != nullptr && !AssetPack::IsCompressed(*packed) && packed->RawSize >= sizeof(MeshFile::Header))
 	{
-		fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
+		MeshFile::Header header;
+		memcpy(&header, mAssets.Data(*packed), sizeof(header));
+		if (header.Magic == MeshFile::FileMagic)
+		{
+			bounds.Center = XMFLOAT3(header.BoundsCenter);
+			bounds.Extents = XMFLOAT3(header.BoundsExtents);
+		}
 	}
 
-	fin.close();
+	GeometryGenerator geoGen;
+	GeometryGenerator::MeshData box = geoGen.CreateBox(2.0f * bounds.Extents.x, 2.0f * bounds.Extents.y,
+		2.0f * bounds.Extents.z, 0);
 
-	//
-	// Pack the indices of all the meshes into one index buffer.
-	//
-
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
+	std::vector<Vertex> vertices(box.Vertices.size());
+	for (size_t i = 0; i < box.Vertices.size(); ++i)
+	{
+		const auto& v = box.Vertices[i];
+		vertices[i].Pos = XMFLOAT3(v.Position.x + bounds.Center.x, v.Position.y + bounds.Center.y,
+			v.Position.z + bounds.Center.z);
+		vertices[i].Normal = v.Normal;
+		vertices[i].TexC = v.TexC;
+	}
+	std::vector<std::uint16_t> indices = box.GetIndices16();
 
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::int32_t);
+	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
 	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "skullGeo";
-
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+	geo->Name = "skullProxyGeo";
 
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
 	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(),
-		mCommandList.Get(), geo->VertexBufferCPU.Get(), geo->VertexUploadBuffer);
-
+	d3dUtil::CreateSplitVertexBuffers(mD3DDevice.Get(), mCommandList.Get(), *geo,
+		vertices.data(), (UINT)vertices.size());
 	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(mD3DDevice.Get(),
 		mCommandList.Get(), geo->IndexBufferCPU.Get(), geo->IndexUploadBuffer);
 
-	geo->VertexStride = sizeof(Vertex);
-	geo->VertexBufferSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R32_UINT;
+	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
 	geo->IndexBufferSize = ibByteSize;
 
 	SubmeshGeometry submesh;
 	submesh.IndexCount = (UINT)indices.size();
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
-
+	MeshBounds::Compute(vertices.data(), vertices.size(), sizeof(Vertex), submesh.Bounds, submesh.Sphere);
+	geo->Bounds = submesh.Bounds;
+	geo->Sphere = submesh.Sphere;
 	geo->DrawArgs["skull"] = submesh;
 
 	mGeometries[geo->Name] = std::move(geo);
@@ -978,6 +1290,7 @@ void StencilApp::OnKeyboardInput(const GameTimer& gt)
 	XMMATRIX skullOffset = XMMatrixTranslation(skullTranslation.x, skullTranslation.y, skullTranslation.z);
 	XMMATRIX skullWorld = skullRotate * skullScale * skullOffset;
 	XMStoreFloat4x4(&mSkullRitem->World, skullWorld);
+	XMStoreFloat4x4(&mPickedRitem->World, skullWorld);
 
 	// Update reflection world matrix.
 	XMVECTOR mirrorPlane = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f); // xy plane
@@ -994,6 +1307,7 @@ void StencilApp::OnKeyboardInput(const GameTimer& gt)
 	mSkullRitem->NumFramesDirty = gFrameResourcesCount;
 	mReflectedSkullRitem->NumFramesDirty = gFrameResourcesCount;
 	mShadowedSkullRitem->NumFramesDirty = gFrameResourcesCount;
+	mPickedRitem->NumFramesDirty = gFrameResourcesCount;
 }
 
 void StencilApp::UpdateReflectedPassCB(const GameTimer& gt)
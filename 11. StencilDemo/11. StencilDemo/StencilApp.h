@@ -2,13 +2,23 @@
 #include <memory>
 #include <vector>
 #include <array>
+#include <cassert>
 #include <fstream>
 #include <DirectXPackedVector.h>
 #include "../../Common/D3DApp.h"
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/MathHelper.h"
+#include "../../Common/AssetLoader.h"
+#include "../../Common/AssetPack.h"
+#include "../../Common/ContentCache.h"
+#include "../../Common/MeshBounds.h"
+#include "../../Common/MeshBVH.h"
+#include "../../Common/MeshFile.h"
+#include "../../Common/MeshWelder.h"
+#include "../../Common/ModelLoader.h"
 #include "../../Common/DDSTextureLoader.h"
+#include "../../Common/DDSUpload.h"
 
 #define MaxLights 16
 
@@ -129,6 +139,7 @@ enum RenderLayer
 	Reflected,
 	Transparent,
 	Shadow,
+	Highlight,
 	Count
 };
 
@@ -146,6 +157,7 @@ private:
 	void OnMouseUp(WPARAM btnState, int x, int y);
 	void OnMouseMove(WPARAM btnState, int x, int y);
 	void OnKeyboardInput(const GameTimer& gt);
+	void Pick(int x, int y);
 	void UpdateCamera(const GameTimer& gt);
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
@@ -154,6 +166,9 @@ private:
 	void UpdateAnimate(const GameTimer& gt);
 
 	void LoadTextures();
+	void LoadTexture(const std::string& name, const std::wstring& path);
+	void RequestTexture(const std::string& name, const std::wstring& path, UINT srvIndex);
+	void CreateTextureSrv(ID3D12Resource* texture, UINT srvIndex);
 	void BuildDescriptorHeaps();
 	void BuildRootSignature();
 	void BuildRenderItems();
@@ -161,7 +176,9 @@ private:
 	void BuildPSO();
 	void BuildFrameResource();
 	void BuildMaterials();
-	void BuildSkullGeometry();
+	void RequestSkullGeometry();
+	void BuildSkullProxyGeometry();
+	bool CookSkullMesh(std::vector<std::uint8_t>& bytes, std::string& error);
 	void BuildRoomGeometry();
 	void DrawRenderItems(const std::vector<RenderItem*>& ritems);
 
@@ -174,6 +191,7 @@ private:
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3DBlob>> mShaders;
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D12PipelineState>> mPSOs;
 	std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> mPositionInputLayout;
 
 	DirectX::XMFLOAT3 mEyePos;
 	DirectX::XMFLOAT4X4 mView;
@@ -199,4 +217,23 @@ private:
 	RenderItem* mSkullRitem;
 	RenderItem* mReflectedSkullRitem;
 	RenderItem* mShadowedSkullRitem;
+	RenderItem* mPickedRitem;
+
+	// Over the skull's welded vertices, in its object space.  Empty until the skull has
+	// loaded.
+	MeshBVH mSkullBVH;
+
+	// The descriptor drawn in place of textures still loading: white1x1, loaded up front.
+	static const UINT PlaceholderSrv = 3;
+	// Per descriptor slot, whether its texture has finished uploading.
+	std::vector<bool> mSrvReady;
+
+	// Open until the loader has read everything it needs from it.
+	AssetPack mAssets;
+	// Where the skull is kept once cooked from skull.txt, for runs without a pack.
+	ContentCache mCookCache;
+
+	// Last, so its workers stop before the members their loads use are destroyed.
+	AssetLoader::Handle mSkullRequest = AssetLoader::InvalidHandle;
+	AssetLoader mLoader;
 };
@@ -59,6 +59,7 @@ void IcosahedronApp::Update(const GameTimer& gt)
 	}
 
 	UpdateAnimate(gt);
+	UpdateSubdivisionLevel();
 
 	UpdateMainPassCB(gt);
 	UpdateObjectCBs(gt);
@@ -272,6 +273,30 @@ void IcosahedronApp::UpdateAnimate(const GameTimer& gt)
 {
 }
 
+void IcosahedronApp::UpdateSubdivisionLevel()
+{
+	// Same distance bands the subdividing geometry shader used, measured to the nearest
+	// point of the icosahedron's bounding sphere rather than per triangle.
+	static const char* levels[] = { "icosa0", "icosa1", "icosa2" };
+
+	XMMATRIX world = XMLoadFloat4x4(&mIcosaRitem->World);
+	float radius = XMVectorGetX(XMVector3Length(world.r[0]));
+	float dist = XMVectorGetX(XMVector3Length(XMLoadFloat3(&mEyePos) - world.r[3])) - radius;
+
+	int level;
+	if (dist < 15.0f)
+		level = 2;
+	else if (dist <= 30.0f)
+		level = 1;
+	else
+		level = 0;
+
+	const SubmeshGeometry& submesh = mIcosaRitem->Geo->DrawArgs[levels[level]];
+	mIcosaRitem->IndexCount = submesh.IndexCount;
+	mIcosaRitem->StartIndexLocation = submesh.StartIndexLocation;
+	mIcosaRitem->BaseVertexLocation = submesh.BaseVertexLocation;
+}
+
 
 void IcosahedronApp::BuildRootSignature()
 {
@@ -306,27 +331,34 @@ void IcosahedronApp::BuildRenderItems()
 	icosaRitem->Geo = mGeometries["shapeGeo"].get();
 	icosaRitem->Mat = mMaterials["woodCrate"].get();
 	icosaRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	icosaRitem->IndexCount = icosaRitem->Geo->DrawArgs["icosa"].IndexCount;
-	icosaRitem->StartIndexLocation = icosaRitem->Geo->DrawArgs["icosa"].StartIndexLocation;
-	icosaRitem->BaseVertexLocation = icosaRitem->Geo->DrawArgs["icosa"].BaseVertexLocation;
+	icosaRitem->IndexCount = icosaRitem->Geo->DrawArgs["icosa0"].IndexCount;
+	icosaRitem->StartIndexLocation = icosaRitem->Geo->DrawArgs["icosa0"].StartIndexLocation;
+	icosaRitem->BaseVertexLocation = icosaRitem->Geo->DrawArgs["icosa0"].BaseVertexLocation;
 	
+	// The normal visualizations stay on the base level while the icosa item switches.
 	auto icosaPointsRitem = make_unique<RenderItem>();
 	*icosaPointsRitem = *icosaRitem;
+	icosaPointsRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
+
+	auto icosaPlaneRitem = make_unique<RenderItem>();
+	*icosaPlaneRitem = *icosaRitem;
+
+	mIcosaRitem = icosaRitem.get();
 	mAllRitems.push_back(std::move(icosaRitem));
 	mOpaqueRitems.push_back(mAllRitems.back().get());
 
-	icosaPointsRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
 	mAllRitems.push_back(std::move(icosaPointsRitem));
 	mOpaquePointsRitems.push_back(mAllRitems.back().get());
 
-	mOpaquePlaneRitems.push_back(mAllRitems.front().get());
+	mAllRitems.push_back(std::move(icosaPlaneRitem));
+	mOpaquePlaneRitems.push_back(mAllRitems.back().get());
 }
 
 void IcosahedronApp::BuildShadersAndInputLayout()
 {
-	mVertexShader = d3dUtil::CompileShader(L"Shaders/SubDivide.hlsl", "VS", "vs_5_0");
+	mVertexShader = d3dUtil::CompileShader(L"Shaders/SubDivide.hlsl", "ExplodeVS", "vs_5_0");
 	mPixelShader = d3dUtil::CompileShader(L"Shaders/SubDivide.hlsl", "PS", "ps_5_0"); 
-	mGeometryShader = d3dUtil::CompileShader(L"Shaders/SubDivide.hlsl", "GS", "gs_5_0");
+	mPassThroughVS = d3dUtil::CompileShader(L"Shaders/SubDivide.hlsl", "VS", "vs_5_0");
 
 	mPointGS = d3dUtil::CompileShader(L"Shaders/SubDivide.hlsl", "GSPoint", "gs_5_0");
 	mPlaneGS = d3dUtil::CompileShader(L"Shaders/SubDivide.hlsl", "GSPlane", "gs_5_0");
@@ -335,7 +367,8 @@ void IcosahedronApp::BuildShadersAndInputLayout()
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "FACENORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
 	};
 }
 
@@ -344,25 +377,67 @@ void IcosahedronApp::BuildGeometry()
 	GeometryGenerator geoGen;
 	GeometryGenerator::MeshData icosa = geoGen.CreateGeosphere(1.0f, 1);
 
-	std::vector<Vertex> vertices(icosa.Vertices.size());
+	// CreateGeosphere gives every triangle its own corners; share them so the half-edge
+	// mesh sees the adjacency.
+	MeshWelder::Weld(icosa);
 
-	UINT k = 0;
-	for (size_t i = 0; i < icosa.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = icosa.Vertices[i].Position;
-		vertices[k].Normal = icosa.Vertices[i].Normal;
-		vertices[k].TexC = icosa.Vertices[i].TexC;
-	}
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = "shapeGeo";
 
+	std::vector<Vertex> vertices;
 	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(), std::begin(icosa.GetIndices16()), std::end(icosa.GetIndices16()));
+
+	// Levels 0-2 are subdivided once here rather than every frame in a geometry shader:
+	// midpoint subdivision, projected back onto the unit sphere after each level.
+	HalfEdgeMesh level(icosa);
+	for (int k = 0; k <= 2; ++k)
+	{
+		if (k > 0)
+		{
+			level = level.Subdivide(HalfEdgeMesh::Scheme::Midpoint);
+			for (auto& v : level.Vertices())
+			{
+				XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&v.Position));
+				XMStoreFloat3(&v.Position, n);
+				XMStoreFloat3(&v.Normal, n);
+			}
+		}
+
+		SubmeshGeometry submesh;
+		submesh.BaseVertexLocation = 0;
+		submesh.StartIndexLocation = (UINT)indices.size();
+
+		// Triangles explode along their own normal, so each one gets private corners.
+		const auto& levelVertices = level.Vertices();
+		const auto& levelIndices = level.Indices();
+		for (size_t i = 0; i < levelIndices.size(); i += 3)
+		{
+			XMVECTOR faceNormal = XMVectorZero();
+			for (size_t c = 0; c < 3; ++c)
+				faceNormal += XMLoadFloat3(&levelVertices[levelIndices[i + c]].Normal);
+
+			for (size_t c = 0; c < 3; ++c)
+			{
+				const auto& src = levelVertices[levelIndices[i + c]];
+
+				Vertex v;
+				v.Pos = src.Position;
+				v.Normal = src.Normal;
+				v.TexC = src.TexC;
+				XMStoreFloat3(&v.FaceNormal, XMVector3Normalize(faceNormal));
+
+				indices.push_back((std::uint16_t)vertices.size());
+				vertices.push_back(v);
+			}
+		}
+
+		submesh.IndexCount = (UINT)indices.size() - submesh.StartIndexLocation;
+		geo->DrawArgs["icosa" + std::to_string(k)] = submesh;
+	}
 
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
-	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "shapeGeo";
-
 	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
 	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
@@ -380,13 +455,6 @@ void IcosahedronApp::BuildGeometry()
 	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
 	geo->IndexBufferSize = ibByteSize;
 
-	SubmeshGeometry boxSubmesh;
-	boxSubmesh.BaseVertexLocation = 0;
-	boxSubmesh.IndexCount = indices.size();
-	boxSubmesh.StartIndexLocation = 0;
-
-	geo->DrawArgs["icosa"] = boxSubmesh;
-
 	mGeometries[geo->Name] = std::move(geo);
 }
 
@@ -397,7 +465,6 @@ void IcosahedronApp::BuildPSO()
 	desc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
 	desc.VS = { mVertexShader->GetBufferPointer(), mVertexShader->GetBufferSize() };
 	desc.PS = { mPixelShader->GetBufferPointer(), mPixelShader->GetBufferSize() };
-	desc.GS = { mGeometryShader->GetBufferPointer(), mGeometryShader->GetBufferSize() };
 	desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);;
 	desc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
 	desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
@@ -413,11 +480,13 @@ void IcosahedronApp::BuildPSO()
 	ThrowIfFailed(mD3DDevice->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&mPSO)));
 
 	auto pointDesc = desc;
+	pointDesc.VS = { mPassThroughVS->GetBufferPointer(), mPassThroughVS->GetBufferSize() };
 	pointDesc.GS = { mPointGS->GetBufferPointer(), mPointGS->GetBufferSize() };
 	pointDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
 	ThrowIfFailed(mD3DDevice->CreateGraphicsPipelineState(&pointDesc, IID_PPV_ARGS(&mVertexNormalPSO)));
 
 	auto planeDesc = desc;
+	planeDesc.VS = { mPassThroughVS->GetBufferPointer(), mPassThroughVS->GetBufferSize() };
 	planeDesc.GS = { mPlaneGS->GetBufferPointer(), mPlaneGS->GetBufferSize() };
 	ThrowIfFailed(mD3DDevice->CreateGraphicsPipelineState(&planeDesc, IID_PPV_ARGS(&mPlaneNormalPSO)));
 }
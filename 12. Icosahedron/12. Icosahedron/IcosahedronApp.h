@@ -6,6 +6,8 @@
 #include "../../Common/D3DApp.h"
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
+#include "../../Common/HalfEdgeMesh.h"
+#include "../../Common/MeshWelder.h"
 #include "../../Common/MathHelper.h"
 #include "../../Common/DDSTextureLoader.h"
 
@@ -57,6 +59,7 @@ struct Vertex
 	DirectX::XMFLOAT3 Pos;
 	DirectX::XMFLOAT3 Normal;
 	DirectX::XMFLOAT2 TexC;
+	DirectX::XMFLOAT3 FaceNormal;
 };
 
 const INT gFrameResourcesCount = 3;
@@ -127,6 +130,7 @@ private:
 	void UpdateMainPassCB(const GameTimer& gt);
 	void UpdateMaterialCB(const GameTimer& gt);
 	void UpdateAnimate(const GameTimer& gt);
+	void UpdateSubdivisionLevel();
 
 	void BuildRootSignature();
 	void BuildRenderItems();
@@ -144,7 +148,7 @@ private:
 
 	Microsoft::WRL::ComPtr<ID3DBlob> mVertexShader;
 	Microsoft::WRL::ComPtr<ID3DBlob> mPixelShader;
-	Microsoft::WRL::ComPtr<ID3DBlob> mGeometryShader;
+	Microsoft::WRL::ComPtr<ID3DBlob> mPassThroughVS;
 	Microsoft::WRL::ComPtr<ID3DBlob> mPointGS;
 	Microsoft::WRL::ComPtr<ID3DBlob> mPlaneGS;
 	std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
@@ -163,6 +167,7 @@ private:
 
 	std::vector<std::unique_ptr<RenderItem>> mAllRitems;
 	std::vector<RenderItem*> mOpaqueRitems;
+	RenderItem* mIcosaRitem = nullptr;
 
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
 	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
@@ -57,6 +57,7 @@ struct VertexInOut
     float3 PosL : POSITION;
     float3 NormalL : NORMAL;
     float2 TexC : TEXCOORD;
+    float3 FaceNormalL : FACENORMAL;
 };
 
 struct GeoOut
@@ -72,98 +73,20 @@ VertexInOut VS(VertexInOut vin)
     return vin;
 }
 
-VertexInOut MidPoint(VertexInOut a, VertexInOut b)
+// The subdivision levels are built on the CPU (HalfEdgeMesh) and picked by distance
+// at draw time; this only pushes each triangle out along its face normal.
+GeoOut ExplodeVS(VertexInOut vin)
 {
-    VertexInOut ret;
-    ret.PosL = normalize(0.5f * (a.PosL + b.PosL));
-    ret.NormalL = ret.PosL;
-    ret.TexC = 0.5f * (a.TexC + b.TexC);
-    return ret;
-}
-
-GeoOut Solve(VertexInOut x, float3 normal)
-{
-    x.PosL = x.PosL + normal * gTotalTime * 0.3f;
+    vin.PosL = vin.PosL + vin.FaceNormalL * gTotalTime * 0.3f;
     
-    GeoOut ret;
-    ret.PosW = mul(float4(x.PosL, 1.0f), gWorld).xyz;
-    ret.PosH = mul(float4(ret.PosW, 1.0f), gViewProj);
-    ret.NormalW = mul(float4(x.NormalL, 1.0f), gWorld).xyz;
+    GeoOut vout;
+    vout.PosW = mul(float4(vin.PosL, 1.0f), gWorld).xyz;
+    vout.PosH = mul(float4(vout.PosW, 1.0f), gViewProj);
+    vout.NormalW = mul(vin.NormalL, (float3x3)gWorld);
         
-    float4 texC = mul(float4(x.TexC, 0.0f, 1.0f), gTexTransform);
-    ret.TexC = mul(texC, gMatTransform).xy;
-    return ret;
-}
-
-struct StackEntry
-{
-    VertexInOut p0, p1, p2;
-    int currentLevel;
-};
-void SubDivide(VertexInOut a, VertexInOut b, VertexInOut c, int level, inout TriangleStream<GeoOut> stream)
-{
-    StackEntry stack[64];
-    int stackIndex = 0;
-
-    StackEntry t;
-    t.currentLevel = level;
-    t.p0 = a;
-    t.p1 = b;
-    t.p2 = c;
-    stack[stackIndex++] = t;
-
-    while (stackIndex > 0) 
-    {
-        StackEntry entry = stack[--stackIndex];
-
-        if (entry.currentLevel == 0) 
-        {
-            float3 normal = normalize(entry.p0.NormalL + entry.p1.NormalL + entry.p2.NormalL);
-            
-            GeoOut fa = Solve(entry.p0, normal);
-            GeoOut fb = Solve(entry.p1, normal);
-            GeoOut fc = Solve(entry.p2, normal);
-
-            stream.Append(fa);
-            stream.Append(fb);
-            stream.Append(fc);
-            stream.RestartStrip();
-        } 
-        else
-        {
-            VertexInOut ma = MidPoint(entry.p0, entry.p1);
-            VertexInOut mb = MidPoint(entry.p1, entry.p2);
-            VertexInOut mc = MidPoint(entry.p0, entry.p2);
-
-            StackEntry t;
-            t.currentLevel = entry.currentLevel - 1;
-            
-            t.p0 = entry.p0, t.p1 = ma, t.p2 = mc;
-            stack[stackIndex++] = t;
-            t.p0 = ma, t.p1 = mb, t.p2 = mc;
-            stack[stackIndex++] = t;
-            t.p0 = ma, t.p1 = entry.p1, t.p2 = mb;
-            stack[stackIndex++] = t;
-            t.p0 = mc, t.p1 = mb, t.p2 = entry.p2;
-            stack[stackIndex++] = t;
-        }
-    }
-}
-
-
-[maxvertexcount(48)]
-void GS(triangle VertexInOut gin[3], inout TriangleStream<GeoOut> triStream)
-{
-    float3 posW = mul(float4(gin[0].PosL, 1.0f), gWorld);
-    float dist = length(gEyePosW - posW);
-    int k;
-    if (dist < 15)
-        k = 2;
-    else if (dist <= 30)
-        k = 1;
-    else
-        k = 0;
-    SubDivide(gin[0], gin[1], gin[2], k, triStream);
+    float4 texC = mul(float4(vin.TexC, 0.0f, 1.0f), gTexTransform);
+    vout.TexC = mul(texC, gMatTransform).xy;
+    return vout;
 }
 
 float4 PS(GeoOut pin) : SV_Target
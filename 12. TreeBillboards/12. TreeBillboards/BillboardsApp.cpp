@@ -297,34 +297,30 @@ void BillboardsApp::UpdateAnimate(const GameTimer& gt)
 
 void BillboardsApp::LoadTextures()
 {
-	auto grassTex = std::make_unique<Texture>();
-	grassTex->Name = "grassTex";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/grass.dds",
-		grassTex->Resource, grassTex->UploadHeap));
-
-	auto waterTex = std::make_unique<Texture>();
-	waterTex->Name = "waterTex";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/water1.dds",
-		waterTex->Resource, waterTex->UploadHeap));
-
-	auto fenceTex = std::make_unique<Texture>();
-	fenceTex->Name = "fenceTex";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/wirefence.dds",
-		fenceTex->Resource, fenceTex->UploadHeap));
-
-	auto treeTex = std::make_unique<Texture>();
-	treeTex->Name = "treeTex";
-	DirectX::CreateDDSTextureFromFile12(mD3DDevice.Get(),
-		mCommandList.Get(), L"../../Textures/treeArray2.dds",
-		treeTex->Resource, treeTex->UploadHeap);
-
-	mTextures[grassTex->Name] = std::move(grassTex);
-	mTextures[waterTex->Name] = std::move(waterTex);
-	mTextures[fenceTex->Name] = std::move(fenceTex);
-	mTextures[treeTex->Name] = std::move(treeTex);
+	// treeArray2.dds has no mips, so distant billboards sampled it at full size and
+	// shimmered; the batch gives it a chain on its worker before the upload.
+	TextureBatch batch;
+	batch.Add(L"../../Textures/grass.dds");
+	batch.Add(L"../../Textures/water1.dds");
+	batch.Add(L"../../Textures/wirefence.dds");
+	batch.Add(L"../../Textures/treeArray2.dds", 0, true);
+
+	std::string error;
+	if (!batch.Load(mD3DDevice.Get(), mCommandList.Get(), &error))
+	{
+		OutputDebugStringA((error + "\n").c_str());
+		ThrowIfFailed(E_FAIL);
+	}
+
+	const char* names[] = { "grassTex", "waterTex", "fenceTex", "treeTex" };
+	for (size_t i = 0; i < batch.Count(); ++i)
+	{
+		auto tex = std::make_unique<Texture>();
+		tex->Name = names[i];
+		tex->Resource = batch.Get(i).GetTexture();
+		tex->UploadHeap = batch.Get(i).GetUploadHeap();
+		mTextures[tex->Name] = std::move(tex);
+	}
 }
 
 void BillboardsApp::BuildDescriptorHeaps()
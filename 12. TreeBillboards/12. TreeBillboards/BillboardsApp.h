@@ -8,6 +8,7 @@
 #include "../../Common/GeometryGenerator.h"
 #include "../../Common/MathHelper.h"
 #include "../../Common/DDSTextureLoader.h"
+#include "../../Common/TextureBatch.h"
 #include "Waves.h"
 
 #define MaxLights 16
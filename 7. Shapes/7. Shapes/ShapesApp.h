@@ -6,6 +6,8 @@
 #include "../../Common/D3DApp.h"
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
+#include "../../Common/GeometryCache.h"
+#include "../../Common/MeshPacker.h"
 #include "../../Common/MathHelper.h"
 
 struct ObjectConstant {
@@ -95,6 +97,7 @@ private:
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mCbvHeap;
 
 	std::unordered_map<std::string, std::unique_ptr<d3dUtil::MeshGeometry>> mGeometries;
+	GeometryCache mGeometryCache;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> mPSO;
 
 	Microsoft::WRL::ComPtr<ID3DBlob> mVertexShader;
@@ -0,0 +1,204 @@
+#include "AssetLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <utility>
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+}
+
+const AssetLoader::Handle AssetLoader::InvalidHandle;
+
+AssetLoader::AssetLoader(unsigned threadCount)
+{
+	if (threadCount == 0)
+	{
+		const unsigned hardware = std::thread::hardware_concurrency();
+		threadCount = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	mWorkers.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; ++i)
+		mWorkers.emplace_back(&AssetLoader::WorkerMain, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+		mQueue.clear();
+	}
+	mWake.notify_all();
+
+	for (std::thread& worker : mWorkers)
+		worker.join();
+}
+
+AssetLoader::Handle AssetLoader::Request(Job job)
+{
+	Handle handle;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		handle = (Handle)mEntries.size();
+		mEntries.push_back(std::make_unique<Entry>());
+		mEntries.back()->Work = std::move(job);
+		mQueue.push_back(handle);
+		++mStats.Requested;
+	}
+	mWake.notify_one();
+	return handle;
+}
+
+void AssetLoader::WorkerMain()
+{
+	for (;;)
+	{
+		Entry* entry;
+		Handle handle;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this]() { return mStopping || !mQueue.empty(); });
+			if (mStopping)
+				return;
+
+			handle = mQueue.front();
+			mQueue.pop_front();
+			entry = mEntries[handle].get();
+			entry->Status = State::Loading;
+			++mLoading;
+		}
+
+		auto start = Clock::now();
+		std::string error;
+		bool ok;
+		try
+		{
+			ok = entry->Work.Load(error);
+			if (!ok && error.empty())
+				error = "load failed";
+		}
+		catch (const std::exception& e)
+		{
+			ok = false;
+			error = e.what();
+		}
+		catch (...)
+		{
+			ok = false;
+			error = "load threw an exception";
+		}
+		const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		entry->Status = ok ? State::Loaded : State::Failed;
+		entry->Error = error;
+		mLoaded.push_back(handle);
+		--mLoading;
+		mStats.LoadMilliseconds += ms;
+	}
+}
+
+size_t AssetLoader::Pump(uint64 fence, size_t maxUploads)
+{
+	// Taken under the lock, run outside it so workers can keep finishing loads.
+	std::vector<std::pair<Handle, Entry*>> taken;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		std::vector<Handle> kept;
+		size_t uploads = 0;
+		for (Handle handle : mLoaded)
+		{
+			const bool upload = mEntries[handle]->Status == State::Loaded;
+			if (upload && uploads == maxUploads)
+			{
+				kept.push_back(handle);
+				continue;
+			}
+			taken.emplace_back(handle, mEntries[handle].get());
+			uploads += upload;
+		}
+		mLoaded.swap(kept);
+	}
+
+	size_t uploads = 0;
+	for (const auto& item : taken)
+	{
+		Entry& entry = *item.second;
+		if (entry.Status == State::Failed)
+		{
+			if (entry.Work.Failed)
+				entry.Work.Failed(entry.Error);
+			entry.Work = Job();
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			++mStats.Failed;
+			continue;
+		}
+
+		entry.Work.Upload();
+		entry.Work.Load = nullptr;
+		entry.Work.Upload = nullptr;
+		entry.Fence = fence;
+		++uploads;
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		entry.Status = State::Uploading;
+		mInFlight.push_back(item.first);
+	}
+	return uploads;
+}
+
+size_t AssetLoader::Retire(uint64 completedFence)
+{
+	std::vector<Entry*> finished;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto done = std::stable_partition(mInFlight.begin(), mInFlight.end(), [&](Handle handle)
+		{
+			return mEntries[handle]->Fence > completedFence;
+		});
+		for (auto it = done; it != mInFlight.end(); ++it)
+			finished.push_back(mEntries[*it].get());
+		mInFlight.erase(done, mInFlight.end());
+	}
+
+	for (Entry* finishedEntry : finished)
+	{
+		Entry& entry = *finishedEntry;
+		if (entry.Work.Ready)
+			entry.Work.Ready();
+		entry.Work = Job();
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		entry.Status = State::Ready;
+		++mStats.Ready;
+	}
+	return finished.size();
+}
+
+AssetLoader::State AssetLoader::GetState(Handle handle) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return handle < mEntries.size() ? mEntries[handle]->Status : State::Failed;
+}
+
+std::string AssetLoader::GetError(Handle handle) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return handle < mEntries.size() ? mEntries[handle]->Error : std::string("no such request");
+}
+
+bool AssetLoader::Idle() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mQueue.empty() && mLoading == 0 && mLoaded.empty() && mInFlight.empty();
+}
+
+AssetLoader::Stats AssetLoader::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads assets in the background so the first frame does not wait for them.  Each request
+// runs in three steps:
+//
+//	Load	on a worker thread: file reads, decompression, parsing
+//	Upload	on the render thread, from Pump(): records the GPU copies into the command
+//			list of the frame being built, which signals 'fence' when it is submitted
+//	Ready	on the render thread, from Retire(), once the fence has completed
+//
+// Until Ready runs the app keeps drawing a placeholder.  Steps share state through what
+// they capture; a job's functions are destroyed after its last step, which releases it.
+// Nothing here depends on D3D, so the scheduling can be exercised without a device.
+class AssetLoader
+{
+public:
+	using uint64 = std::uint64_t;
+	using Handle = std::uint32_t;
+
+	static const Handle InvalidHandle = ~0u;
+
+	enum class State
+	{
+		Queued,
+		Loading,
+		Loaded,
+		Uploading,
+		Ready,
+		Failed
+	};
+
+	struct Job
+	{
+		std::string Name;
+		// Fills whatever Upload needs; false with 'error' set on failure.  Exceptions are
+		// caught and count as failures.
+		std::function<bool(std::string& error)> Load;
+		std::function<void()> Upload;
+		// Optional.
+		std::function<void()> Ready;
+		// Optional; runs on the render thread, from Pump(), instead of Upload and Ready.
+		std::function<void(const std::string& error)> Failed;
+	};
+
+	struct Stats
+	{
+		size_t Requested = 0;
+		size_t Ready = 0;
+		size_t Failed = 0;
+		// Summed over the workers, so it can exceed the wall-clock time.
+		double LoadMilliseconds = 0.0;
+	};
+
+	// 0 threads means one per hardware thread less the render thread, and at least one.
+	explicit AssetLoader(unsigned threadCount = 0);
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// Drops queued jobs and waits for the loads already running.
+	~AssetLoader();
+
+	Handle Request(Job job);
+
+	// Runs Upload for up to 'maxUploads' loaded jobs, in the order they finished loading,
+	// and Failed for jobs whose load failed.  'fence' is the value the caller signals after
+	// submitting the commands the uploads recorded.  Returns the uploads run.
+	size_t Pump(uint64 fence, size_t maxUploads = ~(size_t)0);
+
+	// Runs Ready for the uploads whose fence is at most 'completedFence'.  Returns how many.
+	size_t Retire(uint64 completedFence);
+
+	State GetState(Handle handle) const;
+	bool IsReady(Handle handle) const { return GetState(handle) == State::Ready; }
+	std::string GetError(Handle handle) const;
+
+	// Nothing queued, loading, or waiting to be uploaded or retired.
+	bool Idle() const;
+	Stats GetStats() const;
+
+private:
+	struct Entry
+	{
+		Job Work;
+		State Status = State::Queued;
+		std::string Error;
+		uint64 Fence = 0;
+	};
+
+	void WorkerMain();
+
+	mutable std::mutex mMutex;
+	std::condition_variable mWake;
+	bool mStopping = false;
+
+	// Entries never move, so workers can run a job without holding the lock.
+	std::vector<std::unique_ptr<Entry>> mEntries;
+	std::deque<Handle> mQueue;
+	// Loaded or failed, waiting for Pump().
+	std::vector<Handle> mLoaded;
+	// Uploaded, waiting for Retire().
+	std::vector<Handle> mInFlight;
+	size_t mLoading = 0;
+
+	Stats mStats;
+	std::vector<std::thread> mWorkers;
+};
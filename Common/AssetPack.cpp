@@ -0,0 +1,408 @@
+#include "AssetPack.h"
+#include "Hash.h"
+#include "Lz4.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	using uint32 = AssetPack::uint32;
+	using uint64 = AssetPack::uint64;
+
+	static_assert(sizeof(AssetPack::Header) == 40, "AssetPack::Header layout changed");
+	static_assert(sizeof(AssetPack::Entry) == 48, "AssetPack::Entry layout changed");
+
+	uint64 AlignUp(uint64 offset)
+	{
+		return (offset + AssetPack::DataAlignment - 1) & ~(uint64)(AssetPack::DataAlignment - 1);
+	}
+
+	bool Fail(std::string* error, const std::string& what)
+	{
+		if (error)
+			*error = what;
+		return false;
+	}
+
+	uint64 BlockCount(uint64 rawSize)
+	{
+		return (rawSize + AssetPack::BlockSize - 1) / AssetPack::BlockSize;
+	}
+
+	// The block table followed by the blocks, or empty if compressing saves less than an
+	// eighth.  Blocks are compressed in parallel.
+	std::vector<std::uint8_t> CompressBlocks(const std::vector<std::uint8_t>& data)
+	{
+		const size_t blockCount = (size_t)BlockCount(data.size());
+		std::vector<std::vector<std::uint8_t>> blocks(blockCount);
+		std::vector<uint32> sizes(blockCount);
+
+		ParallelFor::For(blockCount, 1, [&](size_t b)
+		{
+			const size_t first = b * AssetPack::BlockSize;
+			const size_t size = std::min<size_t>(AssetPack::BlockSize, data.size() - first);
+
+			blocks[b].resize(Lz4::CompressBound(size));
+			size_t packed = Lz4::Compress(data.data() + first, size, blocks[b].data(), blocks[b].size());
+			if (packed == 0 || packed >= size)
+			{
+				blocks[b].assign(data.begin() + first, data.begin() + first + size);
+				sizes[b] = (uint32)size | AssetPack::StoredBlock;
+			}
+			else
+			{
+				blocks[b].resize(packed);
+				sizes[b] = (uint32)packed;
+			}
+		});
+
+		size_t total = sizeof(uint32) * blockCount;
+		for (const auto& block : blocks)
+			total += block.size();
+		if (total > data.size() - data.size() / 8)
+			return {};
+
+		std::vector<std::uint8_t> out(sizeof(uint32) * blockCount);
+		memcpy(out.data(), sizes.data(), out.size());
+		out.reserve(total);
+		for (const auto& block : blocks)
+			out.insert(out.end(), block.begin(), block.end());
+		return out;
+	}
+
+	// The block table of a compressed entry must account for exactly its stored bytes,
+	// which is all Read() relies on.
+	bool ValidateBlocks(const AssetPack::Entry& entry, const char* data)
+	{
+		if (entry.Compression == AssetPack::None)
+			return entry.Size == entry.RawSize;
+		if (entry.Compression != AssetPack::Lz4Blocks)
+			return false;
+
+		const uint64 blockCount = BlockCount(entry.RawSize);
+		if (blockCount > entry.Size / sizeof(uint32))
+			return false;
+
+		uint64 stored = sizeof(uint32) * blockCount;
+		for (uint64 b = 0; b < blockCount; ++b)
+		{
+			uint32 bytes;
+			memcpy(&bytes, data + sizeof(uint32) * b, sizeof(bytes));
+
+			const uint64 raw = std::min<uint64>(AssetPack::BlockSize, entry.RawSize - b * AssetPack::BlockSize);
+			if (bytes & AssetPack::StoredBlock)
+			{
+				if ((bytes & ~AssetPack::StoredBlock) != raw)
+					return false;
+				stored += raw;
+			}
+			else
+			{
+				if (bytes > Lz4::CompressBound((size_t)raw))
+					return false;
+				stored += bytes;
+			}
+		}
+		return stored == entry.Size;
+	}
+
+	void WritePadding(std::ofstream& fout, uint64 to)
+	{
+		static const char zeros[AssetPack::DataAlignment] = {};
+		uint64 at = (uint64)fout.tellp();
+		if (to > at)
+			fout.write(zeros, (std::streamsize)(to - at));
+	}
+}
+
+const uint32 AssetPack::FileMagic;
+const uint32 AssetPack::FileVersion;
+const uint32 AssetPack::DataAlignment;
+const uint32 AssetPack::BlockSize;
+const uint32 AssetPack::StoredBlock;
+
+std::string AssetPack::NormalizeName(const std::string& name)
+{
+	std::string normalized = name;
+	for (char& c : normalized)
+	{
+		if (c == '\\')
+			c = '/';
+		else if (c >= 'A' && c <= 'Z')
+			c = (char)(c - 'A' + 'a');
+	}
+
+	size_t start = 0;
+	for (;;)
+	{
+		if (normalized.compare(start, 2, "./") == 0)
+			start += 2;
+		else if (normalized.compare(start, 3, "../") == 0)
+			start += 3;
+		else if (normalized.compare(start, 1, "/") == 0)
+			start += 1;
+		else
+			break;
+	}
+	return normalized.substr(start);
+}
+
+uint64 AssetPack::HashName(const std::string& name)
+{
+	return Hash::Fnv1a64(NormalizeName(name));
+}
+
+bool AssetPack::Writer::Add(const std::string& name, Type type, std::vector<std::uint8_t> data, std::string* error)
+{
+	std::string normalized = NormalizeName(name);
+	if (normalized.empty())
+		return Fail(error, "empty asset name");
+
+	for (const Item& item : mItems)
+	{
+		if (item.Name == normalized)
+			return Fail(error, normalized + " added twice");
+	}
+
+	mItems.push_back({ normalized, Hash::Fnv1a64(normalized), type, std::move(data), false, None, 0 });
+	return true;
+}
+
+bool AssetPack::Writer::AddStored(const std::string& name, Type type, Compression compression, uint64 rawSize,
+	std::vector<std::uint8_t> stored, std::string* error)
+{
+	if (compression == None && stored.size() != rawSize)
+		return Fail(error, NormalizeName(name) + ": stored size does not match");
+	if (!Add(name, type, std::move(stored), error))
+		return false;
+
+	Item& item = mItems.back();
+	item.Stored = true;
+	item.StoredAs = compression;
+	item.RawSize = rawSize;
+	return true;
+}
+
+bool AssetPack::Writer::Save(const std::wstring& path, std::string* error) const
+{
+	if (mItems.size() > 0xffffffffull)
+		return Fail(error, "too many assets");
+
+	// Sorted by hash for Find(); equal hashes by name so the file is reproducible.
+	std::vector<const Item*> items;
+	items.reserve(mItems.size());
+	for (const Item& item : mItems)
+		items.push_back(&item);
+	std::sort(items.begin(), items.end(), [](const Item* a, const Item* b)
+	{
+		return a->Hash != b->Hash ? a->Hash < b->Hash : a->Name < b->Name;
+	});
+
+	std::vector<std::vector<std::uint8_t>> compressed(items.size());
+	if (mCompression == Lz4Blocks)
+	{
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			if (!items[i]->Stored)
+				compressed[i] = CompressBlocks(items[i]->Data);
+		}
+	}
+
+	std::string names;
+	std::vector<Entry> entries(items.size());
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		Entry& entry = entries[i];
+		memset(&entry, 0, sizeof(entry));
+		entry.NameHash = items[i]->Hash;
+		if (items[i]->Stored)
+		{
+			entry.RawSize = items[i]->RawSize;
+			entry.Compression = items[i]->StoredAs;
+			entry.Size = items[i]->Data.size();
+		}
+		else
+		{
+			entry.RawSize = items[i]->Data.size();
+			entry.Compression = compressed[i].empty() ? None : Lz4Blocks;
+			entry.Size = compressed[i].empty() ? entry.RawSize : compressed[i].size();
+		}
+		entry.NameOffset = (uint32)names.size();
+		entry.NameLength = (uint32)items[i]->Name.size();
+		entry.Type = items[i]->Kind;
+		names += items[i]->Name;
+	}
+
+	if (names.size() > 0xffffffffull)
+		return Fail(error, "asset names too long");
+
+	Header header = {};
+	header.Magic = FileMagic;
+	header.Version = FileVersion;
+	header.EntryCount = (uint32)entries.size();
+	header.NameBytes = (uint32)names.size();
+	header.EntryOffset = sizeof(Header);
+	header.NameOffset = header.EntryOffset + sizeof(Entry) * entries.size();
+
+	uint64 offset = header.NameOffset + names.size();
+	for (Entry& entry : entries)
+	{
+		entry.Offset = AlignUp(offset);
+		offset = entry.Offset + entry.Size;
+	}
+	header.FileSize = offset;
+
+	std::ofstream fout(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+	if (!fout)
+		return Fail(error, "cannot create the file");
+
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	fout.write(reinterpret_cast<const char*>(entries.data()), sizeof(Entry) * entries.size());
+	fout.write(names.data(), names.size());
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		const std::vector<std::uint8_t>& data = compressed[i].empty() ? items[i]->Data : compressed[i];
+		WritePadding(fout, entries[i].Offset);
+		fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	if (!fout)
+		return Fail(error, "write failed");
+	return true;
+}
+
+bool AssetPack::Open(const std::wstring& path, std::string* error)
+{
+	Close();
+
+	if (!mFile.Open(path))
+		return Fail(error, "cannot open the file");
+
+	const uint64 size = mFile.Size();
+	const char* data = mFile.Data();
+	const Header* header = reinterpret_cast<const Header*>(data);
+
+	auto fail = [&](const char* what)
+	{
+		mFile.Close();
+		return Fail(error, what);
+	};
+
+	if (size < sizeof(Header))
+		return fail("file too small");
+	if (header->Magic != FileMagic)
+		return fail("not an asset pack");
+	if (header->Version != FileVersion)
+		return fail("unsupported asset pack version");
+	if (header->FileSize != size)
+		return fail("truncated asset pack");
+
+	// The entry count is 32-bit, so the table size cannot overflow.
+	const uint64 entryBytes = (uint64)header->EntryCount * sizeof(Entry);
+	if (header->EntryOffset % alignof(Entry) != 0 || header->EntryOffset > size || entryBytes > size - header->EntryOffset)
+		return fail("entry table outside the file");
+	if (header->NameOffset > size || header->NameBytes > size - header->NameOffset)
+		return fail("name table outside the file");
+
+	const Entry* entries = reinterpret_cast<const Entry*>(data + header->EntryOffset);
+	for (uint32 i = 0; i < header->EntryCount; ++i)
+	{
+		const Entry& entry = entries[i];
+		if (entry.Offset % DataAlignment != 0 || entry.Offset > size || entry.Size > size - entry.Offset)
+			return fail("asset outside the file");
+		if (!ValidateBlocks(entry, data + entry.Offset))
+			return fail("bad compressed block table");
+		if ((uint64)entry.NameOffset + entry.NameLength > header->NameBytes)
+			return fail("asset name outside the name table");
+		if (i > 0 && entries[i - 1].NameHash > entry.NameHash)
+			return fail("entry table not sorted");
+
+		const char* name = data + header->NameOffset + entry.NameOffset;
+		if (Hash::Fnv1a64(name, entry.NameLength) != entry.NameHash)
+			return fail("asset name does not match its hash");
+	}
+
+	mHeader = header;
+	mEntries = entries;
+	mNames = data + header->NameOffset;
+	return true;
+}
+
+void AssetPack::Close()
+{
+	mFile.Close();
+	mHeader = nullptr;
+	mEntries = nullptr;
+	mNames = nullptr;
+}
+
+std::string AssetPack::Name(const Entry& entry) const
+{
+	return std::string(mNames + entry.NameOffset, entry.NameLength);
+}
+
+const AssetPack::Entry* AssetPack::Find(const std::string& name) const
+{
+	const std::string normalized = NormalizeName(name);
+	const uint64 hash = Hash::Fnv1a64(normalized);
+
+	const Entry* end = mEntries + mHeader->EntryCount;
+	const Entry* it = std::lower_bound(mEntries, end, hash, [](const Entry& entry, uint64 h)
+	{
+		return entry.NameHash < h;
+	});
+
+	for (; it != end && it->NameHash == hash; ++it)
+	{
+		if (it->NameLength == normalized.size() && memcmp(mNames + it->NameOffset, normalized.data(), normalized.size()) == 0)
+			return it;
+	}
+	return nullptr;
+}
+
+bool AssetPack::Read(const Entry& entry, void* destination) const
+{
+	const char* data = static_cast<const char*>(Data(entry));
+	if (entry.Compression == None)
+	{
+		memcpy(destination, data, (size_t)entry.Size);
+		return true;
+	}
+
+	// Open() checked the table, so the offsets stay inside the entry.
+	const size_t blockCount = (size_t)BlockCount(entry.RawSize);
+	std::vector<uint32> sizes(blockCount);
+	std::vector<uint64> offsets(blockCount + 1);
+	memcpy(sizes.data(), data, sizeof(uint32) * blockCount);
+	offsets[0] = sizeof(uint32) * blockCount;
+	for (size_t b = 0; b < blockCount; ++b)
+		offsets[b + 1] = offsets[b] + (sizes[b] & ~StoredBlock);
+
+	std::atomic<bool> ok(true);
+	std::uint8_t* out = static_cast<std::uint8_t*>(destination);
+	ParallelFor::For(blockCount, 4, [&](size_t b)
+	{
+		const size_t first = b * BlockSize;
+		const size_t raw = std::min<size_t>(BlockSize, (size_t)entry.RawSize - first);
+		const char* block = data + offsets[b];
+
+		if (sizes[b] & StoredBlock)
+			memcpy(out + first, block, raw);
+		else if (!Lz4::Decompress(block, sizes[b], out + first, raw))
+			ok = false;
+	});
+	return ok;
+}
+
+const void* AssetPack::Bytes(const Entry& entry, std::vector<std::uint8_t>& storage) const
+{
+	if (entry.Compression == None)
+		return Data(entry);
+
+	storage.resize((size_t)entry.RawSize);
+	return Read(entry, storage.data()) ? storage.data() : nullptr;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// Packed asset archive (.lpak), written by Tools/AssetCooker and mapped whole at startup:
+//
+//	Header | Entry[EntryCount] | names | data
+//
+// Entries are sorted by the FNV-1a hash of their normalized name, so Find() is a binary
+// search; the names are kept to settle collisions and for listing.  Every entry's data
+// starts on a DataAlignment boundary, which keeps the regions of a cooked MeshFile aligned
+// in place.
+//
+// An entry may be stored as independent LZ4 blocks of BlockSize bytes:
+//
+//	uint32 BlockBytes[BlockCount] | block 0 | block 1 | ...
+//
+// where a size with StoredBlock set is a block kept as is because it did not shrink.
+// Read() decompresses the blocks in parallel straight into the caller's buffer.
+class AssetPack
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	static const uint32 FileMagic = 0x4B41504C; // "LPAK"
+	static const uint32 FileVersion = 2;
+	static const uint32 DataAlignment = 64;
+	static const uint32 BlockSize = 64 * 1024;
+	static const uint32 StoredBlock = 0x80000000;
+
+	enum Type : uint32
+	{
+		Raw = 0,
+		Mesh = 1,		// MeshFile image
+		Texture = 2,	// DDS file
+		Shader = 3		// HLSL source with its #includes inlined
+	};
+
+	enum Compression : uint32
+	{
+		None = 0,
+		Lz4Blocks = 1
+	};
+
+	struct Header
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 EntryCount;
+		uint32 NameBytes;
+
+		// Byte offsets from the start of the file.
+		uint64 EntryOffset;
+		uint64 NameOffset;
+		uint64 FileSize;
+	};
+
+	struct Entry
+	{
+		uint64 NameHash;
+		uint64 Offset;
+		// Bytes stored in the pack, and bytes of the asset itself; equal unless compressed.
+		uint64 Size;
+		uint64 RawSize;
+		uint32 NameOffset;
+		uint32 NameLength;
+		uint32 Type;
+		uint32 Compression;
+	};
+
+	// Lower case, forward slashes, and no leading "./" or "../", so the relative paths
+	// the samples use ("../../Textures/bricks3.dds") name the entry the cooker stored as
+	// "Textures/bricks3.dds".
+	static std::string NormalizeName(const std::string& name);
+	static uint64 HashName(const std::string& name);
+
+	// Collects assets in memory and writes them out as one pack.  With Lz4Blocks, entries
+	// are compressed unless that saves less than an eighth of their size.
+	class Writer
+	{
+	public:
+		explicit Writer(Compression compression = None) : mCompression(compression) {}
+
+		// Fails if the normalized name is already taken.
+		bool Add(const std::string& name, Type type, std::vector<std::uint8_t> data, std::string* error = nullptr);
+		// Adds an entry's stored bytes as they are, e.g. copied from the previous pack, so an
+		// unchanged asset is not compressed again.
+		bool AddStored(const std::string& name, Type type, Compression compression, uint64 rawSize,
+			std::vector<std::uint8_t> stored, std::string* error = nullptr);
+		bool Save(const std::wstring& path, std::string* error = nullptr) const;
+
+		size_t Count() const { return mItems.size(); }
+
+	private:
+		struct Item
+		{
+			std::string Name;
+			uint64 Hash;
+			Type Kind;
+			std::vector<std::uint8_t> Data;
+			// For AddStored(): Data is already in this form, and RawSize bytes unpacked.
+			bool Stored;
+			Compression StoredAs;
+			uint64 RawSize;
+		};
+		Compression mCompression;
+		std::vector<Item> mItems;
+	};
+
+	// Maps and validates the pack.  On failure the object is left closed.
+	bool Open(const std::wstring& path, std::string* error = nullptr);
+	void Close();
+
+	bool IsOpen() const { return mHeader != nullptr; }
+
+	// The pointers below point into the mapping and are valid while the pack is open.
+	uint32 Count() const { return mHeader->EntryCount; }
+	const Entry& GetEntry(uint32 i) const { return mEntries[i]; }
+	std::string Name(const Entry& entry) const;
+
+	// nullptr if the pack has no such asset.
+	const Entry* Find(const std::string& name) const;
+
+	// The stored bytes, which are the asset itself unless IsCompressed().
+	const void* Data(const Entry& entry) const { return mFile.Data() + entry.Offset; }
+	static bool IsCompressed(const Entry& entry) { return entry.Compression != None; }
+
+	// Writes the entry's RawSize bytes to 'destination'.  Fails only on corrupt blocks.
+	bool Read(const Entry& entry, void* destination) const;
+
+	// The asset's bytes: the mapping itself for stored entries, otherwise 'storage' after
+	// decompressing into it.  nullptr on corrupt blocks.
+	const void* Bytes(const Entry& entry, std::vector<std::uint8_t>& storage) const;
+
+private:
+	MappedFile mFile;
+	const Header* mHeader = nullptr;
+	const Entry* mEntries = nullptr;
+	const char* mNames = nullptr;
+};
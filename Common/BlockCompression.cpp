@@ -0,0 +1,1523 @@
+#include "BlockCompression.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BLOCKCOMPRESSION_SSE2 1
+#endif
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+	using uint8 = std::uint8_t;
+	using uint16 = std::uint16_t;
+	using uint32 = BlockCompression::uint32;
+
+	bool Fail(std::string* error, const std::string& what)
+	{
+		if (error != nullptr)
+			*error = what;
+		return false;
+	}
+
+	// The 16 texels of a block channel by channel, so four texels fill an SSE register.
+	struct Block
+	{
+		float V[4][16];
+	};
+
+	const uint32 AllTexels = 0xFFFF;
+
+	void LoadBlock(const uint8* rgba, uint32 width, uint32 height, size_t pitch, uint32 bx, uint32 by, Block& block)
+	{
+		for (uint32 y = 0; y < 4; ++y)
+		{
+			const uint8* row = rgba + std::min(by * 4 + y, height - 1) * pitch;
+			for (uint32 x = 0; x < 4; ++x)
+			{
+				const uint8* texel = row + std::min(bx * 4 + x, width - 1) * 4;
+				for (uint32 c = 0; c < 4; ++c)
+					block.V[c][y * 4 + x] = texel[c];
+			}
+		}
+	}
+
+	void StoreBlock(const uint8 texels[16][4], uint32 width, uint32 height, size_t pitch, uint32 bx, uint32 by,
+		uint8* rgba)
+	{
+		for (uint32 y = 0; y < 4 && by * 4 + y < height; ++y)
+		{
+			uint8* row = rgba + (by * 4 + y) * pitch;
+			for (uint32 x = 0; x < 4 && bx * 4 + x < width; ++x)
+				memcpy(row + (bx * 4 + x) * 4, texels[y * 4 + x], 4);
+		}
+	}
+
+	// Picks each texel in 'mask' its nearest palette entry over channels [first, first +
+	// count) and returns their summed squared error.
+	float FitIndices(const Block& block, uint32 first, uint32 count, const float (*palette)[4], uint32 entries,
+		uint32 mask, uint8* indices)
+	{
+		float total = 0.0f;
+#ifdef BLOCKCOMPRESSION_SSE2
+		for (uint32 g = 0; g < 16; g += 4)
+		{
+			if (((mask >> g) & 0xF) == 0)
+				continue;
+
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128 bestIndex = _mm_setzero_ps();
+			for (uint32 k = 0; k < entries; ++k)
+			{
+				__m128 distance = _mm_setzero_ps();
+				for (uint32 c = first; c < first + count; ++c)
+				{
+					const __m128 difference = _mm_sub_ps(_mm_loadu_ps(block.V[c] + g), _mm_set1_ps(palette[k][c]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+				}
+				const __m128 closer = _mm_cmplt_ps(distance, best);
+				best = _mm_min_ps(distance, best);
+				bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)k)), _mm_andnot_ps(closer, bestIndex));
+			}
+
+			float errors[4], chosen[4];
+			_mm_storeu_ps(errors, best);
+			_mm_storeu_ps(chosen, bestIndex);
+			for (uint32 i = 0; i < 4; ++i)
+			{
+				if ((mask >> (g + i)) & 1)
+				{
+					indices[g + i] = (uint8)chosen[i];
+					total += errors[i];
+				}
+			}
+		}
+#else
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			if (((mask >> i) & 1) == 0)
+				continue;
+
+			float best = FLT_MAX;
+			for (uint32 k = 0; k < entries; ++k)
+			{
+				float distance = 0.0f;
+				for (uint32 c = first; c < first + count; ++c)
+					distance += (block.V[c][i] - palette[k][c]) * (block.V[c][i] - palette[k][c]);
+				if (distance < best)
+				{
+					best = distance;
+					indices[i] = (uint8)k;
+				}
+			}
+			total += best;
+		}
+#endif
+		return total;
+	}
+
+	// The endpoints that best fit the texels in 'mask' given their indices, where index k
+	// lies weights[k] of the way from e0 to e1.  False when every texel has the same weight.
+	bool LeastSquares(const Block& block, uint32 first, uint32 count, uint32 mask, const uint8* indices,
+		const float* weights, float e0[4], float e1[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			if (((mask >> i) & 1) == 0)
+				continue;
+			const float t = weights[indices[i]], s = 1.0f - t;
+			aa += s * s;
+			ab += s * t;
+			bb += t * t;
+			for (uint32 c = first; c < first + count; ++c)
+			{
+				ax[c] += s * block.V[c][i];
+				bx[c] += t * block.V[c][i];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+			return false;
+		for (uint32 c = first; c < first + count; ++c)
+		{
+			e0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+			e1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+		}
+		return true;
+	}
+
+	// The line through the texels in 'mask' that fits them best over channels [first,
+	// first + count), by power iteration on their covariance, with the extent of the texels
+	// along it as 'e0' and 'e1'.  Returns the texels' summed squared distance from the line.
+	float PrincipalAxis(const Block& block, uint32 first, uint32 count, uint32 mask, float e0[4], float e1[4])
+	{
+		float mean[4] = {};
+		float n = 0.0f;
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			if ((mask >> i) & 1)
+			{
+				for (uint32 c = first; c < first + count; ++c)
+					mean[c] += block.V[c][i];
+				n += 1.0f;
+			}
+		}
+		if (n == 0.0f)
+			return 0.0f;
+		for (uint32 c = first; c < first + count; ++c)
+			mean[c] /= n;
+
+		float covariance[4][4] = {};
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			if (((mask >> i) & 1) == 0)
+				continue;
+			for (uint32 c = first; c < first + count; ++c)
+			{
+				for (uint32 d = first; d < first + count; ++d)
+					covariance[c][d] += (block.V[c][i] - mean[c]) * (block.V[d][i] - mean[d]);
+			}
+		}
+
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = {};
+			float largest = 0.0f;
+			for (uint32 c = first; c < first + count; ++c)
+			{
+				for (uint32 d = first; d < first + count; ++d)
+					next[c] += covariance[c][d] * axis[d];
+				largest = std::max(largest, std::fabs(next[c]));
+			}
+			if (largest < 1e-6f)
+				break;
+			for (uint32 c = first; c < first + count; ++c)
+				axis[c] = next[c] / largest;
+		}
+		float length = 0.0f;
+		for (uint32 c = first; c < first + count; ++c)
+			length += axis[c] * axis[c];
+		length = std::sqrt(length);
+		for (uint32 c = first; c < first + count; ++c)
+			axis[c] = length > 0.0f ? axis[c] / length : 0.0f;
+
+		float low = FLT_MAX, high = -FLT_MAX, residual = 0.0f;
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			if (((mask >> i) & 1) == 0)
+				continue;
+			float t = 0.0f, distance = 0.0f;
+			for (uint32 c = first; c < first + count; ++c)
+			{
+				const float d = block.V[c][i] - mean[c];
+				t += d * axis[c];
+				distance += d * d;
+			}
+			low = std::min(low, t);
+			high = std::max(high, t);
+			residual += std::max(distance - t * t, 0.0f);
+		}
+		for (uint32 c = first; c < first + count; ++c)
+		{
+			e0[c] = std::min(std::max(mean[c] + axis[c] * low, 0.0f), 255.0f);
+			e1[c] = std::min(std::max(mean[c] + axis[c] * high, 0.0f), 255.0f);
+		}
+		return residual;
+	}
+
+	//
+	// BC1 and the color half of BC3
+	//
+
+	uint32 Pack565(const float color[4])
+	{
+		const uint32 r = (uint32)(color[0] * 31.0f / 255.0f + 0.5f);
+		const uint32 g = (uint32)(color[1] * 63.0f / 255.0f + 0.5f);
+		const uint32 b = (uint32)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (r << 11) | (g << 5) | b;
+	}
+
+	void Unpack565(uint32 packed, uint8 color[4])
+	{
+		const uint32 r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (uint8)((r << 3) | (r >> 2));
+		color[1] = (uint8)((g << 2) | (g >> 4));
+		color[2] = (uint8)((b << 3) | (b >> 2));
+		color[3] = 255;
+	}
+
+	// The colors a BC1 block's endpoints give.  'fourColors' for the color block of BC3,
+	// which has no three-color mode whatever the endpoint order.
+	void BC1Palette(uint32 c0, uint32 c1, bool fourColors, uint8 colors[4][4])
+	{
+		Unpack565(c0, colors[0]);
+		Unpack565(c1, colors[1]);
+		const uint8* a = colors[0];
+		const uint8* b = colors[1];
+		if (c0 > c1 || fourColors)
+		{
+			for (uint32 c = 0; c < 3; ++c)
+			{
+				colors[2][c] = (uint8)((2 * a[c] + b[c] + 1) / 3);
+				colors[3][c] = (uint8)((a[c] + 2 * b[c] + 1) / 3);
+			}
+			colors[2][3] = colors[3][3] = 255;
+		}
+		else
+		{
+			for (uint32 c = 0; c < 3; ++c)
+				colors[2][c] = (uint8)((a[c] + b[c] + 1) / 2);
+			colors[2][3] = 255;
+			memset(colors[3], 0, 4);
+		}
+	}
+
+	struct BC1Fit
+	{
+		uint32 C0 = 0;
+		uint32 C1 = 0;
+		uint8 Indices[16] = {};
+		float Error = FLT_MAX;
+	};
+
+	// Quantizes the endpoints and picks indices.  'threeColors' orders them for the mode
+	// with a transparent entry, which texels outside 'opaque' must use.
+	void TryBC1(const Block& block, uint32 opaque, bool threeColors, bool fourColors, const float e0[4],
+		const float e1[4], BC1Fit& best)
+	{
+		BC1Fit fit;
+		fit.C0 = Pack565(e0);
+		fit.C1 = Pack565(e1);
+		if ((fit.C0 < fit.C1) != threeColors && fit.C0 != fit.C1)
+			std::swap(fit.C0, fit.C1);
+
+		uint8 colors[4][4];
+		BC1Palette(fit.C0, fit.C1, fourColors, colors);
+		float palette[4][4];
+		for (uint32 k = 0; k < 4; ++k)
+		{
+			for (uint32 c = 0; c < 4; ++c)
+				palette[k][c] = colors[k][c];
+		}
+
+		const uint32 entries = fit.C0 > fit.C1 || fourColors ? 4 : 3;
+		fit.Error = FitIndices(block, 0, 3, palette, entries, opaque, fit.Indices);
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			if (((opaque >> i) & 1) == 0)
+				fit.Indices[i] = 3;
+		}
+		if (fit.Error < best.Error)
+			best = fit;
+	}
+
+	void EncodeBC1(const Block& block, bool high, bool alpha, uint8* out)
+	{
+		uint32 opaque = AllTexels;
+		if (alpha)
+		{
+			for (uint32 i = 0; i < 16; ++i)
+			{
+				if (block.V[3][i] < 128.0f)
+					opaque &= ~(1u << i);
+			}
+		}
+		const bool threeColors = opaque != AllTexels;
+
+		BC1Fit best;
+		if (opaque == 0)
+		{
+			best.C0 = best.C1 = 0;
+			memset(best.Indices, 3, 16);
+		}
+		else
+		{
+			// The bounding box diagonal, pulled in slightly, since the extremes are rarely
+			// worth an endpoint of their own.
+			float low[4] = { 255.0f, 255.0f, 255.0f, 255.0f }, high4[4] = {};
+			for (uint32 i = 0; i < 16; ++i)
+			{
+				if (((opaque >> i) & 1) == 0)
+					continue;
+				for (uint32 c = 0; c < 3; ++c)
+				{
+					low[c] = std::min(low[c], block.V[c][i]);
+					high4[c] = std::max(high4[c], block.V[c][i]);
+				}
+			}
+			float e0[4], e1[4];
+			for (uint32 c = 0; c < 3; ++c)
+			{
+				const float inset = (high4[c] - low[c]) / 16.0f;
+				e0[c] = high4[c] - inset;
+				e1[c] = low[c] + inset;
+			}
+			TryBC1(block, opaque, threeColors, !alpha, e0, e1, best);
+
+			if (high)
+			{
+				PrincipalAxis(block, 0, 3, opaque, e0, e1);
+				TryBC1(block, opaque, threeColors, !alpha, e1, e0, best);
+				if (!threeColors && alpha)
+					TryBC1(block, opaque, true, false, e1, e0, best);
+
+				// Index k of the four- and three-color palettes lies this far from C0.
+				const float fourWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+				const float threeWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+				for (int iteration = 0; iteration < 2; ++iteration)
+				{
+					const bool four = best.C0 > best.C1 || !alpha;
+					uint8 colors[4][4];
+					BC1Palette(best.C0, best.C1, !alpha, colors);
+					if (!LeastSquares(block, 0, 3, opaque, best.Indices, four ? fourWeights : threeWeights, e0, e1))
+						break;
+					TryBC1(block, opaque, !four, !alpha, e0, e1, best);
+				}
+			}
+		}
+
+		out[0] = (uint8)best.C0;
+		out[1] = (uint8)(best.C0 >> 8);
+		out[2] = (uint8)best.C1;
+		out[3] = (uint8)(best.C1 >> 8);
+		uint32 bits = 0;
+		for (uint32 i = 0; i < 16; ++i)
+			bits |= (uint32)best.Indices[i] << (2 * i);
+		memcpy(out + 4, &bits, 4);
+	}
+
+	void DecodeBC1(const uint8* in, bool fourColors, uint8 texels[16][4])
+	{
+		uint8 colors[4][4];
+		BC1Palette(in[0] | (in[1] << 8), in[2] | (in[3] << 8), fourColors, colors);
+		uint32 bits;
+		memcpy(&bits, in + 4, 4);
+		for (uint32 i = 0; i < 16; ++i)
+			memcpy(texels[i], colors[(bits >> (2 * i)) & 3], 4);
+	}
+
+	//
+	// BC4, the alpha half of BC3 and both halves of BC5
+	//
+
+	void BC4Palette(uint32 a0, uint32 a1, uint8 values[8])
+	{
+		values[0] = (uint8)a0;
+		values[1] = (uint8)a1;
+		if (a0 > a1)
+		{
+			for (uint32 i = 1; i < 7; ++i)
+				values[i + 1] = (uint8)(((7 - i) * a0 + i * a1 + 3) / 7);
+		}
+		else
+		{
+			for (uint32 i = 1; i < 5; ++i)
+				values[i + 1] = (uint8)(((5 - i) * a0 + i * a1 + 2) / 5);
+			values[6] = 0;
+			values[7] = 255;
+		}
+	}
+
+	struct BC4Fit
+	{
+		uint32 A0 = 0;
+		uint32 A1 = 0;
+		uint8 Indices[16] = {};
+		float Error = FLT_MAX;
+	};
+
+	void TryBC4(const Block& block, uint32 channel, uint32 a0, uint32 a1, BC4Fit& best)
+	{
+		uint8 values[8];
+		BC4Palette(a0, a1, values);
+		float palette[8][4];
+		for (uint32 k = 0; k < 8; ++k)
+			palette[k][channel] = values[k];
+
+		BC4Fit fit;
+		fit.A0 = a0;
+		fit.A1 = a1;
+		fit.Error = FitIndices(block, channel, 1, palette, 8, AllTexels, fit.Indices);
+		if (fit.Error < best.Error)
+			best = fit;
+	}
+
+	uint32 Round255(float v)
+	{
+		return (uint32)std::min(std::max(v + 0.5f, 0.0f), 255.0f);
+	}
+
+	void EncodeBC4(const Block& block, uint32 channel, bool high, uint8* out)
+	{
+		float low = 255.0f, top = 0.0f;
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			low = std::min(low, block.V[channel][i]);
+			top = std::max(top, block.V[channel][i]);
+		}
+
+		BC4Fit best;
+		TryBC4(block, channel, Round255(top), Round255(low), best);
+		if (high && top > low)
+		{
+			// Refine the eight-value mode, whose entries run from A0 to A1 in sevenths.
+			const float weights[8] = { 0.0f, 1.0f, 1 / 7.0f, 2 / 7.0f, 3 / 7.0f, 4 / 7.0f, 5 / 7.0f, 6 / 7.0f };
+			for (int iteration = 0; iteration < 2 && best.A0 > best.A1; ++iteration)
+			{
+				float e0[4], e1[4];
+				if (!LeastSquares(block, channel, 1, AllTexels, best.Indices, weights, e0, e1))
+					break;
+				const uint32 a0 = Round255(e0[channel]), a1 = Round255(e1[channel]);
+				if (a0 > a1)
+					TryBC4(block, channel, a0, a1, best);
+			}
+
+			// The six-value mode spends no entries on exact 0 and 255, so its range is what
+			// lies between them.
+			float innerLow = 255.0f, innerTop = 0.0f;
+			for (uint32 i = 0; i < 16; ++i)
+			{
+				const float v = block.V[channel][i];
+				if (v > 0.0f && v < 255.0f)
+				{
+					innerLow = std::min(innerLow, v);
+					innerTop = std::max(innerTop, v);
+				}
+			}
+			if (innerLow <= innerTop)
+				TryBC4(block, channel, Round255(innerLow), Round255(innerTop), best);
+		}
+
+		out[0] = (uint8)best.A0;
+		out[1] = (uint8)best.A1;
+		uint64_t bits = 0;
+		for (uint32 i = 0; i < 16; ++i)
+			bits |= (uint64_t)best.Indices[i] << (3 * i);
+		for (uint32 i = 0; i < 6; ++i)
+			out[2 + i] = (uint8)(bits >> (8 * i));
+	}
+
+	void DecodeBC4(const uint8* in, uint32 channel, uint8 texels[16][4])
+	{
+		uint8 values[8];
+		BC4Palette(in[0], in[1], values);
+		uint64_t bits = 0;
+		for (uint32 i = 0; i < 6; ++i)
+			bits |= (uint64_t)in[2 + i] << (8 * i);
+		for (uint32 i = 0; i < 16; ++i)
+			texels[i][channel] = values[(bits >> (3 * i)) & 7];
+	}
+
+	//
+	// BC7
+	//
+
+	struct ModeInfo
+	{
+		uint32 Subsets;
+		uint32 PartitionBits;
+		uint32 RotationBits;
+		uint32 IndexSelectionBits;
+		uint32 ColorBits;
+		uint32 AlphaBits;
+		uint32 EndpointPBits;
+		uint32 SharedPBits;
+		uint32 IndexBits;
+		uint32 Index2Bits;
+	};
+
+	const ModeInfo Modes[8] =
+	{
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+	};
+
+	// The partition tables of the BC7 format: a bit per texel for two subsets, and two bits
+	// per texel for three, texel 0 in the low bits.
+	const uint16 Partitions2[64] =
+	{
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+	};
+
+	const uint32 Partitions3[64] =
+	{
+		0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+		0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+		0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+		0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+		0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+		0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+		0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+		0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+	};
+
+	// The texel whose index drops its top bit, for the second subset of two and the second
+	// and third of three.  The first subset's is always texel 0.
+	const uint8 Anchors2[64] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+		15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+		 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+	};
+
+	const uint8 Anchors3Second[64] =
+	{
+		 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+		 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+		 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+		 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3
+	};
+
+	const uint8 Anchors3Third[64] =
+	{
+		15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+		15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+		15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+		15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8
+	};
+
+	const uint8 Weights2[4] = { 0, 21, 43, 64 };
+	const uint8 Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const uint8 Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	const uint8* WeightsFor(uint32 bits)
+	{
+		return bits == 2 ? Weights2 : bits == 3 ? Weights3 : Weights4;
+	}
+
+	uint32 SubsetOf(uint32 subsets, uint32 partition, uint32 texel)
+	{
+		if (subsets == 2)
+			return (Partitions2[partition] >> texel) & 1;
+		if (subsets == 3)
+			return (Partitions3[partition] >> (2 * texel)) & 3;
+		return 0;
+	}
+
+	uint32 AnchorOf(uint32 subsets, uint32 partition, uint32 subset)
+	{
+		if (subset == 0)
+			return 0;
+		if (subsets == 2)
+			return Anchors2[partition];
+		return subset == 1 ? Anchors3Second[partition] : Anchors3Third[partition];
+	}
+
+	// The texels of each subset of each partition as bit masks, built on first use.
+	struct SubsetMasks
+	{
+		uint16 Two[64][2];
+		uint16 Three[64][3];
+
+		SubsetMasks()
+		{
+			memset(this, 0, sizeof(*this));
+			for (uint32 p = 0; p < 64; ++p)
+			{
+				for (uint32 i = 0; i < 16; ++i)
+				{
+					Two[p][SubsetOf(2, p, i)] |= (uint16)(1u << i);
+					Three[p][SubsetOf(3, p, i)] |= (uint16)(1u << i);
+				}
+			}
+		}
+	};
+
+	uint32 SubsetMask(uint32 subsets, uint32 partition, uint32 subset)
+	{
+		static const SubsetMasks masks;
+		if (subsets == 2)
+			return masks.Two[partition][subset];
+		if (subsets == 3)
+			return masks.Three[partition][subset];
+		return AllTexels;
+	}
+
+	uint8 Interpolate(uint32 e0, uint32 e1, uint32 weight)
+	{
+		return (uint8)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+	}
+
+	// An endpoint channel of 'bits' bits (p-bit included) widened to 8 by repeating its
+	// top bits.
+	uint32 Expand(uint32 value, uint32 bits)
+	{
+		return bits >= 8 ? value : (value << (8 - bits)) | (value >> (2 * bits - 8));
+	}
+
+	struct BitWriter
+	{
+		uint8* Out;
+		uint32 Position = 0;
+
+		void Write(uint32 value, uint32 bits)
+		{
+			for (uint32 i = 0; i < bits; ++i, ++Position)
+				Out[Position >> 3] |= (uint8)(((value >> i) & 1) << (Position & 7));
+		}
+	};
+
+	struct BitReader
+	{
+		const uint8* In;
+		uint32 Position = 0;
+
+		uint32 Read(uint32 bits)
+		{
+			uint32 value = 0;
+			for (uint32 i = 0; i < bits; ++i, ++Position)
+				value |= (uint32)((In[Position >> 3] >> (Position & 7)) & 1) << i;
+			return value;
+		}
+	};
+
+	void DecodeBC7(const uint8* in, uint8 texels[16][4])
+	{
+		uint32 mode = 0;
+		while (mode < 8 && ((in[0] >> mode) & 1) == 0)
+			++mode;
+		if (mode == 8)
+		{
+			memset(texels, 0, 64);
+			return;
+		}
+
+		const ModeInfo& info = Modes[mode];
+		BitReader reader = { in };
+		reader.Read(mode + 1);
+		const uint32 partition = reader.Read(info.PartitionBits);
+		const uint32 rotation = reader.Read(info.RotationBits);
+		const uint32 indexSelection = reader.Read(info.IndexSelectionBits);
+
+		uint32 endpoints[3][2][4] = {};
+		for (uint32 c = 0; c < 3; ++c)
+		{
+			for (uint32 s = 0; s < info.Subsets; ++s)
+			{
+				endpoints[s][0][c] = reader.Read(info.ColorBits);
+				endpoints[s][1][c] = reader.Read(info.ColorBits);
+			}
+		}
+		for (uint32 s = 0; s < info.Subsets && info.AlphaBits > 0; ++s)
+		{
+			endpoints[s][0][3] = reader.Read(info.AlphaBits);
+			endpoints[s][1][3] = reader.Read(info.AlphaBits);
+		}
+
+		uint32 pbits[3][2] = {};
+		for (uint32 s = 0; s < info.Subsets; ++s)
+		{
+			if (info.EndpointPBits)
+			{
+				pbits[s][0] = reader.Read(1);
+				pbits[s][1] = reader.Read(1);
+			}
+			else if (info.SharedPBits)
+			{
+				pbits[s][0] = pbits[s][1] = reader.Read(1);
+			}
+		}
+
+		const uint32 pbit = info.EndpointPBits | info.SharedPBits;
+		for (uint32 s = 0; s < info.Subsets; ++s)
+		{
+			for (uint32 e = 0; e < 2; ++e)
+			{
+				for (uint32 c = 0; c < 3; ++c)
+					endpoints[s][e][c] = Expand((endpoints[s][e][c] << pbit) | (pbit ? pbits[s][e] : 0), info.ColorBits + pbit);
+				endpoints[s][e][3] = info.AlphaBits == 0 ? 255 :
+					Expand((endpoints[s][e][3] << pbit) | (pbit ? pbits[s][e] : 0), info.AlphaBits + pbit);
+			}
+		}
+
+		uint32 indices[16], indices2[16] = {};
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			const uint32 subset = SubsetOf(info.Subsets, partition, i);
+			indices[i] = reader.Read(info.IndexBits - (i == AnchorOf(info.Subsets, partition, subset) ? 1 : 0));
+		}
+		for (uint32 i = 0; i < 16 && info.Index2Bits > 0; ++i)
+			indices2[i] = reader.Read(info.Index2Bits - (i == 0 ? 1 : 0));
+
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			const uint32(&e)[2][4] = endpoints[SubsetOf(info.Subsets, partition, i)];
+			uint32 colorIndex = indices[i], colorBits = info.IndexBits;
+			uint32 alphaIndex = indices[i], alphaBits = info.IndexBits;
+			if (info.Index2Bits > 0)
+			{
+				alphaIndex = indices2[i];
+				alphaBits = info.Index2Bits;
+				if (indexSelection)
+				{
+					std::swap(colorIndex, alphaIndex);
+					std::swap(colorBits, alphaBits);
+				}
+			}
+
+			for (uint32 c = 0; c < 3; ++c)
+				texels[i][c] = Interpolate(e[0][c], e[1][c], WeightsFor(colorBits)[colorIndex]);
+			texels[i][3] = Interpolate(e[0][3], e[1][3], WeightsFor(alphaBits)[alphaIndex]);
+			if (rotation > 0)
+				std::swap(texels[i][rotation - 1], texels[i][3]);
+		}
+	}
+
+	// One subset's endpoints as stored, before the p-bits are appended.
+	struct SubsetFit
+	{
+		uint32 Stored[2][4] = {};
+		uint32 PBits[2] = {};
+	};
+
+	// A candidate encoding of a block in one mode.
+	struct BC7Fit
+	{
+		uint32 Mode = 0;
+		uint32 Partition = 0;
+		uint32 Rotation = 0;
+		uint32 IndexSelection = 0;
+		SubsetFit Subsets[3];
+		uint8 ColorIndices[16] = {};
+		uint8 AlphaIndices[16] = {};
+	};
+
+	uint32 ChannelBits(const ModeInfo& info, uint32 channel)
+	{
+		return channel < 3 ? info.ColorBits : info.AlphaBits;
+	}
+
+	// The stored value whose expansion with p-bit 'pbit' (or none, for -1) is nearest 'v'.
+	uint32 Quantize(float v, uint32 bits, int pbit)
+	{
+		const uint32 top = (1u << bits) - 1;
+		if (pbit < 0)
+			return std::min((uint32)(v * top / 255.0f + 0.5f), top);
+		const float scaled = v * ((1u << (bits + 1)) - 1) / 255.0f;
+		return (uint32)std::min(std::max(std::floor((scaled - pbit) / 2.0f + 0.5f), 0.0f), (float)top);
+	}
+
+	// Fits channels [first, first + count) of the texels in 'mask' to endpoints near e0 and
+	// e1: each p-bit choice is quantized and indexed, and the best kept in 'fit' and
+	// 'indices'.  Returns its error.
+	float FitSubset(const Block& block, const ModeInfo& info, uint32 first, uint32 count, uint32 indexBits,
+		uint32 mask, const float e0[4], const float e1[4], SubsetFit& fit, uint8* indices)
+	{
+		const uint32 pbitChoices = info.EndpointPBits ? 4 : info.SharedPBits ? 2 : 1;
+		const uint32 pbit = info.EndpointPBits | info.SharedPBits;
+		const uint8* weights = WeightsFor(indexBits);
+		const uint32 entries = 1u << indexBits;
+
+		float best = FLT_MAX;
+		for (uint32 choice = 0; choice < pbitChoices; ++choice)
+		{
+			SubsetFit trial = fit;
+			trial.PBits[0] = info.EndpointPBits ? choice & 1 : choice;
+			trial.PBits[1] = info.EndpointPBits ? choice >> 1 : choice;
+
+			uint32 expanded[2][4] = {};
+			for (uint32 c = first; c < first + count; ++c)
+			{
+				const uint32 bits = ChannelBits(info, c);
+				for (uint32 e = 0; e < 2; ++e)
+				{
+					trial.Stored[e][c] = Quantize(e == 0 ? e0[c] : e1[c], bits, pbit ? (int)trial.PBits[e] : -1);
+					expanded[e][c] = Expand((trial.Stored[e][c] << pbit) | (pbit ? trial.PBits[e] : 0), bits + pbit);
+				}
+			}
+
+			float palette[16][4];
+			for (uint32 k = 0; k < entries; ++k)
+			{
+				for (uint32 c = first; c < first + count; ++c)
+					palette[k][c] = Interpolate(expanded[0][c], expanded[1][c], weights[k]);
+			}
+
+			uint8 trialIndices[16];
+			const float error = FitIndices(block, first, count, palette, entries, mask, trialIndices);
+			if (error < best)
+			{
+				best = error;
+				fit = trial;
+				for (uint32 i = 0; i < 16; ++i)
+				{
+					if ((mask >> i) & 1)
+						indices[i] = trialIndices[i];
+				}
+			}
+		}
+		return best;
+	}
+
+	// Principal axis endpoints, then least-squares refits from the indices they give.
+	void FitChannels(const Block& block, const ModeInfo& info, uint32 first, uint32 count, uint32 indexBits,
+		uint32 mask, int refinements, SubsetFit& fit, uint8* indices)
+	{
+		float e0[4], e1[4];
+		PrincipalAxis(block, first, count, mask, e0, e1);
+		float error = FitSubset(block, info, first, count, indexBits, mask, e0, e1, fit, indices);
+
+		float weights[16];
+		for (uint32 k = 0; k < (1u << indexBits); ++k)
+			weights[k] = WeightsFor(indexBits)[k] / 64.0f;
+		for (int iteration = 0; iteration < refinements && error > 0.0f; ++iteration)
+		{
+			if (!LeastSquares(block, first, count, mask, indices, weights, e0, e1))
+				break;
+			SubsetFit trial = fit;
+			uint8 trialIndices[16];
+			memcpy(trialIndices, indices, 16);
+			const float trialError = FitSubset(block, info, first, count, indexBits, mask, e0, e1, trial, trialIndices);
+			if (trialError >= error)
+				break;
+			error = trialError;
+			fit = trial;
+			memcpy(indices, trialIndices, 16);
+		}
+	}
+
+	// Anchor texels store their index without its top bit, which must therefore be 0;
+	// swapping a subset's endpoints flips its indices to make it so.
+	void FixAnchors(BC7Fit& fit)
+	{
+		const ModeInfo& info = Modes[fit.Mode];
+		uint32 colorBits = info.IndexBits, alphaBits = info.Index2Bits;
+		if (fit.IndexSelection)
+			std::swap(colorBits, alphaBits);
+		const bool separateAlpha = info.Index2Bits > 0;
+
+		for (uint32 s = 0; s < info.Subsets; ++s)
+		{
+			const uint32 anchor = AnchorOf(info.Subsets, fit.Partition, s);
+			const uint32 colorTop = 1u << (colorBits - 1);
+			if (fit.ColorIndices[anchor] & colorTop)
+			{
+				SubsetFit& subset = fit.Subsets[s];
+				const uint32 last = separateAlpha ? 3 : 4;
+				for (uint32 c = 0; c < last; ++c)
+					std::swap(subset.Stored[0][c], subset.Stored[1][c]);
+				std::swap(subset.PBits[0], subset.PBits[1]);
+				for (uint32 i = 0; i < 16; ++i)
+				{
+					if (SubsetOf(info.Subsets, fit.Partition, i) == s)
+						fit.ColorIndices[i] = (uint8)((colorTop * 2 - 1) - fit.ColorIndices[i]);
+				}
+			}
+		}
+
+		if (separateAlpha && (fit.AlphaIndices[0] & (1u << (alphaBits - 1))))
+		{
+			std::swap(fit.Subsets[0].Stored[0][3], fit.Subsets[0].Stored[1][3]);
+			for (uint32 i = 0; i < 16; ++i)
+				fit.AlphaIndices[i] = (uint8)(((1u << alphaBits) - 1) - fit.AlphaIndices[i]);
+		}
+	}
+
+	void PackBC7(const BC7Fit& fit, uint8* out)
+	{
+		const ModeInfo& info = Modes[fit.Mode];
+		memset(out, 0, 16);
+		BitWriter writer = { out };
+		writer.Write(1u << fit.Mode, fit.Mode + 1);
+		writer.Write(fit.Partition, info.PartitionBits);
+		writer.Write(fit.Rotation, info.RotationBits);
+		writer.Write(fit.IndexSelection, info.IndexSelectionBits);
+
+		for (uint32 c = 0; c < 3; ++c)
+		{
+			for (uint32 s = 0; s < info.Subsets; ++s)
+			{
+				writer.Write(fit.Subsets[s].Stored[0][c], info.ColorBits);
+				writer.Write(fit.Subsets[s].Stored[1][c], info.ColorBits);
+			}
+		}
+		for (uint32 s = 0; s < info.Subsets && info.AlphaBits > 0; ++s)
+		{
+			writer.Write(fit.Subsets[s].Stored[0][3], info.AlphaBits);
+			writer.Write(fit.Subsets[s].Stored[1][3], info.AlphaBits);
+		}
+		for (uint32 s = 0; s < info.Subsets; ++s)
+		{
+			if (info.EndpointPBits)
+			{
+				writer.Write(fit.Subsets[s].PBits[0], 1);
+				writer.Write(fit.Subsets[s].PBits[1], 1);
+			}
+			else if (info.SharedPBits)
+			{
+				writer.Write(fit.Subsets[s].PBits[0], 1);
+			}
+		}
+
+		// With separate alpha, the first set holds the two-bit indices.
+		const uint8* first = fit.ColorIndices;
+		const uint8* second = fit.AlphaIndices;
+		if (fit.IndexSelection)
+			std::swap(first, second);
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			const uint32 subset = SubsetOf(info.Subsets, fit.Partition, i);
+			writer.Write(first[i], info.IndexBits - (i == AnchorOf(info.Subsets, fit.Partition, subset) ? 1 : 0));
+		}
+		for (uint32 i = 0; i < 16 && info.Index2Bits > 0; ++i)
+			writer.Write(second[i], info.Index2Bits - (i == 0 ? 1 : 0));
+	}
+
+	// Encodes the block in one mode, partition, rotation and index selection, and returns
+	// the squared error of what decodes.
+	float TryBC7(const Block& source, uint32 mode, uint32 partition, uint32 rotation, uint32 indexSelection,
+		int refinements, uint8* out)
+	{
+		const ModeInfo& info = Modes[mode];
+		Block block = source;
+		if (rotation > 0)
+			std::swap(block.V[rotation - 1], block.V[3]);
+
+		BC7Fit fit;
+		fit.Mode = mode;
+		fit.Partition = partition;
+		fit.Rotation = rotation;
+		fit.IndexSelection = indexSelection;
+
+		if (info.Index2Bits > 0)
+		{
+			const uint32 colorBits = indexSelection ? info.Index2Bits : info.IndexBits;
+			const uint32 alphaBits = indexSelection ? info.IndexBits : info.Index2Bits;
+			FitChannels(block, info, 0, 3, colorBits, AllTexels, refinements, fit.Subsets[0], fit.ColorIndices);
+			FitChannels(block, info, 3, 1, alphaBits, AllTexels, refinements, fit.Subsets[0], fit.AlphaIndices);
+		}
+		else
+		{
+			// Modes without alpha decode it as 255.
+			const uint32 count = info.AlphaBits > 0 ? 4 : 3;
+			for (uint32 s = 0; s < info.Subsets; ++s)
+			{
+				FitChannels(block, info, 0, count, info.IndexBits, SubsetMask(info.Subsets, partition, s), refinements,
+					fit.Subsets[s], fit.ColorIndices);
+			}
+		}
+
+		FixAnchors(fit);
+		PackBC7(fit, out);
+
+		uint8 texels[16][4];
+		DecodeBC7(out, texels);
+		float error = 0.0f;
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				const float d = texels[i][c] - source.V[c][i];
+				error += d * d;
+			}
+		}
+		return error;
+	}
+
+	// The sums over a set of texels of 1, each channel, and each pairwise product of
+	// channels (upper triangle), padded to a whole number of SSE registers.
+	struct Moments
+	{
+		float M[16];
+	};
+
+	void AddMoments(const Moments* products, uint32 mask, Moments& sum)
+	{
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			if ((mask >> i) & 1)
+			{
+#ifdef BLOCKCOMPRESSION_SSE2
+				for (uint32 k = 0; k < 16; k += 4)
+					_mm_storeu_ps(sum.M + k, _mm_add_ps(_mm_loadu_ps(sum.M + k), _mm_loadu_ps(products[i].M + k)));
+#else
+				for (uint32 k = 0; k < 16; ++k)
+					sum.M[k] += products[i].M[k];
+#endif
+			}
+		}
+	}
+
+	// How far the texels summed in 'moments' lie from their principal axis over the first
+	// 'channels' channels, squared: the covariance's trace less its largest eigenvalue.
+	float LineResidual(const Moments& moments, uint32 channels)
+	{
+		const float n = moments.M[0];
+		if (n < 0.5f)
+			return 0.0f;
+
+		float covariance[4][4];
+		uint32 k = 5;
+		for (uint32 c = 0; c < 4; ++c)
+		{
+			for (uint32 d = c; d < 4; ++d, ++k)
+				covariance[c][d] = covariance[d][c] = moments.M[k] - moments.M[1 + c] * moments.M[1 + d] / n;
+		}
+
+		// Power iteration from the row of the widest channel, which is already near the axis
+		// for most blocks; the Rayleigh quotient's error is the square of the axis's.
+		float axis[4], trace = 0.0f;
+		uint32 widest = 0;
+		for (uint32 c = 0; c < channels; ++c)
+		{
+			trace += covariance[c][c];
+			widest = covariance[c][c] > covariance[widest][widest] ? c : widest;
+		}
+		for (uint32 c = 0; c < channels; ++c)
+			axis[c] = covariance[widest][c];
+		for (int iteration = 0; iteration < 3; ++iteration)
+		{
+			float next[4] = {}, largest = 0.0f;
+			for (uint32 c = 0; c < channels; ++c)
+			{
+				for (uint32 d = 0; d < channels; ++d)
+					next[c] += covariance[c][d] * axis[d];
+				largest = std::max(largest, std::fabs(next[c]));
+			}
+			if (largest < 1e-6f)
+				return trace;
+			for (uint32 c = 0; c < channels; ++c)
+				axis[c] = next[c] / largest;
+		}
+
+		float numerator = 0.0f, denominator = 0.0f;
+		for (uint32 c = 0; c < channels; ++c)
+		{
+			float row = 0.0f;
+			for (uint32 d = 0; d < channels; ++d)
+				row += covariance[c][d] * axis[d];
+			numerator += axis[c] * row;
+			denominator += axis[c] * axis[c];
+		}
+		return std::max(trace - numerator / denominator, 0.0f);
+	}
+
+	// Every partition for 'subsets' subsets ranked by how close to lines their texels lie
+	// over the first 'channels' channels, best first.  The last subset's moments are the
+	// block's less the others', so each partition costs one or two passes over its texels.
+	void RankPartitions(const Block& block, uint32 subsets, uint32 channels, std::pair<float, uint32>* ranked)
+	{
+		Moments products[16], total = {};
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			Moments& p = products[i];
+			p.M[0] = 1.0f;
+			uint32 k = 5;
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				p.M[1 + c] = block.V[c][i];
+				for (uint32 d = c; d < 4; ++d, ++k)
+					p.M[k] = block.V[c][i] * block.V[d][i];
+			}
+			p.M[15] = 0.0f;
+		}
+		AddMoments(products, AllTexels, total);
+
+		for (uint32 partition = 0; partition < 64; ++partition)
+		{
+			Moments last = total;
+			float residual = 0.0f;
+			for (uint32 s = 0; s + 1 < subsets; ++s)
+			{
+				Moments subset = {};
+				AddMoments(products, SubsetMask(subsets, partition, s), subset);
+				residual += LineResidual(subset, channels);
+				for (uint32 k = 0; k < 16; ++k)
+					last.M[k] -= subset.M[k];
+			}
+			ranked[partition] = { residual + LineResidual(last, channels), partition };
+		}
+		std::sort(ranked, ranked + 64);
+	}
+
+	void EncodeBC7(const Block& block, bool high, uint8* out)
+	{
+		bool opaque = true;
+		for (uint32 i = 0; i < 16; ++i)
+			opaque = opaque && block.V[3][i] == 255.0f;
+
+		float best = TryBC7(block, 6, 0, 0, 0, high ? 2 : 1, out);
+		if (!high || best == 0.0f)
+			return;
+
+		uint8 trial[16];
+		auto consider = [&](uint32 mode, uint32 partition, uint32 rotation, uint32 indexSelection)
+		{
+			const float error = TryBC7(block, mode, partition, rotation, indexSelection, 2, trial);
+			if (error < best)
+			{
+				best = error;
+				memcpy(out, trial, 16);
+			}
+		};
+
+		// The partitioned modes are tried on the partitions whose subsets suit them best.
+		// Mode 0 has only the first 16 three-subset partitions.
+		std::pair<float, uint32> ranked[64];
+		if (opaque)
+		{
+			RankPartitions(block, 2, 3, ranked);
+			for (uint32 i = 0; i < 4; ++i)
+				consider(1, ranked[i].second, 0, 0);
+			for (uint32 i = 0; i < 2; ++i)
+				consider(3, ranked[i].second, 0, 0);
+
+			RankPartitions(block, 3, 3, ranked);
+			for (uint32 i = 0; i < 2; ++i)
+				consider(2, ranked[i].second, 0, 0);
+			for (uint32 i = 0, tried = 0; i < 64 && tried < 2; ++i)
+			{
+				if (ranked[i].second < 16)
+				{
+					consider(0, ranked[i].second, 0, 0);
+					++tried;
+				}
+			}
+		}
+		else
+		{
+			for (uint32 rotation = 0; rotation < 4; ++rotation)
+			{
+				consider(5, 0, rotation, 0);
+				consider(4, 0, rotation, 0);
+				consider(4, 0, rotation, 1);
+			}
+			RankPartitions(block, 2, 4, ranked);
+			for (uint32 i = 0; i < 4; ++i)
+				consider(7, ranked[i].second, 0, 0);
+		}
+	}
+
+	//
+	// Surfaces
+	//
+
+	void EncodeBlock(DXGI_FORMAT format, const Block& block, bool high, uint8* out)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			EncodeBC1(block, high, true, out);
+			break;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			EncodeBC4(block, 3, high, out);
+			EncodeBC1(block, high, false, out + 8);
+			break;
+		case DXGI_FORMAT_BC4_UNORM:
+			EncodeBC4(block, 0, high, out);
+			break;
+		case DXGI_FORMAT_BC5_UNORM:
+			EncodeBC4(block, 0, high, out);
+			EncodeBC4(block, 1, high, out + 8);
+			break;
+		default:
+			EncodeBC7(block, high, out);
+			break;
+		}
+	}
+
+	void DecodeBlock(DXGI_FORMAT format, const uint8* in, uint8 texels[16][4])
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			DecodeBC1(in, false, texels);
+			break;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			DecodeBC1(in + 8, true, texels);
+			DecodeBC4(in, 3, texels);
+			break;
+		case DXGI_FORMAT_BC4_UNORM:
+		case DXGI_FORMAT_BC5_UNORM:
+			for (uint32 i = 0; i < 16; ++i)
+			{
+				texels[i][1] = texels[i][2] = 0;
+				texels[i][3] = 255;
+			}
+			DecodeBC4(in, 0, texels);
+			if (format == DXGI_FORMAT_BC5_UNORM)
+				DecodeBC4(in + 8, 1, texels);
+			break;
+		default:
+			DecodeBC7(in, texels);
+			break;
+		}
+	}
+
+	// Source formats Compress() takes, and how their texels widen to RGBA.
+	enum class Source
+	{
+		None,
+		RGBA,
+		BGRA,
+		BGRX,
+		R,
+		RG
+	};
+
+	Source SourceOf(DXGI_FORMAT format, bool& srgb)
+	{
+		srgb = format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ||
+			format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+		switch (format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			return Source::RGBA;
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			return Source::BGRA;
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			return Source::BGRX;
+		case DXGI_FORMAT_R8_UNORM:
+			return Source::R;
+		case DXGI_FORMAT_R8G8_UNORM:
+			return Source::RG;
+		default:
+			return Source::None;
+		}
+	}
+
+	void WidenRow(const uint8* in, uint32 width, Source source, uint8* out)
+	{
+		for (uint32 x = 0; x < width; ++x, out += 4)
+		{
+			switch (source)
+			{
+			case Source::RGBA:
+				memcpy(out, in + x * 4, 4);
+				break;
+			case Source::BGRA:
+			case Source::BGRX:
+				out[0] = in[x * 4 + 2];
+				out[1] = in[x * 4 + 1];
+				out[2] = in[x * 4 + 0];
+				out[3] = source == Source::BGRA ? in[x * 4 + 3] : 255;
+				break;
+			case Source::R:
+				out[0] = in[x];
+				out[1] = out[2] = 0;
+				out[3] = 255;
+				break;
+			default:
+				out[0] = in[x * 2];
+				out[1] = in[x * 2 + 1];
+				out[2] = 0;
+				out[3] = 255;
+				break;
+			}
+		}
+	}
+
+	DXGI_FORMAT WithSRGB(DXGI_FORMAT format, bool srgb)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+		default:
+			return format;
+		}
+	}
+
+	bool IsSRGB(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_BC1_UNORM_SRGB || format == DXGI_FORMAT_BC3_UNORM_SRGB ||
+			format == DXGI_FORMAT_BC7_UNORM_SRGB;
+	}
+
+	// 'out' as a DDS like 'info' in 'format', with room for its texels, and 'outInfo' laid
+	// out over it.
+	bool StartFile(const DDSFile::Info& info, DXGI_FORMAT format, std::vector<uint8>& out, DDSFile::Info& outInfo,
+		std::string* error)
+	{
+		outInfo = info;
+		outInfo.Format = format;
+		out.clear();
+		DDSFile::WriteHeader(outInfo, out);
+
+		size_t dataBytes = 0;
+		for (uint32 mip = 0; mip < info.MipCount; ++mip)
+		{
+			size_t bytes = 0;
+			DDSFile::SurfaceInfo(std::max(info.Width >> mip, 1u), std::max(info.Height >> mip, 1u), format, &bytes,
+				nullptr, nullptr);
+			dataBytes += bytes;
+		}
+		out.resize(out.size() + dataBytes * info.ArraySize);
+		return DDSFile::Parse(out.data(), out.size(), out.size(), outInfo, 0, error);
+	}
+}
+
+bool BlockCompression::IsSupported(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool BlockCompression::CanCompress(const DDSFile::Info& info)
+{
+	bool srgb;
+	return SourceOf(info.Format, srgb) != Source::None && info.ResourceDimension == DDSFile::Texture2D &&
+		!info.IsCubeMap && info.Width % 4 == 0 && info.Height % 4 == 0;
+}
+
+size_t BlockCompression::BlockBytes(DXGI_FORMAT format)
+{
+	return format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB || format == DXGI_FORMAT_BC4_UNORM ?
+		8 : 16;
+}
+
+void BlockCompression::Encode(const std::uint8_t* rgba, uint32 width, uint32 height, size_t pitch, DXGI_FORMAT format,
+	std::uint8_t* blocks, const Options& options)
+{
+	const uint32 blocksWide = (width + 3) / 4;
+	const size_t count = (size_t)blocksWide * ((height + 3) / 4);
+	const size_t blockBytes = BlockBytes(format);
+	const bool high = options.Mode == High;
+
+	auto encode = [&](size_t, size_t first, size_t last)
+	{
+		Block block;
+		for (size_t i = first; i < last; ++i)
+		{
+			LoadBlock(rgba, width, height, pitch, (uint32)(i % blocksWide), (uint32)(i / blocksWide), block);
+			EncodeBlock(format, block, high, blocks + i * blockBytes);
+		}
+	};
+
+	// BC7 blocks take far longer to search than the others.
+	const bool slow = high && (format == DXGI_FORMAT_BC7_UNORM || format == DXGI_FORMAT_BC7_UNORM_SRGB);
+	if (options.Parallel)
+		ParallelFor::ForChunks(count, slow ? 16 : 256, encode);
+	else
+		encode(0, 0, count);
+}
+
+void BlockCompression::Decode(const std::uint8_t* blocks, uint32 width, uint32 height, DXGI_FORMAT format,
+	std::uint8_t* rgba, size_t pitch)
+{
+	const uint32 blocksWide = (width + 3) / 4;
+	const size_t count = (size_t)blocksWide * ((height + 3) / 4);
+	const size_t blockBytes = BlockBytes(format);
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint8 texels[16][4];
+		DecodeBlock(format, blocks + i * blockBytes, texels);
+		StoreBlock(texels, width, height, pitch, (uint32)(i % blocksWide), (uint32)(i / blocksWide), rgba);
+	}
+}
+
+bool BlockCompression::Compress(const void* dds, size_t size, DXGI_FORMAT format, std::vector<std::uint8_t>& out,
+	const Options& options, Stats* stats, std::string* error)
+{
+	auto start = Clock::now();
+	DDSFile::Info info;
+	if (!DDSFile::Parse(dds, size, size, info, 0, error))
+		return false;
+	if (!IsSupported(format))
+		return Fail(error, "format " + std::to_string(format) + " is not a block format this encodes");
+
+	if (!CanCompress(info))
+		return Fail(error, "block compression takes 2D textures in 8-bit RGBA, BGRA, R or RG formats, with a width and "
+			"height that are multiples of 4");
+
+	bool srgb;
+	const Source source = SourceOf(info.Format, srgb);
+	DDSFile::Info outInfo;
+	if (!StartFile(info, WithSRGB(format, srgb), out, outInfo, error))
+		return false;
+
+	Stats total;
+	const uint8* bytes = static_cast<const uint8*>(dds);
+	std::vector<uint8> rgba;
+	for (size_t i = 0; i < info.Subresources.size(); ++i)
+	{
+		const DDSFile::Subresource& from = info.Subresources[i];
+		rgba.resize((size_t)from.Width * from.Height * 4);
+		for (uint32 y = 0; y < from.Height; ++y)
+			WidenRow(bytes + from.Offset + y * from.RowBytes, from.Width, source, rgba.data() + (size_t)y * from.Width * 4);
+
+		Encode(rgba.data(), from.Width, from.Height, (size_t)from.Width * 4, outInfo.Format,
+			out.data() + outInfo.Subresources[i].Offset, options);
+		total.Blocks += (uint64)((from.Width + 3) / 4) * ((from.Height + 3) / 4);
+		total.SourceBytes += rgba.size();
+	}
+
+	if (stats != nullptr)
+	{
+		*stats = total;
+		stats->Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+	return true;
+}
+
+bool BlockCompression::Decompress(const void* dds, size_t size, std::vector<std::uint8_t>& out, std::string* error)
+{
+	DDSFile::Info info;
+	if (!DDSFile::Parse(dds, size, size, info, 0, error))
+		return false;
+	if (!IsSupported(info.Format))
+		return Fail(error, "format " + std::to_string(info.Format) + " is not a block format this decodes");
+
+	DDSFile::Info outInfo;
+	const DXGI_FORMAT format = IsSRGB(info.Format) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+	if (!StartFile(info, format, out, outInfo, error))
+		return false;
+
+	const uint8* bytes = static_cast<const uint8*>(dds);
+	for (size_t i = 0; i < info.Subresources.size(); ++i)
+	{
+		const DDSFile::Subresource& from = info.Subresources[i];
+		const DDSFile::Subresource& to = outInfo.Subresources[i];
+		for (uint32 z = 0; z < from.Depth; ++z)
+		{
+			Decode(bytes + from.Offset + z * from.SliceBytes, from.Width, from.Height, info.Format,
+				out.data() + to.Offset + z * to.SliceBytes, to.RowBytes);
+		}
+	}
+	return true;
+}
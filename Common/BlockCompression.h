@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dxgiformat.h>
+#include "DDSFile.h"
+
+// BC1, BC3, BC4, BC5 and BC7 block compression and decompression on the CPU.  A texture
+// that reaches the GPU uncompressed costs four to eight times the memory and bandwidth
+// of its blocks, and the loaders can only upload what the file holds, so Tools/AssetCooker
+// compresses textures here.  The decoders give the texels a GPU would, for checking the
+// encoders and for software paths.
+//
+// Every 4x4 block is encoded on its own, so the blocks of a surface are split across
+// ParallelFor workers.  Within a block, the search for each texel's nearest palette entry
+// runs four texels per SSE operation.  Platform-independent: cooks run on Linux.
+class BlockCompression
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	enum Quality
+	{
+		// One endpoint fit per block, and BC7 mode 6 only: for iteration.
+		Fast,
+		// Refined endpoints, both BC1 and BC4 palette modes, and for BC7 the partitioned
+		// and separate-alpha modes as well, each tried on its most promising partitions.
+		High
+	};
+
+	struct Options
+	{
+		Options() :
+			Mode(High),
+			Parallel(true) {}
+
+		Quality Mode;
+		// Off when the caller already runs one texture per worker.
+		bool Parallel;
+	};
+
+	struct Stats
+	{
+		uint64 Blocks = 0;
+		// Of the texels encoded, as 8-bit RGBA.
+		uint64 SourceBytes = 0;
+		double Milliseconds = 0.0;
+	};
+
+	// The formats Encode() writes and Decode() reads: BC1, BC3 and BC7 (UNORM and sRGB),
+	// and BC4 and BC5 UNORM.
+	static bool IsSupported(DXGI_FORMAT format);
+
+	// Bytes per 4x4 block of a supported format: 8 or 16.
+	static size_t BlockBytes(DXGI_FORMAT format);
+
+	// Encodes a width x height image of 8-bit RGBA texels, rows 'pitch' bytes apart, into
+	// row-major blocks.  Blocks past the right or bottom edge repeat the edge texels.
+	// BC1 keeps texels with alpha below 128 transparent; BC4 encodes red and BC5 red and
+	// green.
+	static void Encode(const std::uint8_t* rgba, uint32 width, uint32 height, size_t pitch, DXGI_FORMAT format,
+		std::uint8_t* blocks, const Options& options = Options());
+
+	// The inverse: BC4 gives (r, 0, 0, 255) and BC5 (r, g, 0, 255), as a GPU samples them.
+	static void Decode(const std::uint8_t* blocks, uint32 width, uint32 height, DXGI_FORMAT format,
+		std::uint8_t* rgba, size_t pitch);
+
+	// A 2D texture or array in an 8-bit RGBA, BGRA, R or RG format with a width and height
+	// that are multiples of 4: what the cooker gives Compress().
+	static bool CanCompress(const DDSFile::Info& info);
+
+	// Writes 'dds', a 2D texture in an 8-bit RGBA, BGRA, R or RG format with a width and
+	// height that are multiples of 4, to 'out' as 'format', keeping its mips and slices.
+	// An sRGB source gives the sRGB variant of 'format' where it has one.
+	static bool Compress(const void* dds, size_t size, DXGI_FORMAT format, std::vector<std::uint8_t>& out,
+		const Options& options = Options(), Stats* stats = nullptr, std::string* error = nullptr);
+
+	// Writes a DDS in a supported format to 'out' as R8G8B8A8, UNORM or sRGB to match.
+	static bool Decompress(const void* dds, size_t size, std::vector<std::uint8_t>& out,
+		std::string* error = nullptr);
+};
@@ -0,0 +1,280 @@
+#include "ContentCache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include "MappedFile.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	using uint64 = std::uint64_t;
+
+	static_assert(sizeof(ContentCache::Header) == 48, "ContentCache::Header layout changed");
+
+	// Temporary files older than this belong to writers that died mid-write.
+	const auto AbandonedAfter = std::chrono::hours(1);
+
+	bool Fail(std::string* error, const char* what)
+	{
+		if (error != nullptr)
+			*error = what;
+		return false;
+	}
+
+	bool IsKey(const std::string& key)
+	{
+		return key.size() == 64 && std::all_of(key.begin(), key.end(), [](char c)
+		{
+			return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+		});
+	}
+
+	// Unique across the threads and processes that may share the directory.
+	std::string TemporarySuffix()
+	{
+		static std::atomic<uint64> counter(0);
+		static const uint64 seed = ((uint64)std::random_device()() << 32) ^ std::random_device()();
+		const uint64 value = seed ^ (counter.fetch_add(1) * 0x9E3779B97F4A7C15ull) ^
+			(uint64)std::chrono::steady_clock::now().time_since_epoch().count();
+
+		static const char digits[] = "0123456789abcdef";
+		std::string suffix = ".";
+		for (int i = 0; i < 16; ++i)
+			suffix += digits[(value >> (4 * i)) & 15];
+		return suffix + ".tmp";
+	}
+}
+
+const ContentCache::uint32 ContentCache::FileMagic;
+const ContentCache::uint32 ContentCache::FileVersion;
+
+ContentCache::KeyBuilder& ContentCache::KeyBuilder::Add(const void* data, size_t size)
+{
+	Add((uint64)size);
+	mHash.Update(data, size);
+	return *this;
+}
+
+ContentCache::KeyBuilder& ContentCache::KeyBuilder::Add(uint64 value)
+{
+	std::uint8_t bytes[8];
+	for (int i = 0; i < 8; ++i)
+		bytes[i] = (std::uint8_t)(value >> (8 * i));
+	mHash.Update(bytes, sizeof(bytes));
+	return *this;
+}
+
+bool ContentCache::KeyBuilder::AddFile(const std::wstring& path)
+{
+	std::error_code ec;
+	const uint64 size = fs::file_size(fs::path(path), ec);
+	std::ifstream fin(fs::path(path), std::ios::binary);
+	if (ec || !fin)
+		return false;
+
+	Add(size);
+	std::vector<char> buffer(1 << 20);
+	uint64 read = 0;
+	while (fin)
+	{
+		fin.read(buffer.data(), (std::streamsize)buffer.size());
+		const size_t n = (size_t)fin.gcount();
+		mHash.Update(buffer.data(), n);
+		read += n;
+	}
+	// A file that changed size while it was read would give a key for neither version.
+	return read == size;
+}
+
+std::string ContentCache::KeyBuilder::Key()
+{
+	return Sha256::ToHex(mHash.Final());
+}
+
+bool ContentCache::Open(const std::wstring& directory, uint64 maxBytes, std::string* error)
+{
+	mDirectory.clear();
+
+	std::error_code ec;
+	fs::create_directories(fs::path(directory), ec);
+	if (!fs::is_directory(fs::path(directory), ec))
+		return Fail(error, "cannot create the cache directory");
+
+	mDirectory = directory;
+	mMaxBytes = maxBytes;
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	mStats = Stats();
+	return true;
+}
+
+ContentCache::Stats ContentCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	return mStats;
+}
+
+void ContentCache::Count(size_t Stats::*counter)
+{
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	++(mStats.*counter);
+}
+
+std::wstring ContentCache::PathOf(const std::string& key) const
+{
+	return (fs::path(mDirectory) / key.substr(0, 2) / key).wstring();
+}
+
+bool ContentCache::Load(const std::string& key, std::vector<std::uint8_t>& bytes)
+{
+	if (!IsOpen() || !IsKey(key))
+		return false;
+
+	const std::wstring path = PathOf(key);
+	bool valid = false;
+	{
+		MappedFile file;
+		if (!file.Open(path))
+		{
+			Count(&Stats::Misses);
+			return false;
+		}
+
+		Header header;
+		if (file.Size() >= sizeof(Header))
+		{
+			memcpy(&header, file.Data(), sizeof(header));
+			const std::uint8_t* payload = reinterpret_cast<const std::uint8_t*>(file.Data()) + sizeof(Header);
+			valid = header.Magic == FileMagic && header.Version == FileVersion &&
+				header.Size == file.Size() - sizeof(Header) &&
+				Sha256::Hash(payload, (size_t)header.Size) == header.Digest;
+			if (valid)
+				bytes.assign(payload, payload + header.Size);
+		}
+	}
+
+	std::error_code ec;
+	if (!valid)
+	{
+		fs::remove(fs::path(path), ec);
+		Count(&Stats::Corrupt);
+		Count(&Stats::Misses);
+		return false;
+	}
+
+	// The eviction order.  A failure only makes the entry look older than it is.
+	fs::last_write_time(fs::path(path), fs::file_time_type::clock::now(), ec);
+	Count(&Stats::Hits);
+	return true;
+}
+
+bool ContentCache::Store(const std::string& key, const void* data, size_t size, std::string* error)
+{
+	if (!IsOpen())
+		return Fail(error, "cache not open");
+	if (!IsKey(key))
+		return Fail(error, "malformed cache key");
+
+	const fs::path path = PathOf(key);
+	std::error_code ec;
+	fs::create_directories(path.parent_path(), ec);
+
+	Header header;
+	header.Magic = FileMagic;
+	header.Version = FileVersion;
+	header.Size = size;
+	header.Digest = Sha256::Hash(data, size);
+
+	const fs::path temporary = path.parent_path() / (key + TemporarySuffix());
+	{
+		std::ofstream fout(temporary, std::ios::binary | std::ios::trunc);
+		if (!fout)
+			return Fail(error, "cannot create a file in the cache directory");
+
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fout.write(static_cast<const char*>(data), (std::streamsize)size);
+		fout.close();
+		if (!fout)
+		{
+			fs::remove(temporary, ec);
+			return Fail(error, "write to the cache failed");
+		}
+	}
+
+	fs::rename(temporary, path, ec);
+	if (ec)
+	{
+		fs::remove(temporary, ec);
+
+		// On Windows the rename fails while a reader has the file open; that file holds
+		// these same bytes.
+		if (!fs::exists(path, ec))
+			return Fail(error, "cannot rename into the cache");
+	}
+
+	Count(&Stats::Stores);
+	return true;
+}
+
+ContentCache::uint64 ContentCache::Trim()
+{
+	if (!IsOpen())
+		return 0;
+
+	struct Item
+	{
+		fs::path Path;
+		uint64 Size;
+		fs::file_time_type Time;
+	};
+	std::vector<Item> items;
+	uint64 total = 0;
+
+	const auto now = fs::file_time_type::clock::now();
+	std::error_code ec;
+	for (fs::recursive_directory_iterator it(fs::path(mDirectory), ec), end; !ec && it != end; it.increment(ec))
+	{
+		std::error_code itemError;
+		if (!it->is_regular_file(itemError))
+			continue;
+
+		Item item = { it->path(), it->file_size(itemError), it->last_write_time(itemError) };
+		if (itemError)
+			continue;
+
+		if (item.Path.extension() == ".tmp")
+		{
+			if (now - item.Time > AbandonedAfter)
+				fs::remove(item.Path, itemError);
+			continue;
+		}
+
+		total += item.Size;
+		items.push_back(item);
+	}
+
+	if (total <= mMaxBytes)
+		return total;
+
+	std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.Time < b.Time; });
+	for (const Item& item : items)
+	{
+		if (total <= mMaxBytes)
+			break;
+
+		std::error_code removeError;
+		if (fs::remove(item.Path, removeError))
+		{
+			total -= item.Size;
+
+			std::lock_guard<std::mutex> lock(mStatsMutex);
+			++mStats.Evictions;
+			mStats.EvictedBytes += item.Size;
+		}
+	}
+	return total;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Sha256.h"
+
+// Content-addressed store for cooked outputs.  An output is filed under the SHA-256 of
+// everything that determined it -- the input bytes, the tool and its version, and the
+// parameters -- so an input that has not changed is never cooked twice with the same
+// settings, and machines pointing at one shared directory share the results.
+//
+//	<directory>/<first two hex digits>/<64 hex digits>
+//
+// Each file is a Header followed by the output; a file whose size or SHA-256 does not
+// match its header is a miss and is removed.  Files are written under a temporary name
+// and renamed into place, so a reader never sees a partial file, and two writers of one
+// key just replace each other's identical bytes.  Load() refreshes the file's time,
+// which Trim() evicts by, least recently used first.  Load() and Store() may be called
+// from several threads at once.
+class ContentCache
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	static const uint32 FileMagic = 0x4843434C; // "LCCH"
+	static const uint32 FileVersion = 1;
+
+	struct Header
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint64 Size;
+		Sha256::Digest Digest;
+	};
+
+	// Hashes the parts of a key.  Each part is prefixed with its length, so ("ab", "c")
+	// and ("a", "bc") give different keys.
+	class KeyBuilder
+	{
+	public:
+		KeyBuilder& Add(const void* data, size_t size);
+		KeyBuilder& Add(const std::string& text) { return Add(text.data(), text.size()); }
+		KeyBuilder& Add(const char* text) { return Add(std::string(text)); }
+		KeyBuilder& Add(uint64 value);
+
+		// The file's contents, read in pieces.  False if it cannot be read.
+		bool AddFile(const std::wstring& path);
+
+		// 64 hex digits.  The builder should not be used afterwards.
+		std::string Key();
+
+	private:
+		Sha256 mHash;
+	};
+
+	struct Stats
+	{
+		size_t Hits = 0;
+		size_t Misses = 0;
+		size_t Stores = 0;
+		// Files Load() found damaged and removed.
+		size_t Corrupt = 0;
+		size_t Evictions = 0;
+		uint64 EvictedBytes = 0;
+	};
+
+	// Creates the directory if needed.  Trim() keeps its contents to at most 'maxBytes'.
+	bool Open(const std::wstring& directory, uint64 maxBytes, std::string* error = nullptr);
+	bool IsOpen() const { return !mDirectory.empty(); }
+
+	// False on a miss.
+	bool Load(const std::string& key, std::vector<std::uint8_t>& bytes);
+	bool Store(const std::string& key, const void* data, size_t size, std::string* error = nullptr);
+
+	// Store() does not trim, so a run of stores costs no directory scans; call this after
+	// a batch.  Also removes temporary files that writers left behind.  Returns the bytes
+	// the cache holds afterwards.
+	uint64 Trim();
+
+	Stats GetStats() const;
+
+private:
+	std::wstring PathOf(const std::string& key) const;
+	void Count(size_t Stats::*counter);
+
+	std::wstring mDirectory;
+	uint64 mMaxBytes = 0;
+
+	mutable std::mutex mStatsMutex;
+	Stats mStats;
+};
@@ -7,6 +7,7 @@
 #include "d3dx12.h"
 #include "DxException.h"
 #include <d3dcompiler.h>
+#include <DirectXCollision.h>
 
 namespace d3dUtil 
 {
@@ -20,6 +21,10 @@ namespace d3dUtil
 		UINT IndexCount = 0;
 		UINT StartIndexLocation = 0;
 		INT BaseVertexLocation = 0;
+
+		// Object-space bounds of the vertices this submesh draws.
+		DirectX::BoundingBox Bounds;
+		DirectX::BoundingSphere Sphere;
 	};
 
 	struct MeshGeometry
@@ -42,6 +47,35 @@ namespace d3dUtil
 
 		std::unordered_map<std::string, SubmeshGeometry> DrawArgs;
 
+		// Optional packed position-only stream.  When present it is bound to slot 0 and the
+		// vertex buffer above holds the remaining attributes for slot 1, so depth and stencil
+		// passes can fetch positions alone.
+		Microsoft::WRL::ComPtr<ID3DBlob> PositionBufferCPU;
+		Microsoft::WRL::ComPtr<ID3D12Resource> PositionBufferGPU;
+		Microsoft::WRL::ComPtr<ID3D12Resource> PositionUploadBuffer;
+
+		UINT PositionBufferSize = 0;
+		UINT PositionStride = 0;
+
+		// Bounds of the whole vertex buffer.
+		DirectX::BoundingBox Bounds;
+		DirectX::BoundingSphere Sphere;
+
+		bool HasPositionStream() const
+		{
+			return PositionBufferGPU != nullptr;
+		}
+
+		D3D12_VERTEX_BUFFER_VIEW PositionBufferView()
+		{
+			D3D12_VERTEX_BUFFER_VIEW vbv;
+			vbv.BufferLocation = PositionBufferGPU->GetGPUVirtualAddress();
+			vbv.SizeInBytes = PositionBufferSize;
+			vbv.StrideInBytes = PositionStride;
+
+			return vbv;
+		}
+
 		D3D12_VERTEX_BUFFER_VIEW VertexBufferView()
 		{
 			D3D12_VERTEX_BUFFER_VIEW vbv;
@@ -63,14 +97,15 @@ namespace d3dUtil
 		}
 	};
 
+	// 'data' is only read while recording, so it may point into a memory-mapped file
+	// that is closed right after.
 	static Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(
 		ID3D12Device* device, 
 		ID3D12GraphicsCommandList* cmdList,
-		ID3DBlob* data,
+		const void* data,
+		UINT64 byteSize,
 		Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer)
 	{
-		UINT byteSize = data->GetBufferSize();
-
 		Microsoft::WRL::ComPtr<ID3D12Resource> defaultBuffer;
 		
 		CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_DEFAULT);
@@ -94,9 +129,9 @@ namespace d3dUtil
 			IID_PPV_ARGS(&uploadBuffer)));
 
 		D3D12_SUBRESOURCE_DATA subresourceData;
-		subresourceData.pData = data->GetBufferPointer();
-		subresourceData.RowPitch = byteSize;
-		subresourceData.SlicePitch = byteSize;
+		subresourceData.pData = data;
+		subresourceData.RowPitch = (LONG_PTR)byteSize;
+		subresourceData.SlicePitch = (LONG_PTR)byteSize;
 
 		auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
 			defaultBuffer.Get(),
@@ -113,6 +148,51 @@ namespace d3dUtil
 		return defaultBuffer;
 	}
 
+	static Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(
+		ID3D12Device* device, 
+		ID3D12GraphicsCommandList* cmdList,
+		ID3DBlob* data,
+		Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer)
+	{
+		return CreateDefaultBuffer(device, cmdList, data->GetBufferPointer(), data->GetBufferSize(), uploadBuffer);
+	}
+
+	// Splits interleaved vertices, whose first member is an XMFLOAT3 position, into the
+	// packed position stream and the attribute stream of geo, and uploads both.
+	template<typename VertexT>
+	static void CreateSplitVertexBuffers(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		MeshGeometry& geo,
+		const VertexT* vertices,
+		UINT vertexCount)
+	{
+		static_assert(sizeof(VertexT) > sizeof(DirectX::XMFLOAT3), "vertex has no attributes besides position");
+
+		const UINT positionStride = sizeof(DirectX::XMFLOAT3);
+		const UINT attributeStride = sizeof(VertexT) - positionStride;
+
+		ThrowIfFailed(D3DCreateBlob(vertexCount * positionStride, &geo.PositionBufferCPU));
+		ThrowIfFailed(D3DCreateBlob(vertexCount * attributeStride, &geo.VertexBufferCPU));
+
+		const BYTE* src = reinterpret_cast<const BYTE*>(vertices);
+		BYTE* positions = static_cast<BYTE*>(geo.PositionBufferCPU->GetBufferPointer());
+		BYTE* attributes = static_cast<BYTE*>(geo.VertexBufferCPU->GetBufferPointer());
+		for (UINT i = 0; i < vertexCount; ++i)
+		{
+			memcpy(positions + i * positionStride, src + i * sizeof(VertexT), positionStride);
+			memcpy(attributes + i * attributeStride, src + i * sizeof(VertexT) + positionStride, attributeStride);
+		}
+
+		geo.PositionBufferGPU = CreateDefaultBuffer(device, cmdList, geo.PositionBufferCPU.Get(), geo.PositionUploadBuffer);
+		geo.VertexBufferGPU = CreateDefaultBuffer(device, cmdList, geo.VertexBufferCPU.Get(), geo.VertexUploadBuffer);
+
+		geo.PositionStride = positionStride;
+		geo.PositionBufferSize = vertexCount * positionStride;
+		geo.VertexStride = attributeStride;
+		geo.VertexBufferSize = vertexCount * attributeStride;
+	}
+
 	static Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
 		std::wstring file,
 		std::string entry,
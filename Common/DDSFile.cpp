@@ -0,0 +1,637 @@
+#include "DDSFile.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	constexpr uint32 FourCC(char a, char b, char c, char d)
+	{
+		return (uint32)(std::uint8_t)a | ((uint32)(std::uint8_t)b << 8) | ((uint32)(std::uint8_t)c << 16) |
+			((uint32)(std::uint8_t)d << 24);
+	}
+
+	// As in DDS.h of DirectXTex.
+#pragma pack(push, 1)
+	struct Header
+	{
+		uint32 Size;
+		uint32 Flags;
+		uint32 Height;
+		uint32 Width;
+		uint32 PitchOrLinearSize;
+		uint32 Depth;
+		uint32 MipMapCount;
+		uint32 Reserved1[11];
+		DDSFile::PixelFormat Format;
+		uint32 Caps;
+		uint32 Caps2;
+		uint32 Caps3;
+		uint32 Caps4;
+		uint32 Reserved2;
+	};
+
+	struct HeaderDX10
+	{
+		uint32 DxgiFormat;
+		uint32 ResourceDimension;
+		uint32 MiscFlag;
+		uint32 ArraySize;
+		uint32 MiscFlags2;
+	};
+#pragma pack(pop)
+
+	static_assert(sizeof(DDSFile::PixelFormat) == 32 && sizeof(Header) == 124 && sizeof(HeaderDX10) == 20,
+		"DDS header layout");
+
+	const uint32 FlagFourCC = 0x4;
+	const uint32 FlagRGB = 0x40;
+	const uint32 FlagLuminance = 0x20000;
+	const uint32 FlagAlpha = 0x2;
+	const uint32 FlagCaps = 0x1;
+	const uint32 FlagHeight = 0x2;
+	const uint32 FlagWidth = 0x4;
+	const uint32 FlagPixelFormat = 0x1000;
+	const uint32 FlagMipCount = 0x20000;
+	const uint32 FlagVolume = 0x800000;
+	const uint32 Cubemap = 0x200;
+	const uint32 CubemapAllFaces = 0xFE00;
+	const uint32 MiscTextureCube = 0x4;
+	const uint32 CapsComplex = 0x8;
+	const uint32 CapsTexture = 0x1000;
+	const uint32 CapsMipmap = 0x400000;
+	const uint32 AlphaModeMask = 0x7;
+
+	// D3D11_RESOURCE_DIMENSION, as the DX10 extension stores it.
+	const uint32 DX10Texture1D = 2;
+	const uint32 DX10Texture2D = 3;
+	const uint32 DX10Texture3D = 4;
+
+	// The D3D12 hardware limits; DDSTextureLoader does not trust larger metadata.
+	const uint32 MaxMipLevels = 15;
+	const uint32 MaxTexture1D = 16384;
+	const uint32 MaxTexture2D = 16384;
+	const uint32 MaxTexture3D = 2048;
+	const uint32 MaxArraySize = 2048;
+
+	uint64 AlignUp(uint64 value, uint64 alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	bool Fail(std::string* error, const char* what)
+	{
+		if (error != nullptr)
+			*error = what;
+		return false;
+	}
+
+	uint32 AlphaModeOf(const Header& header, const HeaderDX10* dx10)
+	{
+		if (dx10 != nullptr)
+		{
+			const uint32 mode = dx10->MiscFlags2 & AlphaModeMask;
+			return mode <= 4 ? mode : 0;
+		}
+		if ((header.Format.Flags & FlagFourCC) &&
+			(header.Format.FourCC == FourCC('D', 'X', 'T', '2') || header.Format.FourCC == FourCC('D', 'X', 'T', '4')))
+			return 2; // DDS_ALPHA_MODE_PREMULTIPLIED
+		return 0;
+	}
+}
+
+const DDSFile::uint32 DDSFile::Magic;
+const size_t DDSFile::HeaderBytes;
+const size_t DDSFile::MaxHeaderBytes;
+const DDSFile::uint32 DDSFile::RowPitchAlignment;
+const DDSFile::uint32 DDSFile::PlacementAlignment;
+
+DXGI_FORMAT DDSFile::FormatOf(const PixelFormat& pf)
+{
+	auto masks = [&](uint32 r, uint32 g, uint32 b, uint32 a)
+	{
+		return pf.RBitMask == r && pf.GBitMask == g && pf.BBitMask == b && pf.ABitMask == a;
+	};
+
+	if (pf.Flags & FlagRGB)
+	{
+		switch (pf.RGBBitCount)
+		{
+		case 32:
+			if (masks(0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+				return DXGI_FORMAT_R8G8B8A8_UNORM;
+			if (masks(0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
+				return DXGI_FORMAT_B8G8R8A8_UNORM;
+			if (masks(0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000))
+				return DXGI_FORMAT_B8G8R8X8_UNORM;
+			if (masks(0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000))
+				return DXGI_FORMAT_R10G10B10A2_UNORM;
+			if (masks(0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
+				return DXGI_FORMAT_R16G16_UNORM;
+			if (masks(0xffffffff, 0x00000000, 0x00000000, 0x00000000))
+				return DXGI_FORMAT_R32_FLOAT;
+			break;
+
+		case 16:
+			if (masks(0x7c00, 0x03e0, 0x001f, 0x8000))
+				return DXGI_FORMAT_B5G5R5A1_UNORM;
+			if (masks(0xf800, 0x07e0, 0x001f, 0x0000))
+				return DXGI_FORMAT_B5G6R5_UNORM;
+			if (masks(0x0f00, 0x00f0, 0x000f, 0xf000))
+				return DXGI_FORMAT_B4G4R4A4_UNORM;
+			break;
+		}
+	}
+	else if (pf.Flags & FlagLuminance)
+	{
+		if (pf.RGBBitCount == 8 && masks(0x000000ff, 0, 0, 0))
+			return DXGI_FORMAT_R8_UNORM;
+		if (pf.RGBBitCount == 16 && masks(0x0000ffff, 0, 0, 0))
+			return DXGI_FORMAT_R16_UNORM;
+		if (pf.RGBBitCount == 16 && masks(0x000000ff, 0, 0, 0x0000ff00))
+			return DXGI_FORMAT_R8G8_UNORM;
+	}
+	else if (pf.Flags & FlagAlpha)
+	{
+		if (pf.RGBBitCount == 8)
+			return DXGI_FORMAT_A8_UNORM;
+	}
+	else if (pf.Flags & FlagFourCC)
+	{
+		static const struct { uint32 Code; DXGI_FORMAT Format; } codes[] =
+		{
+			{ FourCC('D', 'X', 'T', '1'), DXGI_FORMAT_BC1_UNORM },
+			{ FourCC('D', 'X', 'T', '3'), DXGI_FORMAT_BC2_UNORM },
+			{ FourCC('D', 'X', 'T', '5'), DXGI_FORMAT_BC3_UNORM },
+			{ FourCC('D', 'X', 'T', '2'), DXGI_FORMAT_BC2_UNORM },
+			{ FourCC('D', 'X', 'T', '4'), DXGI_FORMAT_BC3_UNORM },
+			{ FourCC('A', 'T', 'I', '1'), DXGI_FORMAT_BC4_UNORM },
+			{ FourCC('B', 'C', '4', 'U'), DXGI_FORMAT_BC4_UNORM },
+			{ FourCC('B', 'C', '4', 'S'), DXGI_FORMAT_BC4_SNORM },
+			{ FourCC('A', 'T', 'I', '2'), DXGI_FORMAT_BC5_UNORM },
+			{ FourCC('B', 'C', '5', 'U'), DXGI_FORMAT_BC5_UNORM },
+			{ FourCC('B', 'C', '5', 'S'), DXGI_FORMAT_BC5_SNORM },
+			{ FourCC('R', 'G', 'B', 'G'), DXGI_FORMAT_R8G8_B8G8_UNORM },
+			{ FourCC('G', 'R', 'G', 'B'), DXGI_FORMAT_G8R8_G8B8_UNORM },
+			{ FourCC('Y', 'U', 'Y', '2'), DXGI_FORMAT_YUY2 },
+			// D3DFORMAT values.
+			{ 36, DXGI_FORMAT_R16G16B16A16_UNORM },
+			{ 110, DXGI_FORMAT_R16G16B16A16_SNORM },
+			{ 111, DXGI_FORMAT_R16_FLOAT },
+			{ 112, DXGI_FORMAT_R16G16_FLOAT },
+			{ 113, DXGI_FORMAT_R16G16B16A16_FLOAT },
+			{ 114, DXGI_FORMAT_R32_FLOAT },
+			{ 115, DXGI_FORMAT_R32G32_FLOAT },
+			{ 116, DXGI_FORMAT_R32G32B32A32_FLOAT }
+		};
+		for (const auto& code : codes)
+		{
+			if (code.Code == pf.FourCC)
+				return code.Format;
+		}
+	}
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+size_t DDSFile::BitsPerPixel(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_UINT:
+	case DXGI_FORMAT_R32G32B32A32_SINT:
+		return 128;
+
+	case DXGI_FORMAT_R32G32B32_TYPELESS:
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+	case DXGI_FORMAT_R32G32B32_UINT:
+	case DXGI_FORMAT_R32G32B32_SINT:
+		return 96;
+
+	case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R16G16B16A16_UINT:
+	case DXGI_FORMAT_R16G16B16A16_SNORM:
+	case DXGI_FORMAT_R16G16B16A16_SINT:
+	case DXGI_FORMAT_R32G32_TYPELESS:
+	case DXGI_FORMAT_R32G32_FLOAT:
+	case DXGI_FORMAT_R32G32_UINT:
+	case DXGI_FORMAT_R32G32_SINT:
+	case DXGI_FORMAT_R32G8X24_TYPELESS:
+	case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+	case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+	case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+	case DXGI_FORMAT_Y416:
+	case DXGI_FORMAT_Y210:
+	case DXGI_FORMAT_Y216:
+		return 64;
+
+	case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+	case DXGI_FORMAT_R10G10B10A2_UINT:
+	case DXGI_FORMAT_R11G11B10_FLOAT:
+	case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R8G8B8A8_UINT:
+	case DXGI_FORMAT_R8G8B8A8_SNORM:
+	case DXGI_FORMAT_R8G8B8A8_SINT:
+	case DXGI_FORMAT_R16G16_TYPELESS:
+	case DXGI_FORMAT_R16G16_FLOAT:
+	case DXGI_FORMAT_R16G16_UNORM:
+	case DXGI_FORMAT_R16G16_UINT:
+	case DXGI_FORMAT_R16G16_SNORM:
+	case DXGI_FORMAT_R16G16_SINT:
+	case DXGI_FORMAT_R32_TYPELESS:
+	case DXGI_FORMAT_D32_FLOAT:
+	case DXGI_FORMAT_R32_FLOAT:
+	case DXGI_FORMAT_R32_UINT:
+	case DXGI_FORMAT_R32_SINT:
+	case DXGI_FORMAT_R24G8_TYPELESS:
+	case DXGI_FORMAT_D24_UNORM_S8_UINT:
+	case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+	case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+	case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+	case DXGI_FORMAT_R8G8_B8G8_UNORM:
+	case DXGI_FORMAT_G8R8_G8B8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+	case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+	case DXGI_FORMAT_AYUV:
+	case DXGI_FORMAT_Y410:
+	case DXGI_FORMAT_YUY2:
+		return 32;
+
+	case DXGI_FORMAT_P010:
+	case DXGI_FORMAT_P016:
+		return 24;
+
+	case DXGI_FORMAT_R8G8_TYPELESS:
+	case DXGI_FORMAT_R8G8_UNORM:
+	case DXGI_FORMAT_R8G8_UINT:
+	case DXGI_FORMAT_R8G8_SNORM:
+	case DXGI_FORMAT_R8G8_SINT:
+	case DXGI_FORMAT_R16_TYPELESS:
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_D16_UNORM:
+	case DXGI_FORMAT_R16_UNORM:
+	case DXGI_FORMAT_R16_UINT:
+	case DXGI_FORMAT_R16_SNORM:
+	case DXGI_FORMAT_R16_SINT:
+	case DXGI_FORMAT_B5G6R5_UNORM:
+	case DXGI_FORMAT_B5G5R5A1_UNORM:
+	case DXGI_FORMAT_A8P8:
+	case DXGI_FORMAT_B4G4R4A4_UNORM:
+		return 16;
+
+	case DXGI_FORMAT_NV12:
+	case DXGI_FORMAT_420_OPAQUE:
+	case DXGI_FORMAT_NV11:
+		return 12;
+
+	case DXGI_FORMAT_R8_TYPELESS:
+	case DXGI_FORMAT_R8_UNORM:
+	case DXGI_FORMAT_R8_UINT:
+	case DXGI_FORMAT_R8_SNORM:
+	case DXGI_FORMAT_R8_SINT:
+	case DXGI_FORMAT_A8_UNORM:
+	case DXGI_FORMAT_AI44:
+	case DXGI_FORMAT_IA44:
+	case DXGI_FORMAT_P8:
+		return 8;
+
+	case DXGI_FORMAT_R1_UNORM:
+		return 1;
+
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		return 4;
+
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_TYPELESS:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return 8;
+
+	default:
+		return 0;
+	}
+}
+
+bool DDSFile::IsBlockCompressed(DXGI_FORMAT format)
+{
+	return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+		(format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+void DDSFile::SurfaceInfo(size_t width, size_t height, DXGI_FORMAT format, size_t* bytes, size_t* rowBytes,
+	size_t* rowCount)
+{
+	size_t numBytes = 0;
+	size_t row = 0;
+	size_t rows = 0;
+
+	if (IsBlockCompressed(format))
+	{
+		const size_t blockBytes = BitsPerPixel(format) * 2; // 16 pixels per block
+		const size_t blocksWide = width > 0 ? std::max<size_t>(1, (width + 3) / 4) : 0;
+		const size_t blocksHigh = height > 0 ? std::max<size_t>(1, (height + 3) / 4) : 0;
+		row = blocksWide * blockBytes;
+		rows = blocksHigh;
+		numBytes = row * rows;
+	}
+	else if (format == DXGI_FORMAT_R8G8_B8G8_UNORM || format == DXGI_FORMAT_G8R8_G8B8_UNORM ||
+		format == DXGI_FORMAT_YUY2 || format == DXGI_FORMAT_Y210 || format == DXGI_FORMAT_Y216)
+	{
+		// Pairs of pixels.
+		const size_t pairBytes = format == DXGI_FORMAT_Y210 || format == DXGI_FORMAT_Y216 ? 8 : 4;
+		row = ((width + 1) >> 1) * pairBytes;
+		rows = height;
+		numBytes = row * rows;
+	}
+	else if (format == DXGI_FORMAT_NV11)
+	{
+		// Direct3D's simplification; larger than the 4:1:1 data.
+		row = ((width + 3) >> 2) * 4;
+		rows = height * 2;
+		numBytes = row * rows;
+	}
+	else if (format == DXGI_FORMAT_NV12 || format == DXGI_FORMAT_420_OPAQUE || format == DXGI_FORMAT_P010 ||
+		format == DXGI_FORMAT_P016)
+	{
+		// A luma plane, then chroma at half height.
+		const size_t elementBytes = format == DXGI_FORMAT_P010 || format == DXGI_FORMAT_P016 ? 4 : 2;
+		row = ((width + 1) >> 1) * elementBytes;
+		numBytes = row * height + ((row * height + 1) >> 1);
+		rows = height + ((height + 1) >> 1);
+	}
+	else
+	{
+		row = (width * BitsPerPixel(format) + 7) / 8;
+		rows = height;
+		numBytes = row * rows;
+	}
+
+	if (bytes != nullptr)
+		*bytes = numBytes;
+	if (rowBytes != nullptr)
+		*rowBytes = row;
+	if (rowCount != nullptr)
+		*rowCount = rows;
+}
+
+bool DDSFile::Parse(const void* data, size_t size, uint64 fileSize, Info& info, size_t maxSize, std::string* error)
+{
+	info = Info();
+
+	const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+	size = (size_t)std::min<uint64>(size, fileSize);
+	if (size < HeaderBytes)
+		return Fail(error, "too small for a DDS header");
+
+	uint32 magic;
+	Header header;
+	memcpy(&magic, bytes, sizeof(magic));
+	memcpy(&header, bytes + 4, sizeof(header));
+	if (magic != Magic || header.Size != sizeof(Header) || header.Format.Size != sizeof(PixelFormat))
+		return Fail(error, "not a DDS file");
+
+	HeaderDX10 dx10 = {};
+	const bool hasDX10 = (header.Format.Flags & FlagFourCC) && header.Format.FourCC == FourCC('D', 'X', '1', '0');
+	if (hasDX10)
+	{
+		if (size < MaxHeaderBytes)
+			return Fail(error, "truncated DX10 header");
+		memcpy(&dx10, bytes + HeaderBytes, sizeof(dx10));
+	}
+
+	uint32 width = header.Width;
+	uint32 height = header.Height;
+	uint32 depth = header.Depth;
+	uint32 arraySize = 1;
+	const uint32 mipCount = std::max<uint32>(header.MipMapCount, 1);
+
+	if (hasDX10)
+	{
+		info.Format = (DXGI_FORMAT)dx10.DxgiFormat;
+		arraySize = dx10.ArraySize;
+		if (arraySize == 0)
+			return Fail(error, "zero array size");
+
+		switch (info.Format)
+		{
+		case DXGI_FORMAT_AI44:
+		case DXGI_FORMAT_IA44:
+		case DXGI_FORMAT_P8:
+		case DXGI_FORMAT_A8P8:
+			return Fail(error, "palettized formats are not supported");
+		default:
+			if (BitsPerPixel(info.Format) == 0)
+				return Fail(error, "unsupported DXGI format");
+		}
+
+		switch (dx10.ResourceDimension)
+		{
+		case DX10Texture1D:
+			if ((header.Flags & FlagHeight) && height != 1)
+				return Fail(error, "1D texture with a height");
+			height = depth = 1;
+			info.ResourceDimension = Texture1D;
+			break;
+
+		case DX10Texture2D:
+			if (dx10.MiscFlag & MiscTextureCube)
+			{
+				arraySize *= 6;
+				info.IsCubeMap = true;
+			}
+			depth = 1;
+			info.ResourceDimension = Texture2D;
+			break;
+
+		case DX10Texture3D:
+			if (!(header.Flags & FlagVolume))
+				return Fail(error, "3D texture without the volume flag");
+			if (arraySize > 1)
+				return Fail(error, "3D texture arrays are not supported");
+			info.ResourceDimension = Texture3D;
+			break;
+
+		default:
+			return Fail(error, "unsupported resource dimension");
+		}
+	}
+	else
+	{
+		info.Format = FormatOf(header.Format);
+		if (info.Format == DXGI_FORMAT_UNKNOWN)
+			return Fail(error, "unsupported pixel format");
+
+		if (header.Flags & FlagVolume)
+		{
+			info.ResourceDimension = Texture3D;
+		}
+		else
+		{
+			if (header.Caps2 & Cubemap)
+			{
+				if ((header.Caps2 & CubemapAllFaces) != CubemapAllFaces)
+					return Fail(error, "cube maps need all six faces");
+				arraySize = 6;
+				info.IsCubeMap = true;
+			}
+			depth = 1;
+			info.ResourceDimension = Texture2D;
+		}
+	}
+
+	if (mipCount > MaxMipLevels)
+		return Fail(error, "too many mips");
+	if (width == 0 || height == 0 || depth == 0)
+		return Fail(error, "zero-sized texture");
+
+	const bool tooLarge =
+		info.ResourceDimension == Texture1D ? arraySize > MaxArraySize || width > MaxTexture1D :
+		info.ResourceDimension == Texture2D ? arraySize > MaxArraySize || width > MaxTexture2D || height > MaxTexture2D :
+		arraySize > 1 || width > MaxTexture3D || height > MaxTexture3D || depth > MaxTexture3D;
+	if (tooLarge)
+		return Fail(error, "larger than Direct3D 12 allows");
+
+	info.DataOffset = hasDX10 ? MaxHeaderBytes : HeaderBytes;
+	info.ArraySize = arraySize;
+	info.AlphaMode = AlphaModeOf(header, hasDX10 ? &dx10 : nullptr);
+
+	// The same mips are skipped in every slice, so the first slice decides.
+	uint64 offset = info.DataOffset;
+	info.Subresources.reserve((size_t)mipCount * arraySize);
+	for (uint32 slice = 0; slice < arraySize; ++slice)
+	{
+		uint32 w = width, h = height, d = depth;
+		for (uint32 mip = 0; mip < mipCount; ++mip)
+		{
+			Subresource sub;
+			sub.Offset = offset;
+			sub.Width = w;
+			sub.Height = h;
+			sub.Depth = d;
+			SurfaceInfo(w, h, info.Format, &sub.SliceBytes, &sub.RowBytes, &sub.RowCount);
+
+			// The 4:2:0 formats need even sizes; at an odd height their chroma rows would
+			// run past the slice, and a row-by-row copy past the end of the file.
+			if ((uint64)sub.RowBytes * sub.RowCount > sub.SliceBytes)
+				return Fail(error, "odd-sized planar surface");
+
+			const uint64 subBytes = (uint64)sub.SliceBytes * d;
+			if (subBytes > fileSize || offset > fileSize - subBytes)
+				return Fail(error, "truncated pixel data");
+			offset += subBytes;
+
+			if (mipCount <= 1 || maxSize == 0 || (w <= maxSize && h <= maxSize && d <= maxSize))
+			{
+				if (info.Width == 0)
+				{
+					info.Width = w;
+					info.Height = h;
+					info.Depth = d;
+				}
+				info.Subresources.push_back(sub);
+			}
+			else if (slice == 0)
+			{
+				++info.SkippedMips;
+			}
+
+			w = std::max<uint32>(w >> 1, 1);
+			h = std::max<uint32>(h >> 1, 1);
+			d = std::max<uint32>(d >> 1, 1);
+		}
+	}
+
+	info.MipCount = mipCount - info.SkippedMips;
+	if (info.Subresources.empty())
+		return Fail(error, "every mip exceeds the size limit");
+	return true;
+}
+
+void DDSFile::WriteHeader(const Info& info, std::vector<std::uint8_t>& out)
+{
+	Header header = {};
+	header.Size = sizeof(Header);
+	header.Flags = FlagCaps | FlagHeight | FlagWidth | FlagPixelFormat | (info.MipCount > 1 ? FlagMipCount : 0) |
+		(info.ResourceDimension == Texture3D ? FlagVolume : 0);
+	header.Height = info.Height;
+	header.Width = info.Width;
+	header.Depth = info.ResourceDimension == Texture3D ? info.Depth : 0;
+	header.MipMapCount = info.MipCount;
+	header.Format.Size = sizeof(PixelFormat);
+	header.Format.Flags = FlagFourCC;
+	header.Format.FourCC = FourCC('D', 'X', '1', '0');
+	header.Caps = CapsTexture | (info.MipCount > 1 || info.ArraySize > 1 ? CapsComplex : 0) |
+		(info.MipCount > 1 ? CapsMipmap : 0);
+	header.Caps2 = info.IsCubeMap ? Cubemap | CubemapAllFaces : 0;
+
+	HeaderDX10 dx10 = {};
+	dx10.DxgiFormat = info.Format;
+	dx10.ResourceDimension = info.ResourceDimension;
+	dx10.MiscFlag = info.IsCubeMap ? MiscTextureCube : 0;
+	dx10.ArraySize = info.IsCubeMap ? info.ArraySize / 6 : info.ArraySize;
+	dx10.MiscFlags2 = info.AlphaMode;
+
+	const uint32 magic = Magic;
+	const size_t start = out.size();
+	out.resize(start + MaxHeaderBytes);
+	memcpy(out.data() + start, &magic, sizeof(magic));
+	memcpy(out.data() + start + 4, &header, sizeof(header));
+	memcpy(out.data() + start + HeaderBytes, &dx10, sizeof(dx10));
+}
+
+DDSFile::uint64 DDSFile::Footprints(const Info& info, std::vector<Footprint>& footprints, uint64 baseOffset)
+{
+	footprints.clear();
+	footprints.reserve(info.Subresources.size());
+
+	// The total stops at the last row's bytes, not its pitch, as the runtime's does.
+	const uint32 block = IsBlockCompressed(info.Format) ? 4 : 1;
+	uint64 offset = AlignUp(baseOffset, PlacementAlignment);
+	uint64 end = baseOffset;
+	for (const Subresource& sub : info.Subresources)
+	{
+		Footprint footprint;
+		footprint.Offset = offset;
+		footprint.Width = (uint32)AlignUp(sub.Width, block);
+		footprint.Height = (uint32)AlignUp(sub.Height, block);
+		footprint.Depth = sub.Depth;
+		footprint.RowPitch = (uint32)AlignUp(sub.RowBytes, RowPitchAlignment);
+		footprint.RowCount = (uint32)sub.RowCount;
+		footprint.RowBytes = sub.RowBytes;
+		footprints.push_back(footprint);
+
+		const uint64 rows = (uint64)footprint.RowCount * footprint.Depth;
+		end = offset + (rows - 1) * footprint.RowPitch + footprint.RowBytes;
+		offset = AlignUp(offset + rows * footprint.RowPitch, PlacementAlignment);
+	}
+	return end - baseOffset;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <dxgiformat.h>
+
+// DDS header parsing and subresource layout with no D3D or Win32 dependency, so a loader
+// can size its upload from the header alone and tools on Linux can inspect textures.
+// Follows DDSTextureLoader's rules: legacy pixel formats map to DXGI formats, the same
+// size limits apply, and mips larger than a limit can be skipped.
+class DDSFile
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	static const uint32 Magic = 0x20534444; // "DDS "
+	// The magic number and DDS_HEADER, then the DX10 extension when the header names one.
+	// Reading MaxHeaderBytes is always enough to parse a file.
+	static const size_t HeaderBytes = 4 + 124;
+	static const size_t MaxHeaderBytes = HeaderBytes + 20;
+
+	// D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT: the
+	// row pitch and subresource offset alignments of texture data in a buffer.
+	static const uint32 RowPitchAlignment = 256;
+	static const uint32 PlacementAlignment = 512;
+
+	// DDS_PIXELFORMAT, the legacy format description in the header.
+	struct PixelFormat
+	{
+		uint32 Size;
+		uint32 Flags;
+		uint32 FourCC;
+		uint32 RGBBitCount;
+		uint32 RBitMask;
+		uint32 GBitMask;
+		uint32 BBitMask;
+		uint32 ABitMask;
+	};
+
+	// The values of D3D12_RESOURCE_DIMENSION.
+	enum Dimension : uint32
+	{
+		Unknown = 0,
+		Texture1D = 2,
+		Texture2D = 3,
+		Texture3D = 4
+	};
+
+	struct Subresource
+	{
+		// From the start of the file.
+		uint64 Offset;
+		uint32 Width;
+		uint32 Height;
+		uint32 Depth;
+		// As stored, tightly packed; rows of 4x4 blocks for block-compressed formats.
+		size_t RowBytes;
+		size_t RowCount;
+		// One depth slice; a subresource holds Depth of them.
+		size_t SliceBytes;
+	};
+
+	struct Info
+	{
+		DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+		Dimension ResourceDimension = Unknown;
+		// Of the largest mip kept.
+		uint32 Width = 0;
+		uint32 Height = 0;
+		uint32 Depth = 0;
+		uint32 MipCount = 0;
+		// Six per cube for cube maps.
+		uint32 ArraySize = 0;
+		bool IsCubeMap = false;
+		// Mips left out from the top because they exceeded the size limit.
+		uint32 SkippedMips = 0;
+		// A DirectX::DDS_ALPHA_MODE.
+		uint32 AlphaMode = 0;
+		// Where the pixel data starts.
+		uint64 DataOffset = 0;
+
+		// In D3D12 subresource order: the kept mips of slice 0, then of slice 1, and so on.
+		std::vector<Subresource> Subresources;
+	};
+
+	// Where a subresource goes in an upload buffer, and the shape CopyTextureRegion reads
+	// it in, as in D3D12_PLACED_SUBRESOURCE_FOOTPRINT.
+	struct Footprint
+	{
+		// From the start of the buffer; a multiple of PlacementAlignment.
+		uint64 Offset;
+		// In texels, rounded up to whole blocks for block-compressed formats.
+		uint32 Width;
+		uint32 Height;
+		uint32 Depth;
+		// A multiple of RowPitchAlignment, at least RowBytes.
+		uint32 RowPitch;
+		uint32 RowCount;
+		size_t RowBytes;
+	};
+
+	// Parses the header at the start of 'data', which holds at least the first
+	// MaxHeaderBytes of the file (or all of it, if shorter), and lays out the subresources
+	// of a file of 'fileSize' bytes.  With 'maxSize' non-zero, mips larger than it in any
+	// dimension are skipped.
+	static bool Parse(const void* data, size_t size, uint64 fileSize, Info& info, size_t maxSize = 0,
+		std::string* error = nullptr);
+
+	// Appends MaxHeaderBytes: a header with the DX10 extension that describes the format,
+	// dimension, size, mips, array size and alpha mode of 'info'.  The pixel data goes
+	// after it in subresource order; Subresources and DataOffset are not read.
+	static void WriteHeader(const Info& info, std::vector<std::uint8_t>& out);
+
+	// Lays out the subresources of 'info' in an upload buffer, in the same order, following
+	// the alignment rules GetCopyableFootprints does, and returns the buffer's size.  Planar
+	// video formats are laid out as a single plane, as DDSTextureLoader uploads them.
+	static uint64 Footprints(const Info& info, std::vector<Footprint>& footprints, uint64 baseOffset = 0);
+
+	// The DXGI format of a legacy pixel format; DXGI_FORMAT_UNKNOWN if it has none.
+	static DXGI_FORMAT FormatOf(const PixelFormat& pixelFormat);
+
+	// 0 for formats a DDS file cannot hold.
+	static size_t BitsPerPixel(DXGI_FORMAT format);
+	static bool IsBlockCompressed(DXGI_FORMAT format);
+
+	// Bytes in a width x height surface of 'format', and its rows: of pixels, or of blocks.
+	static void SurfaceInfo(size_t width, size_t height, DXGI_FORMAT format, size_t* bytes, size_t* rowBytes,
+		size_t* rowCount);
+};
@@ -0,0 +1,134 @@
+#include "DDSUpload.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "MappedFile.h"
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	bool Fail(std::string* error, const std::string& what)
+	{
+		if (error != nullptr)
+			*error = what;
+		return false;
+	}
+}
+
+bool DDSUpload::Prepare(ID3D12Device* device, const std::wstring& path, size_t maxSize, std::string* error)
+{
+	// Only the pages the header and the copies touch are read, straight from the page cache.
+	MappedFile file;
+	if (!file.Open(path))
+		return Fail(error, "cannot open the file");
+	return Prepare(device, file.Data(), file.Size(), maxSize, error);
+}
+
+bool DDSUpload::Prepare(ID3D12Device* device, const void* data, size_t size, size_t maxSize, std::string* error)
+{
+	auto start = Clock::now();
+	mTexture = nullptr;
+	mUploadHeap = nullptr;
+	mLayouts.clear();
+	mStats = Stats();
+
+	if (!DDSFile::Parse(data, std::min(size, DDSFile::MaxHeaderBytes), size, mInfo, maxSize, error))
+		return false;
+
+	const UINT16 mips = (UINT16)mInfo.MipCount;
+	D3D12_RESOURCE_DESC desc;
+	switch (mInfo.ResourceDimension)
+	{
+	case DDSFile::Texture1D:
+		desc = CD3DX12_RESOURCE_DESC::Tex1D(mInfo.Format, mInfo.Width, (UINT16)mInfo.ArraySize, mips);
+		break;
+	case DDSFile::Texture3D:
+		desc = CD3DX12_RESOURCE_DESC::Tex3D(mInfo.Format, mInfo.Width, mInfo.Height, (UINT16)mInfo.Depth, mips);
+		break;
+	default:
+		desc = CD3DX12_RESOURCE_DESC::Tex2D(mInfo.Format, mInfo.Width, mInfo.Height, (UINT16)mInfo.ArraySize, mips);
+		break;
+	}
+
+	// Created in the copy state, so Record() needs one barrier, after the copies.
+	const CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+	if (FAILED(device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &desc,
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&mTexture))))
+		return Fail(error, "cannot create the texture");
+
+	const UINT count = (UINT)mInfo.Subresources.size();
+	std::vector<UINT> rowCounts(count);
+	std::vector<UINT64> rowSizes(count);
+	mLayouts.resize(count);
+	device->GetCopyableFootprints(&desc, 0, count, 0, mLayouts.data(), rowCounts.data(), rowSizes.data(),
+		&mStats.UploadBytes);
+
+	const CD3DX12_HEAP_PROPERTIES uploadHeap(D3D12_HEAP_TYPE_UPLOAD);
+	const CD3DX12_RESOURCE_DESC buffer = CD3DX12_RESOURCE_DESC::Buffer(mStats.UploadBytes);
+	if (FAILED(device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &buffer,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&mUploadHeap))))
+	{
+		mTexture = nullptr;
+		return Fail(error, "cannot create the upload heap");
+	}
+
+	std::uint8_t* mapped = nullptr;
+	const D3D12_RANGE noRead = { 0, 0 };
+	if (FAILED(mUploadHeap->Map(0, &noRead, reinterpret_cast<void**>(&mapped))))
+	{
+		mTexture = nullptr;
+		mUploadHeap = nullptr;
+		return Fail(error, "cannot map the upload heap");
+	}
+
+	// Upload heaps are write-combined, so every byte is written once, front to back, and
+	// none is read back.
+	const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+	for (UINT i = 0; i < count; ++i)
+	{
+		const DDSFile::Subresource& sub = mInfo.Subresources[i];
+		const D3D12_SUBRESOURCE_FOOTPRINT& footprint = mLayouts[i].Footprint;
+		const std::uint8_t* source = bytes + sub.Offset;
+		std::uint8_t* destination = mapped + mLayouts[i].Offset;
+
+		if (footprint.RowPitch == sub.RowBytes && rowCounts[i] == sub.RowCount)
+		{
+			memcpy(destination, source, sub.SliceBytes * sub.Depth);
+			++mStats.WholeCopies;
+			continue;
+		}
+
+		const size_t rowBytes = std::min<size_t>(sub.RowBytes, (size_t)rowSizes[i]);
+		const size_t rows = std::min<size_t>(sub.RowCount, rowCounts[i]);
+		const size_t destinationSlice = (size_t)footprint.RowPitch * rowCounts[i];
+		for (UINT z = 0; z < sub.Depth; ++z)
+		{
+			for (size_t row = 0; row < rows; ++row)
+			{
+				memcpy(destination + z * destinationSlice + row * footprint.RowPitch,
+					source + z * sub.SliceBytes + row * sub.RowBytes, rowBytes);
+			}
+		}
+		++mStats.RowCopies;
+	}
+	mUploadHeap->Unmap(0, nullptr);
+
+	mStats.FileBytes = size;
+	mStats.Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	return true;
+}
+
+void DDSUpload::Record(ID3D12GraphicsCommandList* cmdList) const
+{
+	for (UINT i = 0; i < (UINT)mLayouts.size(); ++i)
+	{
+		const CD3DX12_TEXTURE_COPY_LOCATION destination(mTexture.Get(), i);
+		const CD3DX12_TEXTURE_COPY_LOCATION source(mUploadHeap.Get(), mLayouts[i]);
+		cmdList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+	}
+
+	const CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(mTexture.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	cmdList->ResourceBarrier(1, &barrier);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <wrl.h>
+#include "d3dx12.h"
+#include "DDSFile.h"
+
+// Loads a DDS texture without staging the file in a heap copy.  Prepare() parses the
+// header, creates the texture and an upload heap sized by the device's copyable
+// footprints, and copies the pixel rows from the mapped file (or from bytes already in
+// memory, such as a pack entry) straight to their aligned places in the upload heap.
+// DDSTextureLoader reads the whole file into a new allocation and then copies it again.
+//
+// Prepare() only uses the device, which is free-threaded, so it can run on a worker;
+// Record() adds the copies to a command list and must run where that list is recorded.
+// The upload heap must outlive the copy, as with CreateDDSTextureFromFile12.
+class DDSUpload
+{
+public:
+	using uint64 = std::uint64_t;
+
+	struct Stats
+	{
+		uint64 FileBytes = 0;
+		uint64 UploadBytes = 0;
+		// Subresources whose rows were already at the footprint's pitch, copied whole.
+		size_t WholeCopies = 0;
+		size_t RowCopies = 0;
+		double Milliseconds = 0.0;
+	};
+
+	// 'maxSize' skips mips larger than it, as in DDSTextureLoader.
+	bool Prepare(ID3D12Device* device, const std::wstring& path, size_t maxSize = 0, std::string* error = nullptr);
+	bool Prepare(ID3D12Device* device, const void* data, size_t size, size_t maxSize = 0, std::string* error = nullptr);
+
+	// Copies every subresource and leaves the texture ready for pixel shaders.
+	void Record(ID3D12GraphicsCommandList* cmdList) const;
+
+	const DDSFile::Info& GetInfo() const { return mInfo; }
+	const Stats& GetStats() const { return mStats; }
+	const Microsoft::WRL::ComPtr<ID3D12Resource>& GetTexture() const { return mTexture; }
+	const Microsoft::WRL::ComPtr<ID3D12Resource>& GetUploadHeap() const { return mUploadHeap; }
+
+private:
+	DDSFile::Info mInfo;
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> mLayouts;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mTexture;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadHeap;
+	Stats mStats;
+};
@@ -0,0 +1,488 @@
+#include "DependencyGraph.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "MappedFile.h"
+#include "ParallelFor.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	bool Fail(std::string* error, const char* what)
+	{
+		if (error != nullptr)
+			*error = what;
+		return false;
+	}
+
+	std::string Utf8(const std::wstring& path)
+	{
+		return fs::path(path).u8string();
+	}
+
+	std::wstring FromUtf8(const std::string& text)
+	{
+		return fs::u8path(text).wstring();
+	}
+
+	// Length-prefixed, so adjacent strings cannot run into each other.
+	void AddString(Sha256& hash, const std::string& text)
+	{
+		const uint64 size = text.size();
+		hash.Update(&size, sizeof(size));
+		hash.Update(text);
+	}
+
+	bool HashFile(const fs::path& path, Sha256::Digest& digest)
+	{
+		std::ifstream fin(path, std::ios::binary);
+		if (!fin)
+			return false;
+
+		Sha256 hash;
+		std::vector<char> buffer(1 << 20);
+		while (fin)
+		{
+			fin.read(buffer.data(), (std::streamsize)buffer.size());
+			hash.Update(buffer.data(), (size_t)fin.gcount());
+		}
+		digest = hash.Final();
+		return true;
+	}
+
+	// Bounds-checked reads over the saved state.
+	class Reader
+	{
+	public:
+		Reader(const char* data, size_t size) : mData(data), mSize(size) {}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			if (mSize - mOffset < sizeof(T))
+				return false;
+			memcpy(&value, mData + mOffset, sizeof(T));
+			mOffset += sizeof(T);
+			return true;
+		}
+
+		bool Read(std::string& text)
+		{
+			uint32 size;
+			if (!Read(size) || mSize - mOffset < size)
+				return false;
+			text.assign(mData + mOffset, size);
+			mOffset += size;
+			return true;
+		}
+
+		bool Read(Sha256::Digest& digest)
+		{
+			if (mSize - mOffset < digest.size())
+				return false;
+			memcpy(digest.data(), mData + mOffset, digest.size());
+			mOffset += digest.size();
+			return true;
+		}
+
+	private:
+		const char* mData;
+		size_t mSize;
+		size_t mOffset = 0;
+	};
+
+	template<typename T>
+	void Write(std::ofstream& fout, const T& value)
+	{
+		fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void Write(std::ofstream& fout, const std::string& text)
+	{
+		Write(fout, (uint32)text.size());
+		fout.write(text.data(), text.size());
+	}
+
+	void Write(std::ofstream& fout, const Sha256::Digest& digest)
+	{
+		fout.write(reinterpret_cast<const char*>(digest.data()), digest.size());
+	}
+}
+
+const DependencyGraph::uint32 DependencyGraph::FileMagic;
+const DependencyGraph::uint32 DependencyGraph::FileVersion;
+
+DependencyGraph::Node DependencyGraph::AddFile(const std::wstring& path)
+{
+	auto existing = mFiles.find(path);
+	if (existing != mFiles.end())
+		return existing->second;
+
+	const Node node = (Node)mNodes.size();
+	mNodes.emplace_back();
+	mNodes.back().IsFile = true;
+	mNodes.back().Name = Utf8(path);
+	mNodes.back().Path = path;
+	mFiles.emplace(path, node);
+	return node;
+}
+
+DependencyGraph::Node DependencyGraph::AddOutput(const std::string& name, const std::string& parameters, BuildFn build)
+{
+	const Node node = (Node)mNodes.size();
+	mNodes.emplace_back();
+	mNodes.back().Name = name;
+	mNodes.back().Parameters = parameters;
+	mNodes.back().Build = std::move(build);
+	return node;
+}
+
+void DependencyGraph::AddInput(Node output, Node input)
+{
+	mNodes[output].Inputs.push_back(input);
+	mNodes[input].Dependents.push_back(output);
+}
+
+void DependencyGraph::Invalidate(Node output)
+{
+	mNodes[output].Invalidated = true;
+}
+
+//	Header: uint32 Magic, Version, FileCount, OutputCount
+//	File:   string Path, uint64 Size, int64 Time, Digest
+//	Output: string Name, Digest Signature, uint32 DiscoveredCount, string Path[DiscoveredCount]
+//
+// Strings are a uint32 length and UTF-8 bytes.
+bool DependencyGraph::Load(const std::wstring& path)
+{
+	mSaved.clear();
+	mSavedFiles.clear();
+
+	MappedFile file;
+	if (!file.Open(path))
+		return false;
+
+	Reader reader(file.Data(), file.Size());
+	uint32 magic, version, fileCount, outputCount;
+	if (!reader.Read(magic) || !reader.Read(version) || !reader.Read(fileCount) || !reader.Read(outputCount) ||
+		magic != FileMagic || version != FileVersion)
+		return false;
+
+	bool ok = true;
+	for (uint32 i = 0; ok && i < fileCount; ++i)
+	{
+		std::string name;
+		FileState state;
+		ok = reader.Read(name) && reader.Read(state.Size) && reader.Read(state.Time) && reader.Read(state.Digest);
+		state.Exists = true;
+		if (ok)
+			mSavedFiles[FromUtf8(name)] = state;
+	}
+
+	for (uint32 i = 0; ok && i < outputCount; ++i)
+	{
+		std::string name;
+		Record record;
+		uint32 discovered = 0;
+		ok = reader.Read(name) && reader.Read(record.Signature) && reader.Read(discovered);
+		for (uint32 j = 0; ok && j < discovered; ++j)
+		{
+			std::string discoveredPath;
+			ok = reader.Read(discoveredPath);
+			record.Discovered.push_back(FromUtf8(discoveredPath));
+		}
+		if (ok)
+			mSaved[name] = std::move(record);
+	}
+
+	if (!ok)
+	{
+		mSaved.clear();
+		mSavedFiles.clear();
+	}
+	return ok;
+}
+
+bool DependencyGraph::Save(const std::wstring& path, std::string* error) const
+{
+	std::lock_guard<std::mutex> lock(mFileMutex);
+
+	std::vector<const NodeData*> outputs;
+	for (const NodeData& node : mNodes)
+	{
+		// Failed outputs are left out, so the next run builds them again.
+		if (!node.IsFile && node.Done && !node.Failed)
+			outputs.push_back(&node);
+	}
+
+	uint32 fileCount = 0;
+	for (const auto& file : mCheckedFiles)
+		fileCount += file.second.Exists;
+
+	std::ofstream fout(fs::path(path), std::ios::binary | std::ios::trunc);
+	if (!fout)
+		return Fail(error, "cannot create the file");
+
+	Write(fout, FileMagic);
+	Write(fout, FileVersion);
+	Write(fout, fileCount);
+	Write(fout, (uint32)outputs.size());
+
+	for (const auto& file : mCheckedFiles)
+	{
+		if (!file.second.Exists)
+			continue;
+		Write(fout, Utf8(file.first));
+		Write(fout, file.second.Size);
+		Write(fout, file.second.Time);
+		Write(fout, file.second.Digest);
+	}
+
+	for (const NodeData* output : outputs)
+	{
+		Write(fout, output->Name);
+		Write(fout, output->Signature);
+		Write(fout, (uint32)output->Discovered.size());
+		for (const std::wstring& discovered : output->Discovered)
+			Write(fout, Utf8(discovered));
+	}
+
+	if (!fout)
+		return Fail(error, "write failed");
+	return true;
+}
+
+Sha256::Digest DependencyGraph::FileDigest(const std::wstring& path)
+{
+	{
+		std::lock_guard<std::mutex> lock(mFileMutex);
+		auto checked = mCheckedFiles.find(path);
+		if (checked != mCheckedFiles.end())
+			return checked->second.Digest;
+	}
+
+	FileState state;
+	std::error_code ec;
+	const fs::path filePath(path);
+	state.Size = fs::file_size(filePath, ec);
+	if (!ec)
+		state.Time = fs::last_write_time(filePath, ec).time_since_epoch().count();
+	state.Exists = !ec;
+
+	bool hashed = false;
+	if (state.Exists)
+	{
+		// mSavedFiles is only written by Load(), so it is read here without the lock.
+		auto saved = mSavedFiles.find(path);
+		if (saved != mSavedFiles.end() && saved->second.Size == state.Size && saved->second.Time == state.Time)
+		{
+			state.Digest = saved->second.Digest;
+		}
+		else
+		{
+			state.Exists = HashFile(filePath, state.Digest);
+			hashed = true;
+		}
+	}
+
+	// A missing file keeps the zero digest, which no file hashes to.
+	std::lock_guard<std::mutex> lock(mFileMutex);
+	auto result = mCheckedFiles.emplace(path, state);
+	if (result.second && hashed)
+		++mStats.FilesHashed;
+	return result.first->second.Digest;
+}
+
+Sha256::Digest DependencyGraph::Signature(const NodeData& output, const std::vector<std::wstring>& discovered)
+{
+	Sha256 hash;
+	AddString(hash, output.Name);
+	AddString(hash, output.Parameters);
+
+	for (Node input : output.Inputs)
+	{
+		const NodeData& node = mNodes[input];
+		AddString(hash, node.IsFile ? "file" : "output");
+		AddString(hash, node.Name);
+		hash.Update(node.Signature.data(), node.Signature.size());
+	}
+
+	for (const std::wstring& path : discovered)
+	{
+		const Sha256::Digest digest = FileDigest(path);
+		AddString(hash, Utf8(path));
+		hash.Update(digest.data(), digest.size());
+	}
+	return hash.Final();
+}
+
+void DependencyGraph::Process(Node node)
+{
+	NodeData& output = mNodes[node];
+	for (Node input : output.Inputs)
+	{
+		if (mNodes[input].Failed)
+		{
+			output.Failed = true;
+			output.Error = mNodes[input].Name + " failed";
+			return;
+		}
+	}
+
+	auto saved = mSaved.find(output.Name);
+	if (!output.Invalidated && saved != mSaved.end() &&
+		Signature(output, saved->second.Discovered) == saved->second.Signature)
+	{
+		output.Signature = saved->second.Signature;
+		output.Discovered = saved->second.Discovered;
+		return;
+	}
+
+	Step step;
+	bool ok;
+	try
+	{
+		ok = !output.Build || output.Build(step);
+		if (!ok && step.Error.empty())
+			step.Error = "build failed";
+	}
+	catch (const std::exception& e)
+	{
+		ok = false;
+		step.Error = e.what();
+	}
+	catch (...)
+	{
+		ok = false;
+		step.Error = "build threw an exception";
+	}
+
+	if (!ok)
+	{
+		output.Failed = true;
+		output.Error = step.Error;
+		return;
+	}
+
+	std::sort(step.Discovered.begin(), step.Discovered.end());
+	step.Discovered.erase(std::unique(step.Discovered.begin(), step.Discovered.end()), step.Discovered.end());
+	output.Discovered = std::move(step.Discovered);
+	output.Signature = Signature(output, output.Discovered);
+	output.Rebuilt = true;
+}
+
+bool DependencyGraph::Build(unsigned threadCount)
+{
+	auto start = Clock::now();
+	mStats = Stats();
+	mCheckedFiles.clear();
+
+	// The declared files and the ones outputs discovered last time, hashed up front so
+	// the outputs that read them do not wait on each other's I/O.
+	std::vector<std::wstring> paths;
+	for (NodeData& node : mNodes)
+	{
+		node.Done = node.Rebuilt = node.Failed = false;
+		node.Error.clear();
+		if (node.IsFile)
+		{
+			paths.push_back(node.Path);
+			continue;
+		}
+
+		++mStats.Outputs;
+		auto saved = mSaved.find(node.Name);
+		if (saved != mSaved.end())
+			paths.insert(paths.end(), saved->second.Discovered.begin(), saved->second.Discovered.end());
+	}
+	std::sort(paths.begin(), paths.end());
+	paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+	ParallelFor::For(paths.size(), 1, [&](size_t i) { FileDigest(paths[i]); });
+
+	// Kahn's algorithm, with the ready outputs shared by a pool of threads.
+	std::vector<size_t> waiting(mNodes.size(), 0);
+	std::vector<Node> ready;
+	for (Node node = 0; node < (Node)mNodes.size(); ++node)
+	{
+		NodeData& data = mNodes[node];
+		if (data.IsFile)
+		{
+			data.Signature = FileDigest(data.Path);
+			data.Done = true;
+			continue;
+		}
+
+		for (Node input : data.Inputs)
+			waiting[node] += !mNodes[input].IsFile;
+		if (waiting[node] == 0)
+			ready.push_back(node);
+	}
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	size_t running = 0;
+	auto worker = [&]()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			wake.wait(lock, [&]() { return !ready.empty() || running == 0; });
+			if (ready.empty())
+				return;
+
+			const Node node = ready.back();
+			ready.pop_back();
+			++running;
+
+			lock.unlock();
+			Process(node);
+			lock.lock();
+
+			mNodes[node].Done = true;
+			--running;
+			for (Node dependent : mNodes[node].Dependents)
+			{
+				if (--waiting[dependent] == 0)
+					ready.push_back(dependent);
+			}
+			wake.notify_all();
+		}
+	};
+
+	if (threadCount == 0)
+		threadCount = ParallelFor::WorkerCount();
+	std::vector<std::thread> threads;
+	for (unsigned i = 1; i < threadCount; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	for (NodeData& node : mNodes)
+	{
+		if (node.IsFile)
+			continue;
+
+		if (!node.Done)
+		{
+			node.Done = node.Failed = true;
+			node.Error = "dependency cycle";
+		}
+		mStats.Rebuilt += node.Rebuilt;
+		mStats.Failed += node.Failed;
+	}
+
+	mStats.Files = mCheckedFiles.size();
+	mStats.Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	return mStats.Failed == 0;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Sha256.h"
+
+// Records what each cooked output was built from, so the next run rebuilds only the
+// outputs whose inputs changed.  Inputs are files, or other outputs; files are compared
+// by SHA-256, and only hashed again when their size or time differs from the last run.
+//
+// An output's signature is the digest of its name, its parameters, and the signatures
+// of its inputs.  Build() runs the outputs whose signature differs from the one saved,
+// on several threads, each once the outputs it reads have finished.  A build may report
+// files it found it needed on the way, such as a shader's #include chain; those are
+// saved with the output and are part of its signature from then on, the way a compiler's
+// dependency file is.
+class DependencyGraph
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+	using Node = uint32;
+
+	static const uint32 FileMagic = 0x5045444C; // "LDEP"
+	static const uint32 FileVersion = 1;
+
+	struct Step
+	{
+		// Set when the build fails.
+		std::string Error;
+		// Files read beyond the declared inputs.
+		std::vector<std::wstring> Discovered;
+	};
+	using BuildFn = std::function<bool(Step& step)>;
+
+	struct Stats
+	{
+		size_t Files = 0;
+		// Files whose size or time had changed, or that were new.
+		size_t FilesHashed = 0;
+		size_t Outputs = 0;
+		size_t Rebuilt = 0;
+		size_t Failed = 0;
+		double Milliseconds = 0.0;
+	};
+
+	Node AddFile(const std::wstring& path);
+	// 'parameters' is whatever besides the inputs shapes the output: tool version, settings.
+	Node AddOutput(const std::string& name, const std::string& parameters, BuildFn build);
+	// 'output' reads 'input', a file or another output.
+	void AddInput(Node output, Node input);
+	// Rebuilds 'output' even if nothing it reads changed, e.g. because its result was lost.
+	void Invalidate(Node output);
+
+	// The state a previous run saved.  False if there is none or it is unreadable, which
+	// only means every output is built.
+	bool Load(const std::wstring& path);
+	bool Save(const std::wstring& path, std::string* error = nullptr) const;
+
+	// 0 threads means one per hardware thread.  False if any output failed, including
+	// outputs whose inputs failed and outputs on a cycle.
+	bool Build(unsigned threadCount = 0);
+
+	bool WasRebuilt(Node output) const { return mNodes[output].Rebuilt; }
+	const std::string& GetError(Node output) const { return mNodes[output].Error; }
+	const std::string& GetName(Node node) const { return mNodes[node].Name; }
+	const Stats& GetStats() const { return mStats; }
+
+private:
+	struct FileState
+	{
+		uint64 Size = 0;
+		std::int64_t Time = 0;
+		Sha256::Digest Digest = {};
+		bool Exists = false;
+	};
+
+	struct Record
+	{
+		Sha256::Digest Signature = {};
+		std::vector<std::wstring> Discovered;
+	};
+
+	struct NodeData
+	{
+		bool IsFile = false;
+		// The path for files.
+		std::string Name;
+		std::wstring Path;
+
+		std::string Parameters;
+		BuildFn Build;
+		std::vector<Node> Inputs;
+		std::vector<Node> Dependents;
+		bool Invalidated = false;
+
+		// Filled by Build().
+		Sha256::Digest Signature = {};
+		std::vector<std::wstring> Discovered;
+		bool Done = false;
+		bool Rebuilt = false;
+		bool Failed = false;
+		std::string Error;
+	};
+
+	// Thread-safe; hashes the file unless the saved state says it has not changed.
+	Sha256::Digest FileDigest(const std::wstring& path);
+	Sha256::Digest Signature(const NodeData& output, const std::vector<std::wstring>& discovered);
+	void Process(Node output);
+
+	std::vector<NodeData> mNodes;
+	std::map<std::wstring, Node> mFiles;
+
+	// From Load(), by output name and by path.
+	std::map<std::string, Record> mSaved;
+	std::map<std::wstring, FileState> mSavedFiles;
+
+	// Every file Build() looked at, which Save() writes.
+	mutable std::mutex mFileMutex;
+	std::map<std::wstring, FileState> mCheckedFiles;
+
+	Stats mStats;
+};
@@ -0,0 +1,128 @@
+#include "Flipbook.h"
+#include <filesystem>
+#include <memory>
+#include "DDSFile.h"
+#include "MappedFile.h"
+
+namespace
+{
+	bool Fail(std::string* error, const std::string& what)
+	{
+		if (error != nullptr)
+			*error = what;
+		return false;
+	}
+
+	// Splits "prefix%0Nd suffix" into its parts.  Returns false if there is no conversion.
+	template<typename Char>
+	bool SplitPattern(const std::basic_string<Char>& pattern, std::basic_string<Char>& prefix,
+		std::basic_string<Char>& suffix, size_t& width)
+	{
+		const size_t percent = pattern.find(Char('%'));
+		if (percent == std::basic_string<Char>::npos)
+			return false;
+
+		size_t i = percent + 1;
+		width = 0;
+		while (i < pattern.size() && pattern[i] >= Char('0') && pattern[i] <= Char('9'))
+			width = width * 10 + (size_t)(pattern[i++] - Char('0'));
+		if (i >= pattern.size() || pattern[i] != Char('d'))
+			return false;
+
+		prefix = pattern.substr(0, percent);
+		suffix = pattern.substr(i + 1);
+		return true;
+	}
+}
+
+std::vector<std::wstring> Flipbook::FramePaths(const std::wstring& pattern, int first)
+{
+	std::vector<std::wstring> paths;
+	std::wstring prefix, suffix;
+	size_t width;
+	if (!SplitPattern(pattern, prefix, suffix, width))
+		return paths;
+
+	for (int i = first;; ++i)
+	{
+		std::wstring number = std::to_wstring(i);
+		if (number.size() < width)
+			number.insert(0, width - number.size(), L'0');
+
+		std::wstring path = prefix + number + suffix;
+		std::error_code ec;
+		if (!std::filesystem::is_regular_file(path, ec))
+			break;
+		paths.push_back(std::move(path));
+	}
+	return paths;
+}
+
+std::string Flipbook::ArrayName(const std::string& pattern)
+{
+	std::string prefix, suffix;
+	size_t width;
+	return SplitPattern(pattern, prefix, suffix, width) ? prefix + suffix : pattern;
+}
+
+bool Flipbook::Build(const std::vector<const void*>& frames, const std::vector<size_t>& sizes,
+	std::vector<std::uint8_t>& dds, std::string* error)
+{
+	dds.clear();
+	if (frames.empty() || frames.size() != sizes.size())
+		return Fail(error, "no frames");
+
+	std::vector<DDSFile::Info> infos(frames.size());
+	size_t payload = 0;
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		DDSFile::Info& info = infos[i];
+		std::string frameError;
+		if (!DDSFile::Parse(frames[i], sizes[i], sizes[i], info, 0, &frameError))
+			return Fail(error, "frame " + std::to_string(i) + ": " + frameError);
+		if (info.ResourceDimension != DDSFile::Texture2D || info.ArraySize != 1)
+			return Fail(error, "frame " + std::to_string(i) + ": not a single 2D texture");
+
+		const DDSFile::Info& first = infos[0];
+		if (info.Format != first.Format || info.Width != first.Width || info.Height != first.Height ||
+			info.MipCount != first.MipCount)
+		{
+			return Fail(error, "frame " + std::to_string(i) + ": format, size or mips differ from frame 0");
+		}
+
+		const DDSFile::Subresource& last = info.Subresources.back();
+		payload += (size_t)(last.Offset + last.SliceBytes - info.DataOffset);
+	}
+
+	// A DDS array is stored slice by slice, each with its mips, so the frames' pixel data
+	// follows the new header as it is.
+	DDSFile::Info array = infos[0];
+	array.ArraySize = (DDSFile::uint32)frames.size();
+	dds.reserve(DDSFile::MaxHeaderBytes + payload);
+	DDSFile::WriteHeader(array, dds);
+
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		const DDSFile::Info& info = infos[i];
+		const std::uint8_t* bytes = static_cast<const std::uint8_t*>(frames[i]);
+		const DDSFile::Subresource& last = info.Subresources.back();
+		dds.insert(dds.end(), bytes + info.DataOffset, bytes + last.Offset + last.SliceBytes);
+	}
+	return true;
+}
+
+bool Flipbook::Build(const std::vector<std::wstring>& paths, std::vector<std::uint8_t>& dds, std::string* error)
+{
+	std::vector<std::unique_ptr<MappedFile>> files;
+	std::vector<const void*> frames;
+	std::vector<size_t> sizes;
+	for (const std::wstring& path : paths)
+	{
+		files.push_back(std::make_unique<MappedFile>());
+		if (!files.back()->Open(path))
+			return Fail(error, "cannot open " + std::filesystem::path(path).generic_string());
+		frames.push_back(files.back()->Data());
+		sizes.push_back(files.back()->Size());
+	}
+	return Build(frames, sizes, dds, error);
+}
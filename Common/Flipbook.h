@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A numbered sequence of DDS frames, such as Textures/BoltAnim/Bolt%03d.dds, joined into one
+// Texture2DArray DDS with a frame per slice.  The array is one resource, one upload and one
+// SRV, where the frames as separate textures need one of each per frame; a shader picks
+// the frame by slice index.
+//
+// Tools/AssetCooker builds the array offline (--flipbook); loaders without a cooked one
+// can build it from the frames at load time, which costs one copy of the pixel data.
+class Flipbook
+{
+public:
+	// 'pattern' with its integer conversion (%d, or %0Nd for zero padding) formatted with
+	// first, first + 1, ..., up to the last of those files that exists.  Empty if the
+	// pattern has no conversion or the first frame is missing.
+	static std::vector<std::wstring> FramePaths(const std::wstring& pattern, int first = 1);
+
+	// The name the array goes by: 'pattern' without its conversion, so
+	// BoltAnim/Bolt%03d.dds is BoltAnim/Bolt.dds.
+	static std::string ArrayName(const std::string& pattern);
+
+	// Joins the frames into 'dds'.  Each must be a single 2D texture, and all must share a
+	// format, size and mip count; the alpha mode is the first frame's.
+	static bool Build(const std::vector<const void*>& frames, const std::vector<size_t>& sizes,
+		std::vector<std::uint8_t>& dds, std::string* error = nullptr);
+
+	// Maps the files and joins them.
+	static bool Build(const std::vector<std::wstring>& paths, std::vector<std::uint8_t>& dds,
+		std::string* error = nullptr);
+};
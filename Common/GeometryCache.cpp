@@ -0,0 +1,265 @@
+#include "GeometryCache.h"
+#include "Hash.h"
+#include "MeshWelder.h"
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	// "GEOC" followed by a format version; bump the version whenever MeshData changes.
+	const std::uint32_t CacheFileMagic = 0x434F4547;
+	const std::uint32_t CacheFileVersion = 2;
+
+	template<typename T>
+	void WritePod(std::ofstream& fout, const T& value)
+	{
+		fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	bool ReadPod(std::ifstream& fin, T& value)
+	{
+		fin.read(reinterpret_cast<char*>(&value), sizeof(T));
+		return (bool)fin;
+	}
+}
+
+size_t GeometryCache::KeyHasher::operator()(const Key& key) const
+{
+	std::uint64_t h = Hash::Fnv1a64(&key.Type, sizeof(key.Type));
+	h = Hash::Fnv1a64(key.Params.data(), sizeof(uint32) * key.Params.size(), h);
+	return static_cast<size_t>(h);
+}
+
+GeometryCache::uint32 GeometryCache::AsBits(float f)
+{
+	// Key on the exact bit pattern so 1.5f and 1.5000001f are different meshes.
+	uint32 bits;
+	std::memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+template<typename CreateFn>
+GeometryCache::MeshPtr GeometryCache::GetOrCreate(const Key& key, CreateFn create)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mMeshes.find(key);
+		if (it != mMeshes.end())
+		{
+			++mStats.Hits;
+			return it->second;
+		}
+	}
+
+	// Generate outside the lock so independent meshes can be built concurrently.
+	GeometryGenerator geoGen;
+	MeshPtr mesh = std::make_shared<const GeometryGenerator::MeshData>(create(geoGen));
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	++mStats.Misses;
+	auto result = mMeshes.emplace(key, mesh);
+	if (result.second)
+		mDirty = true;
+
+	return result.first->second;
+}
+
+GeometryCache::MeshPtr GeometryCache::GetBox(float width, float height, float depth, uint32 numSubdivisions)
+{
+	Key key;
+	key.Type = Generator::Box;
+	key.Params = { AsBits(width), AsBits(height), AsBits(depth), numSubdivisions };
+
+	return GetOrCreate(key, [&](GeometryGenerator& geoGen)
+	{
+		// Subdivide emits the corners of every triangle separately; share them again.
+		GeometryGenerator::MeshData mesh = geoGen.CreateBox(width, height, depth, numSubdivisions);
+		MeshWelder::Weld(mesh);
+		return mesh;
+	});
+}
+
+GeometryCache::MeshPtr GeometryCache::GetSphere(float radius, uint32 sliceCount, uint32 stackCount)
+{
+	Key key;
+	key.Type = Generator::Sphere;
+	key.Params = { AsBits(radius), sliceCount, stackCount };
+
+	return GetOrCreate(key, [&](GeometryGenerator& geoGen)
+	{
+		return geoGen.CreateSphere(radius, sliceCount, stackCount);
+	});
+}
+
+GeometryCache::MeshPtr GeometryCache::GetGeosphere(float radius, uint32 numSubdivisions)
+{
+	Key key;
+	key.Type = Generator::Geosphere;
+	key.Params = { AsBits(radius), numSubdivisions };
+
+	return GetOrCreate(key, [&](GeometryGenerator& geoGen)
+	{
+		GeometryGenerator::MeshData mesh = geoGen.CreateGeosphere(radius, numSubdivisions);
+		MeshWelder::Weld(mesh);
+		return mesh;
+	});
+}
+
+GeometryCache::MeshPtr GeometryCache::GetCylinder(float bottomRadius, float topRadius, float height,
+	uint32 sliceCount, uint32 stackCount, bool hasTop, bool hasBottom)
+{
+	Key key;
+	key.Type = Generator::Cylinder;
+	key.Params = { AsBits(bottomRadius), AsBits(topRadius), AsBits(height),
+		sliceCount, stackCount, hasTop ? 1u : 0u, hasBottom ? 1u : 0u };
+
+	return GetOrCreate(key, [&](GeometryGenerator& geoGen)
+	{
+		return geoGen.CreateCylinder(bottomRadius, topRadius, height, sliceCount, stackCount, hasTop, hasBottom);
+	});
+}
+
+GeometryCache::MeshPtr GeometryCache::GetGrid(float width, float depth, uint32 m, uint32 n)
+{
+	Key key;
+	key.Type = Generator::Grid;
+	key.Params = { AsBits(width), AsBits(depth), m, n };
+
+	return GetOrCreate(key, [&](GeometryGenerator& geoGen)
+	{
+		return geoGen.CreateGrid(width, depth, m, n);
+	});
+}
+
+GeometryCache::MeshPtr GeometryCache::GetQuad(float x, float y, float w, float h, float depth)
+{
+	Key key;
+	key.Type = Generator::Quad;
+	key.Params = { AsBits(x), AsBits(y), AsBits(w), AsBits(h), AsBits(depth) };
+
+	return GetOrCreate(key, [&](GeometryGenerator& geoGen)
+	{
+		return geoGen.CreateQuad(x, y, w, h, depth);
+	});
+}
+
+bool GeometryCache::LoadFromFile(const std::string& fileName)
+{
+	std::ifstream fin(fileName, std::ios::binary | std::ios::ate);
+	if (!fin)
+		return false;
+
+	// Every count below is checked against the bytes still in the file before anything is
+	// allocated for it, so a truncated or corrupt file is a miss rather than a bad_alloc.
+	std::uint64_t remaining = (std::uint64_t)fin.tellg();
+	fin.seekg(0);
+
+	uint32 magic = 0, version = 0, vertexSize = 0, meshCount = 0;
+	if (!ReadPod(fin, magic) || !ReadPod(fin, version) || !ReadPod(fin, vertexSize) || !ReadPod(fin, meshCount))
+		return false;
+
+	if (magic != CacheFileMagic || version != CacheFileVersion ||
+		vertexSize != sizeof(GeometryGenerator::Vertex))
+		return false;
+
+	const std::uint64_t meshHeaderSize = sizeof(Generator) + sizeof(Key::Params) + 2 * sizeof(uint32);
+	remaining -= 4 * sizeof(uint32);
+	if (meshCount > remaining / meshHeaderSize)
+		return false;
+
+	std::vector<std::pair<Key, MeshPtr>> loaded;
+	loaded.reserve(meshCount);
+
+	for (uint32 i = 0; i < meshCount; ++i)
+	{
+		Key key;
+		uint32 vertexCount = 0, indexCount = 0;
+		if (!ReadPod(fin, key.Type) || !ReadPod(fin, key.Params) ||
+			!ReadPod(fin, vertexCount) || !ReadPod(fin, indexCount))
+			return false;
+		remaining -= meshHeaderSize;
+
+		const std::uint64_t meshBytes = (std::uint64_t)sizeof(GeometryGenerator::Vertex) * vertexCount +
+			(std::uint64_t)sizeof(uint32) * indexCount;
+		if (key.Type > Generator::Quad || meshBytes > remaining)
+			return false;
+		remaining -= meshBytes;
+
+		auto mesh = std::make_shared<GeometryGenerator::MeshData>();
+		mesh->Vertices.resize(vertexCount);
+		mesh->Indices32.resize(indexCount);
+		fin.read(reinterpret_cast<char*>(mesh->Vertices.data()), sizeof(GeometryGenerator::Vertex) * vertexCount);
+		fin.read(reinterpret_cast<char*>(mesh->Indices32.data()), sizeof(uint32) * indexCount);
+		if (!fin)
+			return false;
+
+		for (uint32 index : mesh->Indices32)
+		{
+			if (index >= vertexCount)
+				return false;
+		}
+
+		loaded.emplace_back(key, std::move(mesh));
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (auto& e : loaded)
+	{
+		if (mMeshes.emplace(e.first, std::move(e.second)).second)
+			++mStats.LoadedFromDisk;
+	}
+
+	return true;
+}
+
+bool GeometryCache::SaveToFile(const std::string& fileName)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	std::ofstream fout(fileName, std::ios::binary | std::ios::trunc);
+	if (!fout)
+		return false;
+
+	WritePod(fout, CacheFileMagic);
+	WritePod(fout, CacheFileVersion);
+	WritePod(fout, (uint32)sizeof(GeometryGenerator::Vertex));
+	WritePod(fout, (uint32)mMeshes.size());
+
+	for (const auto& e : mMeshes)
+	{
+		const auto& mesh = *e.second;
+		WritePod(fout, e.first.Type);
+		WritePod(fout, e.first.Params);
+		WritePod(fout, (uint32)mesh.Vertices.size());
+		WritePod(fout, (uint32)mesh.Indices32.size());
+		fout.write(reinterpret_cast<const char*>(mesh.Vertices.data()), sizeof(GeometryGenerator::Vertex) * mesh.Vertices.size());
+		fout.write(reinterpret_cast<const char*>(mesh.Indices32.data()), sizeof(uint32) * mesh.Indices32.size());
+	}
+
+	if (!fout)
+		return false;
+
+	mDirty = false;
+	return true;
+}
+
+bool GeometryCache::IsDirty() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mDirty;
+}
+
+GeometryCache::Stats GeometryCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+void GeometryCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mMeshes.clear();
+	mStats = Stats();
+	mDirty = false;
+}
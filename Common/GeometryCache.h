@@ -0,0 +1,98 @@
+//***************************************************************************************
+// GeometryCache.h
+//
+// Memoizes GeometryGenerator output.  Meshes are keyed by generator type plus the
+// exact parameter values, shared as immutable MeshData, and can be persisted to a
+// binary file so later runs skip procedural generation entirely.  Boxes and
+// geospheres come back welded (see MeshWelder), so their vertex count and order differ
+// from what CreateBox and CreateGeosphere return; the other shapes are unchanged.
+//***************************************************************************************
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "GeometryGenerator.h"
+
+class GeometryCache
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+	using MeshPtr = std::shared_ptr<const GeometryGenerator::MeshData>;
+
+	struct Stats
+	{
+		uint64 Hits = 0;
+		uint64 Misses = 0;
+		uint64 LoadedFromDisk = 0;
+	};
+
+	GeometryCache() = default;
+	GeometryCache(const GeometryCache& rhs) = delete;
+	GeometryCache& operator=(const GeometryCache& rhs) = delete;
+
+	// Same parameters as the GeometryGenerator functions of the same name.  GetBox and
+	// GetGeosphere weld the generator's output, so the same triangles come back with
+	// shared vertices in a different order.
+	MeshPtr GetBox(float width, float height, float depth, uint32 numSubdivisions);
+	MeshPtr GetSphere(float radius, uint32 sliceCount, uint32 stackCount);
+	MeshPtr GetGeosphere(float radius, uint32 numSubdivisions);
+	MeshPtr GetCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+		bool hasTop = true, bool hasBottom = true);
+	MeshPtr GetGrid(float width, float depth, uint32 m, uint32 n);
+	MeshPtr GetQuad(float x, float y, float w, float h, float depth);
+
+	// Merges the meshes stored in fileName into the cache.  Returns false, and merges
+	// nothing, if the file is missing, truncated, corrupt (counts larger than the file or
+	// indices past a mesh's vertices) or was written with an incompatible vertex layout.
+	bool LoadFromFile(const std::string& fileName);
+
+	// Writes every cached mesh to fileName.
+	bool SaveToFile(const std::string& fileName);
+
+	// True when meshes were generated since the last load/save.
+	bool IsDirty() const;
+
+	Stats GetStats() const;
+	void Clear();
+
+private:
+	enum class Generator : uint32
+	{
+		Box = 0,
+		Sphere,
+		Geosphere,
+		Cylinder,
+		Grid,
+		Quad
+	};
+
+	static const size_t MaxParams = 7;
+
+	struct Key
+	{
+		Generator Type = Generator::Box;
+		std::array<uint32, MaxParams> Params = {};
+
+		bool operator==(const Key& rhs) const { return Type == rhs.Type && Params == rhs.Params; }
+	};
+
+	struct KeyHasher
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	static uint32 AsBits(float f);
+
+	template<typename CreateFn>
+	MeshPtr GetOrCreate(const Key& key, CreateFn create);
+
+	mutable std::mutex mMutex;
+	std::unordered_map<Key, MeshPtr, KeyHasher> mMeshes;
+	Stats mStats;
+	bool mDirty = false;
+};
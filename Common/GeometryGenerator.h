@@ -16,7 +16,9 @@
 
 #include <cstdint>
 #include <DirectXMath.h>
+#include <stdexcept>
 #include <vector>
+#include "IndexBuilder.h"
 
 class GeometryGenerator
 {
@@ -58,13 +60,19 @@ public:
 		std::vector<Vertex> Vertices;
         std::vector<uint32> Indices32;
 
+        // Throws std::length_error, in every build, when an index does not fit in 16 bits;
+        // use Indices32 (or MeshPacker, which splits them into batches) for larger meshes.
         std::vector<uint16>& GetIndices16()
         {
-			if(mIndices16.empty())
+			if(mIndices16.empty() && !Indices32.empty())
 			{
+				uint32 minIndex, maxIndex;
+				IndexBuilder::MinMax(Indices32.data(), Indices32.size(), minIndex, maxIndex);
+				if(maxIndex > 0xffff)
+					throw std::length_error("MeshData::GetIndices16: mesh too large for 16-bit indices");
+
 				mIndices16.resize(Indices32.size());
-				for(size_t i = 0; i < Indices32.size(); ++i)
-					mIndices16[i] = static_cast<uint16>(Indices32[i]);
+				IndexBuilder::Narrow16(Indices32.data(), mIndices16.data(), Indices32.size());
 			}
 
 			return mIndices16;
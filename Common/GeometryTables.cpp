@@ -0,0 +1,267 @@
+#include "GeometryTables.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	// Plain aggregates with the layouts of GeometryGenerator::Vertex and XMFLOAT3, so they
+	// can be built and copied in constant expressions.
+	struct TableVertex
+	{
+		float Position[3];
+		float Normal[3];
+		float TangentU[3];
+		float TexC[2];
+	};
+
+	struct TablePosition
+	{
+		float Position[3];
+	};
+
+	static_assert(sizeof(TableVertex) == sizeof(GeometryGenerator::Vertex), "TableVertex must match GeometryGenerator::Vertex");
+	static_assert(offsetof(TableVertex, Normal) == offsetof(GeometryGenerator::Vertex, Normal), "TableVertex must match GeometryGenerator::Vertex");
+	static_assert(offsetof(TableVertex, TangentU) == offsetof(GeometryGenerator::Vertex, TangentU), "TableVertex must match GeometryGenerator::Vertex");
+	static_assert(offsetof(TableVertex, TexC) == offsetof(GeometryGenerator::Vertex, TexC), "TableVertex must match GeometryGenerator::Vertex");
+	static_assert(sizeof(TablePosition) == sizeof(DirectX::XMFLOAT3), "TablePosition must match XMFLOAT3");
+
+	template<typename V, std::size_t NV, std::size_t NI>
+	struct MeshTable
+	{
+		V Vertices[NV];
+		uint32 Indices[NI];
+	};
+
+	// Newton iteration from above; converges monotonically, exact for 0 and 1.
+	constexpr double Sqrt(double x)
+	{
+		if (x <= 0.0)
+			return 0.0;
+
+		double r = x > 1.0 ? x : 1.0;
+		for (int i = 0; i < 64; ++i)
+		{
+			double next = 0.5 * (r + x / r);
+			if (next >= r)
+				break;
+			r = next;
+		}
+		return r;
+	}
+
+	// Same as XMVector3Normalize, including leaving zero vectors untouched.
+	constexpr void Normalize(float v[3])
+	{
+		float lengthSq = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+		if (lengthSq > 0.0f)
+		{
+			float length = (float)Sqrt(lengthSq);
+			v[0] /= length;
+			v[1] /= length;
+			v[2] /= length;
+		}
+	}
+
+	// Mirrors GeometryGenerator::MidPoint.
+	constexpr TableVertex MidPoint(const TableVertex& v0, const TableVertex& v1)
+	{
+		TableVertex m{};
+		for (int i = 0; i < 3; ++i)
+		{
+			m.Position[i] = 0.5f * (v0.Position[i] + v1.Position[i]);
+			m.Normal[i] = 0.5f * (v0.Normal[i] + v1.Normal[i]);
+			m.TangentU[i] = 0.5f * (v0.TangentU[i] + v1.TangentU[i]);
+		}
+		for (int i = 0; i < 2; ++i)
+			m.TexC[i] = 0.5f * (v0.TexC[i] + v1.TexC[i]);
+
+		Normalize(m.Normal);
+		Normalize(m.TangentU);
+		return m;
+	}
+
+	constexpr TablePosition MidPoint(const TablePosition& v0, const TablePosition& v1)
+	{
+		TablePosition m{};
+		for (int i = 0; i < 3; ++i)
+			m.Position[i] = 0.5f * (v0.Position[i] + v1.Position[i]);
+		return m;
+	}
+
+	// Mirrors GeometryGenerator::Subdivide, so table levels match runtime subdivision
+	// vertex for vertex.
+	template<typename V, std::size_t NV, std::size_t NI>
+	constexpr MeshTable<V, NI / 3 * 6, NI * 4> Subdivide(const MeshTable<V, NV, NI>& in)
+	{
+		MeshTable<V, NI / 3 * 6, NI * 4> out{};
+
+		for (uint32 i = 0; i < (uint32)(NI / 3); ++i)
+		{
+			const V& v0 = in.Vertices[in.Indices[i * 3 + 0]];
+			const V& v1 = in.Vertices[in.Indices[i * 3 + 1]];
+			const V& v2 = in.Vertices[in.Indices[i * 3 + 2]];
+
+			out.Vertices[i * 6 + 0] = v0;
+			out.Vertices[i * 6 + 1] = v1;
+			out.Vertices[i * 6 + 2] = v2;
+			out.Vertices[i * 6 + 3] = MidPoint(v0, v1);
+			out.Vertices[i * 6 + 4] = MidPoint(v1, v2);
+			out.Vertices[i * 6 + 5] = MidPoint(v0, v2);
+
+			const uint32 tri[12] =
+			{
+				0, 3, 5,
+				3, 4, 5,
+				5, 4, 2,
+				3, 1, 4
+			};
+			for (uint32 k = 0; k < 12; ++k)
+				out.Indices[i * 12 + k] = i * 6 + tri[k];
+		}
+
+		return out;
+	}
+
+	constexpr MeshTable<TableVertex, 24, 36> kBox0 =
+	{
+		{
+			// Front face.
+			{ { -0.5f, -0.5f, -0.5f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f } },
+			{ { -0.5f, +0.5f, -0.5f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+			{ { +0.5f, +0.5f, -0.5f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } },
+			{ { +0.5f, -0.5f, -0.5f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f } },
+
+			// Back face.
+			{ { -0.5f, -0.5f, +0.5f }, { 0.0f, 0.0f, 1.0f }, { -1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f } },
+			{ { +0.5f, -0.5f, +0.5f }, { 0.0f, 0.0f, 1.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f } },
+			{ { +0.5f, +0.5f, +0.5f }, { 0.0f, 0.0f, 1.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+			{ { -0.5f, +0.5f, +0.5f }, { 0.0f, 0.0f, 1.0f }, { -1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } },
+
+			// Top face.
+			{ { -0.5f, +0.5f, -0.5f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f } },
+			{ { -0.5f, +0.5f, +0.5f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+			{ { +0.5f, +0.5f, +0.5f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } },
+			{ { +0.5f, +0.5f, -0.5f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f } },
+
+			// Bottom face.
+			{ { -0.5f, -0.5f, -0.5f }, { 0.0f, -1.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f } },
+			{ { +0.5f, -0.5f, -0.5f }, { 0.0f, -1.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f } },
+			{ { +0.5f, -0.5f, +0.5f }, { 0.0f, -1.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+			{ { -0.5f, -0.5f, +0.5f }, { 0.0f, -1.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } },
+
+			// Left face.
+			{ { -0.5f, -0.5f, +0.5f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f } },
+			{ { -0.5f, +0.5f, +0.5f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f } },
+			{ { -0.5f, +0.5f, -0.5f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f } },
+			{ { -0.5f, -0.5f, -0.5f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 1.0f } },
+
+			// Right face.
+			{ { +0.5f, -0.5f, -0.5f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f } },
+			{ { +0.5f, +0.5f, -0.5f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f } },
+			{ { +0.5f, +0.5f, +0.5f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f } },
+			{ { +0.5f, -0.5f, +0.5f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f } },
+		},
+		{
+			0, 1, 2,     0, 2, 3,
+			4, 5, 6,     4, 6, 7,
+			8, 9, 10,    8, 10, 11,
+			12, 13, 14,  12, 14, 15,
+			16, 17, 18,  16, 18, 19,
+			20, 21, 22,  20, 22, 23
+		}
+	};
+
+	constexpr auto kBox1 = Subdivide(kBox0);
+	constexpr auto kBox2 = Subdivide(kBox1);
+	constexpr auto kBox3 = Subdivide(kBox2);
+
+	constexpr MeshTable<TableVertex, 4, 6> kQuad =
+	{
+		{
+			{ { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f } },
+			{ { 0.0f,  0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+			{ { 1.0f,  0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } },
+			{ { 1.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f } },
+		},
+		{
+			0, 1, 2,
+			0, 2, 3
+		}
+	};
+
+	constexpr float X = 0.525731f;
+	constexpr float Z = 0.850651f;
+
+	constexpr MeshTable<TablePosition, 12, 60> kIcosahedron0 =
+	{
+		{
+			{ { -X, 0.0f, Z } },  { { X, 0.0f, Z } },
+			{ { -X, 0.0f, -Z } }, { { X, 0.0f, -Z } },
+			{ { 0.0f, Z, X } },   { { 0.0f, Z, -X } },
+			{ { 0.0f, -Z, X } },  { { 0.0f, -Z, -X } },
+			{ { Z, X, 0.0f } },   { { -Z, X, 0.0f } },
+			{ { Z, -X, 0.0f } },  { { -Z, -X, 0.0f } }
+		},
+		{
+			1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,
+			1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,
+			3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0,
+			10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7
+		}
+	};
+
+	constexpr auto kIcosahedron1 = Subdivide(kIcosahedron0);
+	constexpr auto kIcosahedron2 = Subdivide(kIcosahedron1);
+	constexpr auto kIcosahedron3 = Subdivide(kIcosahedron2);
+
+	template<std::size_t NV, std::size_t NI>
+	GeometryTables::MeshView MakeView(const MeshTable<TableVertex, NV, NI>& table)
+	{
+		return
+		{
+			reinterpret_cast<const GeometryGenerator::Vertex*>(table.Vertices), (uint32)NV,
+			table.Indices, (uint32)NI
+		};
+	}
+
+	template<std::size_t NV, std::size_t NI>
+	GeometryTables::PositionView MakeView(const MeshTable<TablePosition, NV, NI>& table)
+	{
+		return
+		{
+			reinterpret_cast<const DirectX::XMFLOAT3*>(table.Vertices), (uint32)NV,
+			table.Indices, (uint32)NI
+		};
+	}
+}
+
+const GeometryTables::uint32 GeometryTables::MaxSubdivisions;
+
+GeometryTables::MeshView GeometryTables::Box(uint32 numSubdivisions)
+{
+	switch (std::min(numSubdivisions, MaxSubdivisions))
+	{
+	case 0: return MakeView(kBox0);
+	case 1: return MakeView(kBox1);
+	case 2: return MakeView(kBox2);
+	default: return MakeView(kBox3);
+	}
+}
+
+GeometryTables::MeshView GeometryTables::Quad()
+{
+	return MakeView(kQuad);
+}
+
+GeometryTables::PositionView GeometryTables::Icosahedron(uint32 numSubdivisions)
+{
+	switch (std::min(numSubdivisions, MaxSubdivisions))
+	{
+	case 0: return MakeView(kIcosahedron0);
+	case 1: return MakeView(kIcosahedron1);
+	case 2: return MakeView(kIcosahedron2);
+	default: return MakeView(kIcosahedron3);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include "GeometryGenerator.h"
+
+// Read-only vertex and index tables for the fixed-size primitives of GeometryGenerator.
+// The tables, including their first subdivision levels, are generated at compile time
+// and live in the binary's constant data, so they can be copied or uploaded directly.
+class GeometryTables
+{
+public:
+	using uint32 = std::uint32_t;
+
+	// Deepest subdivision level stored in a table.  Deeper levels are subdivided at runtime.
+	static const uint32 MaxSubdivisions = 3;
+
+	struct MeshView
+	{
+		const GeometryGenerator::Vertex* Vertices;
+		uint32 VertexCount;
+		const uint32* Indices;
+		uint32 IndexCount;
+	};
+
+	struct PositionView
+	{
+		const DirectX::XMFLOAT3* Positions;
+		uint32 VertexCount;
+		const uint32* Indices;
+		uint32 IndexCount;
+	};
+
+	// 1x1x1 box centered at the origin, subdivided min(numSubdivisions, MaxSubdivisions) times.
+	static MeshView Box(uint32 numSubdivisions);
+
+	// Quad spanning [0, 1] x [-1, 0] at depth 0, i.e. CreateQuad(0, 0, 1, 1, 0).
+	static MeshView Quad();
+
+	// Subdivided icosahedron positions, before they are projected onto the sphere.
+	static PositionView Icosahedron(uint32 numSubdivisions);
+};
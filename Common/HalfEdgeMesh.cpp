@@ -0,0 +1,378 @@
+#include "HalfEdgeMesh.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = HalfEdgeMesh::uint32;
+	using uint64 = std::uint64_t;
+
+	// Marks a directed edge shared by several triangles.
+	const uint32 Duplicate = HalfEdgeMesh::Invalid - 1;
+
+	// Vertex ids are below 2^32 - 1, so no edge key is all ones.
+	const uint64 EmptyKey = ~(uint64)0;
+
+	uint64 EdgeKey(uint32 a, uint32 b)
+	{
+		return (uint64)a << 32 | b;
+	}
+
+	// Directed edge -> half-edge map.  Linear probing over a power-of-two table that is
+	// kept at most half full, so lookups stay short and never allocate.
+	class DirectedEdgeTable
+	{
+	public:
+		explicit DirectedEdgeTable(size_t count)
+		{
+			size_t capacity = 16;
+			int bits = 4;
+			while (capacity < count * 2)
+			{
+				capacity <<= 1;
+				++bits;
+			}
+
+			mShift = 64 - bits;
+			mMask = capacity - 1;
+			mKeys.assign(capacity, EmptyKey);
+			mValues.resize(capacity);
+		}
+
+		void Insert(uint64 key, uint32 value)
+		{
+			for (size_t slot = Slot(key);; slot = (slot + 1) & mMask)
+			{
+				if (mKeys[slot] == EmptyKey)
+				{
+					mKeys[slot] = key;
+					mValues[slot] = value;
+					return;
+				}
+				if (mKeys[slot] == key)
+				{
+					mValues[slot] = Duplicate;
+					return;
+				}
+			}
+		}
+
+		uint32 Find(uint64 key) const
+		{
+			for (size_t slot = Slot(key);; slot = (slot + 1) & mMask)
+			{
+				if (mKeys[slot] == key)
+					return mValues[slot];
+				if (mKeys[slot] == EmptyKey)
+					return HalfEdgeMesh::Invalid;
+			}
+		}
+
+	private:
+		size_t Slot(uint64 key) const
+		{
+			return (size_t)((key * 0x9E3779B97F4A7C15ull) >> mShift);
+		}
+
+		std::vector<uint64> mKeys;
+		std::vector<uint32> mValues;
+		int mShift = 0;
+		size_t mMask = 0;
+	};
+
+	// Like GeometryGenerator::MidPoint: averaged position and texture coordinates,
+	// renormalized normal and tangent.
+	HalfEdgeMesh::Vertex MidPoint(const HalfEdgeMesh::Vertex& v0, const HalfEdgeMesh::Vertex& v1)
+	{
+		HalfEdgeMesh::Vertex v;
+		XMStoreFloat3(&v.Position, XMVectorScale(XMVectorAdd(XMLoadFloat3(&v0.Position), XMLoadFloat3(&v1.Position)), 0.5f));
+		XMStoreFloat3(&v.Normal, XMVector3Normalize(XMVectorAdd(XMLoadFloat3(&v0.Normal), XMLoadFloat3(&v1.Normal))));
+		XMStoreFloat3(&v.TangentU, XMVector3Normalize(XMVectorAdd(XMLoadFloat3(&v0.TangentU), XMLoadFloat3(&v1.TangentU))));
+		XMStoreFloat2(&v.TexC, XMVectorScale(XMVectorAdd(XMLoadFloat2(&v0.TexC), XMLoadFloat2(&v1.TexC)), 0.5f));
+		return v;
+	}
+
+	// Loop's weight for the one-ring of an interior vertex of valence n.
+	float LoopBeta(uint32 n)
+	{
+		float c = 0.375f + 0.25f * cosf(XM_2PI / (float)n);
+		return (0.625f - c * c) / (float)n;
+	}
+}
+
+const HalfEdgeMesh::uint32 HalfEdgeMesh::Invalid;
+
+HalfEdgeMesh::HalfEdgeMesh(const GeometryGenerator::MeshData& mesh) :
+	mVertices(mesh.Vertices),
+	mIndices(mesh.Indices32)
+{
+	BuildAdjacency();
+}
+
+HalfEdgeMesh::HalfEdgeMesh(std::vector<Vertex> vertices, std::vector<uint32> indices) :
+	mVertices(std::move(vertices)),
+	mIndices(std::move(indices))
+{
+	BuildAdjacency();
+}
+
+void HalfEdgeMesh::BuildAdjacency()
+{
+	const size_t halfEdgeCount = mIndices.size() - mIndices.size() % 3;
+	mIndices.resize(halfEdgeCount);
+
+	mTwins.assign(halfEdgeCount, Invalid);
+	mNonManifoldHalfEdges = 0;
+
+	DirectedEdgeTable table(halfEdgeCount);
+	for (uint32 he = 0; he < (uint32)halfEdgeCount; ++he)
+		table.Insert(EdgeKey(Origin(he), Dest(he)), he);
+
+	// Lookups only read the table, so the twins are matched in parallel.
+	ParallelFor::For(halfEdgeCount, 4096, [&](size_t i)
+	{
+		uint32 he = (uint32)i;
+		uint32 a = Origin(he);
+		uint32 b = Dest(he);
+		if (a == b || table.Find(EdgeKey(a, b)) == Duplicate)
+			return;
+
+		uint32 twin = table.Find(EdgeKey(b, a));
+		if (twin != Invalid && twin != Duplicate)
+			mTwins[he] = twin;
+	});
+
+	for (uint32 he = 0; he < (uint32)halfEdgeCount; ++he)
+	{
+		if (IsBoundary(he) && Origin(he) != Dest(he) && table.Find(EdgeKey(Origin(he), Dest(he))) == Duplicate)
+			++mNonManifoldHalfEdges;
+	}
+
+	LinkVertices();
+}
+
+void HalfEdgeMesh::LinkVertices()
+{
+	mVertexHalfEdges.assign(mVertices.size(), Invalid);
+	mBoundaryHalfEdges = 0;
+
+	for (uint32 he = 0; he < (uint32)mIndices.size(); ++he)
+	{
+		if (IsBoundary(he))
+			++mBoundaryHalfEdges;
+
+		uint32& vertexHalfEdge = mVertexHalfEdges[Origin(he)];
+		if (vertexHalfEdge == Invalid || (IsBoundary(he) && !IsBoundary(vertexHalfEdge)))
+			vertexHalfEdge = he;
+	}
+}
+
+HalfEdgeMesh HalfEdgeMesh::Subdivide(Scheme scheme) const
+{
+	const size_t vertexCount = mVertices.size();
+	const size_t halfEdgeCount = mIndices.size();
+	const size_t faceCount = FaceCount();
+
+	// Number the undirected edges.  Each edge is owned by its lower half-edge, or by its
+	// only half-edge on a border.
+	std::vector<uint32> edgeIds(halfEdgeCount);
+	std::vector<uint32> edgeHalfEdges;
+	edgeHalfEdges.reserve((halfEdgeCount + mBoundaryHalfEdges) / 2);
+	for (uint32 he = 0; he < (uint32)halfEdgeCount; ++he)
+	{
+		if (IsBoundary(he) || he < mTwins[he])
+		{
+			edgeIds[he] = (uint32)edgeHalfEdges.size();
+			edgeHalfEdges.push_back(he);
+		}
+	}
+	ParallelFor::For(halfEdgeCount, 4096, [&](size_t he)
+	{
+		if (!IsBoundary((uint32)he) && mTwins[he] < he)
+			edgeIds[he] = edgeIds[mTwins[he]];
+	});
+
+	const size_t edgeCount = edgeHalfEdges.size();
+	std::vector<Vertex> vertices(vertexCount + edgeCount);
+
+	if (scheme == Scheme::Loop)
+	{
+		// One-ring and border-neighbour sums, gathered from the half-edges instead of
+		// walking each fan.  A border edge has a single half-edge, so it is credited to
+		// both of its ends.
+		std::vector<XMFLOAT3> ringSums(vertexCount, XMFLOAT3(0.0f, 0.0f, 0.0f));
+		std::vector<XMFLOAT3> borderSums(vertexCount, XMFLOAT3(0.0f, 0.0f, 0.0f));
+		std::vector<uint32> valences(vertexCount, 0);
+		std::vector<uint32> borderCounts(vertexCount, 0);
+
+		auto accumulate = [](XMFLOAT3& sum, const XMFLOAT3& p)
+		{
+			sum.x += p.x;
+			sum.y += p.y;
+			sum.z += p.z;
+		};
+
+		for (uint32 he = 0; he < (uint32)halfEdgeCount; ++he)
+		{
+			uint32 a = Origin(he);
+			uint32 b = Dest(he);
+			accumulate(ringSums[a], mVertices[b].Position);
+			++valences[a];
+
+			if (IsBoundary(he))
+			{
+				accumulate(ringSums[b], mVertices[a].Position);
+				++valences[b];
+				accumulate(borderSums[a], mVertices[b].Position);
+				accumulate(borderSums[b], mVertices[a].Position);
+				++borderCounts[a];
+				++borderCounts[b];
+			}
+		}
+
+		ParallelFor::For(vertexCount, 4096, [&](size_t v)
+		{
+			Vertex out = mVertices[v];
+			XMVECTOR p = XMLoadFloat3(&out.Position);
+
+			if (borderCounts[v] == 0 && valences[v] >= 3)
+			{
+				float beta = LoopBeta(valences[v]);
+				p = XMVectorAdd(XMVectorScale(p, 1.0f - valences[v] * beta), XMVectorScale(XMLoadFloat3(&ringSums[v]), beta));
+			}
+			else if (borderCounts[v] == 2)
+			{
+				p = XMVectorAdd(XMVectorScale(p, 0.75f), XMVectorScale(XMLoadFloat3(&borderSums[v]), 0.125f));
+			}
+			// Corners and non-manifold vertices stay put.
+
+			XMStoreFloat3(&out.Position, p);
+			vertices[v] = out;
+		});
+	}
+	else
+	{
+		std::copy(mVertices.begin(), mVertices.end(), vertices.begin());
+	}
+
+	ParallelFor::For(edgeCount, 4096, [&](size_t e)
+	{
+		uint32 he = edgeHalfEdges[e];
+		Vertex v = MidPoint(mVertices[Origin(he)], mVertices[Dest(he)]);
+
+		if (scheme == Scheme::Loop && !IsBoundary(he))
+		{
+			// 3/8 of the edge ends plus 1/8 of the two opposite corners.
+			XMVECTOR ends = XMVectorAdd(XMLoadFloat3(&mVertices[Origin(he)].Position), XMLoadFloat3(&mVertices[Dest(he)].Position));
+			XMVECTOR wings = XMVectorAdd(XMLoadFloat3(&mVertices[Origin(Prev(he))].Position),
+				XMLoadFloat3(&mVertices[Origin(Prev(mTwins[he]))].Position));
+			XMStoreFloat3(&v.Position, XMVectorAdd(XMVectorScale(ends, 0.375f), XMVectorScale(wings, 0.125f)));
+		}
+
+		vertices[vertexCount + e] = v;
+	});
+
+	std::vector<uint32> indices(faceCount * 12);
+	ParallelFor::For(faceCount, 4096, [&](size_t f)
+	{
+		const uint32* corner = &mIndices[f * 3];
+		const uint32* edge = &edgeIds[f * 3];
+
+		uint32 v0 = corner[0];
+		uint32 v1 = corner[1];
+		uint32 v2 = corner[2];
+		uint32 m0 = (uint32)vertexCount + edge[0];
+		uint32 m1 = (uint32)vertexCount + edge[1];
+		uint32 m2 = (uint32)vertexCount + edge[2];
+
+		uint32* out = &indices[f * 12];
+		out[0] = v0; out[1] = m0; out[2] = m2;
+		out[3] = m0; out[4] = v1; out[5] = m1;
+		out[6] = m2; out[7] = m1; out[8] = v2;
+		out[9] = m0; out[10] = m1; out[11] = m2;
+	});
+
+	if (scheme == Scheme::Loop)
+	{
+		// Smoothing moved the surface, so the interpolated normals no longer match it.
+		// Rebuild them as area-weighted face normal sums.
+		std::vector<XMFLOAT3> normals(vertices.size(), XMFLOAT3(0.0f, 0.0f, 0.0f));
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&vertices[indices[i + 0]].Position);
+			XMVECTOR p1 = XMLoadFloat3(&vertices[indices[i + 1]].Position);
+			XMVECTOR p2 = XMLoadFloat3(&vertices[indices[i + 2]].Position);
+
+			XMFLOAT3 n;
+			XMStoreFloat3(&n, XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
+			for (int k = 0; k < 3; ++k)
+			{
+				XMFLOAT3& sum = normals[indices[i + k]];
+				sum.x += n.x;
+				sum.y += n.y;
+				sum.z += n.z;
+			}
+		}
+
+		ParallelFor::For(vertices.size(), 4096, [&](size_t v)
+		{
+			XMVECTOR n = XMLoadFloat3(&normals[v]);
+			if (XMVectorGetX(XMVector3LengthSq(n)) > 0.0f)
+				XMStoreFloat3(&vertices[v].Normal, XMVector3Normalize(n));
+		});
+	}
+
+	HalfEdgeMesh result;
+	result.mVertices = std::move(vertices);
+	result.mIndices = std::move(indices);
+
+	// The child twins follow from the parent's, so the directed edges are not hashed
+	// again.  Parent half-edge i splits into a first half (corner i to its midpoint) and
+	// a second half; the twin of one half is the other half of the parent's twin.
+	static const uint32 FirstHalf[3] = { 0, 4, 8 };
+	static const uint32 SecondHalf[3] = { 3, 7, 2 };
+
+	result.mTwins.resize(faceCount * 12);
+	ParallelFor::For(faceCount, 4096, [&](size_t f)
+	{
+		uint32* twins = &result.mTwins[f * 12];
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			uint32 twin = mTwins[f * 3 + i];
+			if (twin == Invalid)
+			{
+				twins[FirstHalf[i]] = Invalid;
+				twins[SecondHalf[i]] = Invalid;
+			}
+			else
+			{
+				twins[FirstHalf[i]] = Face(twin) * 12 + SecondHalf[twin % 3];
+				twins[SecondHalf[i]] = Face(twin) * 12 + FirstHalf[twin % 3];
+			}
+		}
+
+		// The edges of the centre triangle.
+		const uint32 base = (uint32)f * 12;
+		twins[1] = base + 11;
+		twins[11] = base + 1;
+		twins[5] = base + 9;
+		twins[9] = base + 5;
+		twins[6] = base + 10;
+		twins[10] = base + 6;
+	});
+
+	result.mNonManifoldHalfEdges = mNonManifoldHalfEdges * 2;
+	result.LinkVertices();
+	return result;
+}
+
+GeometryGenerator::MeshData HalfEdgeMesh::ToMeshData() const
+{
+	GeometryGenerator::MeshData mesh;
+	mesh.Vertices = mVertices;
+	mesh.Indices32 = mIndices;
+	return mesh;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "GeometryGenerator.h"
+
+// Triangle mesh with half-edge adjacency.  Half-edges are implicit in the index list:
+// half-edge 3f + i of triangle f runs from corner i to corner i + 1, so Next, Prev and
+// Face are arithmetic and only the twin links are stored.  Twins are matched in O(n)
+// through an open-addressing hash of the directed edges.
+//
+// Vertices are shared by index, so weld meshes whose triangles carry private copies of
+// their corners (e.g. GeometryGenerator::CreateGeosphere) before building.
+class HalfEdgeMesh
+{
+public:
+	using uint32 = std::uint32_t;
+	using Vertex = GeometryGenerator::Vertex;
+
+	static const uint32 Invalid = 0xffffffff;
+
+	enum class Scheme
+	{
+		// Splits every edge at its midpoint; positions on the input stay where they are.
+		Midpoint,
+		// Loop's approximating scheme.  Boundary edges use the cubic B-spline rules and
+		// normals are recomputed from the smoothed faces.
+		Loop
+	};
+
+	HalfEdgeMesh() = default;
+	explicit HalfEdgeMesh(const GeometryGenerator::MeshData& mesh);
+	HalfEdgeMesh(std::vector<Vertex> vertices, std::vector<uint32> indices);
+
+	size_t VertexCount() const { return mVertices.size(); }
+	size_t FaceCount() const { return mIndices.size() / 3; }
+	size_t HalfEdgeCount() const { return mIndices.size(); }
+
+	// Directed edges without a twin, i.e. mesh borders and seams.
+	size_t BoundaryHalfEdgeCount() const { return mBoundaryHalfEdges; }
+	// Directed edges used by more than one triangle.  They are left without a twin.
+	size_t NonManifoldHalfEdgeCount() const { return mNonManifoldHalfEdges; }
+
+	uint32 Next(uint32 he) const { return he % 3 == 2 ? he - 2 : he + 1; }
+	uint32 Prev(uint32 he) const { return he % 3 == 0 ? he + 2 : he - 1; }
+	uint32 Face(uint32 he) const { return he / 3; }
+	uint32 Twin(uint32 he) const { return mTwins[he]; }
+	uint32 Origin(uint32 he) const { return mIndices[he]; }
+	uint32 Dest(uint32 he) const { return mIndices[Next(he)]; }
+	bool IsBoundary(uint32 he) const { return mTwins[he] == Invalid; }
+
+	// An outgoing half-edge of v, or Invalid for unreferenced vertices.  Border vertices
+	// return their border half-edge, so stepping with Twin(Prev(he)) visits the whole fan.
+	uint32 VertexHalfEdge(uint32 v) const { return mVertexHalfEdges[v]; }
+
+	std::vector<Vertex>& Vertices() { return mVertices; }
+	const std::vector<Vertex>& Vertices() const { return mVertices; }
+	const std::vector<uint32>& Indices() const { return mIndices; }
+
+	// One level of 1-to-4 subdivision.  Edge vertices are appended after the existing
+	// vertices, and child triangle k of face f is face 4f + k of the result.
+	HalfEdgeMesh Subdivide(Scheme scheme) const;
+
+	GeometryGenerator::MeshData ToMeshData() const;
+
+private:
+	void BuildAdjacency();
+	void LinkVertices();
+
+	std::vector<Vertex> mVertices;
+	std::vector<uint32> mIndices;
+	std::vector<uint32> mTwins;
+	std::vector<uint32> mVertexHalfEdges;
+
+	size_t mBoundaryHalfEdges = 0;
+	size_t mNonManifoldHalfEdges = 0;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Small non-cryptographic hashing helpers used for cache keys and lookup tables.
+class Hash
+{
+public:
+	static const std::uint64_t FnvOffsetBasis = 14695981039346656037ull;
+	static const std::uint64_t FnvPrime = 1099511628211ull;
+
+	// 64-bit FNV-1a.  Pass a previous result as seed to hash several ranges as one.
+	static std::uint64_t Fnv1a64(const void* data, size_t size, std::uint64_t seed = FnvOffsetBasis)
+	{
+		const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+		std::uint64_t h = seed;
+		for (size_t i = 0; i < size; ++i)
+		{
+			h ^= bytes[i];
+			h *= FnvPrime;
+		}
+		return h;
+	}
+
+	static std::uint64_t Fnv1a64(const std::string& str, std::uint64_t seed = FnvOffsetBasis)
+	{
+		return Fnv1a64(str.data(), str.size(), seed);
+	}
+};
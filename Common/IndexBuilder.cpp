@@ -0,0 +1,118 @@
+#include "IndexBuilder.h"
+#include <cassert>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define INDEXBUILDER_SSE2 1
+#endif
+
+void IndexBuilder::MinMax(const uint32* indices, size_t count, uint32& minIndex, uint32& maxIndex)
+{
+	uint32 lo = 0xffffffff;
+	uint32 hi = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		lo = indices[i] < lo ? indices[i] : lo;
+		hi = indices[i] > hi ? indices[i] : hi;
+	}
+	minIndex = count ? lo : 0;
+	maxIndex = hi;
+}
+
+void IndexBuilder::Narrow16(const uint32* src, uint16* dst, size_t count, uint32 bias)
+{
+	size_t i = 0;
+
+#ifdef INDEXBUILDER_SSE2
+	// packs_epi32 saturates signed values, so shift [0, 65535] down into the signed
+	// 16-bit range first and flip the sign bit back after packing.
+	const __m128i offset = _mm_set1_epi32((int)(bias + 0x8000));
+	const __m128i signBit = _mm_set1_epi16((short)0x8000);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+		a = _mm_sub_epi32(a, offset);
+		b = _mm_sub_epi32(b, offset);
+		__m128i packed = _mm_xor_si128(_mm_packs_epi32(a, b), signBit);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		assert(src[i] - bias <= 0xffff);
+		dst[i] = static_cast<uint16>(src[i] - bias);
+	}
+}
+
+bool IndexBuilder::Build(const uint32* indices, size_t indexCount, size_t vertexCount, std::vector<Batch>& batches,
+	size_t maxBatches)
+{
+	batches.clear();
+
+	if (vertexCount <= 0x10000)
+	{
+		Batch batch;
+		batch.IndexCount = (uint32)indexCount;
+		batch.VertexCount = (uint32)vertexCount;
+		batches.push_back(batch);
+		return true;
+	}
+
+	// Greedily grow batches triangle by triangle while the batch's index span still
+	// fits in 16 bits.  A trailing partial triangle joins the last batch.
+	Batch batch;
+	uint32 lo = 0xffffffff, hi = 0;
+	for (size_t t = 0; t < indexCount; t += 3)
+	{
+		const size_t count = indexCount - t < 3 ? indexCount - t : 3;
+		uint32 triLo, triHi;
+		MinMax(indices + t, count, triLo, triHi);
+		if (triHi - triLo > 0xffff)
+		{
+			batches.clear();
+			return false;
+		}
+
+		uint32 newLo = triLo < lo ? triLo : lo;
+		uint32 newHi = triHi > hi ? triHi : hi;
+		if (batch.IndexCount > 0 && newHi - newLo > 0xffff)
+		{
+			batch.BaseVertexLocation = (std::int32_t)lo;
+			batch.VertexCount = hi - lo + 1;
+			batches.push_back(batch);
+			if (batches.size() >= maxBatches)
+			{
+				batches.clear();
+				return false;
+			}
+
+			batch = Batch();
+			batch.StartIndexLocation = (uint32)t;
+			newLo = triLo;
+			newHi = triHi;
+		}
+
+		lo = newLo;
+		hi = newHi;
+		batch.IndexCount += (uint32)count;
+	}
+
+	if (batch.IndexCount > 0)
+	{
+		batch.BaseVertexLocation = (std::int32_t)lo;
+		batch.VertexCount = hi - lo + 1;
+	}
+	batches.push_back(batch);
+	return true;
+}
+
+void IndexBuilder::Write16(const uint32* indices, const std::vector<Batch>& batches, uint16* dst)
+{
+	for (const Batch& batch : batches)
+	{
+		Narrow16(indices + batch.StartIndexLocation, dst + batch.StartIndexLocation, batch.IndexCount,
+			(uint32)batch.BaseVertexLocation);
+	}
+}
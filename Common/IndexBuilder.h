@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <dxgiformat.h>
+
+// Helpers for writing index buffers in the narrowest format that can address a mesh.
+// Meshes with more than 65536 vertices are split into batches whose indices are rebased
+// on BaseVertexLocation, so they can still use 16-bit indices.
+class IndexBuilder
+{
+public:
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	// One draw call worth of indices.  StartIndexLocation is relative to the mesh's
+	// first index; the batch reads VertexCount vertices from BaseVertexLocation.
+	struct Batch
+	{
+		uint32 StartIndexLocation = 0;
+		uint32 IndexCount = 0;
+		std::int32_t BaseVertexLocation = 0;
+		uint32 VertexCount = 0;
+	};
+
+	// Splits a triangle list into batches whose indices, less their BaseVertexLocation,
+	// fit in 16 bits; a mesh of up to 65536 vertices is one batch.  Returns false, with
+	// 'batches' empty, when that takes more than maxBatches draws (poor index locality,
+	// or a single triangle spanning more than 65536 vertices) and the mesh should use
+	// R32_UINT instead.
+	static bool Build(const uint32* indices, size_t indexCount, size_t vertexCount, std::vector<Batch>& batches,
+		size_t maxBatches = 16);
+
+	// Narrows each batch's indices, less its BaseVertexLocation, into the same positions
+	// of 'dst'.
+	static void Write16(const uint32* indices, const std::vector<Batch>& batches, uint16* dst);
+
+	// dst[i] = src[i] - bias.  Every src[i] - bias must fit in 16 bits.  Uses SSE2 packs
+	// eight indices at a time where available.
+	static void Narrow16(const uint32* src, uint16* dst, size_t count, uint32 bias = 0);
+
+	static void MinMax(const uint32* indices, size_t count, uint32& minIndex, uint32& maxIndex);
+};
@@ -0,0 +1,243 @@
+#include "Lz4.h"
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint32 = std::uint32_t;
+
+	const size_t MinMatch = 4;
+	// The last match must start this far before the end, and the last bytes are literals.
+	const size_t MatchFindLimit = 12;
+	const size_t LastLiterals = 5;
+	const size_t MaxOffset = 65535;
+	const int HashLog = 12;
+
+	uint32 Read32(const uint8* p)
+	{
+		uint32 value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	uint32 HashSequence(uint32 sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashLog);
+	}
+
+	// Bytes equal at a and b, stopping at 'limit' on a's side.
+	size_t CountEqual(const uint8* a, const uint8* b, const uint8* limit)
+	{
+		const uint8* start = a;
+		while (a + 8 <= limit)
+		{
+			std::uint64_t x, y;
+			memcpy(&x, a, 8);
+			memcpy(&y, b, 8);
+			std::uint64_t diff = x ^ y;
+			if (diff != 0)
+			{
+				// Little-endian: the lowest differing byte is the first mismatch.
+				size_t n = 0;
+				while ((diff & 0xff) == 0)
+				{
+					diff >>= 8;
+					++n;
+				}
+				return (a - start) + n;
+			}
+			a += 8;
+			b += 8;
+		}
+		while (a < limit && *a == *b)
+		{
+			++a;
+			++b;
+		}
+		return a - start;
+	}
+
+	// Writes the 255-run that continues a length field whose 4-bit part was saturated.
+	bool WriteLength(uint8*& op, const uint8* oend, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+		{
+			if (op >= oend)
+				return false;
+			*op++ = 255;
+		}
+		if (op >= oend)
+			return false;
+		*op++ = (uint8)length;
+		return true;
+	}
+
+	bool ReadLength(const uint8*& ip, const uint8* iend, size_t& length)
+	{
+		uint8 b;
+		do
+		{
+			if (ip >= iend)
+				return false;
+			b = *ip++;
+			length += b;
+		} while (b == 255);
+		return true;
+	}
+
+	// One sequence: literals [anchor, anchor + literals) then, if matchLength is non-zero,
+	// a match at 'offset' back.
+	bool WriteSequence(uint8*& op, const uint8* oend, const uint8* anchor, size_t literals,
+		size_t offset, size_t matchLength)
+	{
+		if (op >= oend)
+			return false;
+
+		uint8* token = op++;
+		*token = (uint8)((literals >= 15 ? 15 : literals) << 4);
+		if (literals >= 15 && !WriteLength(op, oend, literals - 15))
+			return false;
+
+		if ((size_t)(oend - op) < literals)
+			return false;
+		memcpy(op, anchor, literals);
+		op += literals;
+
+		if (matchLength == 0)
+			return true;
+
+		if (oend - op < 2)
+			return false;
+		*op++ = (uint8)(offset & 0xff);
+		*op++ = (uint8)(offset >> 8);
+
+		const size_t length = matchLength - MinMatch;
+		*token |= (uint8)(length >= 15 ? 15 : length);
+		return length < 15 || WriteLength(op, oend, length - 15);
+	}
+}
+
+size_t Lz4::Compress(const void* source, size_t sourceSize, void* destination, size_t capacity)
+{
+	if (sourceSize > 0x7fffffff)
+		return 0;
+
+	const uint8* const base = static_cast<const uint8*>(source);
+	const uint8* const iend = base + sourceSize;
+	uint8* op = static_cast<uint8*>(destination);
+	uint8* const oend = op + capacity;
+
+	const uint8* anchor = base;
+	if (sourceSize > MatchFindLimit)
+	{
+		// Positions of recent sequences, relative to base.  A stale or colliding slot only
+		// costs a failed comparison.
+		uint32 table[1 << HashLog] = {};
+
+		const uint8* const matchFindEnd = iend - MatchFindLimit;
+		const uint8* const matchEnd = iend - LastLiterals;
+		const uint8* ip = base + 1;
+
+		while (ip < matchFindEnd)
+		{
+			const uint32 sequence = Read32(ip);
+			const uint32 h = HashSequence(sequence);
+			const uint8* ref = base + table[h];
+			table[h] = (uint32)(ip - base);
+
+			if (ref >= ip || (size_t)(ip - ref) > MaxOffset || Read32(ref) != sequence)
+			{
+				// Skip faster through data that does not match.
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			while (ip > anchor && ref > base && ip[-1] == ref[-1])
+			{
+				--ip;
+				--ref;
+			}
+
+			const size_t length = MinMatch + CountEqual(ip + MinMatch, ref + MinMatch, matchEnd);
+			if (!WriteSequence(op, oend, anchor, ip - anchor, ip - ref, length))
+				return 0;
+
+			ip += length;
+			anchor = ip;
+			if (ip >= matchFindEnd)
+				break;
+
+			table[HashSequence(Read32(ip - 2))] = (uint32)(ip - 2 - base);
+		}
+	}
+
+	if (!WriteSequence(op, oend, anchor, iend - anchor, 0, 0))
+		return 0;
+	return op - static_cast<uint8*>(destination);
+}
+
+bool Lz4::Decompress(const void* source, size_t sourceSize, void* destination, size_t destinationSize)
+{
+	const uint8* ip = static_cast<const uint8*>(source);
+	const uint8* const iend = ip + sourceSize;
+	uint8* const base = static_cast<uint8*>(destination);
+	uint8* op = base;
+	uint8* const oend = base + destinationSize;
+
+	for (;;)
+	{
+		if (ip >= iend)
+			return false;
+
+		const unsigned token = *ip++;
+		size_t literals = token >> 4;
+		if (literals == 15 && !ReadLength(ip, iend, literals))
+			return false;
+
+		if ((size_t)(iend - ip) < literals || (size_t)(oend - op) < literals)
+			return false;
+
+		// Short runs with room on both sides are copied as one 16-byte block.
+		if (literals <= 16 && iend - ip >= 16 && oend - op >= 16)
+			memcpy(op, ip, 16);
+		else
+			memcpy(op, ip, literals);
+		op += literals;
+		ip += literals;
+
+		// The last sequence has no match.
+		if (ip == iend)
+			return op == oend;
+
+		if (iend - ip < 2)
+			return false;
+		const size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - base))
+			return false;
+
+		size_t length = token & 15;
+		if (length == 15 && !ReadLength(ip, iend, length))
+			return false;
+		length += MinMatch;
+
+		if ((size_t)(oend - op) < length)
+			return false;
+
+		const uint8* match = op - offset;
+		if (offset >= 8 && (size_t)(oend - op) >= length + 8)
+		{
+			// 8-byte steps only read bytes already written when the offset is at least 8;
+			// the last step may spill up to 7 bytes, which the next sequence overwrites.
+			for (size_t i = 0; i < length; i += 8)
+				memcpy(op + i, match + i, 8);
+		}
+		else
+		{
+			for (size_t i = 0; i < length; ++i)
+				op[i] = match[i];
+		}
+		op += length;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+// LZ4 block format (no frame): sequences of a token, literals, a 16-bit back offset and a
+// match length, with the last five bytes always literals.  Blocks are independent, which is
+// what lets AssetPack compress and decompress an entry's 64 KB blocks in parallel.
+//
+// Compress() is the greedy single-probe matcher of the reference "fast" mode; Decompress()
+// checks every length and offset against both buffers, so a corrupt block fails instead of
+// reading or writing out of bounds.
+class Lz4
+{
+public:
+	// Largest compressed size of 'size' input bytes.
+	static size_t CompressBound(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	// Returns the compressed size, or 0 if it does not fit in 'capacity'.  Inputs larger
+	// than 2 GB are not supported.
+	static size_t Compress(const void* source, size_t sourceSize, void* destination, size_t capacity);
+
+	// Decompresses a whole block.  Fails unless it expands to exactly 'destinationSize'.
+	static bool Decompress(const void* source, size_t sourceSize, void* destination, size_t destinationSize);
+};
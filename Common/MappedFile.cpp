@@ -0,0 +1,148 @@
+#include "MappedFile.h"
+#include <utility>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept
+{
+	*this = std::move(rhs);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+{
+	if (this != &rhs)
+	{
+		Close();
+		std::swap(mFile, rhs.mFile);
+#ifdef _WIN32
+		std::swap(mMapping, rhs.mMapping);
+#endif
+		std::swap(mData, rhs.mData);
+		std::swap(mSize, rhs.mSize);
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::wstring& path)
+{
+	Close();
+
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || (unsigned long long)size.QuadPart > (size_t)-1)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	mFile = file;
+	mSize = (size_t)size.QuadPart;
+
+	// Zero-length files cannot be mapped.
+	if (mSize == 0)
+		return true;
+
+	mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mData == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+		UnmapViewOfFile(mData);
+	if (mMapping)
+		CloseHandle(mMapping);
+	if (mFile)
+		CloseHandle(mFile);
+
+	mFile = nullptr;
+	mMapping = nullptr;
+	mData = nullptr;
+	mSize = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return mFile != nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::wstring& path)
+{
+	Close();
+
+	int file = open(std::filesystem::path(path).c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || !S_ISREG(info.st_mode) || (unsigned long long)info.st_size > (size_t)-1)
+	{
+		close(file);
+		return false;
+	}
+
+	mFile = file;
+	mSize = (size_t)info.st_size;
+
+	// Zero-length files cannot be mapped.
+	if (mSize == 0)
+		return true;
+
+	void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	mData = static_cast<const char*>(data);
+	madvise(data, mSize, MADV_SEQUENTIAL);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+		munmap(const_cast<char*>(mData), mSize);
+	if (mFile >= 0)
+		close(mFile);
+
+	mFile = -1;
+	mData = nullptr;
+	mSize = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return mFile >= 0;
+}
+
+#endif
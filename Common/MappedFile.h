@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file mapped into memory, so parsers can walk its bytes
+// without copying them through a stream.  The view stays valid until Close() or
+// destruction.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::wstring& path) { Open(path); }
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& rhs) noexcept;
+	MappedFile& operator=(MappedFile&& rhs) noexcept;
+
+	// Returns false if the file cannot be opened or mapped.  An empty file opens with a
+	// null Data() and Size() 0.
+	bool Open(const std::wstring& path);
+	void Close();
+
+	bool IsOpen() const;
+	const char* Data() const { return mData; }
+	size_t Size() const { return mSize; }
+
+private:
+#ifdef _WIN32
+	// Win32 HANDLEs, kept as void* so this header does not pull in windows.h.
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#else
+	// POSIX file descriptor, for the command-line tools built on Linux.
+	int mFile = -1;
+#endif
+	const char* mData = nullptr;
+	size_t mSize = 0;
+};
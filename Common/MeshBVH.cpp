@@ -0,0 +1,658 @@
+#include "MeshBVH.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <xmmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = MeshBVH::uint32;
+
+	const uint32 BinCount = 16;
+	const uint32 MaxLeafSize = 8;
+
+	// Deeper nodes become leaves, which also bounds the traversal stack.
+	const uint32 MaxDepth = 64;
+	const uint32 StackSize = 3 * MaxDepth + 4;
+
+	// Top-level nodes at least this large bin their triangles in parallel.
+	const uint32 ParallelBinThreshold = 1 << 16;
+
+	struct Box
+	{
+		XMFLOAT3 Min = { FLT_MAX, FLT_MAX, FLT_MAX };
+		XMFLOAT3 Max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void Grow(const XMFLOAT3& p)
+		{
+			Min.x = std::min(Min.x, p.x); Max.x = std::max(Max.x, p.x);
+			Min.y = std::min(Min.y, p.y); Max.y = std::max(Max.y, p.y);
+			Min.z = std::min(Min.z, p.z); Max.z = std::max(Max.z, p.z);
+		}
+
+		void Grow(const Box& b)
+		{
+			Min.x = std::min(Min.x, b.Min.x); Max.x = std::max(Max.x, b.Max.x);
+			Min.y = std::min(Min.y, b.Min.y); Max.y = std::max(Max.y, b.Max.y);
+			Min.z = std::min(Min.z, b.Min.z); Max.z = std::max(Max.z, b.Max.z);
+		}
+
+		// Half the surface area, which is all the SAH ratios need.
+		float HalfArea() const
+		{
+			if (Min.x > Max.x)
+				return 0.0f;
+
+			float dx = Max.x - Min.x;
+			float dy = Max.y - Min.y;
+			float dz = Max.z - Min.z;
+			return dx * dy + dy * dz + dz * dx;
+		}
+	};
+
+	float Component(const XMFLOAT3& v, int axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	// Triangles are reordered in place as nodes are split, so each node's triangles are
+	// contiguous and the passes over them read memory in order.
+	struct Prim
+	{
+		Box Bounds;
+		XMFLOAT3 Centroid;
+		uint32 Id;
+	};
+
+	struct BuildNode
+	{
+		Box Bounds;
+
+		// Inner nodes.
+		uint32 Left = MeshBVH::NoHit;
+		uint32 Right = MeshBVH::NoHit;
+
+		// Leaves have Count > 0 and cover Prims[First, First + Count).
+		uint32 First = 0;
+		uint32 Count = 0;
+
+		// Top-level placeholder for a subtree built on its own thread.
+		uint32 Subtree = MeshBVH::NoHit;
+	};
+
+	struct Bin
+	{
+		Box Bounds;
+		uint32 Count = 0;
+	};
+
+	struct BinSet
+	{
+		Bin Axes[3][BinCount];
+	};
+
+	struct Split
+	{
+		int Axis = -1;
+		uint32 Bin = 0;
+		float Cost = FLT_MAX;
+	};
+}
+
+struct MeshBVH::Builder
+{
+	std::vector<Prim> Prims;
+	std::vector<Triangle> Triangles;
+
+	struct Task
+	{
+		uint32 First;
+		uint32 Count;
+		uint32 Depth;
+		Box Bounds;
+		Box CentroidBounds;
+	};
+
+	std::vector<BuildNode> Top;
+	std::vector<Task> Tasks;
+	std::vector<std::vector<BuildNode>> Subtrees;
+	uint32 SubtreeThreshold = 0;
+
+	std::vector<Node>* OutNodes = nullptr;
+	std::vector<Triangle>* OutTriangles = nullptr;
+	size_t LeafCount = 0;
+
+	struct Ref
+	{
+		const std::vector<BuildNode>* Tree;
+		uint32 Index;
+
+		const BuildNode& Get() const { return (*Tree)[Index]; }
+	};
+
+	void ComputeBounds(uint32 first, uint32 count, bool parallel, Box& bounds, Box& centroidBounds) const
+	{
+		if (!parallel)
+		{
+			for (uint32 i = first; i < first + count; ++i)
+			{
+				bounds.Grow(Prims[i].Bounds);
+				centroidBounds.Grow(Prims[i].Centroid);
+			}
+			return;
+		}
+
+		std::vector<Box> partial(ParallelFor::ChunkCount(count, 4096) * 2);
+		ParallelFor::ForChunks(count, 4096, [&](size_t chunk, size_t begin, size_t end)
+		{
+			for (size_t i = first + begin; i < first + end; ++i)
+			{
+				partial[chunk * 2].Grow(Prims[i].Bounds);
+				partial[chunk * 2 + 1].Grow(Prims[i].Centroid);
+			}
+		});
+
+		for (size_t i = 0; i < partial.size(); i += 2)
+		{
+			bounds.Grow(partial[i]);
+			centroidBounds.Grow(partial[i + 1]);
+		}
+	}
+
+	static uint32 BinOf(float c, float min, float scale, uint32 binCount)
+	{
+		return std::min(binCount - 1, (uint32)((c - min) * scale));
+	}
+
+	void FillBins(uint32 first, uint32 count, bool parallel, const Box& centroidBounds, const float scale[3], uint32 binCount,
+		BinSet& bins) const
+	{
+		// Copied to locals: the bin stores could otherwise alias them and force reloads.
+		const float min[3] = { centroidBounds.Min.x, centroidBounds.Min.y, centroidBounds.Min.z };
+		const float k[3] = { scale[0], scale[1], scale[2] };
+		const Prim* prims = Prims.data();
+
+		auto fill = [&](size_t begin, size_t end, BinSet& out)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const Prim prim = prims[i];
+				const float c[3] = { prim.Centroid.x, prim.Centroid.y, prim.Centroid.z };
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					if (k[axis] == 0.0f)
+						continue;
+
+					Bin& bin = out.Axes[axis][BinOf(c[axis], min[axis], k[axis], binCount)];
+					bin.Bounds.Grow(prim.Bounds);
+					++bin.Count;
+				}
+			}
+		};
+
+		if (!parallel)
+		{
+			fill(first, first + count, bins);
+			return;
+		}
+
+		std::vector<BinSet> partial(ParallelFor::ChunkCount(count, 4096));
+		ParallelFor::ForChunks(count, 4096, [&](size_t chunk, size_t begin, size_t end)
+		{
+			fill(first + begin, first + end, partial[chunk]);
+		});
+
+		for (const BinSet& p : partial)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				for (uint32 b = 0; b < binCount; ++b)
+				{
+					bins.Axes[axis][b].Bounds.Grow(p.Axes[axis][b].Bounds);
+					bins.Axes[axis][b].Count += p.Axes[axis][b].Count;
+				}
+			}
+		}
+	}
+
+	// Cheapest bin boundary over the three axes, in units of one triangle test, with a
+	// node traversal costing as much as a triangle.
+	static Split FindSplit(const BinSet& bins, const float scale[3], uint32 binCount, float parentArea)
+	{
+		Split best;
+		if (parentArea <= 0.0f)
+			return best;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (scale[axis] == 0.0f)
+				continue;
+
+			// Empty bins leave the sweep unchanged, so their boxes are not merged.
+			float leftCost[BinCount];
+			uint32 leftCount[BinCount];
+			Box box;
+			uint32 n = 0;
+			for (uint32 b = 0; b + 1 < binCount; ++b)
+			{
+				if (bins.Axes[axis][b].Count > 0)
+				{
+					box.Grow(bins.Axes[axis][b].Bounds);
+					n += bins.Axes[axis][b].Count;
+				}
+				leftCost[b] = box.HalfArea() * n;
+				leftCount[b] = n;
+			}
+
+			box = Box();
+			n = 0;
+			for (uint32 b = binCount - 1; b > 0; --b)
+			{
+				if (bins.Axes[axis][b].Count == 0)
+					continue;
+
+				box.Grow(bins.Axes[axis][b].Bounds);
+				n += bins.Axes[axis][b].Count;
+
+				float cost = 1.0f + (leftCost[b - 1] + box.HalfArea() * n) / parentArea;
+				if (n > 0 && leftCount[b - 1] > 0 && cost < best.Cost)
+				{
+					best.Axis = axis;
+					best.Bin = b;
+					best.Cost = cost;
+				}
+			}
+		}
+
+		return best;
+	}
+
+	// Splits Prims[first, first + count) so the triangles going left come first, growing
+	// both sides' bounds on the way so the children need no pass of their own.
+	template<typename GoesLeft>
+	uint32 Partition(uint32 first, uint32 count, GoesLeft goesLeft, Box bounds[2], Box centroidBounds[2])
+	{
+		uint32 i = first;
+		uint32 j = first + count;
+		while (i < j)
+		{
+			if (goesLeft(Prims[i]))
+			{
+				bounds[0].Grow(Prims[i].Bounds);
+				centroidBounds[0].Grow(Prims[i].Centroid);
+				++i;
+			}
+			else
+			{
+				std::swap(Prims[i], Prims[--j]);
+				bounds[1].Grow(Prims[j].Bounds);
+				centroidBounds[1].Grow(Prims[j].Centroid);
+			}
+		}
+		return i - first;
+	}
+
+	uint32 Build(std::vector<BuildNode>& nodes, uint32 first, uint32 count, const Box& bounds, const Box& centroidBounds,
+		uint32 depth, bool top)
+	{
+		const uint32 index = (uint32)nodes.size();
+		nodes.emplace_back();
+		nodes[index].Bounds = bounds;
+
+		if (top && count <= SubtreeThreshold)
+		{
+			nodes[index].Subtree = (uint32)Tasks.size();
+			Tasks.push_back({ first, count, depth, bounds, centroidBounds });
+			return index;
+		}
+
+		auto makeLeaf = [&]()
+		{
+			nodes[index].First = first;
+			nodes[index].Count = count;
+			return index;
+		};
+
+		if (count <= 2 || depth >= MaxDepth)
+			return makeLeaf();
+
+		const bool parallel = top && count >= ParallelBinThreshold;
+
+		// Small nodes get about one bin per triangle; more would only be swept empty.
+		const uint32 binCount = std::min(BinCount, std::max<uint32>(count, 4));
+
+		float scale[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float extent = Component(centroidBounds.Max, axis) - Component(centroidBounds.Min, axis);
+			scale[axis] = extent > 0.0f ? binCount * (1.0f - 1e-6f) / extent : 0.0f;
+		}
+
+		BinSet bins;
+		FillBins(first, count, parallel, centroidBounds, scale, binCount, bins);
+		Split split = FindSplit(bins, scale, binCount, bounds.HalfArea());
+
+		Box childBounds[2], childCentroids[2];
+		uint32 leftCount;
+		if (split.Axis >= 0)
+		{
+			if (count <= MaxLeafSize && (float)count <= split.Cost)
+				return makeLeaf();
+
+			const int axis = split.Axis;
+			const float min = Component(centroidBounds.Min, axis);
+			leftCount = Partition(first, count, [&](const Prim& prim)
+			{
+				return BinOf(Component(prim.Centroid, axis), min, scale[axis], binCount) < split.Bin;
+			}, childBounds, childCentroids);
+		}
+		else
+		{
+			// Every centroid coincides; only the leaf size forces a split.
+			if (count <= MaxLeafSize)
+				return makeLeaf();
+			leftCount = count / 2;
+			ComputeBounds(first, leftCount, false, childBounds[0], childCentroids[0]);
+			ComputeBounds(first + leftCount, count - leftCount, false, childBounds[1], childCentroids[1]);
+		}
+
+		uint32 left = Build(nodes, first, leftCount, childBounds[0], childCentroids[0], depth + 1, top);
+		uint32 right = Build(nodes, first + leftCount, count - leftCount, childBounds[1], childCentroids[1], depth + 1, top);
+		nodes[index].Left = left;
+		nodes[index].Right = right;
+		return index;
+	}
+
+	Ref Resolve(Ref ref) const
+	{
+		const BuildNode& node = ref.Get();
+		if (node.Subtree != NoHit)
+			return { &Subtrees[node.Subtree], 0 };
+		return ref;
+	}
+
+	// Collapses the binary node and up to two levels below it into one 4-wide node,
+	// always opening the largest inner child next.
+	uint32 Emit(Ref ref)
+	{
+		Ref children[4];
+		int n = 0;
+
+		if (ref.Get().Count > 0)
+		{
+			children[n++] = ref;
+		}
+		else
+		{
+			children[n++] = Resolve({ ref.Tree, ref.Get().Left });
+			children[n++] = Resolve({ ref.Tree, ref.Get().Right });
+
+			while (n < 4)
+			{
+				int widest = -1;
+				float widestArea = -1.0f;
+				for (int i = 0; i < n; ++i)
+				{
+					const BuildNode& child = children[i].Get();
+					if (child.Count == 0 && child.Bounds.HalfArea() > widestArea)
+					{
+						widest = i;
+						widestArea = child.Bounds.HalfArea();
+					}
+				}
+
+				if (widest < 0)
+					break;
+
+				Ref opened = children[widest];
+				children[widest] = Resolve({ opened.Tree, opened.Get().Left });
+				children[n++] = Resolve({ opened.Tree, opened.Get().Right });
+			}
+		}
+
+		const uint32 index = (uint32)OutNodes->size();
+		OutNodes->emplace_back();
+
+		Node out;
+		for (int i = 0; i < 4; ++i)
+		{
+			out.MinX[i] = out.MinY[i] = out.MinZ[i] = 0.0f;
+			out.MaxX[i] = out.MaxY[i] = out.MaxZ[i] = 0.0f;
+			out.Child[i] = NoHit;
+			out.Count[i] = 0;
+		}
+
+		for (int i = 0; i < n; ++i)
+		{
+			const BuildNode& child = children[i].Get();
+			out.MinX[i] = child.Bounds.Min.x;
+			out.MinY[i] = child.Bounds.Min.y;
+			out.MinZ[i] = child.Bounds.Min.z;
+			out.MaxX[i] = child.Bounds.Max.x;
+			out.MaxY[i] = child.Bounds.Max.y;
+			out.MaxZ[i] = child.Bounds.Max.z;
+
+			if (child.Count > 0)
+			{
+				out.Child[i] = (uint32)OutTriangles->size();
+				out.Count[i] = child.Count;
+				for (uint32 k = child.First; k < child.First + child.Count; ++k)
+					OutTriangles->push_back(Triangles[Prims[k].Id]);
+				++LeafCount;
+			}
+			else
+			{
+				out.Child[i] = Emit(children[i]);
+			}
+		}
+
+		(*OutNodes)[index] = out;
+		return index;
+	}
+};
+
+const MeshBVH::uint32 MeshBVH::NoHit;
+
+void MeshBVH::Build(const void* positions, size_t stride, const uint32* indices, size_t indexCount)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	mNodes.clear();
+	mTriangles.clear();
+	mStats = Stats();
+
+	const uint32 triangleCount = (uint32)(indexCount / 3);
+	if (triangleCount == 0)
+		return;
+
+	Builder b;
+	b.Prims.resize(triangleCount);
+	b.Triangles.resize(triangleCount);
+
+	const char* base = static_cast<const char*>(positions);
+	ParallelFor::For(triangleCount, 4096, [&](size_t t)
+	{
+		XMFLOAT3 p[3];
+		for (int k = 0; k < 3; ++k)
+			memcpy(&p[k], base + indices[t * 3 + k] * stride, sizeof(XMFLOAT3));
+
+		Box box;
+		box.Grow(p[0]);
+		box.Grow(p[1]);
+		box.Grow(p[2]);
+		Prim& prim = b.Prims[t];
+		prim.Bounds = box;
+		prim.Centroid = XMFLOAT3(
+			0.5f * (box.Min.x + box.Max.x),
+			0.5f * (box.Min.y + box.Max.y),
+			0.5f * (box.Min.z + box.Max.z));
+		prim.Id = (uint32)t;
+
+		Triangle& tri = b.Triangles[t];
+		tri.V0 = p[0];
+		tri.E1 = XMFLOAT3(p[1].x - p[0].x, p[1].y - p[0].y, p[1].z - p[0].z);
+		tri.E2 = XMFLOAT3(p[2].x - p[0].x, p[2].y - p[0].y, p[2].z - p[0].z);
+		tri.Id = (uint32)t;
+	});
+
+	// The top of the tree is built here with parallel binning; below this size the
+	// subtrees are independent and each is built by one thread.
+	b.SubtreeThreshold = std::max<uint32>(triangleCount / (ParallelFor::WorkerCount() * 4), 4096);
+	Box bounds, centroidBounds;
+	b.ComputeBounds(0, triangleCount, triangleCount >= ParallelBinThreshold, bounds, centroidBounds);
+	b.Build(b.Top, 0, triangleCount, bounds, centroidBounds, 0, true);
+
+	b.Subtrees.resize(b.Tasks.size());
+	ParallelFor::For(b.Tasks.size(), 1, [&](size_t i)
+	{
+		const Builder::Task& task = b.Tasks[i];
+		b.Subtrees[i].reserve(task.Count / 2);
+		b.Build(b.Subtrees[i], task.First, task.Count, task.Bounds, task.CentroidBounds, task.Depth, false);
+	});
+
+	mTriangles.reserve(triangleCount);
+	b.OutNodes = &mNodes;
+	b.OutTriangles = &mTriangles;
+	b.Emit(b.Resolve({ &b.Top, 0 }));
+
+	mStats.TriangleCount = triangleCount;
+	mStats.NodeCount = mNodes.size();
+	mStats.LeafCount = b.LeafCount;
+	mStats.Milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void MeshBVH::Build(const GeometryGenerator::MeshData& mesh)
+{
+	Build(mesh.Vertices.data(), sizeof(GeometryGenerator::Vertex), mesh.Indices32.data(), mesh.Indices32.size());
+}
+
+MeshBVH::Hit MeshBVH::Pick(const Ray& ray) const
+{
+	Hit hit;
+	hit.T = ray.MaxT;
+	if (mNodes.empty())
+		return hit;
+
+	const XMFLOAT3& o = ray.Origin;
+	const XMFLOAT3& d = ray.Direction;
+
+	// A huge finite reciprocal for axis-parallel rays keeps the slab math free of NaNs.
+	auto reciprocal = [](float x)
+	{
+		return fabsf(x) > 1e-30f ? 1.0f / x : copysignf(1e30f, x);
+	};
+
+	const __m128 originX = _mm_set1_ps(o.x);
+	const __m128 originY = _mm_set1_ps(o.y);
+	const __m128 originZ = _mm_set1_ps(o.z);
+	const __m128 invX = _mm_set1_ps(reciprocal(d.x));
+	const __m128 invY = _mm_set1_ps(reciprocal(d.y));
+	const __m128 invZ = _mm_set1_ps(reciprocal(d.z));
+
+	struct Entry
+	{
+		uint32 Child;
+		uint32 Count;
+		float TMin;
+	};
+
+	Entry stack[StackSize];
+	int top = 0;
+	stack[top++] = { 0, 0, 0.0f };
+
+	while (top > 0)
+	{
+		const Entry entry = stack[--top];
+		if (entry.TMin > hit.T)
+			continue;
+
+		if (entry.Count > 0)
+		{
+			// Moller-Trumbore, without back-face culling.
+			for (uint32 i = entry.Child; i < entry.Child + entry.Count; ++i)
+			{
+				const Triangle& tri = mTriangles[i];
+
+				XMFLOAT3 p(d.y * tri.E2.z - d.z * tri.E2.y, d.z * tri.E2.x - d.x * tri.E2.z, d.x * tri.E2.y - d.y * tri.E2.x);
+				float det = tri.E1.x * p.x + tri.E1.y * p.y + tri.E1.z * p.z;
+				if (fabsf(det) < 1e-20f)
+					continue;
+
+				float invDet = 1.0f / det;
+				XMFLOAT3 s(o.x - tri.V0.x, o.y - tri.V0.y, o.z - tri.V0.z);
+				float u = (s.x * p.x + s.y * p.y + s.z * p.z) * invDet;
+				if (u < 0.0f || u > 1.0f)
+					continue;
+
+				XMFLOAT3 q(s.y * tri.E1.z - s.z * tri.E1.y, s.z * tri.E1.x - s.x * tri.E1.z, s.x * tri.E1.y - s.y * tri.E1.x);
+				float v = (d.x * q.x + d.y * q.y + d.z * q.z) * invDet;
+				if (v < 0.0f || u + v > 1.0f)
+					continue;
+
+				float t = (tri.E2.x * q.x + tri.E2.y * q.y + tri.E2.z * q.z) * invDet;
+				if (t >= 0.0f && t < hit.T)
+				{
+					hit.Triangle = tri.Id;
+					hit.T = t;
+					hit.U = u;
+					hit.V = v;
+				}
+			}
+			continue;
+		}
+
+		const Node& node = mNodes[entry.Child];
+
+		__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MinX), originX), invX);
+		__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MaxX), originX), invX);
+		__m128 tNear = _mm_min_ps(t0, t1);
+		__m128 tFar = _mm_max_ps(t0, t1);
+
+		t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MinY), originY), invY);
+		t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MaxY), originY), invY);
+		tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+		tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+
+		t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MinZ), originZ), invZ);
+		t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MaxZ), originZ), invZ);
+		tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+		tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+
+		tNear = _mm_max_ps(tNear, _mm_setzero_ps());
+		tFar = _mm_min_ps(tFar, _mm_set1_ps(hit.T));
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+		if (mask == 0)
+			continue;
+
+		float nears[4];
+		_mm_storeu_ps(nears, tNear);
+
+		// Push far to near so the nearest child is popped first.
+		Entry hits[4];
+		int n = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			if ((mask & (1 << i)) == 0 || node.Child[i] == NoHit)
+				continue;
+
+			int k = n++;
+			while (k > 0 && hits[k - 1].TMin < nears[i])
+			{
+				hits[k] = hits[k - 1];
+				--k;
+			}
+			hits[k] = { node.Child[i], node.Count[i], nears[i] };
+		}
+
+		for (int i = 0; i < n; ++i)
+			stack[top++] = hits[i];
+	}
+
+	return hit;
+}
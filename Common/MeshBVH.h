@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <DirectXMath.h>
+#include "GeometryGenerator.h"
+
+// Bounding volume hierarchy over the triangles of an indexed mesh, for ray picking.
+// The tree is built top-down with binned SAH splits, the large top-level nodes binning
+// in parallel and the remaining subtrees built on separate threads, then collapsed into
+// 4-wide nodes whose child boxes are tested together with SSE.
+class MeshBVH
+{
+public:
+	using uint32 = std::uint32_t;
+
+	static const uint32 NoHit = 0xffffffff;
+
+	// In the mesh's object space.  Direction need not be normalized; T is measured in
+	// multiples of it.
+	struct Ray
+	{
+		DirectX::XMFLOAT3 Origin = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 Direction = { 0.0f, 0.0f, 1.0f };
+		float MaxT = FLT_MAX;
+	};
+
+	struct Hit
+	{
+		// Triangle index, i.e. its indices start at 3 * Triangle.
+		uint32 Triangle = NoHit;
+		float T = FLT_MAX;
+
+		// Barycentric weights of corners 1 and 2; corner 0 has 1 - U - V.
+		float U = 0.0f;
+		float V = 0.0f;
+
+		bool Valid() const { return Triangle != NoHit; }
+	};
+
+	struct Stats
+	{
+		size_t TriangleCount = 0;
+		size_t NodeCount = 0;
+		size_t LeafCount = 0;
+		double Milliseconds = 0.0;
+	};
+
+	// Positions are read as an XMFLOAT3 at the start of every vertex, 'stride' bytes
+	// apart, as in MeshBounds.
+	void Build(const void* positions, size_t stride, const uint32* indices, size_t indexCount);
+	void Build(const GeometryGenerator::MeshData& mesh);
+
+	// Closest hit along the ray.  Both faces of a triangle are hit.
+	Hit Pick(const Ray& ray) const;
+
+	bool Empty() const { return mNodes.empty(); }
+	const Stats& GetStats() const { return mStats; }
+
+private:
+	// Four child boxes in SoA order.  A child with Count > 0 is a leaf of Count triangles
+	// starting at mTriangles[Child]; otherwise Child is a node index, or NoHit for an
+	// unused slot.
+	struct Node
+	{
+		float MinX[4], MinY[4], MinZ[4];
+		float MaxX[4], MaxY[4], MaxZ[4];
+		uint32 Child[4];
+		uint32 Count[4];
+	};
+
+	// Stored ready for Moller-Trumbore: one corner and the two edges leaving it.
+	struct Triangle
+	{
+		DirectX::XMFLOAT3 V0;
+		DirectX::XMFLOAT3 E1;
+		DirectX::XMFLOAT3 E2;
+		uint32 Id;
+	};
+
+	struct Builder;
+
+	std::vector<Node> mNodes;
+	std::vector<Triangle> mTriangles;
+	Stats mStats;
+};
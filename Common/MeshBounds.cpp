@@ -0,0 +1,147 @@
+#include "MeshBounds.h"
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	inline XMVECTOR LoadPosition(const std::uint8_t* base, size_t i, size_t stride)
+	{
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(base + i * stride));
+	}
+
+	BoundingBox BoxFromMinMax(FXMVECTOR vMin, FXMVECTOR vMax)
+	{
+		BoundingBox box;
+		XMStoreFloat3(&box.Center, 0.5f * (vMin + vMax));
+		XMStoreFloat3(&box.Extents, 0.5f * (vMax - vMin));
+		return box;
+	}
+
+	template<typename IndexT>
+	void ComputeIndexedImpl(const void* positions, size_t stride,
+		const IndexT* indices, size_t indexCount, std::int32_t baseVertex,
+		BoundingBox& box, BoundingSphere& sphere)
+	{
+		if (indexCount == 0)
+		{
+			box = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+			sphere = BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+			return;
+		}
+
+		// Gather the referenced positions once so both passes run over packed data.
+		const std::uint8_t* base = static_cast<const std::uint8_t*>(positions);
+		std::vector<XMFLOAT3> gathered(indexCount);
+		for (size_t i = 0; i < indexCount; ++i)
+			gathered[i] = *reinterpret_cast<const XMFLOAT3*>(base + (size_t)(baseVertex + (std::int64_t)indices[i]) * stride);
+
+		MeshBounds::Compute(gathered.data(), gathered.size(), sizeof(XMFLOAT3), box, sphere);
+	}
+}
+
+BoundingBox MeshBounds::ComputeBox(const void* positions, size_t count, size_t stride)
+{
+	if (count == 0)
+		return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+	const std::uint8_t* base = static_cast<const std::uint8_t*>(positions);
+
+	// Four independent accumulators hide the latency of the min/max dependency chain.
+	XMVECTOR vMin0 = LoadPosition(base, 0, stride);
+	XMVECTOR vMax0 = vMin0;
+	XMVECTOR vMin1 = vMin0, vMax1 = vMin0;
+	XMVECTOR vMin2 = vMin0, vMax2 = vMin0;
+	XMVECTOR vMin3 = vMin0, vMax3 = vMin0;
+
+	size_t i = 1;
+	for (; i + 4 <= count; i += 4)
+	{
+		XMVECTOR p0 = LoadPosition(base, i + 0, stride);
+		XMVECTOR p1 = LoadPosition(base, i + 1, stride);
+		XMVECTOR p2 = LoadPosition(base, i + 2, stride);
+		XMVECTOR p3 = LoadPosition(base, i + 3, stride);
+
+		vMin0 = XMVectorMin(vMin0, p0); vMax0 = XMVectorMax(vMax0, p0);
+		vMin1 = XMVectorMin(vMin1, p1); vMax1 = XMVectorMax(vMax1, p1);
+		vMin2 = XMVectorMin(vMin2, p2); vMax2 = XMVectorMax(vMax2, p2);
+		vMin3 = XMVectorMin(vMin3, p3); vMax3 = XMVectorMax(vMax3, p3);
+	}
+
+	for (; i < count; ++i)
+	{
+		XMVECTOR p = LoadPosition(base, i, stride);
+		vMin0 = XMVectorMin(vMin0, p);
+		vMax0 = XMVectorMax(vMax0, p);
+	}
+
+	XMVECTOR vMin = XMVectorMin(XMVectorMin(vMin0, vMin1), XMVectorMin(vMin2, vMin3));
+	XMVECTOR vMax = XMVectorMax(XMVectorMax(vMax0, vMax1), XMVectorMax(vMax2, vMax3));
+
+	return BoxFromMinMax(vMin, vMax);
+}
+
+BoundingSphere MeshBounds::ComputeSphere(const void* positions, size_t count, size_t stride,
+	const BoundingBox& box)
+{
+	if (count == 0)
+		return BoundingSphere(box.Center, 0.0f);
+
+	const std::uint8_t* base = static_cast<const std::uint8_t*>(positions);
+	const XMVECTOR boxCenter = XMLoadFloat3(&box.Center);
+
+	// Candidate 1: the box center with the radius reaching the farthest point.
+	XMVECTOR maxDistSq = XMVectorZero();
+	for (size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR d = LoadPosition(base, i, stride) - boxCenter;
+		maxDistSq = XMVectorMax(maxDistSq, XMVector3LengthSq(d));
+	}
+	const float boxRadius = sqrtf(XMVectorGetX(maxDistSq));
+
+	// Candidate 2: Ritter's growth pass.  Every point outside the current sphere pulls
+	// the center towards itself and enlarges the radius just enough to contain it.
+	XMVECTOR center = boxCenter;
+	float radius = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR d = LoadPosition(base, i, stride) - center;
+		float distSq = XMVectorGetX(XMVector3LengthSq(d));
+		if (distSq > radius * radius)
+		{
+			float dist = sqrtf(distSq);
+			float newRadius = 0.5f * (radius + dist);
+			center = center + d * ((newRadius - radius) / dist);
+			radius = newRadius;
+		}
+	}
+
+	if (boxRadius <= radius)
+		return BoundingSphere(box.Center, boxRadius);
+
+	BoundingSphere sphere;
+	XMStoreFloat3(&sphere.Center, center);
+	sphere.Radius = radius;
+	return sphere;
+}
+
+void MeshBounds::Compute(const void* positions, size_t count, size_t stride,
+	BoundingBox& box, BoundingSphere& sphere)
+{
+	box = ComputeBox(positions, count, stride);
+	sphere = ComputeSphere(positions, count, stride, box);
+}
+
+void MeshBounds::ComputeIndexed(const void* positions, size_t stride,
+	const std::uint16_t* indices, size_t indexCount, std::int32_t baseVertex,
+	BoundingBox& box, BoundingSphere& sphere)
+{
+	ComputeIndexedImpl(positions, stride, indices, indexCount, baseVertex, box, sphere);
+}
+
+void MeshBounds::ComputeIndexed(const void* positions, size_t stride,
+	const std::uint32_t* indices, size_t indexCount, std::int32_t baseVertex,
+	BoundingBox& box, BoundingSphere& sphere)
+{
+	ComputeIndexedImpl(positions, stride, indices, indexCount, baseVertex, box, sphere);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// Bounding volume computation for vertex data.  Positions are read as an XMFLOAT3 at
+// the start of every element, 'stride' bytes apart, so any app vertex whose first
+// member is the position can be passed without copying.
+class MeshBounds
+{
+public:
+	// Axis-aligned box of positions[0, count).  Min/max are reduced four lanes at a time.
+	static DirectX::BoundingBox ComputeBox(const void* positions, size_t count, size_t stride);
+
+	// Ritter bounding sphere, or the sphere around the box center when that is tighter.
+	// Linear in the vertex count and within a few percent of the minimal sphere.
+	static DirectX::BoundingSphere ComputeSphere(const void* positions, size_t count, size_t stride,
+		const DirectX::BoundingBox& box);
+
+	static void Compute(const void* positions, size_t count, size_t stride,
+		DirectX::BoundingBox& box, DirectX::BoundingSphere& sphere);
+
+	// Bounds of the vertices referenced by an index range, for submeshes that share
+	// a vertex buffer with BaseVertexLocation = 0.
+	static void ComputeIndexed(const void* positions, size_t stride,
+		const std::uint16_t* indices, size_t indexCount, std::int32_t baseVertex,
+		DirectX::BoundingBox& box, DirectX::BoundingSphere& sphere);
+	static void ComputeIndexed(const void* positions, size_t stride,
+		const std::uint32_t* indices, size_t indexCount, std::int32_t baseVertex,
+		DirectX::BoundingBox& box, DirectX::BoundingSphere& sphere);
+};
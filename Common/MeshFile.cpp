@@ -0,0 +1,402 @@
+#include "MeshFile.h"
+#include "IndexBuilder.h"
+#include "MeshBounds.h"
+#include "ModelLoader.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = MeshFile::uint32;
+	using uint64 = MeshFile::uint64;
+
+	static_assert(sizeof(MeshFile::Header) == 104, "MeshFile::Header layout changed");
+	static_assert(sizeof(MeshFile::Submesh) == 104, "MeshFile::Submesh layout changed");
+
+	uint64 AlignUp(uint64 offset)
+	{
+		return (offset + MeshFile::RegionAlignment - 1) & ~(uint64)(MeshFile::RegionAlignment - 1);
+	}
+
+	bool Fail(std::string* error, const char* what)
+	{
+		if (error)
+			*error = what;
+		return false;
+	}
+
+	void StoreBounds(const BoundingBox& box, const BoundingSphere& sphere,
+		float center[3], float extents[3], float sphereCenter[3], float& radius)
+	{
+		memcpy(center, &box.Center, sizeof(float) * 3);
+		memcpy(extents, &box.Extents, sizeof(float) * 3);
+		memcpy(sphereCenter, &sphere.Center, sizeof(float) * 3);
+		radius = sphere.Radius;
+	}
+
+	void Append(std::vector<std::uint8_t>& bytes, uint64 at, const void* data, size_t size)
+	{
+		memcpy(bytes.data() + at, data, size);
+	}
+
+	MeshFile::Source MeshDataSource(const GeometryGenerator::MeshData& mesh, const std::string& name)
+	{
+		MeshFile::Source source;
+		source.Vertices = mesh.Vertices.data();
+		source.VertexCount = mesh.Vertices.size();
+		source.Layout.Stride = sizeof(GeometryGenerator::Vertex);
+		source.Layout.NormalOffset = offsetof(GeometryGenerator::Vertex, Normal);
+		source.Layout.TangentOffset = offsetof(GeometryGenerator::Vertex, TangentU);
+		source.Layout.TexCOffset = offsetof(GeometryGenerator::Vertex, TexC);
+		source.Indices = mesh.Indices32.data();
+		source.IndexCount = mesh.Indices32.size();
+		source.Parts.push_back({ name, 0, (MeshFile::uint32)mesh.Indices32.size() });
+		return source;
+	}
+
+	bool WriteFile(const std::wstring& path, const std::vector<std::uint8_t>& bytes, std::string* error)
+	{
+		std::ofstream fout(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+		if (!fout)
+			return Fail(error, "cannot create the file");
+
+		fout.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+		if (!fout)
+			return Fail(error, "write failed");
+		return true;
+	}
+}
+
+const uint32 MeshFile::FileMagic;
+const uint32 MeshFile::FileVersion;
+const uint32 MeshFile::RegionAlignment;
+const size_t MeshFile::NoAttribute;
+
+size_t MeshFile::AttributeOffset(uint32 attributes, Attribute attribute)
+{
+	if ((attributes & attribute) == 0)
+		return NoAttribute;
+
+	size_t offset = 0;
+	if (attribute != Normal && (attributes & Normal))
+		offset += sizeof(XMFLOAT3);
+	if (attribute == TexC && (attributes & TangentU))
+		offset += sizeof(XMFLOAT3);
+	return offset;
+}
+
+uint32 MeshFile::AttributeStride(uint32 attributes)
+{
+	uint32 stride = 0;
+	if (attributes & Normal)
+		stride += sizeof(XMFLOAT3);
+	if (attributes & TangentU)
+		stride += sizeof(XMFLOAT3);
+	if (attributes & TexC)
+		stride += sizeof(XMFLOAT2);
+	return stride;
+}
+
+bool MeshFile::Save(const std::wstring& path, const Source& source, uint32 attributes, std::string* error)
+{
+	std::vector<std::uint8_t> bytes;
+	return Write(source, attributes, bytes, error) && WriteFile(path, bytes, error);
+}
+
+bool MeshFile::Write(const Source& source, uint32 attributes, std::vector<std::uint8_t>& bytes, std::string* error)
+{
+	attributes &= Normal | TangentU | TexC;
+
+	if (source.VertexCount == 0 || source.VertexCount > 0xffffffffull || source.IndexCount > 0xffffffffull)
+		return Fail(error, "vertex or index count out of range");
+
+	std::vector<Part> parts = source.Parts;
+	if (parts.empty())
+		parts.push_back({ "mesh", 0, (uint32)source.IndexCount });
+
+	for (const Part& part : parts)
+	{
+		if (part.Name.size() >= sizeof(Submesh::Name))
+			return Fail(error, "submesh name too long");
+		if ((uint64)part.StartIndexLocation + part.IndexCount > source.IndexCount)
+			return Fail(error, "submesh outside the index range");
+	}
+
+	uint32 minIndex = 0, maxIndex = 0;
+	IndexBuilder::MinMax(source.Indices, source.IndexCount, minIndex, maxIndex);
+	if (source.IndexCount > 0 && maxIndex >= source.VertexCount)
+		return Fail(error, "index past the vertex count");
+
+	const size_t vertexCount = source.VertexCount;
+	const VertexLayout& layout = source.Layout;
+	const std::uint8_t* src = static_cast<const std::uint8_t*>(source.Vertices);
+
+	// Split the vertices into the two streams.
+	const uint32 stride = AttributeStride(attributes);
+	std::vector<XMFLOAT3> positions(vertexCount);
+	std::vector<std::uint8_t> interleaved((size_t)stride * vertexCount, 0);
+
+	struct Copy
+	{
+		Attribute Which;
+		size_t From;
+		size_t Size;
+	};
+	const Copy copies[] = {
+		{ Normal, layout.NormalOffset, sizeof(XMFLOAT3) },
+		{ TangentU, layout.TangentOffset, sizeof(XMFLOAT3) },
+		{ TexC, layout.TexCOffset, sizeof(XMFLOAT2) } };
+
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const std::uint8_t* vertex = src + i * layout.Stride;
+		memcpy(&positions[i], vertex, sizeof(XMFLOAT3));
+		for (const Copy& copy : copies)
+		{
+			size_t to = AttributeOffset(attributes, copy.Which);
+			if (to != NoAttribute && copy.From != NoAttribute)
+				memcpy(&interleaved[i * stride + to], vertex + copy.From, copy.Size);
+		}
+	}
+
+	const bool narrow = vertexCount <= 0x10000;
+	std::vector<std::uint16_t> indices16;
+	if (narrow)
+	{
+		indices16.resize(source.IndexCount);
+		IndexBuilder::Narrow16(source.Indices, indices16.data(), source.IndexCount);
+	}
+
+	Header header = {};
+	header.Magic = FileMagic;
+	header.Version = FileVersion;
+	header.Attributes = attributes;
+	header.AttributeStride = stride;
+	header.VertexCount = (uint32)vertexCount;
+	header.IndexCount = (uint32)source.IndexCount;
+	header.IndexFormat = narrow ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	header.SubmeshCount = (uint32)parts.size();
+	header.SubmeshOffset = AlignUp(sizeof(Header));
+	header.PositionOffset = AlignUp(header.SubmeshOffset + sizeof(Submesh) * parts.size());
+	header.AttributeOffset = AlignUp(header.PositionOffset + sizeof(XMFLOAT3) * vertexCount);
+	header.IndexOffset = AlignUp(header.AttributeOffset + interleaved.size());
+
+	BoundingBox box;
+	BoundingSphere sphere;
+	MeshBounds::Compute(positions.data(), vertexCount, sizeof(XMFLOAT3), box, sphere);
+	StoreBounds(box, sphere, header.BoundsCenter, header.BoundsExtents, header.SphereCenter, header.SphereRadius);
+
+	std::vector<Submesh> submeshes(parts.size());
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		Submesh& submesh = submeshes[i];
+		memset(&submesh, 0, sizeof(submesh));
+		memcpy(submesh.Name, parts[i].Name.data(), parts[i].Name.size());
+		submesh.IndexCount = parts[i].IndexCount;
+		submesh.StartIndexLocation = parts[i].StartIndexLocation;
+		submesh.BaseVertexLocation = 0;
+
+		if (parts[i].IndexCount > 0)
+		{
+			MeshBounds::ComputeIndexed(positions.data(), sizeof(XMFLOAT3), source.Indices + parts[i].StartIndexLocation,
+				parts[i].IndexCount, 0, box, sphere);
+		}
+		else
+		{
+			box = BoundingBox();
+			sphere = BoundingSphere();
+		}
+		StoreBounds(box, sphere, submesh.BoundsCenter, submesh.BoundsExtents, submesh.SphereCenter, submesh.SphereRadius);
+	}
+
+	const uint64 indexBytes = (uint64)source.IndexCount * (narrow ? sizeof(std::uint16_t) : sizeof(uint32));
+
+	// Padding between the regions stays zero.
+	bytes.assign((size_t)(header.IndexOffset + indexBytes), 0);
+	Append(bytes, 0, &header, sizeof(header));
+	Append(bytes, header.SubmeshOffset, submeshes.data(), sizeof(Submesh) * submeshes.size());
+	Append(bytes, header.PositionOffset, positions.data(), sizeof(XMFLOAT3) * positions.size());
+	Append(bytes, header.AttributeOffset, interleaved.data(), interleaved.size());
+	if (narrow)
+		Append(bytes, header.IndexOffset, indices16.data(), (size_t)indexBytes);
+	else
+		Append(bytes, header.IndexOffset, source.Indices, (size_t)indexBytes);
+	return true;
+}
+
+bool MeshFile::Save(const std::wstring& path, const GeometryGenerator::MeshData& mesh, const std::string& name,
+	std::string* error)
+{
+	return Save(path, MeshDataSource(mesh, name), Normal | TangentU | TexC, error);
+}
+
+bool MeshFile::Write(const GeometryGenerator::MeshData& mesh, const std::string& name, uint32 attributes,
+	std::vector<std::uint8_t>& bytes, std::string* error)
+{
+	return Write(MeshDataSource(mesh, name), attributes, bytes, error);
+}
+
+bool MeshFile::ConvertTextModel(const std::wstring& textPath, const std::wstring& path, const std::string& name,
+	uint32 attributes, std::string* error)
+{
+	GeometryGenerator::MeshData mesh;
+	ModelLoader::Stats stats;
+	if (!ModelLoader::Load(textPath, mesh, &stats))
+	{
+		if (error)
+			*error = stats.Error;
+		return false;
+	}
+
+	return Save(path, MeshDataSource(mesh, name), attributes, error);
+}
+
+bool MeshFile::Open(const std::wstring& path, std::string* error)
+{
+	Close();
+
+	if (!mFile.Open(path))
+		return Fail(error, "cannot open the file");
+
+	if (!Validate(mFile.Data(), mFile.Size(), error))
+	{
+		mFile.Close();
+		return false;
+	}
+	return true;
+}
+
+bool MeshFile::Open(const void* data, size_t size, std::string* error)
+{
+	Close();
+	return Validate(static_cast<const char*>(data), size, error);
+}
+
+bool MeshFile::Validate(const char* data, uint64 size, std::string* error)
+{
+	const Header* header = reinterpret_cast<const Header*>(data);
+
+	auto fail = [&](const char* what)
+	{
+		return Fail(error, what);
+	};
+
+	if (reinterpret_cast<std::uintptr_t>(data) % RegionAlignment != 0)
+		return fail("mesh data not aligned");
+	if (size < sizeof(Header))
+		return fail("file too small");
+	if (header->Magic != FileMagic)
+		return fail("not a mesh file");
+	if (header->Version != FileVersion)
+		return fail("unsupported mesh file version");
+	if ((header->Attributes & ~(uint32)(Normal | TangentU | TexC)) != 0 ||
+		header->AttributeStride != AttributeStride(header->Attributes))
+		return fail("unknown vertex attributes");
+	if (header->IndexFormat != DXGI_FORMAT_R16_UINT && header->IndexFormat != DXGI_FORMAT_R32_UINT)
+		return fail("unknown index format");
+
+	// Every region must be aligned and inside the file.  Counts are 32-bit, so none of
+	// these products overflows 64 bits.
+	const uint64 indexSize = header->IndexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
+	struct Region
+	{
+		uint64 Offset;
+		uint64 Bytes;
+	};
+	const Region regions[] = {
+		{ header->SubmeshOffset, (uint64)header->SubmeshCount * sizeof(Submesh) },
+		{ header->PositionOffset, (uint64)header->VertexCount * sizeof(XMFLOAT3) },
+		{ header->AttributeOffset, (uint64)header->VertexCount * header->AttributeStride },
+		{ header->IndexOffset, (uint64)header->IndexCount * indexSize } };
+
+	for (const Region& region : regions)
+	{
+		if (region.Offset % RegionAlignment != 0 || region.Offset > size || region.Bytes > size - region.Offset)
+			return fail("region outside the file");
+	}
+
+	const Submesh* submeshes = reinterpret_cast<const Submesh*>(data + header->SubmeshOffset);
+	for (uint32 i = 0; i < header->SubmeshCount; ++i)
+	{
+		const Submesh& submesh = submeshes[i];
+		if (memchr(submesh.Name, 0, sizeof(submesh.Name)) == nullptr)
+			return fail("submesh name not terminated");
+		if ((uint64)submesh.StartIndexLocation + submesh.IndexCount > header->IndexCount)
+			return fail("submesh outside the index range");
+	}
+
+	mData = data;
+	mHeader = header;
+	mSubmeshes = submeshes;
+	return true;
+}
+
+void MeshFile::Close()
+{
+	mFile.Close();
+	mData = nullptr;
+	mHeader = nullptr;
+	mSubmeshes = nullptr;
+}
+
+const MeshFile::Submesh* MeshFile::FindSubmesh(const std::string& name) const
+{
+	for (uint32 i = 0; i < mHeader->SubmeshCount; ++i)
+	{
+		if (name == mSubmeshes[i].Name)
+			return &mSubmeshes[i];
+	}
+	return nullptr;
+}
+
+uint32 MeshFile::IndexSize() const
+{
+	return mHeader->IndexFormat == DXGI_FORMAT_R16_UINT ? 2u : 4u;
+}
+
+std::vector<uint32> MeshFile::WidenIndices() const
+{
+	std::vector<uint32> indices(mHeader->IndexCount);
+	if (IndexSize() == 4)
+	{
+		memcpy(indices.data(), Indices(), IndexBytes());
+	}
+	else
+	{
+		const std::uint16_t* src = static_cast<const std::uint16_t*>(Indices());
+		for (size_t i = 0; i < indices.size(); ++i)
+			indices[i] = src[i];
+	}
+	return indices;
+}
+
+BoundingBox MeshFile::Bounds() const
+{
+	return BoundingBox(
+		XMFLOAT3(mHeader->BoundsCenter[0], mHeader->BoundsCenter[1], mHeader->BoundsCenter[2]),
+		XMFLOAT3(mHeader->BoundsExtents[0], mHeader->BoundsExtents[1], mHeader->BoundsExtents[2]));
+}
+
+BoundingSphere MeshFile::Sphere() const
+{
+	return BoundingSphere(
+		XMFLOAT3(mHeader->SphereCenter[0], mHeader->SphereCenter[1], mHeader->SphereCenter[2]),
+		mHeader->SphereRadius);
+}
+
+BoundingBox MeshFile::Bounds(const Submesh& submesh)
+{
+	return BoundingBox(
+		XMFLOAT3(submesh.BoundsCenter[0], submesh.BoundsCenter[1], submesh.BoundsCenter[2]),
+		XMFLOAT3(submesh.BoundsExtents[0], submesh.BoundsExtents[1], submesh.BoundsExtents[2]));
+}
+
+BoundingSphere MeshFile::Sphere(const Submesh& submesh)
+{
+	return BoundingSphere(
+		XMFLOAT3(submesh.SphereCenter[0], submesh.SphereCenter[1], submesh.SphereCenter[2]),
+		submesh.SphereRadius);
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <DirectXCollision.h>
+#include "GeometryGenerator.h"
+#include "MappedFile.h"
+
+// Binary mesh container (.lmesh) laid out so a memory-mapped file is used in place:
+//
+//	Header | Submesh[SubmeshCount] | positions | attributes | indices
+//
+// Every region starts on a RegionAlignment boundary.  Positions are a packed XMFLOAT3
+// stream and the other attributes are interleaved in a second stream, matching the two
+// vertex buffers d3dUtil::CreateSplitVertexBuffers creates, so the regions are handed to
+// the upload heap as they are.  Loading is a page-in of the mapped file.
+class MeshFile
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	static const uint32 FileMagic = 0x48534D4C; // "LMSH"
+	static const uint32 FileVersion = 1;
+	static const uint32 RegionAlignment = 16;
+	static const size_t NoAttribute = ~(size_t)0;
+
+	// Attribute stream contents, interleaved in this order.  Position is always present
+	// and lives in its own stream.
+	enum Attribute : uint32
+	{
+		Normal = 1 << 0,	// XMFLOAT3
+		TangentU = 1 << 1,	// XMFLOAT3
+		TexC = 1 << 2		// XMFLOAT2
+	};
+
+	struct Header
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 Attributes;
+		uint32 AttributeStride;
+
+		uint32 VertexCount;
+		uint32 IndexCount;
+		// DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT.
+		uint32 IndexFormat;
+		uint32 SubmeshCount;
+
+		// Byte offsets from the start of the file.
+		uint64 SubmeshOffset;
+		uint64 PositionOffset;
+		uint64 AttributeOffset;
+		uint64 IndexOffset;
+
+		float BoundsCenter[3];
+		float BoundsExtents[3];
+		float SphereCenter[3];
+		float SphereRadius;
+	};
+
+	struct Submesh
+	{
+		char Name[48];
+		uint32 IndexCount;
+		uint32 StartIndexLocation;
+		std::int32_t BaseVertexLocation;
+		uint32 Reserved;
+
+		float BoundsCenter[3];
+		float BoundsExtents[3];
+		float SphereCenter[3];
+		float SphereRadius;
+	};
+
+	// Where the source attributes live in each vertex; the position is an XMFLOAT3 at
+	// offset 0.  Attributes the file asks for but the source lacks are written as zero.
+	struct VertexLayout
+	{
+		size_t Stride = 0;
+		size_t NormalOffset = NoAttribute;
+		size_t TangentOffset = NoAttribute;
+		size_t TexCOffset = NoAttribute;
+	};
+
+	// A named index range of the shared vertex array.
+	struct Part
+	{
+		std::string Name;
+		uint32 StartIndexLocation = 0;
+		uint32 IndexCount = 0;
+	};
+
+	struct Source
+	{
+		const void* Vertices = nullptr;
+		size_t VertexCount = 0;
+		VertexLayout Layout;
+		const uint32* Indices = nullptr;
+		size_t IndexCount = 0;
+
+		// Empty means one part named "mesh" covering every index.
+		std::vector<Part> Parts;
+	};
+
+	// Writes 'source' with the given Attribute mask.  Indices are stored as 16 bits when
+	// every vertex can be addressed that way.
+	static bool Save(const std::wstring& path, const Source& source, uint32 attributes, std::string* error = nullptr);
+
+	// The same file built in memory, e.g. for AssetPack.
+	static bool Write(const Source& source, uint32 attributes, std::vector<std::uint8_t>& bytes,
+		std::string* error = nullptr);
+
+	// GeometryGenerator output, with every attribute.
+	static bool Save(const std::wstring& path, const GeometryGenerator::MeshData& mesh, const std::string& name,
+		std::string* error = nullptr);
+	static bool Write(const GeometryGenerator::MeshData& mesh, const std::string& name, uint32 attributes,
+		std::vector<std::uint8_t>& bytes, std::string* error = nullptr);
+
+	// Converts one of the Luna text models (see ModelLoader), whose only part is named
+	// after 'name'.  TangentU and TexC, if asked for, are zero.
+	static bool ConvertTextModel(const std::wstring& textPath, const std::wstring& path, const std::string& name,
+		uint32 attributes, std::string* error = nullptr);
+
+	// Maps and validates the file.  On failure the object is left closed.
+	bool Open(const std::wstring& path, std::string* error = nullptr);
+
+	// Validates a file image the caller keeps alive, such as an AssetPack entry.  'data'
+	// must be RegionAlignment-aligned.
+	bool Open(const void* data, size_t size, std::string* error = nullptr);
+	void Close();
+
+	bool IsOpen() const { return mHeader != nullptr; }
+
+	// The accessors below point into the mapping and are valid while the file is open.
+	const Header& GetHeader() const { return *mHeader; }
+	const Submesh* Submeshes() const { return mSubmeshes; }
+	const Submesh* FindSubmesh(const std::string& name) const;
+
+	const void* Positions() const { return mData + mHeader->PositionOffset; }
+	size_t PositionBytes() const { return (size_t)mHeader->VertexCount * sizeof(DirectX::XMFLOAT3); }
+
+	const void* Attributes() const { return mData + mHeader->AttributeOffset; }
+	size_t AttributeBytes() const { return (size_t)mHeader->VertexCount * mHeader->AttributeStride; }
+
+	const void* Indices() const { return mData + mHeader->IndexOffset; }
+	size_t IndexBytes() const { return (size_t)mHeader->IndexCount * IndexSize(); }
+	uint32 IndexSize() const;
+
+	// A 32-bit copy of the indices, for CPU-side users such as MeshBVH.
+	std::vector<uint32> WidenIndices() const;
+
+	DirectX::BoundingBox Bounds() const;
+	DirectX::BoundingSphere Sphere() const;
+	static DirectX::BoundingBox Bounds(const Submesh& submesh);
+	static DirectX::BoundingSphere Sphere(const Submesh& submesh);
+
+	// Byte offset of each attribute within the attribute stream of a file with the
+	// given mask, or NoAttribute.
+	static size_t AttributeOffset(uint32 attributes, Attribute attribute);
+	static uint32 AttributeStride(uint32 attributes);
+
+private:
+	// Checks the image and points the accessors at it.
+	bool Validate(const char* data, uint64 size, std::string* error);
+
+	MappedFile mFile;
+	const char* mData = nullptr;
+	const Header* mHeader = nullptr;
+	const Submesh* mSubmeshes = nullptr;
+};
@@ -0,0 +1,803 @@
+#include "MeshImporter.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using DirectX::XMFLOAT2;
+using DirectX::XMFLOAT3;
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	const uint32 Missing = ~0u;
+
+	double Since(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Reads a file through a window of BufferSize bytes.  Line() and Take() return views
+	// into the window that stay valid until the next call.
+	class Stream
+	{
+	public:
+		bool Open(const std::wstring& path)
+		{
+			mFile.open(std::filesystem::path(path), std::ios::binary);
+			if (!mFile.is_open())
+				return false;
+			mBuffer.resize(MeshImporter::BufferSize);
+			return true;
+		}
+
+		// The next line without its '\n' or "\r\n".  False at the end of the file, or with
+		// 'tooLong' set when a line does not fit the window.
+		bool Line(const char*& begin, const char*& end, bool& tooLong)
+		{
+			tooLong = false;
+			size_t scanned = 0;
+			for (;;)
+			{
+				const char* p = mBuffer.data() + mBegin;
+				const size_t available = mEnd - mBegin;
+				const char* newline = static_cast<const char*>(memchr(p + scanned, '\n', available - scanned));
+				if (newline != nullptr)
+				{
+					begin = p;
+					end = newline;
+					mBegin += newline + 1 - p;
+					break;
+				}
+				if (mEof)
+				{
+					if (available == 0)
+						return false;
+					begin = p;
+					end = p + available;
+					mBegin = mEnd;
+					break;
+				}
+				if (available == mBuffer.size())
+					return tooLong = true, false;
+
+				scanned = available;
+				Fill(available + 1);
+			}
+
+			if (end > begin && end[-1] == '\r')
+				--end;
+			++mLine;
+			return true;
+		}
+
+		// The next n bytes, or nullptr if the file ends first or n exceeds the window.
+		const char* Take(size_t n)
+		{
+			if (mEnd - mBegin < n && Fill(n) < n)
+				return nullptr;
+			const char* p = mBuffer.data() + mBegin;
+			mBegin += n;
+			return p;
+		}
+
+		size_t LineNumber() const { return mLine; }
+		size_t BytesRead() const { return mRead; }
+
+	private:
+		// Moves the unread bytes to the front of the window and reads until at least n are
+		// buffered or the file ends.  Returns the bytes buffered.
+		size_t Fill(size_t n)
+		{
+			memmove(mBuffer.data(), mBuffer.data() + mBegin, mEnd - mBegin);
+			mEnd -= mBegin;
+			mBegin = 0;
+			while (mEnd < n && !mEof)
+			{
+				mFile.read(mBuffer.data() + mEnd, mBuffer.size() - mEnd);
+				const size_t got = (size_t)mFile.gcount();
+				mEnd += got;
+				mRead += got;
+				mEof = got == 0;
+			}
+			return mEnd;
+		}
+
+		std::ifstream mFile;
+		std::vector<char> mBuffer;
+		size_t mBegin = 0;
+		size_t mEnd = 0;
+		size_t mLine = 0;
+		size_t mRead = 0;
+		bool mEof = false;
+	};
+
+	// Walks one line.
+	struct LineCursor
+	{
+		const char* P;
+		const char* End;
+
+		void SkipBlanks()
+		{
+			while (P < End && (*P == ' ' || *P == '\t'))
+				++P;
+		}
+
+		bool AtEnd()
+		{
+			SkipBlanks();
+			return P == End;
+		}
+
+		// The next whitespace-separated word; empty at the end of the line.
+		std::string Word()
+		{
+			SkipBlanks();
+			const char* start = P;
+			while (P < End && *P != ' ' && *P != '\t')
+				++P;
+			return std::string(start, P);
+		}
+
+		bool Is(const char* word)
+		{
+			SkipBlanks();
+			const char* start = P;
+			while (P < End && *P != ' ' && *P != '\t')
+				++P;
+			const size_t n = strlen(word);
+			if ((size_t)(P - start) == n && memcmp(start, word, n) == 0)
+				return true;
+			P = start;
+			return false;
+		}
+
+		bool Float(float& value)
+		{
+			SkipBlanks();
+			auto result = std::from_chars(P, End, value);
+			if (result.ec != std::errc())
+				return false;
+			P = result.ptr;
+			return true;
+		}
+
+		// No leading blanks: face corners are "p/t/n" with nothing in between.
+		bool Int(long long& value)
+		{
+			auto result = std::from_chars(P, End, value);
+			if (result.ec != std::errc())
+				return false;
+			P = result.ptr;
+			return true;
+		}
+	};
+
+	// OBJ indices count from 1, or back from the last element defined when negative.
+	bool Resolve(long long index, size_t count, uint32& resolved)
+	{
+		if (index > 0 && (uint64)index <= count)
+			resolved = (uint32)(index - 1);
+		else if (index < 0 && (uint64)-index <= count)
+			resolved = (uint32)(count + index);
+		else
+			return false;
+		return true;
+	}
+
+	// The output vertex for each distinct position/texcoord/normal triplet an OBJ face
+	// uses.  Open addressing with linear probing; the slots hold the key beside the value
+	// so a lookup touches one cache line.
+	class CornerMap
+	{
+	public:
+		struct Key
+		{
+			uint32 P, T, N;
+		};
+
+		CornerMap() : mSlots(1 << 16) {}
+
+		// The vertex stored for 'key', or 'next' after storing it, in which case 'added'
+		// is set.
+		uint32 Insert(const Key& key, uint32 next, bool& added)
+		{
+			if (2 * (mCount + 1) > mSlots.size())
+				Grow();
+
+			const size_t mask = mSlots.size() - 1;
+			for (size_t i = Hash(key) & mask;; i = (i + 1) & mask)
+			{
+				Slot& slot = mSlots[i];
+				if (slot.Vertex == Missing)
+				{
+					slot.Key = key;
+					slot.Vertex = next;
+					++mCount;
+					added = true;
+					return next;
+				}
+				if (slot.Key.P == key.P && slot.Key.T == key.T && slot.Key.N == key.N)
+				{
+					added = false;
+					return slot.Vertex;
+				}
+			}
+		}
+
+	private:
+		struct Slot
+		{
+			CornerMap::Key Key = { 0, 0, 0 };
+			uint32 Vertex = Missing;
+		};
+
+		static size_t Hash(const Key& key)
+		{
+			uint64 h = key.P * 0x9E3779B97F4A7C15ull ^ key.T * 0xC2B2AE3D27D4EB4Full ^ key.N * 0x165667B19E3779F9ull;
+			return (size_t)(h ^ (h >> 29));
+		}
+
+		void Grow()
+		{
+			std::vector<Slot> old(mSlots.size() * 2);
+			old.swap(mSlots);
+
+			const size_t mask = mSlots.size() - 1;
+			for (const Slot& slot : old)
+			{
+				if (slot.Vertex == Missing)
+					continue;
+				size_t i = Hash(slot.Key) & mask;
+				while (mSlots[i].Vertex != Missing)
+					i = (i + 1) & mask;
+				mSlots[i] = slot;
+			}
+		}
+
+		std::vector<Slot> mSlots;
+		size_t mCount = 0;
+	};
+
+	// Appends the fan of 'polygon' to the index list.
+	void Triangulate(const std::vector<uint32>& polygon, bool reverse, std::vector<uint32>& indices)
+	{
+		for (size_t i = 2; i < polygon.size(); ++i)
+		{
+			indices.push_back(polygon[0]);
+			indices.push_back(polygon[reverse ? i : i - 1]);
+			indices.push_back(polygon[reverse ? i - 1 : i]);
+		}
+	}
+
+	GeometryGenerator::Vertex MakeVertex(const XMFLOAT3& position, const XMFLOAT3& normal, const XMFLOAT2& texC,
+		bool hasTexC, const MeshImporter::Options& options)
+	{
+		GeometryGenerator::Vertex v;
+		v.Position = position;
+		v.Normal = normal;
+		v.TangentU = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		v.TexC = texC;
+		if (options.ConvertHandedness)
+		{
+			v.Position.z = -v.Position.z;
+			v.Normal.z = -v.Normal.z;
+		}
+		if (options.FlipV && hasTexC)
+			v.TexC.y = 1.0f - v.TexC.y;
+		return v;
+	}
+
+	enum class Scalar
+	{
+		Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64
+	};
+
+	bool ParseScalar(const std::string& name, Scalar& type, size_t& size)
+	{
+		static const struct { const char* Name; Scalar Type; size_t Size; } types[] =
+		{
+			{ "char", Scalar::Int8, 1 }, { "int8", Scalar::Int8, 1 },
+			{ "uchar", Scalar::UInt8, 1 }, { "uint8", Scalar::UInt8, 1 },
+			{ "short", Scalar::Int16, 2 }, { "int16", Scalar::Int16, 2 },
+			{ "ushort", Scalar::UInt16, 2 }, { "uint16", Scalar::UInt16, 2 },
+			{ "int", Scalar::Int32, 4 }, { "int32", Scalar::Int32, 4 },
+			{ "uint", Scalar::UInt32, 4 }, { "uint32", Scalar::UInt32, 4 },
+			{ "float", Scalar::Float32, 4 }, { "float32", Scalar::Float32, 4 },
+			{ "double", Scalar::Float64, 8 }, { "float64", Scalar::Float64, 8 },
+		};
+		for (const auto& t : types)
+		{
+			if (name == t.Name)
+			{
+				type = t.Type;
+				size = t.Size;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template<typename T>
+	T Load(const char* p, bool swap)
+	{
+		char bytes[sizeof(T)];
+		memcpy(bytes, p, sizeof(T));
+		if (swap)
+			std::reverse(bytes, bytes + sizeof(T));
+		T value;
+		memcpy(&value, bytes, sizeof(T));
+		return value;
+	}
+
+	double ReadScalar(const char* p, Scalar type, bool swap)
+	{
+		switch (type)
+		{
+		case Scalar::Int8:		return (std::int8_t)*p;
+		case Scalar::UInt8:		return (std::uint8_t)*p;
+		case Scalar::Int16:		return Load<std::int16_t>(p, swap);
+		case Scalar::UInt16:	return Load<std::uint16_t>(p, swap);
+		case Scalar::Int32:		return Load<std::int32_t>(p, swap);
+		case Scalar::UInt32:	return Load<std::uint32_t>(p, swap);
+		case Scalar::Float32:	return Load<float>(p, swap);
+		default:				return Load<double>(p, swap);
+		}
+	}
+
+	struct PlyProperty
+	{
+		std::string Name;
+		Scalar Type = Scalar::Float32;
+		size_t Size = 0;
+		// Lists are a count of CountType followed by that many values of Type.
+		bool List = false;
+		Scalar CountType = Scalar::UInt8;
+		size_t CountSize = 0;
+	};
+
+	struct PlyElement
+	{
+		std::string Name;
+		uint64 Count = 0;
+		std::vector<PlyProperty> Properties;
+		// Bytes per record, or 0 if the records hold lists and so vary.
+		size_t Stride = 0;
+	};
+
+	// Reads one record of 'element', passing each scalar property to scalar(index, bytes)
+	// and each list to list(index, count, bytes).  False if the file ends first.
+	template<typename ScalarFn, typename ListFn>
+	bool ReadRecord(Stream& stream, const PlyElement& element, bool swap, ScalarFn scalar, ListFn list)
+	{
+		if (element.Stride != 0)
+		{
+			const char* p = stream.Take(element.Stride);
+			if (p == nullptr)
+				return false;
+			for (size_t i = 0; i < element.Properties.size(); p += element.Properties[i++].Size)
+				scalar(i, p);
+			return true;
+		}
+
+		for (size_t i = 0; i < element.Properties.size(); ++i)
+		{
+			const PlyProperty& property = element.Properties[i];
+			if (!property.List)
+			{
+				const char* p = stream.Take(property.Size);
+				if (p == nullptr)
+					return false;
+				scalar(i, p);
+				continue;
+			}
+
+			const char* p = stream.Take(property.CountSize);
+			if (p == nullptr)
+				return false;
+			const double count = ReadScalar(p, property.CountType, swap);
+			if (count < 0 || count * property.Size > MeshImporter::BufferSize)
+				return false;
+
+			p = stream.Take((size_t)count * property.Size);
+			if (p == nullptr)
+				return false;
+			list(i, (size_t)count, p);
+		}
+		return true;
+	}
+
+	// Where each vertex property goes in the eight floats a PLY vertex is read into.
+	int VertexSlot(const std::string& name)
+	{
+		static const char* const names[][2] =
+		{
+			{ "x", nullptr }, { "y", nullptr }, { "z", nullptr },
+			{ "nx", nullptr }, { "ny", nullptr }, { "nz", nullptr },
+			{ "u", "s" }, { "v", "t" },
+		};
+		for (int i = 0; i < 8; ++i)
+		{
+			if (name == names[i][0] || (names[i][1] != nullptr && name == names[i][1]) ||
+				(i >= 6 && name == std::string("texture_") + names[i][0]))
+				return i;
+		}
+		return -1;
+	}
+
+	bool Finish(MeshImporter::Stats& s, const GeometryGenerator::MeshData& mesh, const Stream& stream,
+		Clock::time_point start)
+	{
+		s.VertexCount = mesh.Vertices.size();
+		s.TriangleCount = mesh.Indices32.size() / 3;
+		s.Bytes = stream.BytesRead();
+		s.Milliseconds = Since(start);
+		return true;
+	}
+}
+
+const size_t MeshImporter::BufferSize;
+
+bool MeshImporter::ImportObj(const std::wstring& path, GeometryGenerator::MeshData& mesh, Stats* stats,
+	const Options& options)
+{
+	auto start = Clock::now();
+	Stats local;
+	Stats& s = stats ? *stats : local;
+	s = Stats();
+	mesh = GeometryGenerator::MeshData();
+
+	Stream stream;
+	if (!stream.Open(path))
+	{
+		s.Error = "cannot open the file";
+		return false;
+	}
+
+	auto fail = [&](const char* what)
+	{
+		s.Error = std::string(what) + " on line " + std::to_string(stream.LineNumber());
+		return false;
+	};
+
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT2> texCoords;
+	CornerMap corners;
+	std::vector<uint32> polygon;
+
+	const char* begin;
+	const char* end;
+	bool tooLong;
+	while (stream.Line(begin, end, tooLong))
+	{
+		LineCursor cursor = { begin, end };
+		if (cursor.AtEnd() || *cursor.P == '#')
+			continue;
+
+		if (cursor.Is("v"))
+		{
+			// An optional w follows; it has no meaning for meshes.
+			XMFLOAT3 p;
+			if (!cursor.Float(p.x) || !cursor.Float(p.y) || !cursor.Float(p.z))
+				return fail("expected 3 numbers per position");
+			positions.push_back(p);
+		}
+		else if (cursor.Is("vt"))
+		{
+			XMFLOAT2 t(0.0f, 0.0f);
+			if (!cursor.Float(t.x))
+				return fail("expected a texture coordinate");
+			cursor.Float(t.y);
+			texCoords.push_back(t);
+		}
+		else if (cursor.Is("vn"))
+		{
+			XMFLOAT3 n;
+			if (!cursor.Float(n.x) || !cursor.Float(n.y) || !cursor.Float(n.z))
+				return fail("expected 3 numbers per normal");
+			normals.push_back(n);
+		}
+		else if (cursor.Is("f"))
+		{
+			polygon.clear();
+			while (!cursor.AtEnd())
+			{
+				// p, p/t, p//n or p/t/n.
+				long long p, t = 0, n = 0;
+				bool hasT = false, hasN = false;
+				if (!cursor.Int(p))
+					return fail("expected a vertex index");
+				if (cursor.P < cursor.End && *cursor.P == '/')
+				{
+					++cursor.P;
+					if (cursor.P < cursor.End && *cursor.P != '/')
+					{
+						if (!cursor.Int(t))
+							return fail("expected a texture coordinate index");
+						hasT = true;
+					}
+					if (cursor.P < cursor.End && *cursor.P == '/')
+					{
+						++cursor.P;
+						if (!cursor.Int(n))
+							return fail("expected a normal index");
+						hasN = true;
+					}
+				}
+				if (cursor.P < cursor.End && *cursor.P != ' ' && *cursor.P != '\t')
+					return fail("malformed face corner");
+
+				CornerMap::Key key = { Missing, Missing, Missing };
+				if (!Resolve(p, positions.size(), key.P))
+					return fail("position index out of range");
+				if (hasT && !Resolve(t, texCoords.size(), key.T))
+					return fail("texture coordinate index out of range");
+				if (hasN && !Resolve(n, normals.size(), key.N))
+					return fail("normal index out of range");
+
+				if (mesh.Vertices.size() == Missing)
+					return fail("more vertices than 32-bit indices can address");
+
+				bool added;
+				const uint32 vertex = corners.Insert(key, (uint32)mesh.Vertices.size(), added);
+				if (added)
+				{
+					mesh.Vertices.push_back(MakeVertex(positions[key.P],
+						hasN ? normals[key.N] : XMFLOAT3(0.0f, 0.0f, 0.0f),
+						hasT ? texCoords[key.T] : XMFLOAT2(0.0f, 0.0f), hasT, options));
+				}
+				polygon.push_back(vertex);
+				s.HasNormals |= hasN;
+				s.HasTexCoords |= hasT;
+			}
+
+			if (polygon.size() < 3)
+				return fail("face with fewer than 3 corners");
+			if (polygon.size() > 3)
+				++s.PolygonCount;
+			Triangulate(polygon, options.ConvertHandedness, mesh.Indices32);
+		}
+		// Groups, objects, materials, smoothing groups, lines and points add no triangles.
+	}
+
+	if (tooLong)
+	{
+		s.Error = "line longer than the read buffer after line " + std::to_string(stream.LineNumber());
+		return false;
+	}
+
+	return Finish(s, mesh, stream, start);
+}
+
+bool MeshImporter::ImportPly(const std::wstring& path, GeometryGenerator::MeshData& mesh, Stats* stats,
+	const Options& options)
+{
+	auto start = Clock::now();
+	Stats local;
+	Stats& s = stats ? *stats : local;
+	s = Stats();
+	mesh = GeometryGenerator::MeshData();
+
+	Stream stream;
+	if (!stream.Open(path))
+	{
+		s.Error = "cannot open the file";
+		return false;
+	}
+
+	auto failLine = [&](const char* what)
+	{
+		s.Error = std::string(what) + " on header line " + std::to_string(stream.LineNumber());
+		return false;
+	};
+
+	const char* begin;
+	const char* end;
+	bool tooLong;
+	if (!stream.Line(begin, end, tooLong) || std::string(begin, end) != "ply")
+	{
+		s.Error = "not a PLY file";
+		return false;
+	}
+
+	bool swap = false;
+	bool haveFormat = false;
+	std::vector<PlyElement> elements;
+	for (;;)
+	{
+		if (!stream.Line(begin, end, tooLong))
+			return failLine("missing end_header");
+
+		LineCursor cursor = { begin, end };
+		const std::string keyword = cursor.Word();
+		if (keyword == "end_header")
+			break;
+
+		if (keyword == "format")
+		{
+			const std::string format = cursor.Word();
+			if (format == "ascii")
+				return failLine("ASCII PLY is not supported, only binary");
+			if (format != "binary_little_endian" && format != "binary_big_endian")
+				return failLine("unknown format");
+
+			const std::uint16_t one = 1;
+			const bool littleEndian = *reinterpret_cast<const std::uint8_t*>(&one) == 1;
+			swap = (format == "binary_little_endian") != littleEndian;
+			haveFormat = true;
+		}
+		else if (keyword == "element")
+		{
+			PlyElement element;
+			element.Name = cursor.Word();
+			const std::string count = cursor.Word();
+			auto result = std::from_chars(count.data(), count.data() + count.size(), element.Count);
+			if (element.Name.empty() || result.ec != std::errc() || result.ptr != count.data() + count.size())
+				return failLine("expected 'element name count'");
+			elements.push_back(element);
+		}
+		else if (keyword == "property")
+		{
+			if (elements.empty())
+				return failLine("property before any element");
+
+			PlyProperty property;
+			std::string type = cursor.Word();
+			if (type == "list")
+			{
+				property.List = true;
+				if (!ParseScalar(cursor.Word(), property.CountType, property.CountSize))
+					return failLine("unknown list count type");
+				type = cursor.Word();
+			}
+			if (!ParseScalar(type, property.Type, property.Size))
+				return failLine("unknown property type");
+			property.Name = cursor.Word();
+			if (property.Name.empty())
+				return failLine("property without a name");
+			elements.back().Properties.push_back(property);
+		}
+		else if (keyword != "comment" && keyword != "obj_info" && !keyword.empty())
+		{
+			return failLine("unknown header keyword");
+		}
+	}
+
+	if (!haveFormat)
+		return failLine("missing format");
+
+	for (PlyElement& element : elements)
+	{
+		bool lists = false;
+		for (const PlyProperty& property : element.Properties)
+		{
+			element.Stride += property.Size;
+			lists |= property.List;
+		}
+		if (lists || element.Stride > BufferSize)
+			element.Stride = 0;
+	}
+
+	auto fail = [&](const std::string& what)
+	{
+		s.Error = what;
+		return false;
+	};
+
+	for (const PlyElement& element : elements)
+	{
+		if (element.Name == "vertex")
+		{
+			if (element.Count > Missing)
+				return fail("more vertices than 32-bit indices can address");
+
+			std::vector<int> slots(element.Properties.size());
+			for (size_t i = 0; i < slots.size(); ++i)
+			{
+				slots[i] = element.Properties[i].List ? -1 : VertexSlot(element.Properties[i].Name);
+				s.HasNormals |= slots[i] >= 3 && slots[i] < 6;
+				s.HasTexCoords |= slots[i] >= 6;
+			}
+
+			mesh.Vertices.reserve(mesh.Vertices.size() + (size_t)element.Count);
+			for (uint64 i = 0; i < element.Count; ++i)
+			{
+				float values[8] = {};
+				bool ok = ReadRecord(stream, element, swap,
+					[&](size_t property, const char* p)
+				{
+					if (slots[property] >= 0)
+						values[slots[property]] = (float)ReadScalar(p, element.Properties[property].Type, swap);
+				},
+					[](size_t, size_t, const char*) {});
+				if (!ok)
+					return fail("truncated at vertex " + std::to_string(i));
+
+				mesh.Vertices.push_back(MakeVertex(XMFLOAT3(values[0], values[1], values[2]),
+					XMFLOAT3(values[3], values[4], values[5]), XMFLOAT2(values[6], values[7]), s.HasTexCoords, options));
+			}
+		}
+		else if (element.Name == "face")
+		{
+			// Faces index the vertices read so far, so the vertex element must come first,
+			// as it does in every exporter's output.
+			const double vertexCount = (double)mesh.Vertices.size();
+			std::vector<uint32> polygon;
+			const char* error = nullptr;
+			for (uint64 i = 0; i < element.Count; ++i)
+			{
+				bool ok = ReadRecord(stream, element, swap,
+					[](size_t, const char*) {},
+					[&](size_t property, size_t count, const char* p)
+				{
+					const PlyProperty& list = element.Properties[property];
+					if (list.Name != "vertex_indices" && list.Name != "vertex_index")
+						return;
+
+					polygon.clear();
+					for (size_t k = 0; k < count; ++k, p += list.Size)
+					{
+						const double index = ReadScalar(p, list.Type, swap);
+						if (index < 0 || index >= vertexCount)
+						{
+							error = "vertex index out of range";
+							return;
+						}
+						polygon.push_back((uint32)index);
+					}
+					if (count < 3)
+					{
+						error = "face with fewer than 3 corners";
+						return;
+					}
+					if (count > 3)
+						++s.PolygonCount;
+					Triangulate(polygon, options.ConvertHandedness, mesh.Indices32);
+				});
+				if (!ok)
+					return fail("truncated at face " + std::to_string(i));
+				if (error != nullptr)
+					return fail(std::string(error) + " in face " + std::to_string(i));
+			}
+		}
+		else
+		{
+			for (uint64 i = 0; i < element.Count; ++i)
+			{
+				if (!ReadRecord(stream, element, swap, [](size_t, const char*) {}, [](size_t, size_t, const char*) {}))
+					return fail("truncated in element '" + element.Name + "'");
+			}
+		}
+	}
+
+	return Finish(s, mesh, stream, start);
+}
+
+bool MeshImporter::Import(const std::wstring& path, GeometryGenerator::MeshData& mesh, Stats* stats,
+	const Options& options)
+{
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](char c) { return (char)std::tolower((unsigned char)c); });
+
+	if (extension == ".obj")
+		return ImportObj(path, mesh, stats, options);
+	if (extension == ".ply")
+		return ImportPly(path, mesh, stats, options);
+
+	if (stats != nullptr)
+	{
+		*stats = Stats();
+		stats->Error = "unknown model format '" + extension + "'";
+	}
+	return false;
+}
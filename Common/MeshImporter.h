@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "GeometryGenerator.h"
+
+// Imports Wavefront OBJ and binary PLY models into MeshData.  Files are streamed through a
+// fixed BufferSize window rather than read or mapped whole, so the only memory that grows
+// with the input is the mesh being built (and, for OBJ, the position, normal and texture
+// coordinate pools its faces index).
+//
+// OBJ faces index the three pools separately; each distinct position/uv/normal triplet
+// becomes one output vertex, found through a hash table keyed on the triplet.  Polygons of
+// either format are triangulated as fans.  Attributes a file lacks are left zero, and
+// TangentU is always zero; run TangentSpace::Generate() where they are needed.
+class MeshImporter
+{
+public:
+	static const size_t BufferSize = 1 << 20;
+
+	// Both formats are right-handed with the texture origin at the bottom left by
+	// convention, while the samples are left-handed with it at the top left.
+	struct Options
+	{
+		Options() :
+			ConvertHandedness(true),
+			FlipV(true) {}
+
+		// Negates z and reverses the winding.
+		bool ConvertHandedness;
+		// Stores 1 - v.
+		bool FlipV;
+	};
+
+	struct Stats
+	{
+		size_t VertexCount = 0;
+		size_t TriangleCount = 0;
+		// Polygons with more than three corners.
+		size_t PolygonCount = 0;
+		size_t Bytes = 0;
+		bool HasNormals = false;
+		bool HasTexCoords = false;
+		double Milliseconds = 0.0;
+
+		// Empty on success, otherwise what went wrong and where.
+		std::string Error;
+	};
+
+	// v, vt, vn and f records; negative (relative) indices are accepted.  Groups,
+	// materials and smoothing groups are ignored.
+	static bool ImportObj(const std::wstring& path, GeometryGenerator::MeshData& mesh,
+		Stats* stats = nullptr, const Options& options = Options());
+
+	// binary_little_endian or binary_big_endian.  Vertex x/y/z, nx/ny/nz and u/v (or s/t)
+	// of any scalar type, and the face vertex_indices (or vertex_index) list; every other
+	// element and property is skipped.
+	static bool ImportPly(const std::wstring& path, GeometryGenerator::MeshData& mesh,
+		Stats* stats = nullptr, const Options& options = Options());
+
+	// By extension: .obj or .ply.
+	static bool Import(const std::wstring& path, GeometryGenerator::MeshData& mesh,
+		Stats* stats = nullptr, const Options& options = Options());
+};
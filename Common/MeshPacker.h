@@ -0,0 +1,193 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include "D3DUtils.h"
+#include "GeometryGenerator.h"
+#include "IndexBuilder.h"
+#include "MeshBounds.h"
+
+// Concatenates several MeshData into one vertex buffer and one index buffer and
+// fills the DrawArgs of the resulting MeshGeometry, so a whole set of shapes is
+// drawn with a single IA binding.  A mesh with more than 65536 vertices is split into
+// IndexBuilder batches so the pack keeps 16-bit indices; it then has one DrawArgs entry
+// per batch, named by BatchName(), each drawn with its own BaseVertexLocation.
+class MeshPacker
+{
+public:
+	using MeshData = GeometryGenerator::MeshData;
+
+	// The mesh is referenced, not copied; it must outlive the call to Pack().
+	UINT Add(const std::string& name, const MeshData& mesh)
+	{
+		mEntries.push_back({ name, &mesh, nullptr });
+		return (UINT)mEntries.size() - 1;
+	}
+
+	// Keeps shared meshes (e.g. from GeometryCache) alive until the packer is destroyed.
+	UINT Add(const std::string& name, std::shared_ptr<const MeshData> mesh)
+	{
+		const MeshData* ptr = mesh.get();
+		mEntries.push_back({ name, ptr, std::move(mesh) });
+		return (UINT)mEntries.size() - 1;
+	}
+
+	void Clear()
+	{
+		mEntries.clear();
+	}
+
+	UINT TotalVertexCount() const
+	{
+		size_t count = 0;
+		for (const auto& e : mEntries)
+			count += e.Mesh->Vertices.size();
+		return (UINT)count;
+	}
+
+	UINT TotalIndexCount() const
+	{
+		size_t count = 0;
+		for (const auto& e : mEntries)
+			count += e.Mesh->Indices32.size();
+		return (UINT)count;
+	}
+
+	// The DrawArgs name of a mesh's batch: the mesh's own name for the first, which is
+	// the whole mesh unless it was split, then "name#1", "name#2" and so on.
+	static std::string BatchName(const std::string& name, UINT batch)
+	{
+		return batch == 0 ? name : name + "#" + std::to_string(batch);
+	}
+
+	// Indices stay local to each mesh, or to each batch of a large one, and are rebased
+	// with BaseVertexLocation.  R32_UINT only when a mesh cannot be split into few enough
+	// batches, in which case no mesh is split.
+	DXGI_FORMAT ChooseIndexFormat(std::vector<std::vector<IndexBuilder::Batch>>& batches) const
+	{
+		batches.resize(mEntries.size());
+		for (size_t m = 0; m < mEntries.size(); ++m)
+		{
+			const MeshData& mesh = *mEntries[m].Mesh;
+			if (!IndexBuilder::Build(mesh.Indices32.data(), mesh.Indices32.size(), mesh.Vertices.size(), batches[m]))
+			{
+				batches.clear();
+				return DXGI_FORMAT_R32_UINT;
+			}
+		}
+		return DXGI_FORMAT_R16_UINT;
+	}
+
+	// Writes every added mesh into one VB/IB pair.  convert(meshIndex, vertex) turns a
+	// GeometryGenerator vertex of the meshIndex-th added mesh into the app's VertexT.
+	template<typename VertexT, typename ConvertFn>
+	std::unique_ptr<d3dUtil::MeshGeometry> Pack(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		const std::string& geoName,
+		ConvertFn convert) const
+	{
+		std::vector<std::vector<IndexBuilder::Batch>> batches;
+		const DXGI_FORMAT indexFormat = ChooseIndexFormat(batches);
+		const UINT indexSize = indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+		const UINT vbByteSize = TotalVertexCount() * sizeof(VertexT);
+		const UINT ibByteSize = TotalIndexCount() * indexSize;
+
+		auto geo = std::make_unique<d3dUtil::MeshGeometry>();
+		geo->Name = geoName;
+
+		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+
+		// Single pass: each mesh is converted straight into its slot of the final buffers.
+		VertexT* vertices = static_cast<VertexT*>(geo->VertexBufferCPU->GetBufferPointer());
+		BYTE* indices = static_cast<BYTE*>(geo->IndexBufferCPU->GetBufferPointer());
+
+		UINT vertexOffset = 0;
+		UINT indexOffset = 0;
+		for (UINT m = 0; m < (UINT)mEntries.size(); ++m)
+		{
+			const MeshData& mesh = *mEntries[m].Mesh;
+
+			for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+				vertices[vertexOffset + i] = convert(m, mesh.Vertices[i]);
+
+			if (indexFormat == DXGI_FORMAT_R16_UINT)
+			{
+				IndexBuilder::Write16(mesh.Indices32.data(), batches[m],
+					reinterpret_cast<std::uint16_t*>(indices) + indexOffset);
+			}
+			else
+			{
+				std::uint32_t* dst = reinterpret_cast<std::uint32_t*>(indices) + indexOffset;
+				std::copy(mesh.Indices32.begin(), mesh.Indices32.end(), dst);
+			}
+
+			d3dUtil::SubmeshGeometry submesh;
+			submesh.IndexCount = (UINT)mesh.Indices32.size();
+			submesh.StartIndexLocation = indexOffset;
+			submesh.BaseVertexLocation = (INT)vertexOffset;
+			MeshBounds::Compute(mesh.Vertices.data(), mesh.Vertices.size(), sizeof(GeometryGenerator::Vertex),
+				submesh.Bounds, submesh.Sphere);
+
+			if (m == 0)
+			{
+				geo->Bounds = submesh.Bounds;
+				geo->Sphere = submesh.Sphere;
+			}
+			else
+			{
+				DirectX::BoundingBox::CreateMerged(geo->Bounds, geo->Bounds, submesh.Bounds);
+				DirectX::BoundingSphere::CreateMerged(geo->Sphere, geo->Sphere, submesh.Sphere);
+			}
+
+			if (indexFormat == DXGI_FORMAT_R32_UINT || batches[m].size() == 1)
+			{
+				geo->DrawArgs[mEntries[m].Name] = submesh;
+			}
+			else
+			{
+				// Each batch is bounded by the vertex range it reads.
+				for (UINT b = 0; b < (UINT)batches[m].size(); ++b)
+				{
+					const IndexBuilder::Batch& batch = batches[m][b];
+					d3dUtil::SubmeshGeometry part;
+					part.IndexCount = batch.IndexCount;
+					part.StartIndexLocation = indexOffset + batch.StartIndexLocation;
+					part.BaseVertexLocation = (INT)vertexOffset + batch.BaseVertexLocation;
+					MeshBounds::Compute(mesh.Vertices.data() + batch.BaseVertexLocation, batch.VertexCount,
+						sizeof(GeometryGenerator::Vertex), part.Bounds, part.Sphere);
+					geo->DrawArgs[BatchName(mEntries[m].Name, b)] = part;
+				}
+			}
+
+			vertexOffset += (UINT)mesh.Vertices.size();
+			indexOffset += (UINT)mesh.Indices32.size();
+		}
+
+		geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
+			cmdList, geo->VertexBufferCPU.Get(), geo->VertexUploadBuffer);
+
+		geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
+			cmdList, geo->IndexBufferCPU.Get(), geo->IndexUploadBuffer);
+
+		geo->VertexStride = sizeof(VertexT);
+		geo->VertexBufferSize = vbByteSize;
+		geo->IndexFormat = indexFormat;
+		geo->IndexBufferSize = ibByteSize;
+
+		return geo;
+	}
+
+private:
+	struct Entry
+	{
+		std::string Name;
+		const MeshData* Mesh;
+		std::shared_ptr<const MeshData> Owner;
+	};
+
+	std::vector<Entry> mEntries;
+};
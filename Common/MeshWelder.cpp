@@ -0,0 +1,367 @@
+#include "MeshWelder.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	inline const float* Attribute(const std::uint8_t* base, size_t stride, size_t i, size_t offset)
+	{
+		return reinterpret_cast<const float*>(base + i * stride + offset);
+	}
+
+	inline bool Near(const float* a, const float* b, int count, float eps)
+	{
+		for (int k = 0; k < count; ++k)
+		{
+			if (std::fabs(a[k] - b[k]) > eps)
+				return false;
+		}
+		return true;
+	}
+
+	// Uniform grid hashed into a power-of-two number of buckets.
+	struct HashGrid
+	{
+		double InvCellSize;
+		double FaceBand;
+		uint64 BucketMask;
+
+		uint32 Bucket(std::int64_t x, std::int64_t y, std::int64_t z) const
+		{
+			uint64 h = (uint64)x * 0x9E3779B97F4A7C15ull;
+			h ^= (uint64)y * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+			h ^= (uint64)z * 0x165667B19E3779F9ull + (h >> 31);
+			return (uint32)((h ^ (h >> 32)) & BucketMask);
+		}
+
+		// Cell of p, and two bits per axis in 'faces': bit 2k if p is within epsilon of the
+		// cell's low face on axis k, bit 2k+1 for the high face.
+		void Locate(const float* p, std::int64_t cell[3], std::uint8_t& faces) const
+		{
+			faces = 0;
+			for (int k = 0; k < 3; ++k)
+			{
+				double scaled = (double)p[k] * InvCellSize;
+				double c = std::floor(scaled);
+				cell[k] = (std::int64_t)c;
+				if (scaled - c <= FaceBand)
+					faces |= (std::uint8_t)(1 << (2 * k));
+				if (c + 1.0 - scaled <= FaceBand)
+					faces |= (std::uint8_t)(2 << (2 * k));
+			}
+		}
+	};
+
+	// Stable LSD radix sort of (bucket << 32 | vertex) keys on their bucket bits, 11 bits
+	// per pass.  Keys start in vertex order, so each bucket ends up sorted by vertex id.
+	void SortByBucket(std::vector<uint64>& keys, unsigned bucketBits)
+	{
+		const size_t n = keys.size();
+		const unsigned DigitBits = 11;
+		const size_t DigitCount = (size_t)1 << DigitBits;
+		const size_t MinChunk = 16384;
+		const size_t chunkCount = ParallelFor::ChunkCount(n, MinChunk);
+
+		std::vector<uint64> scratch(n);
+		std::vector<uint32> offsets(chunkCount * DigitCount);
+
+		for (unsigned shift = 32; shift < 32 + bucketBits; shift += DigitBits)
+		{
+			std::fill(offsets.begin(), offsets.end(), 0u);
+			ParallelFor::ForChunks(n, MinChunk, [&](size_t chunk, size_t first, size_t last)
+			{
+				uint32* histogram = &offsets[chunk * DigitCount];
+				for (size_t i = first; i < last; ++i)
+					++histogram[(keys[i] >> shift) & (DigitCount - 1)];
+			});
+
+			// Exclusive prefix over (digit, chunk) keeps the scatter stable.
+			uint32 sum = 0;
+			for (size_t d = 0; d < DigitCount; ++d)
+			{
+				for (size_t c = 0; c < chunkCount; ++c)
+				{
+					uint32 count = offsets[c * DigitCount + d];
+					offsets[c * DigitCount + d] = sum;
+					sum += count;
+				}
+			}
+
+			ParallelFor::ForChunks(n, MinChunk, [&](size_t chunk, size_t first, size_t last)
+			{
+				uint32* next = &offsets[chunk * DigitCount];
+				for (size_t i = first; i < last; ++i)
+					scratch[next[(keys[i] >> shift) & (DigitCount - 1)]++] = keys[i];
+			});
+
+			keys.swap(scratch);
+		}
+	}
+}
+
+const size_t MeshWelder::NoAttribute;
+
+std::vector<std::uint32_t> MeshWelder::ComputeRemap(const void* vertices, size_t vertexCount,
+	const VertexLayout& layout, const Options& options)
+{
+	std::vector<uint32> remap(vertexCount);
+	if (vertexCount == 0)
+		return remap;
+
+	const std::uint8_t* base = static_cast<const std::uint8_t*>(vertices);
+	const size_t stride = layout.Stride;
+	const float posEps = std::max(options.PositionEpsilon, 0.0f);
+
+	// Size the cells for roughly one surface vertex per cell (the extent over sqrt(n)),
+	// but never below twice the epsilon, so a match can only lie in the vertex's own cell
+	// or across a cell face the vertex is within epsilon of.
+	const size_t boundsChunks = ParallelFor::ChunkCount(vertexCount, 4096);
+	std::vector<float> chunkMin(boundsChunks * 3), chunkMax(boundsChunks * 3);
+	ParallelFor::ForChunks(vertexCount, 4096, [&](size_t chunk, size_t first, size_t last)
+	{
+		float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (size_t i = first; i < last; ++i)
+		{
+			const float* p = Attribute(base, stride, i, 0);
+			for (int k = 0; k < 3; ++k)
+			{
+				lo[k] = std::min(lo[k], p[k]);
+				hi[k] = std::max(hi[k], p[k]);
+			}
+		}
+		for (int k = 0; k < 3; ++k)
+		{
+			chunkMin[chunk * 3 + k] = lo[k];
+			chunkMax[chunk * 3 + k] = hi[k];
+		}
+	});
+
+	float extent = 0.0f;
+	for (int k = 0; k < 3; ++k)
+	{
+		float lo = FLT_MAX, hi = -FLT_MAX;
+		for (size_t c = 0; c < boundsChunks; ++c)
+		{
+			lo = std::min(lo, chunkMin[c * 3 + k]);
+			hi = std::max(hi, chunkMax[c * 3 + k]);
+		}
+		extent = std::max(extent, hi - lo);
+	}
+
+	unsigned bucketBits = 1;
+	while (((size_t)1 << bucketBits) < vertexCount)
+		++bucketBits;
+	const size_t bucketCount = (size_t)1 << bucketBits;
+
+	HashGrid grid;
+	const double cellSize = std::max({ 2.0 * posEps, (double)extent / std::sqrt((double)vertexCount), 1e-6 });
+	grid.InvCellSize = 1.0 / cellSize;
+	grid.FaceBand = posEps * grid.InvCellSize;
+	grid.BucketMask = bucketCount - 1;
+
+	// Group vertex ids by bucket.
+	std::vector<uint64> keys(vertexCount);
+	ParallelFor::For(vertexCount, 4096, [&](size_t i)
+	{
+		std::int64_t cell[3];
+		std::uint8_t faces;
+		grid.Locate(Attribute(base, stride, i, 0), cell, faces);
+		keys[i] = ((uint64)grid.Bucket(cell[0], cell[1], cell[2]) << 32) | (uint64)i;
+	});
+
+	SortByBucket(keys, bucketBits);
+
+	std::vector<uint32> bucketStart(bucketCount + 1);
+	{
+		size_t s = 0;
+		for (size_t b = 0; b < bucketCount; ++b)
+		{
+			bucketStart[b] = (uint32)s;
+			while (s < vertexCount && (keys[s] >> 32) == b)
+				++s;
+		}
+		bucketStart[bucketCount] = (uint32)vertexCount;
+	}
+
+	// Positions gathered in bucket order, so candidate tests read neighbouring memory
+	// instead of chasing vertex ids across the whole vertex buffer.
+	struct Position
+	{
+		float P[3];
+	};
+	std::vector<Position> sortedPositions(vertexCount);
+	ParallelFor::For(vertexCount, 4096, [&](size_t s)
+	{
+		memcpy(sortedPositions[s].P, Attribute(base, stride, (uint32)keys[s], 0), sizeof(Position));
+	});
+
+	// s and t are positions in the sorted order.
+	auto matches = [&](size_t s, size_t t)
+	{
+		if (!Near(sortedPositions[s].P, sortedPositions[t].P, 3, posEps))
+			return false;
+
+		const uint32 v = (uint32)keys[s];
+		const uint32 u = (uint32)keys[t];
+		if (layout.NormalOffset != NoAttribute &&
+			!Near(Attribute(base, stride, v, layout.NormalOffset), Attribute(base, stride, u, layout.NormalOffset), 3, options.NormalEpsilon))
+			return false;
+		if (layout.TexCOffset != NoAttribute &&
+			!Near(Attribute(base, stride, v, layout.TexCOffset), Attribute(base, stride, u, layout.TexCOffset), 2, options.TexCEpsilon))
+			return false;
+		return true;
+	};
+
+	// Each vertex maps to the lowest-indexed matching vertex among its candidate cells.
+	// Walking the sorted keys runs over the buckets in order, in parallel.
+	ParallelFor::For(vertexCount, 4096, [&](size_t s)
+	{
+		const uint32 v = (uint32)keys[s];
+		const uint32 bucket = (uint32)(keys[s] >> 32);
+
+		// Bucket entries before s are exactly the lower-indexed vertices of this bucket.
+		uint32 best = v;
+		for (uint32 t = bucketStart[bucket]; t < s; ++t)
+		{
+			if (matches(s, t))
+			{
+				best = (uint32)keys[t];
+				break;
+			}
+		}
+
+		std::int64_t cell[3];
+		std::uint8_t faces;
+		grid.Locate(sortedPositions[s].P, cell, faces);
+
+		// Cross only the faces v is near; for almost every vertex there are none.
+		if (faces != 0)
+		{
+			int offsets[3][3];
+			int offsetCount[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				offsetCount[k] = 0;
+				offsets[k][offsetCount[k]++] = 0;
+				if (faces & (1 << (2 * k)))
+					offsets[k][offsetCount[k]++] = -1;
+				if (faces & (2 << (2 * k)))
+					offsets[k][offsetCount[k]++] = 1;
+			}
+
+			uint32 visited[8] = { bucket };
+			int visitedCount = 1;
+
+			for (int ox = 0; ox < offsetCount[0]; ++ox)
+			for (int oy = 0; oy < offsetCount[1]; ++oy)
+			for (int oz = 0; oz < offsetCount[2]; ++oz)
+			{
+				uint32 nb = grid.Bucket(cell[0] + offsets[0][ox], cell[1] + offsets[1][oy], cell[2] + offsets[2][oz]);
+				if (std::find(visited, visited + visitedCount, nb) != visited + visitedCount)
+					continue;
+				if (visitedCount < 8)
+					visited[visitedCount++] = nb;
+
+				for (uint32 t = bucketStart[nb]; t < bucketStart[nb + 1]; ++t)
+				{
+					const uint32 u = (uint32)keys[t];
+					if (u >= best)
+						break;
+					if (matches(s, t))
+					{
+						best = u;
+						break;
+					}
+				}
+			}
+		}
+
+		remap[v] = best;
+	});
+
+	// remap[v] < v for merged vertices, so one forward pass collapses chains onto the
+	// group's first vertex.
+	for (size_t v = 0; v < vertexCount; ++v)
+		remap[v] = remap[remap[v]];
+
+	return remap;
+}
+
+MeshWelder::Stats MeshWelder::Weld(void* vertices, size_t vertexCount, const VertexLayout& layout,
+	std::uint32_t* indices, size_t indexCount, const Options& options)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	Stats stats;
+	stats.VerticesBefore = vertexCount;
+	stats.TrianglesBefore = indexCount / 3;
+
+	std::vector<uint32> remap = ComputeRemap(vertices, vertexCount, layout, options);
+
+	// Compact the surviving vertices in place; their new slots never pass their old ones.
+	std::vector<uint32> newIndex(vertexCount);
+	std::uint8_t* base = static_cast<std::uint8_t*>(vertices);
+	uint32 kept = 0;
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		if (remap[v] == v)
+		{
+			if (kept != v)
+				memmove(base + kept * layout.Stride, base + v * layout.Stride, layout.Stride);
+			newIndex[v] = kept++;
+		}
+		else
+		{
+			newIndex[v] = newIndex[remap[v]];
+		}
+	}
+	stats.VerticesAfter = kept;
+
+	ParallelFor::For(indexCount, 16384, [&](size_t i)
+	{
+		indices[i] = newIndex[indices[i]];
+	});
+
+	size_t triCount = indexCount / 3;
+	if (options.RemoveDegenerateTriangles)
+	{
+		size_t out = 0;
+		for (size_t t = 0; t < indexCount / 3; ++t)
+		{
+			uint32 a = indices[t * 3 + 0];
+			uint32 b = indices[t * 3 + 1];
+			uint32 c = indices[t * 3 + 2];
+			if (a == b || b == c || a == c)
+				continue;
+
+			indices[out * 3 + 0] = a;
+			indices[out * 3 + 1] = b;
+			indices[out * 3 + 2] = c;
+			++out;
+		}
+		triCount = out;
+	}
+	stats.TrianglesAfter = triCount;
+
+	auto end = std::chrono::high_resolution_clock::now();
+	stats.Milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+	return stats;
+}
+
+MeshWelder::Stats MeshWelder::Weld(GeometryGenerator::MeshData& mesh, const Options& options)
+{
+	VertexLayout layout;
+	layout.Stride = sizeof(GeometryGenerator::Vertex);
+	layout.NormalOffset = offsetof(GeometryGenerator::Vertex, Normal);
+	layout.TexCOffset = offsetof(GeometryGenerator::Vertex, TexC);
+
+	return Weld(mesh.Vertices, mesh.Indices32, layout, options);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "GeometryGenerator.h"
+
+// Merges vertices whose position, normal and texture coordinates all agree within an
+// epsilon, then remaps the indices.  Candidates are found through a spatial hash grid, and
+// the hashing, matching and remapping passes run in parallel over the hash buckets.
+class MeshWelder
+{
+public:
+	static const size_t NoAttribute = ~(size_t)0;
+
+	// Where the attributes live in the vertex.  The position is an XMFLOAT3 at offset 0;
+	// the normal (XMFLOAT3) and texture coordinates (XMFLOAT2) are optional.
+	struct VertexLayout
+	{
+		size_t Stride = 0;
+		size_t NormalOffset = NoAttribute;
+		size_t TexCOffset = NoAttribute;
+	};
+
+	// Per-component tolerances.
+	struct Options
+	{
+		Options() :
+			PositionEpsilon(1e-5f),
+			NormalEpsilon(1e-3f),
+			TexCEpsilon(1e-4f),
+			RemoveDegenerateTriangles(true) {}
+
+		float PositionEpsilon;
+		float NormalEpsilon;
+		float TexCEpsilon;
+		bool RemoveDegenerateTriangles;
+	};
+
+	struct Stats
+	{
+		size_t VerticesBefore = 0;
+		size_t VerticesAfter = 0;
+		size_t TrianglesBefore = 0;
+		size_t TrianglesAfter = 0;
+		double Milliseconds = 0.0;
+
+		// Fraction of vertices removed, in [0, 1].
+		float VertexReduction() const
+		{
+			return VerticesBefore ? 1.0f - (float)VerticesAfter / (float)VerticesBefore : 0.0f;
+		}
+	};
+
+	// Welds in place: the first VerticesAfter vertices and TrianglesAfter * 3 indices of
+	// the arrays are valid afterwards.  Surviving vertices keep their relative order and
+	// every merged vertex maps to the lowest-indexed vertex of its group.
+	static Stats Weld(void* vertices, size_t vertexCount, const VertexLayout& layout,
+		std::uint32_t* indices, size_t indexCount, const Options& options = Options());
+
+	// Call before MeshData::GetIndices16(), whose cached copy is not renumbered.
+	static Stats Weld(GeometryGenerator::MeshData& mesh, const Options& options = Options());
+
+	template<typename VertexT>
+	static Stats Weld(std::vector<VertexT>& vertices, std::vector<std::uint32_t>& indices,
+		const VertexLayout& layout, const Options& options = Options())
+	{
+		Stats stats = Weld(vertices.data(), vertices.size(), layout, indices.data(), indices.size(), options);
+		vertices.resize(stats.VerticesAfter);
+		indices.resize(stats.TrianglesAfter * 3);
+		return stats;
+	}
+
+	// Returns remap[i], the index vertex i merges into (remap[i] <= i, and remap[remap[i]]
+	// == remap[i]).  Does not modify the vertices.
+	static std::vector<std::uint32_t> ComputeRemap(const void* vertices, size_t vertexCount,
+		const VertexLayout& layout, const Options& options = Options());
+};
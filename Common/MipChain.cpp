@@ -0,0 +1,615 @@
+#include "MipChain.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MIPCHAIN_SSE2 1
+#endif
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+	using uint32 = MipChain::uint32;
+
+	bool Fail(std::string* error, const std::string& what)
+	{
+		if (error != nullptr)
+			*error = what;
+		return false;
+	}
+
+	// How a supported format stores its texels.
+	struct Layout
+	{
+		uint32 Channels = 0;
+		bool Float = false;
+		// The first three channels are sRGB-encoded; alpha never is.
+		bool SRGB = false;
+	};
+
+	Layout LayoutOf(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8_UNORM:
+		case DXGI_FORMAT_A8_UNORM:
+			return { 1, false, false };
+		case DXGI_FORMAT_R8G8_UNORM:
+			return { 2, false, false };
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+			return { 4, false, false };
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			return { 4, false, true };
+		case DXGI_FORMAT_R32_FLOAT:
+			return { 1, true, false };
+		case DXGI_FORMAT_R32G32_FLOAT:
+			return { 2, true, false };
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+			return { 3, true, false };
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			return { 4, true, false };
+		default:
+			return Layout();
+		}
+	}
+
+	bool IsSRGBChannel(const Layout& layout, size_t i)
+	{
+		return layout.SRGB && i % layout.Channels < 3;
+	}
+
+	// The sRGB transfer functions of IEC 61966-2-1.
+	double SRGBToLinear(double v)
+	{
+		return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+	}
+
+	double LinearToSRGB(double v)
+	{
+		return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055;
+	}
+
+	// Byte to float conversions by lookup, and sRGB encoding without pow(): each byte
+	// covers an interval of linear values, and Start narrows the search for the one
+	// holding a value to a step or two.
+	struct Tables
+	{
+		static const uint32 Buckets = 4096;
+
+		float Unorm[256];
+		float Linear[256];
+		// The linear value where rounding starts to give each byte.
+		float Threshold[256];
+		std::uint8_t Start[Buckets + 1];
+
+		Tables()
+		{
+			for (uint32 b = 0; b < 256; ++b)
+			{
+				Unorm[b] = b / 255.0f;
+				Linear[b] = (float)SRGBToLinear(b / 255.0);
+				Threshold[b] = b == 0 ? 0.0f : (float)SRGBToLinear((b - 0.5) / 255.0);
+			}
+
+			uint32 b = 0;
+			for (uint32 i = 0; i <= Buckets; ++i)
+			{
+				const float v = (float)i / Buckets;
+				while (b < 255 && v >= Threshold[b + 1])
+					++b;
+				Start[i] = (std::uint8_t)b;
+			}
+		}
+
+		std::uint8_t EncodeSRGB(float v) const
+		{
+			if (!(v > 0.0f))
+				return 0;
+			if (v >= 1.0f)
+				return 255;
+
+			uint32 b = Start[(uint32)(v * Buckets)];
+			while (b < 255 && v >= Threshold[b + 1])
+				++b;
+			return (std::uint8_t)b;
+		}
+	};
+
+	const Tables& GetTables()
+	{
+		static const Tables tables;
+		return tables;
+	}
+
+	const double Pi = 3.14159265358979323846;
+	// Of the windowed sinc filters, in texels of the smaller level.
+	const double Radius = 3.0;
+	const double KaiserAlpha = 4.0;
+
+	double Sinc(double x)
+	{
+		x *= Pi;
+		return std::fabs(x) < 1e-8 ? 1.0 : std::sin(x) / x;
+	}
+
+	// The modified Bessel function of the first kind and order 0, by its power series.
+	double BesselI0(double x)
+	{
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 64 && term > sum * 1e-17; ++k)
+		{
+			const double half = x / (2.0 * k);
+			term *= half * half;
+			sum += term;
+		}
+		return sum;
+	}
+
+	// 't' is in texels of the smaller level.
+	double Kernel(MipChain::Filter filter, double t)
+	{
+		if (std::fabs(t) >= Radius)
+			return 0.0;
+		if (filter == MipChain::Kaiser)
+		{
+			const double r = t / Radius;
+			return Sinc(t) * BesselI0(KaiserAlpha * std::sqrt(1.0 - r * r)) / BesselI0(KaiserAlpha);
+		}
+		return Sinc(t) * Sinc(t / Radius);
+	}
+
+	// The texel a sample past an edge reads.
+	uint32 Address(long long i, uint32 size, bool wrap)
+	{
+		if (wrap)
+		{
+			i %= size;
+			return (uint32)(i < 0 ? i + size : i);
+		}
+		return (uint32)std::min<long long>(std::max<long long>(i, 0), size - 1);
+	}
+
+	// The fraction of texel 's' that [left, right) covers.
+	double Overlap(double left, double right, uint32 s)
+	{
+		return std::max(0.0, std::min(right, s + 1.0) - std::max(left, (double)s));
+	}
+
+	// Along one axis, the texels of the larger level each texel of the smaller one reads,
+	// with weights that sum to one.  Taps of texel i are [First[i], First[i + 1]).
+	struct Taps
+	{
+		std::vector<uint32> First;
+		std::vector<uint32> Index;
+		std::vector<float> Weight;
+	};
+
+	void BuildTaps(uint32 source, uint32 destination, const MipChain::Options& options, Taps& taps)
+	{
+		const double scale = (double)source / destination;
+		taps.First.assign(1, 0);
+		taps.Index.clear();
+		taps.Weight.clear();
+
+		std::vector<std::pair<uint32, double>> row;
+		auto add = [&](uint32 index, double weight)
+		{
+			// Clamped samples land on the edge texel again and again.
+			if (!row.empty() && row.back().first == index)
+				row.back().second += weight;
+			else if (weight != 0.0)
+				row.emplace_back(index, weight);
+		};
+
+		for (uint32 i = 0; i < destination; ++i)
+		{
+			row.clear();
+			if (options.Kernel == MipChain::Box)
+			{
+				const double left = i * scale, right = (i + 1) * scale;
+				for (uint32 s = (uint32)left; s < right && s < source; ++s)
+					add(s, Overlap(left, right, s));
+			}
+			else
+			{
+				const double center = (i + 0.5) * scale;
+				const long long first = (long long)std::floor(center - Radius * scale);
+				const long long last = (long long)std::ceil(center + Radius * scale);
+				for (long long s = first; s <= last; ++s)
+					add(Address(s, source, options.Wrap), Kernel(options.Kernel, (s + 0.5 - center) / scale));
+			}
+
+			double sum = 0.0;
+			for (const auto& tap : row)
+				sum += tap.second;
+			for (const auto& tap : row)
+			{
+				taps.Index.push_back(tap.first);
+				taps.Weight.push_back((float)(tap.second / sum));
+			}
+			taps.First.push_back((uint32)taps.Index.size());
+		}
+	}
+
+	// The vertical pass: the weighted sum of whole source rows, so it runs four floats per
+	// SSE operation whatever the format.
+	void FilterRows(const float* source, size_t rowFloats, const Taps& taps, uint32 y, float* out)
+	{
+		const uint32 first = taps.First[y], last = taps.First[y + 1];
+		size_t x = 0;
+#ifdef MIPCHAIN_SSE2
+		for (; x + 4 <= rowFloats; x += 4)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (uint32 k = first; k < last; ++k)
+			{
+				const __m128 row = _mm_loadu_ps(source + taps.Index[k] * rowFloats + x);
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(taps.Weight[k]), row));
+			}
+			_mm_storeu_ps(out + x, sum);
+		}
+#endif
+		for (; x < rowFloats; ++x)
+		{
+			float sum = 0.0f;
+			for (uint32 k = first; k < last; ++k)
+				sum += taps.Weight[k] * source[taps.Index[k] * rowFloats + x];
+			out[x] = sum;
+		}
+	}
+
+	// The horizontal pass over one row: a whole texel per SSE operation for four-channel
+	// formats.
+	void FilterTexels(const float* row, uint32 channels, const Taps& taps, uint32 width, float* out)
+	{
+#ifdef MIPCHAIN_SSE2
+		if (channels == 4)
+		{
+			for (uint32 x = 0; x < width; ++x)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (uint32 k = taps.First[x]; k < taps.First[x + 1]; ++k)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(taps.Weight[k]), _mm_loadu_ps(row + taps.Index[k] * 4)));
+				_mm_storeu_ps(out + x * 4, sum);
+			}
+			return;
+		}
+#endif
+		for (uint32 x = 0; x < width; ++x)
+		{
+			for (uint32 c = 0; c < channels; ++c)
+			{
+				float sum = 0.0f;
+				for (uint32 k = taps.First[x]; k < taps.First[x + 1]; ++k)
+					sum += taps.Weight[k] * row[taps.Index[k] * channels + c];
+				out[x * channels + c] = sum;
+			}
+		}
+	}
+
+	void Decode(const std::uint8_t* bytes, size_t count, const Layout& layout, float* out)
+	{
+		if (layout.Float)
+		{
+			memcpy(out, bytes, count * sizeof(float));
+			return;
+		}
+
+		const Tables& tables = GetTables();
+		const float* table[4];
+		for (uint32 c = 0; c < layout.Channels; ++c)
+			table[c] = IsSRGBChannel(layout, c) ? tables.Linear : tables.Unorm;
+		for (size_t i = 0; i < count; i += layout.Channels)
+		{
+			for (uint32 c = 0; c < layout.Channels; ++c)
+				out[i + c] = table[c][bytes[i + c]];
+		}
+	}
+
+	void Encode(const float* values, size_t count, const Layout& layout, std::uint8_t* out)
+	{
+		if (layout.Float)
+		{
+			memcpy(out, values, count * sizeof(float));
+			return;
+		}
+
+		const Tables& tables = GetTables();
+		if (layout.SRGB)
+		{
+			// Four channels, the last alpha.
+			for (size_t i = 0; i < count; i += 4)
+			{
+				out[i + 0] = tables.EncodeSRGB(values[i + 0]);
+				out[i + 1] = tables.EncodeSRGB(values[i + 1]);
+				out[i + 2] = tables.EncodeSRGB(values[i + 2]);
+				out[i + 3] = (std::uint8_t)(std::min(std::max(values[i + 3], 0.0f), 1.0f) * 255.0f + 0.5f);
+			}
+			return;
+		}
+
+		size_t i = 0;
+#ifdef MIPCHAIN_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(values + i), zero), one);
+			__m128i n = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
+			n = _mm_packs_epi32(n, n);
+			n = _mm_packus_epi16(n, n);
+			const int packed = _mm_cvtsi128_si32(n);
+			memcpy(out + i, &packed, 4);
+		}
+#endif
+		for (; i < count; ++i)
+			out[i] = (std::uint8_t)(std::min(std::max(values[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+
+	// Rows are split into chunks of about this many texels.
+	const size_t TexelsPerChunk = 16384;
+
+	template<typename Fn>
+	void ForRows(size_t rows, uint32 width, bool parallel, Fn fn)
+	{
+		if (parallel)
+			ParallelFor::ForChunks(rows, std::max<size_t>(TexelsPerChunk / width, 1), fn);
+		else
+			fn((size_t)0, (size_t)0, rows);
+	}
+
+	// What both generators share: the source's layout, and 'out' holding the new file's
+	// header and the top level of every slice, with 'outInfo' describing it.
+	bool Begin(const void* dds, size_t size, const MipChain::Options& options, DDSFile::Info& info, Layout& layout,
+		std::vector<std::uint8_t>& out, DDSFile::Info& outInfo, std::string* error)
+	{
+		if (!DDSFile::Parse(dds, size, size, info, 0, error))
+			return false;
+		if (info.ResourceDimension == DDSFile::Texture3D)
+			return Fail(error, "volume textures are not supported");
+		layout = LayoutOf(info.Format);
+		if (layout.Channels == 0)
+			return Fail(error, "format " + std::to_string(info.Format) + " is not supported");
+
+		const uint32 full = MipChain::FullMipCount(info.Width, info.Height);
+		outInfo = info;
+		outInfo.MipCount = options.MipCount == 0 ? full : std::min(options.MipCount, full);
+
+		out.clear();
+		DDSFile::WriteHeader(outInfo, out);
+		size_t dataBytes = 0;
+		for (uint32 mip = 0; mip < outInfo.MipCount; ++mip)
+		{
+			size_t bytes = 0;
+			DDSFile::SurfaceInfo(std::max(info.Width >> mip, 1u), std::max(info.Height >> mip, 1u), info.Format,
+				&bytes, nullptr, nullptr);
+			dataBytes += bytes;
+		}
+		out.resize(out.size() + dataBytes * info.ArraySize);
+		if (!DDSFile::Parse(out.data(), out.size(), out.size(), outInfo, 0, error))
+			return false;
+
+		const std::uint8_t* bytes = static_cast<const std::uint8_t*>(dds);
+		for (uint32 slice = 0; slice < info.ArraySize; ++slice)
+		{
+			const DDSFile::Subresource& top = info.Subresources[slice * info.MipCount];
+			memcpy(out.data() + outInfo.Subresources[slice * outInfo.MipCount].Offset, bytes + top.Offset,
+				top.SliceBytes);
+		}
+		return true;
+	}
+}
+
+bool MipChain::IsSupported(DXGI_FORMAT format)
+{
+	return LayoutOf(format).Channels != 0;
+}
+
+bool MipChain::NeedsMips(const DDSFile::Info& info)
+{
+	return info.MipCount == 1 && info.ResourceDimension != DDSFile::Texture3D && IsSupported(info.Format) &&
+		FullMipCount(info.Width, info.Height) > 1;
+}
+
+MipChain::uint32 MipChain::FullMipCount(uint32 width, uint32 height)
+{
+	uint32 count = 1;
+	for (uint32 size = std::max(width, height); size > 1; size >>= 1)
+		++count;
+	return count;
+}
+
+bool MipChain::Generate(const void* dds, size_t size, std::vector<std::uint8_t>& out, const Options& options,
+	Stats* stats, std::string* error)
+{
+	auto start = Clock::now();
+	DDSFile::Info info, outInfo;
+	Layout layout;
+	if (!Begin(dds, size, options, info, layout, out, outInfo, error))
+		return false;
+
+	const uint32 slices = info.ArraySize;
+	const uint32 levels = outInfo.MipCount;
+	const uint32 channels = layout.Channels;
+
+	// Every slice's current level as linear floats, one slice after another, and the next.
+	uint32 width = info.Width, height = info.Height;
+	std::vector<float> current((size_t)slices * width * height * channels), next;
+	ForRows((size_t)slices * height, width, options.Parallel, [&](size_t, size_t first, size_t last)
+	{
+		for (size_t row = first; row < last; ++row)
+		{
+			const uint32 slice = (uint32)(row / height), y = (uint32)(row % height);
+			const DDSFile::Subresource& top = outInfo.Subresources[slice * levels];
+			Decode(out.data() + top.Offset + y * top.RowBytes, (size_t)width * channels, layout,
+				current.data() + row * width * channels);
+		}
+	});
+
+	Taps horizontal, vertical;
+	for (uint32 level = 1; level < levels; ++level)
+	{
+		const uint32 nextWidth = std::max(width >> 1, 1u), nextHeight = std::max(height >> 1, 1u);
+		BuildTaps(width, nextWidth, options, horizontal);
+		BuildTaps(height, nextHeight, options, vertical);
+		next.resize((size_t)slices * nextWidth * nextHeight * channels);
+
+		const size_t rowFloats = (size_t)width * channels;
+		ForRows((size_t)slices * nextHeight, nextWidth, options.Parallel, [&](size_t, size_t first, size_t last)
+		{
+			std::vector<float> filtered(rowFloats);
+			for (size_t row = first; row < last; ++row)
+			{
+				const uint32 slice = (uint32)(row / nextHeight), y = (uint32)(row % nextHeight);
+				const float* source = current.data() + (size_t)slice * height * rowFloats;
+				float* destination = next.data() + row * nextWidth * channels;
+				FilterRows(source, rowFloats, vertical, y, filtered.data());
+				FilterTexels(filtered.data(), channels, horizontal, nextWidth, destination);
+
+				const DDSFile::Subresource& mip = outInfo.Subresources[slice * levels + level];
+				Encode(destination, (size_t)nextWidth * channels, layout,
+					out.data() + mip.Offset + y * mip.RowBytes);
+			}
+		});
+
+		current.swap(next);
+		width = nextWidth;
+		height = nextHeight;
+	}
+
+	if (stats != nullptr)
+	{
+		stats->Levels = levels;
+		stats->Slices = slices;
+		stats->Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+	return true;
+}
+
+bool MipChain::GenerateReference(const void* dds, size_t size, std::vector<std::uint8_t>& out,
+	const Options& options, std::string* error)
+{
+	DDSFile::Info info, outInfo;
+	Layout layout;
+	if (!Begin(dds, size, options, info, layout, out, outInfo, error))
+		return false;
+
+	const uint32 slices = info.ArraySize;
+	const uint32 levels = outInfo.MipCount;
+	const uint32 channels = layout.Channels;
+
+	uint32 width = info.Width, height = info.Height;
+	std::vector<double> current((size_t)slices * width * height * channels), next;
+	for (uint32 slice = 0; slice < slices; ++slice)
+	{
+		const std::uint8_t* bytes = out.data() + outInfo.Subresources[slice * levels].Offset;
+		for (size_t i = 0; i < (size_t)width * height * channels; ++i)
+		{
+			double& v = current[slice * width * height * channels + i];
+			if (layout.Float)
+			{
+				float f;
+				memcpy(&f, bytes + i * sizeof(float), sizeof(float));
+				v = f;
+			}
+			else
+			{
+				v = bytes[i] / 255.0;
+				v = IsSRGBChannel(layout, i) ? SRGBToLinear(v) : v;
+			}
+		}
+	}
+
+	for (uint32 level = 1; level < levels; ++level)
+	{
+		const uint32 nextWidth = std::max(width >> 1, 1u), nextHeight = std::max(height >> 1, 1u);
+		const double scaleX = (double)width / nextWidth, scaleY = (double)height / nextHeight;
+		next.assign((size_t)slices * nextWidth * nextHeight * channels, 0.0);
+
+		for (uint32 slice = 0; slice < slices; ++slice)
+		{
+			const double* source = current.data() + (size_t)slice * width * height * channels;
+			std::uint8_t* bytes = out.data() + outInfo.Subresources[slice * levels + level].Offset;
+			for (uint32 y = 0; y < nextHeight; ++y)
+			{
+				for (uint32 x = 0; x < nextWidth; ++x)
+				{
+					// Every texel the 2D kernel reaches, weighted by the product of its two axes.
+					double sum[4] = {}, total = 0.0;
+					long long left, right, top, bottom;
+					if (options.Kernel == Box)
+					{
+						left = (long long)(x * scaleX);
+						right = (long long)std::ceil((x + 1) * scaleX) - 1;
+						top = (long long)(y * scaleY);
+						bottom = (long long)std::ceil((y + 1) * scaleY) - 1;
+					}
+					else
+					{
+						left = (long long)std::floor((x + 0.5 - Radius) * scaleX);
+						right = (long long)std::ceil((x + 0.5 + Radius) * scaleX);
+						top = (long long)std::floor((y + 0.5 - Radius) * scaleY);
+						bottom = (long long)std::ceil((y + 0.5 + Radius) * scaleY);
+					}
+
+					for (long long v = top; v <= bottom; ++v)
+					{
+						for (long long u = left; u <= right; ++u)
+						{
+							double weight;
+							if (options.Kernel == Box)
+							{
+								weight = Overlap(x * scaleX, (x + 1) * scaleX, (uint32)u) *
+									Overlap(y * scaleY, (y + 1) * scaleY, (uint32)v);
+							}
+							else
+							{
+								weight = Kernel(options.Kernel, (u + 0.5) / scaleX - (x + 0.5)) *
+									Kernel(options.Kernel, (v + 0.5) / scaleY - (y + 0.5));
+							}
+
+							const double* texel = source + ((size_t)Address(v, height, options.Wrap) * width +
+								Address(u, width, options.Wrap)) * channels;
+							for (uint32 c = 0; c < channels; ++c)
+								sum[c] += weight * texel[c];
+							total += weight;
+						}
+					}
+
+					const size_t i = ((size_t)y * nextWidth + x) * channels;
+					for (uint32 c = 0; c < channels; ++c)
+					{
+						const double value = sum[c] / total;
+						next[(size_t)slice * nextWidth * nextHeight * channels + i + c] = value;
+						if (layout.Float)
+						{
+							const float f = (float)value;
+							memcpy(bytes + (i + c) * sizeof(float), &f, sizeof(float));
+						}
+						else
+						{
+							double v = std::min(std::max(value, 0.0), 1.0);
+							v = IsSRGBChannel(layout, c) ? LinearToSRGB(v) : v;
+							bytes[i + c] = (std::uint8_t)std::floor(v * 255.0 + 0.5);
+						}
+					}
+				}
+			}
+		}
+
+		current.swap(next);
+		width = nextWidth;
+		height = nextHeight;
+	}
+	return true;
+}
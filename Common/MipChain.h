@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dxgiformat.h>
+#include "DDSFile.h"
+
+// Builds the mip chain of an uncompressed DDS texture on the CPU, from its top level.  A
+// texture with no mips is sampled at full resolution however small it appears on screen,
+// which reads far more texels than it shows and aliases.
+//
+// Each level is filtered from the one above it, held as linear floats, so sRGB texels are
+// decoded before they are averaged and rounding does not build up down the chain.  The
+// filter is separable: a vertical pass over whole rows (four floats per SSE operation),
+// then a horizontal one (a texel per operation for four-channel formats).  The rows of
+// every slice of a level are split across ParallelFor workers.  Platform-independent, so
+// Tools/AssetCooker and the loaders share it.
+class MipChain
+{
+public:
+	using uint32 = std::uint32_t;
+
+	enum Filter
+	{
+		// Averages the texels each one covers: exact 2x2 means for even sizes.
+		Box,
+		// Windowed sinc filters three texels wide in the smaller level: sharper than the
+		// box, with slight ringing at hard edges.
+		Kaiser,
+		Lanczos
+	};
+
+	struct Options
+	{
+		Options() :
+			Kernel(Box),
+			Wrap(false),
+			MipCount(0),
+			Parallel(true) {}
+
+		Filter Kernel;
+		// Sample across the edges as a tiling texture does, instead of clamping to them.
+		bool Wrap;
+		// Levels in the chain, top included; 0 for the full chain down to 1x1.
+		uint32 MipCount;
+		// Off when the caller already runs one texture per worker.
+		bool Parallel;
+	};
+
+	struct Stats
+	{
+		uint32 Levels = 0;
+		uint32 Slices = 0;
+		double Milliseconds = 0.0;
+	};
+
+	// 8-bit UNORM formats with one, two or four channels (sRGB included) and 32-bit floats.
+	static bool IsSupported(DXGI_FORMAT format);
+
+	// A 1D or 2D texture, array or cube map in a supported format with no mips: what the
+	// cooker and loaders give a chain to.
+	static bool NeedsMips(const DDSFile::Info& info);
+
+	static uint32 FullMipCount(uint32 width, uint32 height);
+
+	// Writes 'dds' to 'out' with its mips replaced by a chain filtered from the top level
+	// of each slice.  The top level is copied unchanged; volume textures are not supported.
+	static bool Generate(const void* dds, size_t size, std::vector<std::uint8_t>& out,
+		const Options& options = Options(), Stats* stats = nullptr, std::string* error = nullptr);
+
+	// The same chain computed the plain way, to check Generate() against: one thread, in
+	// doubles, with the 2D kernel evaluated for every texel pair and sRGB through pow().
+	// Hundreds of times slower.
+	static bool GenerateReference(const void* dds, size_t size, std::vector<std::uint8_t>& out,
+		const Options& options = Options(), std::string* error = nullptr);
+};
@@ -0,0 +1,325 @@
+#include "ModelLoader.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include "ParallelFor.h"
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	// Walks the text, remembering where it started so errors can name a line.
+	struct Cursor
+	{
+		const char* Begin;
+		const char* P;
+		const char* End;
+
+		void SkipSpace()
+		{
+			while (P < End && (*P == ' ' || *P == '\t' || *P == '\r' || *P == '\n'))
+				++P;
+		}
+
+		// Whitespace short of the end of the line.
+		void SkipBlanks()
+		{
+			while (P < End && (*P == ' ' || *P == '\t' || *P == '\r'))
+				++P;
+		}
+
+		// Moves past the next occurrence of c.
+		bool SkipPast(char c)
+		{
+			const char* found = static_cast<const char*>(memchr(P, c, End - P));
+			if (found == nullptr)
+				return false;
+			P = found + 1;
+			return true;
+		}
+
+		bool Keyword(const char* word)
+		{
+			SkipSpace();
+			size_t n = strlen(word);
+			if ((size_t)(End - P) < n || memcmp(P, word, n) != 0)
+				return false;
+			P += n;
+			return true;
+		}
+
+		template<typename T>
+		bool Number(T& value)
+		{
+			SkipSpace();
+			return NumberOnLine(value);
+		}
+
+		template<typename T>
+		bool NumberOnLine(T& value)
+		{
+			SkipBlanks();
+			auto result = std::from_chars(P, End, value);
+			if (result.ec != std::errc())
+				return false;
+			P = result.ptr;
+			return true;
+		}
+
+		size_t Line() const
+		{
+			return 1 + std::count(Begin, P, '\n');
+		}
+	};
+
+	bool Fail(ModelLoader::Stats& stats, const Cursor& cursor, const char* what)
+	{
+		stats.Error = std::string(what) + " on line " + std::to_string(cursor.Line());
+		return false;
+	}
+
+	double Since(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Lists shorter than this are parsed on the calling thread.
+	const size_t MinChunkBytes = 256 * 1024;
+
+	// Cuts [begin, end) into runs of whole lines, one per ParallelFor chunk.  cuts[i] and
+	// cuts[i + 1] bound chunk i; chunks may be empty.
+	std::vector<const char*> SplitLines(const char* begin, const char* end, bool parallel)
+	{
+		const size_t size = end - begin;
+		const size_t chunkCount = parallel ? std::max<size_t>(ParallelFor::ChunkCount(size, MinChunkBytes), 1) : 1;
+
+		std::vector<const char*> cuts(chunkCount + 1, end);
+		cuts[0] = begin;
+		for (size_t i = 1; i < chunkCount; ++i)
+		{
+			const char* p = std::max(begin + size * i / chunkCount, cuts[i - 1]);
+			const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+			cuts[i] = newline ? newline + 1 : end;
+		}
+		return cuts;
+	}
+
+	// Lines in [p, end) holding anything besides whitespace, i.e. records.
+	size_t CountRecords(const char* p, const char* end)
+	{
+		size_t count = 0;
+		while (p < end)
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+				++p;
+			if (p == end)
+				break;
+			if (*p != '\n')
+				++count;
+
+			const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+			if (newline == nullptr)
+				break;
+			p = newline + 1;
+		}
+		return count;
+	}
+
+	// A list's expected record count and the messages for its failures.
+	struct ListInfo
+	{
+		size_t Expected;
+		const char* Short;
+		const char* Long;
+		const char* Record;
+	};
+
+	// Parses the records of one list, 'Width' numbers each, concurrently.  Every chunk
+	// counts its records first; the prefix sum of those counts is where its records go,
+	// so store(record, values) writes straight into the caller's arrays.  store returns
+	// an error message or nullptr.  The error reported is the one nearest the start.
+	template<typename T, size_t Width, typename Store>
+	bool ParseList(const char* text, const char* begin, const char* end, const ListInfo& list,
+		bool parallel, ModelLoader::Stats& stats, Store store)
+	{
+		const std::vector<const char*> cuts = SplitLines(begin, end, parallel);
+		const size_t chunkCount = cuts.size() - 1;
+
+		std::vector<size_t> first(chunkCount + 1, 0);
+		ParallelFor::ForChunks(chunkCount, 1, [&](size_t, size_t c0, size_t c1)
+		{
+			for (size_t c = c0; c < c1; ++c)
+				first[c + 1] = CountRecords(cuts[c], cuts[c + 1]);
+		});
+		for (size_t c = 0; c < chunkCount; ++c)
+			first[c + 1] += first[c];
+
+		if (first[chunkCount] != list.Expected)
+		{
+			Cursor at = { text, end, end };
+			return Fail(stats, at, first[chunkCount] < list.Expected ? list.Short : list.Long);
+		}
+
+		std::vector<const char*> errorAt(chunkCount, nullptr);
+		std::vector<const char*> errorWhat(chunkCount, nullptr);
+		ParallelFor::ForChunks(chunkCount, 1, [&](size_t, size_t c0, size_t c1)
+		{
+			for (size_t c = c0; c < c1; ++c)
+			{
+				Cursor cursor = { text, cuts[c], cuts[c + 1] };
+				for (size_t r = first[c]; r < first[c + 1] && errorAt[c] == nullptr; ++r)
+				{
+					// One record per line, as the counts above assumed.
+					T values[Width];
+					cursor.SkipSpace();
+					for (size_t k = 0; k < Width; ++k)
+					{
+						if (!cursor.NumberOnLine(values[k]))
+						{
+							errorAt[c] = cursor.P;
+							errorWhat[c] = list.Record;
+							break;
+						}
+					}
+
+					cursor.SkipBlanks();
+					if (errorAt[c] == nullptr && cursor.P < cursor.End && *cursor.P != '\n')
+					{
+						errorAt[c] = cursor.P;
+						errorWhat[c] = list.Record;
+					}
+
+					if (errorAt[c] == nullptr)
+					{
+						errorWhat[c] = store(r, values);
+						if (errorWhat[c] != nullptr)
+							errorAt[c] = cursor.P;
+					}
+				}
+			}
+		});
+
+		for (size_t c = 0; c < chunkCount; ++c)
+		{
+			if (errorAt[c] != nullptr)
+			{
+				Cursor at = { text, errorAt[c], end };
+				return Fail(stats, at, errorWhat[c]);
+			}
+		}
+
+		stats.Chunks += chunkCount;
+		return true;
+	}
+}
+
+const size_t ModelLoader::NoAttribute;
+
+bool ModelLoader::ParseHeader(const char* text, size_t size, Header& header, Stats& stats)
+{
+	Cursor cursor = { text, text, text + size };
+
+	if (!cursor.Keyword("VertexCount:") || !cursor.Number(header.VertexCount))
+		return Fail(stats, cursor, "expected 'VertexCount: n'");
+	if (!cursor.Keyword("TriangleCount:") || !cursor.Number(header.TriangleCount))
+		return Fail(stats, cursor, "expected 'TriangleCount: n'");
+
+	// Indices are 32-bit.
+	if (header.VertexCount > 0xffffffffull || header.TriangleCount > 0xffffffffull / 3)
+		return Fail(stats, cursor, "counts too large");
+
+	return true;
+}
+
+bool ModelLoader::Parse(const char* text, size_t size, const Header& header,
+	void* vertices, const VertexLayout& layout, std::uint32_t* indices, Stats& stats, bool parallel)
+{
+	auto start = Clock::now();
+
+	// The header has no braces, so this also steps over it.  Numbers contain no braces
+	// either, so each list ends at the first '}' after its '{'.
+	Cursor cursor = { text, text, text + size };
+	if (!cursor.SkipPast('{'))
+		return Fail(stats, cursor, "missing vertex list");
+	const char* vertexBegin = cursor.P;
+	if (!cursor.SkipPast('}'))
+		return Fail(stats, cursor, "unterminated vertex list");
+	const char* vertexEnd = cursor.P - 1;
+
+	if (!cursor.SkipPast('{'))
+		return Fail(stats, cursor, "missing triangle list");
+	const char* triangleBegin = cursor.P;
+	if (!cursor.SkipPast('}'))
+		return Fail(stats, cursor, "unterminated triangle list");
+	const char* triangleEnd = cursor.P - 1;
+
+	stats.Chunks = 0;
+
+	std::uint8_t* out = static_cast<std::uint8_t*>(vertices);
+	const ListInfo vertexList = { header.VertexCount, "expected a vertex", "vertex list longer than VertexCount",
+		"expected 6 numbers per vertex" };
+	bool ok = ParseList<float, 6>(text, vertexBegin, vertexEnd, vertexList, parallel, stats,
+		[&](size_t i, const float* v) -> const char*
+	{
+		std::uint8_t* vertex = out + i * layout.Stride;
+		memcpy(vertex, v, 3 * sizeof(float));
+		if (layout.NormalOffset != NoAttribute)
+			memcpy(vertex + layout.NormalOffset, v + 3, 3 * sizeof(float));
+		return nullptr;
+	});
+	if (!ok)
+		return false;
+
+	const std::uint32_t vertexCount = (std::uint32_t)header.VertexCount;
+	const ListInfo triangleList = { header.TriangleCount, "expected a vertex index",
+		"triangle list longer than TriangleCount", "expected 3 indices per triangle" };
+	ok = ParseList<std::uint32_t, 3>(text, triangleBegin, triangleEnd, triangleList, parallel, stats,
+		[&](size_t i, const std::uint32_t* t) -> const char*
+	{
+		if (t[0] >= vertexCount || t[1] >= vertexCount || t[2] >= vertexCount)
+			return "vertex index out of range";
+		memcpy(indices + 3 * i, t, 3 * sizeof(std::uint32_t));
+		return nullptr;
+	});
+	if (!ok)
+		return false;
+
+	stats.VertexCount = header.VertexCount;
+	stats.TriangleCount = header.TriangleCount;
+	stats.Bytes = size;
+	stats.Milliseconds += Since(start);
+	return true;
+}
+
+bool ModelLoader::Open(const std::wstring& path, MappedFile& file, Header& header, Stats& stats)
+{
+	auto start = Clock::now();
+
+	if (!file.Open(path))
+	{
+		stats.Error = "cannot open the file";
+		return false;
+	}
+
+	bool ok = ParseHeader(file.Data(), file.Size(), header, stats);
+	stats.Milliseconds += Since(start);
+	return ok;
+}
+
+bool ModelLoader::Load(const std::wstring& path, GeometryGenerator::MeshData& mesh, Stats* stats)
+{
+	VertexLayout layout;
+	layout.Stride = sizeof(GeometryGenerator::Vertex);
+	layout.NormalOffset = offsetof(GeometryGenerator::Vertex, Normal);
+
+	if (!Load(path, mesh.Vertices, mesh.Indices32, layout, stats))
+		return false;
+
+	for (auto& v : mesh.Vertices)
+	{
+		v.TangentU = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		v.TexC = DirectX::XMFLOAT2(0.0f, 0.0f);
+	}
+	return true;
+}
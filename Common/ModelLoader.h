@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "GeometryGenerator.h"
+#include "MappedFile.h"
+
+// Loads the text models in Models/ (skull.txt, car.txt):
+//
+//	VertexCount: n
+//	TriangleCount: m
+//	VertexList (pos, normal)
+//	{
+//		px py pz nx ny nz      (n lines)
+//	}
+//	TriangleList
+//	{
+//		i0 i1 i2               (m lines)
+//	}
+//
+// The file is memory-mapped and parsed with std::from_chars, which neither consults the
+// locale nor allocates, straight into arrays sized from the header.  Large lists are cut
+// at line breaks and the pieces parsed on ParallelFor workers: a count of the records in
+// each piece gives the slot its first record goes to.
+class ModelLoader
+{
+public:
+	static const size_t NoAttribute = ~(size_t)0;
+
+	// The position is an XMFLOAT3 at offset 0; the normal (XMFLOAT3) is optional.
+	struct VertexLayout
+	{
+		size_t Stride = 0;
+		size_t NormalOffset = NoAttribute;
+	};
+
+	struct Header
+	{
+		size_t VertexCount = 0;
+		size_t TriangleCount = 0;
+	};
+
+	struct Stats
+	{
+		size_t VertexCount = 0;
+		size_t TriangleCount = 0;
+		size_t Bytes = 0;
+		// Pieces the two lists were parsed in, 2 for a single-threaded parse.
+		size_t Chunks = 0;
+		double Milliseconds = 0.0;
+
+		// Empty on success, otherwise what went wrong and on which line.
+		std::string Error;
+	};
+
+	// Reads the two counts at the top of the text.
+	static bool ParseHeader(const char* text, size_t size, Header& header, Stats& stats);
+
+	// Parses the lists into 'vertices' (header.VertexCount of them, 'layout.Stride' bytes
+	// apart) and 'indices' (3 * header.TriangleCount), given the header ParseHeader()
+	// read.  Fails on malformed numbers, on lists that do not match the header's counts,
+	// and on indices past the vertex count.  Each vertex and triangle must sit on its own
+	// line.  'parallel' false keeps the whole parse on the calling thread.
+	static bool Parse(const char* text, size_t size, const Header& header,
+		void* vertices, const VertexLayout& layout, std::uint32_t* indices, Stats& stats, bool parallel = true);
+
+	// Fills Position and Normal and zeroes TangentU and TexC.
+	static bool Load(const std::wstring& path, GeometryGenerator::MeshData& mesh, Stats* stats = nullptr);
+
+	// Attributes the layout does not mention are left as the vertex constructor sets them.
+	template<typename VertexT>
+	static bool Load(const std::wstring& path, std::vector<VertexT>& vertices, std::vector<std::uint32_t>& indices,
+		const VertexLayout& layout, Stats* stats = nullptr)
+	{
+		Stats local;
+		Stats& s = stats ? *stats : local;
+		s = Stats();
+
+		MappedFile file;
+		Header header;
+		if (!Open(path, file, header, s))
+			return false;
+
+		vertices.resize(header.VertexCount);
+		indices.resize(header.TriangleCount * 3);
+		return Parse(file.Data(), file.Size(), header, vertices.data(), layout, indices.data(), s);
+	}
+
+private:
+	static bool Open(const std::wstring& path, MappedFile& file, Header& header, Stats& stats);
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Splits an index range into chunks and runs them on short-lived worker threads plus the
+// calling thread.  Meant for load-time mesh and texture processing, not per-frame work.
+class ParallelFor
+{
+public:
+	static unsigned WorkerCount()
+	{
+		unsigned n = std::thread::hardware_concurrency();
+		return n == 0 ? 1 : n;
+	}
+
+	// Number of chunks ForChunks() will use, e.g. to size per-chunk partial results.
+	static size_t ChunkCount(size_t count, size_t minChunkSize)
+	{
+		if (count == 0)
+			return 0;
+
+		minChunkSize = std::max<size_t>(minChunkSize, 1);
+		size_t maxChunks = (count + minChunkSize - 1) / minChunkSize;
+
+		// A few chunks per worker keeps threads busy when chunk costs vary.
+		return std::min<size_t>(maxChunks, (size_t)WorkerCount() * 4);
+	}
+
+	// Calls fn(chunkIndex, first, last) for the chunks of [0, count).  Chunks are contiguous,
+	// ordered by chunkIndex and cover the range exactly.  The first exception thrown by fn
+	// is rethrown on the calling thread once every worker has finished.
+	template<typename Fn>
+	static void ForChunks(size_t count, size_t minChunkSize, Fn fn)
+	{
+		const size_t chunkCount = ChunkCount(count, minChunkSize);
+		if (chunkCount == 0)
+			return;
+
+		if (chunkCount == 1)
+		{
+			fn((size_t)0, (size_t)0, count);
+			return;
+		}
+
+		std::atomic<size_t> nextChunk(0);
+		std::exception_ptr error;
+		std::mutex errorMutex;
+
+		auto worker = [&]()
+		{
+			for (;;)
+			{
+				size_t chunk = nextChunk.fetch_add(1);
+				if (chunk >= chunkCount)
+					return;
+
+				try
+				{
+					fn(chunk, count * chunk / chunkCount, count * (chunk + 1) / chunkCount);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(errorMutex);
+					if (!error)
+						error = std::current_exception();
+				}
+			}
+		};
+
+		const size_t threadCount = std::min<size_t>(chunkCount, WorkerCount()) - 1;
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; ++i)
+			threads.emplace_back(worker);
+
+		worker();
+
+		for (auto& t : threads)
+			t.join();
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	// Calls fn(i) for every i in [0, count).
+	template<typename Fn>
+	static void For(size_t count, size_t minChunkSize, Fn fn)
+	{
+		ForChunks(count, minChunkSize, [&](size_t, size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; ++i)
+				fn(i);
+		});
+	}
+};
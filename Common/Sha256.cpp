@@ -0,0 +1,148 @@
+#include "Sha256.h"
+#include <cstring>
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	const uint32 RoundConstants[64] =
+	{
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+	};
+
+	uint32 Rotr(uint32 x, int n)
+	{
+		return (x >> n) | (x << (32 - n));
+	}
+}
+
+void Sha256::Reset()
+{
+	static const uint32 initial[8] =
+	{
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+	memcpy(mState, initial, sizeof(mState));
+	mLength = 0;
+	mBuffered = 0;
+}
+
+void Sha256::Compress(const std::uint8_t* block)
+{
+	uint32 w[64];
+	for (int i = 0; i < 16; ++i)
+	{
+		w[i] = (uint32)block[4 * i] << 24 | (uint32)block[4 * i + 1] << 16 |
+			(uint32)block[4 * i + 2] << 8 | (uint32)block[4 * i + 3];
+	}
+	for (int i = 16; i < 64; ++i)
+	{
+		const uint32 s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		const uint32 s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	uint32 a = mState[0], b = mState[1], c = mState[2], d = mState[3];
+	uint32 e = mState[4], f = mState[5], g = mState[6], h = mState[7];
+	for (int i = 0; i < 64; ++i)
+	{
+		const uint32 t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + ((e & f) ^ (~e & g)) + RoundConstants[i] + w[i];
+		const uint32 t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	mState[0] += a;
+	mState[1] += b;
+	mState[2] += c;
+	mState[3] += d;
+	mState[4] += e;
+	mState[5] += f;
+	mState[6] += g;
+	mState[7] += h;
+}
+
+void Sha256::Update(const void* data, size_t size)
+{
+	const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+	mLength += size;
+
+	if (mBuffered > 0)
+	{
+		const size_t n = size < 64 - mBuffered ? size : 64 - mBuffered;
+		memcpy(mBuffer + mBuffered, p, n);
+		mBuffered += n;
+		p += n;
+		size -= n;
+		if (mBuffered < 64)
+			return;
+		Compress(mBuffer);
+		mBuffered = 0;
+	}
+
+	for (; size >= 64; p += 64, size -= 64)
+		Compress(p);
+
+	memcpy(mBuffer, p, size);
+	mBuffered = size;
+}
+
+Sha256::Digest Sha256::Final()
+{
+	const std::uint64_t bits = mLength * 8;
+
+	// A 1 bit, zeros up to 56 bytes into the block, then the length in bits, big-endian.
+	const std::uint8_t one = 0x80;
+	Update(&one, 1);
+	const std::uint8_t zeros[64] = {};
+	Update(zeros, (mBuffered <= 56 ? 56 : 120) - mBuffered);
+
+	std::uint8_t length[8];
+	for (int i = 0; i < 8; ++i)
+		length[i] = (std::uint8_t)(bits >> (56 - 8 * i));
+	Update(length, 8);
+
+	Digest digest;
+	for (int i = 0; i < 8; ++i)
+	{
+		digest[4 * i] = (std::uint8_t)(mState[i] >> 24);
+		digest[4 * i + 1] = (std::uint8_t)(mState[i] >> 16);
+		digest[4 * i + 2] = (std::uint8_t)(mState[i] >> 8);
+		digest[4 * i + 3] = (std::uint8_t)mState[i];
+	}
+
+	Reset();
+	return digest;
+}
+
+Sha256::Digest Sha256::Hash(const void* data, size_t size)
+{
+	Sha256 sha;
+	sha.Update(data, size);
+	return sha.Final();
+}
+
+std::string Sha256::ToHex(const Digest& digest)
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string hex(2 * digest.size(), '0');
+	for (size_t i = 0; i < digest.size(); ++i)
+	{
+		hex[2 * i] = digits[digest[i] >> 4];
+		hex[2 * i + 1] = digits[digest[i] & 15];
+	}
+	return hex;
+}
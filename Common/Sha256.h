@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// SHA-256 (FIPS 180-4), for keys that must not collide by accident: ContentCache files
+// cooked outputs under the digest of their inputs.  Hash.h's FNV-1a is faster and is the
+// one to use for in-memory lookup tables.
+class Sha256
+{
+public:
+	using Digest = std::array<std::uint8_t, 32>;
+
+	Sha256() { Reset(); }
+
+	void Reset();
+	void Update(const void* data, size_t size);
+	void Update(const std::string& text) { Update(text.data(), text.size()); }
+
+	// The digest of everything passed to Update() since the last Reset(); resets.
+	Digest Final();
+
+	static Digest Hash(const void* data, size_t size);
+	// 64 lower-case hex digits.
+	static std::string ToHex(const Digest& digest);
+
+private:
+	void Compress(const std::uint8_t* block);
+
+	std::uint32_t mState[8];
+	std::uint64_t mLength;
+	std::uint8_t mBuffer[64];
+	size_t mBuffered;
+};
@@ -0,0 +1,308 @@
+#include "TangentSpace.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	struct Vec3
+	{
+		float x, y, z;
+	};
+
+	inline Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	inline Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+	inline float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline Vec3 Cross(const Vec3& a, const Vec3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	inline Vec3 Normalize(const Vec3& v, float& length)
+	{
+		length = std::sqrt(Dot(v, v));
+		return length > 0.0f ? v * (1.0f / length) : v;
+	}
+
+	// Angle between two edges leaving a corner.
+	inline float Angle(const Vec3& a, const Vec3& b)
+	{
+		float la = Dot(a, a);
+		float lb = Dot(b, b);
+		if (la <= 0.0f || lb <= 0.0f)
+			return 0.0f;
+		float c = Dot(a, b) / std::sqrt(la * lb);
+		return std::acos(std::min(1.0f, std::max(-1.0f, c)));
+	}
+
+	// Some unit vector perpendicular to n, for vertices that get no tangent.
+	inline Vec3 Perpendicular(const Vec3& n)
+	{
+		Vec3 axis = std::fabs(n.x) < 0.9f ? Vec3{ 1.0f, 0.0f, 0.0f } : Vec3{ 0.0f, 1.0f, 0.0f };
+		float length;
+		Vec3 t = Normalize(axis - n * Dot(n, axis), length);
+		return length > 0.0f ? t : Vec3{ 1.0f, 0.0f, 0.0f };
+	}
+
+	struct Mesh
+	{
+		std::uint8_t* Base;
+		size_t Stride;
+
+		template<typename T>
+		T Read(uint32 v, size_t offset) const
+		{
+			T value;
+			memcpy(&value, Base + v * Stride + offset, sizeof(T));
+			return value;
+		}
+
+		template<typename T>
+		void Write(uint32 v, size_t offset, const T& value) const
+		{
+			memcpy(Base + v * Stride + offset, &value, sizeof(T));
+		}
+	};
+
+	// The private sums of one chunk of triangles, covering vertices [First, First + Count).
+	struct Partial
+	{
+		uint32 First = 0;
+		uint32 Count = 0;
+		std::vector<float> Sums;
+	};
+
+	// Adds corner(t, sums) for every triangle t, where sums[k] receives the Width floats
+	// corner k contributes, into out[v * Width].  Returns the number of triangles corner()
+	// reported as skipped.
+	//
+	// There is one chunk per worker thread.  A chunk's triangles usually reference a
+	// narrow band of the vertex array, so its partial array only spans the indices it
+	// touches; in the worst case each is as large as the output.
+	template<int Width, typename CornerFn>
+	size_t Accumulate(size_t vertexCount, const uint32* indices, size_t triangleCount, float* out, CornerFn corner)
+	{
+		const size_t workers = ParallelFor::WorkerCount();
+		const size_t minChunk = std::max<size_t>(4096, (triangleCount + workers - 1) / workers);
+
+		std::vector<Partial> partials(ParallelFor::ChunkCount(triangleCount, minChunk));
+		std::vector<size_t> skipped(partials.size(), 0);
+
+		ParallelFor::ForChunks(triangleCount, minChunk, [&](size_t chunk, size_t first, size_t last)
+		{
+			uint32 lo = 0xffffffff;
+			uint32 hi = 0;
+			for (size_t i = first * 3; i < last * 3; ++i)
+			{
+				lo = std::min(lo, indices[i]);
+				hi = std::max(hi, indices[i]);
+			}
+
+			Partial& partial = partials[chunk];
+			if (lo > hi)
+				return;
+			partial.First = lo;
+			partial.Count = hi - lo + 1;
+			partial.Sums.assign((size_t)partial.Count * Width, 0.0f);
+
+			float sums[3][Width];
+			for (size_t t = first; t < last; ++t)
+			{
+				if (!corner(t, sums))
+				{
+					++skipped[chunk];
+					continue;
+				}
+
+				for (int k = 0; k < 3; ++k)
+				{
+					float* dst = &partial.Sums[(size_t)(indices[t * 3 + k] - lo) * Width];
+					for (int c = 0; c < Width; ++c)
+						dst[c] += sums[k][c];
+				}
+			}
+		});
+
+		// Chunks are added in a fixed order, so the sums are deterministic.
+		ParallelFor::ForChunks(vertexCount, 4096, [&](size_t, size_t first, size_t last)
+		{
+			std::fill(out + first * Width, out + last * Width, 0.0f);
+			for (const Partial& partial : partials)
+			{
+				size_t begin = std::max<size_t>(first, partial.First);
+				size_t end = std::min<size_t>(last, (size_t)partial.First + partial.Count);
+				for (size_t v = begin; v < end; ++v)
+				{
+					const float* src = &partial.Sums[(v - partial.First) * Width];
+					for (int c = 0; c < Width; ++c)
+						out[v * Width + c] += src[c];
+				}
+			}
+		});
+
+		size_t total = 0;
+		for (size_t s : skipped)
+			total += s;
+		return total;
+	}
+}
+
+const size_t TangentSpace::NoAttribute;
+
+TangentSpace::Stats TangentSpace::Generate(void* vertices, size_t vertexCount, const VertexLayout& layout,
+	const std::uint32_t* indices, size_t indexCount, const Options& options)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	Stats stats;
+	stats.VertexCount = vertexCount;
+	stats.TriangleCount = indexCount / 3;
+
+	const bool normals = options.ComputeNormals && layout.NormalOffset != NoAttribute;
+	const bool tangents = options.ComputeTangents && layout.NormalOffset != NoAttribute &&
+		layout.TangentOffset != NoAttribute && layout.TexCOffset != NoAttribute;
+
+	if (vertexCount == 0 || stats.TriangleCount == 0 || (!normals && !tangents))
+		return stats;
+
+	Mesh mesh = { static_cast<std::uint8_t*>(vertices), layout.Stride };
+	auto position = [&](uint32 v) { return mesh.Read<Vec3>(v, 0); };
+
+	std::vector<float> sums;
+
+	if (normals)
+	{
+		sums.resize(vertexCount * 3);
+		const Weighting weighting = options.NormalWeighting;
+		stats.DegenerateTriangles = Accumulate<3>(vertexCount, indices, stats.TriangleCount, sums.data(),
+			[&](size_t t, float out[3][3])
+		{
+			const uint32* tri = indices + t * 3;
+			Vec3 p[3] = { position(tri[0]), position(tri[1]), position(tri[2]) };
+
+			// Twice the area times the unit normal.
+			Vec3 n = Cross(p[1] - p[0], p[2] - p[0]);
+			float length;
+			Vec3 unit = Normalize(n, length);
+			if (length <= 0.0f)
+				return false;
+
+			for (int k = 0; k < 3; ++k)
+			{
+				Vec3 w = n;
+				if (weighting != Weighting::Area)
+				{
+					float angle = Angle(p[(k + 1) % 3] - p[k], p[(k + 2) % 3] - p[k]);
+					w = (weighting == Weighting::Angle ? unit : n) * angle;
+				}
+				out[k][0] = w.x;
+				out[k][1] = w.y;
+				out[k][2] = w.z;
+			}
+			return true;
+		});
+
+		ParallelFor::For(vertexCount, 4096, [&](size_t v)
+		{
+			Vec3 sum = { sums[v * 3 + 0], sums[v * 3 + 1], sums[v * 3 + 2] };
+			float length;
+			Vec3 n = Normalize(sum, length);
+			if (length > 0.0f)
+				mesh.Write((uint32)v, layout.NormalOffset, n);
+		});
+	}
+
+	if (tangents)
+	{
+		// dP/du in the first three floats, dP/dv in the last three.
+		sums.resize(vertexCount * 6);
+		stats.DegenerateTexCoords = Accumulate<6>(vertexCount, indices, stats.TriangleCount, sums.data(),
+			[&](size_t t, float out[3][6])
+		{
+			const uint32* tri = indices + t * 3;
+			Vec3 p[3] = { position(tri[0]), position(tri[1]), position(tri[2]) };
+			DirectX::XMFLOAT2 uv[3] = {
+				mesh.Read<DirectX::XMFLOAT2>(tri[0], layout.TexCOffset),
+				mesh.Read<DirectX::XMFLOAT2>(tri[1], layout.TexCOffset),
+				mesh.Read<DirectX::XMFLOAT2>(tri[2], layout.TexCOffset) };
+
+			Vec3 e1 = p[1] - p[0];
+			Vec3 e2 = p[2] - p[0];
+			float s1 = uv[1].x - uv[0].x, t1 = uv[1].y - uv[0].y;
+			float s2 = uv[2].x - uv[0].x, t2 = uv[2].y - uv[0].y;
+
+			float det = s1 * t2 - s2 * t1;
+			if (std::fabs(det) < 1e-12f)
+				return false;
+
+			float r = 1.0f / det;
+			Vec3 dPdu = (e1 * t2 - e2 * t1) * r;
+			Vec3 dPdv = (e2 * s1 - e1 * s2) * r;
+
+			for (int k = 0; k < 3; ++k)
+			{
+				Vec3 n = mesh.Read<Vec3>(tri[k], layout.NormalOffset);
+				float length;
+
+				Vec3 tangent = Normalize(dPdu - n * Dot(n, dPdu), length);
+				Vec3 bitangent = Normalize(dPdv - n * Dot(n, dPdv), length);
+
+				// The corner angle as seen in the tangent plane.
+				Vec3 a = p[(k + 1) % 3] - p[k];
+				Vec3 b = p[(k + 2) % 3] - p[k];
+				float angle = Angle(a - n * Dot(n, a), b - n * Dot(n, b));
+
+				tangent = tangent * angle;
+				bitangent = bitangent * angle;
+				out[k][0] = tangent.x;
+				out[k][1] = tangent.y;
+				out[k][2] = tangent.z;
+				out[k][3] = bitangent.x;
+				out[k][4] = bitangent.y;
+				out[k][5] = bitangent.z;
+			}
+			return true;
+		});
+
+		ParallelFor::For(vertexCount, 4096, [&](size_t v)
+		{
+			Vec3 n = mesh.Read<Vec3>((uint32)v, layout.NormalOffset);
+			Vec3 tangent = { sums[v * 6 + 0], sums[v * 6 + 1], sums[v * 6 + 2] };
+			Vec3 bitangent = { sums[v * 6 + 3], sums[v * 6 + 4], sums[v * 6 + 5] };
+
+			// The sums drift out of the tangent plane as the normal is averaged; project
+			// again before normalizing.
+			float length;
+			tangent = Normalize(tangent - n * Dot(n, tangent), length);
+			if (length <= 0.0f)
+				tangent = Perpendicular(n);
+
+			mesh.Write((uint32)v, layout.TangentOffset, tangent);
+			if (layout.BitangentSignOffset != NoAttribute)
+			{
+				float sign = Dot(Cross(n, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+				mesh.Write((uint32)v, layout.BitangentSignOffset, sign);
+			}
+		});
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	stats.Milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+	return stats;
+}
+
+TangentSpace::Stats TangentSpace::Generate(GeometryGenerator::MeshData& mesh, const Options& options)
+{
+	VertexLayout layout;
+	layout.Stride = sizeof(GeometryGenerator::Vertex);
+	layout.NormalOffset = offsetof(GeometryGenerator::Vertex, Normal);
+	layout.TangentOffset = offsetof(GeometryGenerator::Vertex, TangentU);
+	layout.TexCOffset = offsetof(GeometryGenerator::Vertex, TexC);
+	return Generate(mesh.Vertices.data(), mesh.Vertices.size(), layout,
+		mesh.Indices32.data(), mesh.Indices32.size(), options);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "GeometryGenerator.h"
+
+// Recomputes per-vertex normals and tangents from the triangles.  Every triangle adds a
+// weighted contribution to its three corners; the triangles are split across threads that
+// each sum into a private array over the vertex range their triangles touch, and a second
+// parallel pass over the vertices adds those partial sums together.  No atomics are
+// involved and the result does not depend on thread timing.
+//
+// Tangents follow MikkTSpace: each corner's dP/du and dP/dv are projected onto the plane
+// of the vertex normal and weighted by the corner angle before summing, and the handedness
+// of the resulting frame is returned as a sign.  Vertices are not split where the frames
+// of neighbouring triangles disagree (mirrored UV islands); such seams must already be
+// separate vertices, as they are after an exporter's UV split.
+class TangentSpace
+{
+public:
+	static const size_t NoAttribute = ~(size_t)0;
+
+	enum class Weighting
+	{
+		// By triangle area: large triangles dominate, the classic cross product sum.
+		Area,
+		// By the corner angle: independent of how the surface is triangulated.
+		Angle,
+		// Both, so slivers with a wide corner do not outvote large neighbours.
+		AreaAndAngle
+	};
+
+	// The position is an XMFLOAT3 at offset 0.  The normal and tangent are XMFLOAT3s, the
+	// texture coordinates an XMFLOAT2 and the bitangent sign a float; each is optional,
+	// but tangents need the normal and texture coordinates.
+	struct VertexLayout
+	{
+		size_t Stride = 0;
+		size_t NormalOffset = NoAttribute;
+		size_t TangentOffset = NoAttribute;
+		size_t BitangentSignOffset = NoAttribute;
+		size_t TexCOffset = NoAttribute;
+	};
+
+	struct Options
+	{
+		Options() :
+			NormalWeighting(Weighting::AreaAndAngle),
+			ComputeNormals(true),
+			ComputeTangents(true) {}
+
+		Weighting NormalWeighting;
+
+		// With ComputeNormals off the existing normals are kept and the tangents are built
+		// around them.
+		bool ComputeNormals;
+		bool ComputeTangents;
+	};
+
+	struct Stats
+	{
+		size_t VertexCount = 0;
+		size_t TriangleCount = 0;
+
+		// Triangles with no area, which add nothing to their corners.
+		size_t DegenerateTriangles = 0;
+		// Triangles whose texture coordinates do not span an area, which add no tangent.
+		size_t DegenerateTexCoords = 0;
+
+		double Milliseconds = 0.0;
+	};
+
+	// Vertices no triangle contributes to keep their normal; their tangent is set to some
+	// direction perpendicular to it.
+	static Stats Generate(void* vertices, size_t vertexCount, const VertexLayout& layout,
+		const std::uint32_t* indices, size_t indexCount, const Options& options = Options());
+
+	// Fills Normal and TangentU.  MeshData has nowhere to keep the bitangent sign, which is
+	// fine for the shaders here that rebuild the bitangent as cross(N, T).
+	static Stats Generate(GeometryGenerator::MeshData& mesh, const Options& options = Options());
+};
@@ -0,0 +1,110 @@
+#include "TextureBatch.h"
+#include <algorithm>
+#include <chrono>
+#include "MappedFile.h"
+#include "MipChain.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+}
+
+size_t TextureBatch::Add(const std::wstring& path, size_t maxSize, bool generateMips)
+{
+	Item item;
+	item.Path = path;
+	item.MaxSize = maxSize;
+	item.GenerateMips = generateMips;
+	mItems.push_back(std::move(item));
+	return mItems.size() - 1;
+}
+
+size_t TextureBatch::Add(const void* data, size_t size, const std::wstring& name, size_t maxSize,
+	bool generateMips)
+{
+	Item item;
+	item.Path = name;
+	item.Data = data;
+	item.Size = size;
+	item.MaxSize = maxSize;
+	item.GenerateMips = generateMips;
+	mItems.push_back(std::move(item));
+	return mItems.size() - 1;
+}
+
+bool TextureBatch::Load(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, std::string* error)
+{
+	mStats = Stats();
+
+	// Each file is one chunk: they differ in size, and a few large ones should not hold up
+	// a chunk of small ones behind them.
+	auto start = Clock::now();
+	ParallelFor::For(mItems.size(), 1, [&](size_t i)
+	{
+		mItems[i].Ok = Prepare(device, mItems[i]);
+	});
+	mStats.PrepareMilliseconds = MillisecondsSince(start);
+
+	for (const Item& item : mItems)
+	{
+		if (!item.Ok)
+		{
+			if (error != nullptr)
+				*error = std::string(item.Path.begin(), item.Path.end()) + ": " + item.Error;
+			return false;
+		}
+	}
+
+	start = Clock::now();
+	for (const Item& item : mItems)
+	{
+		item.Upload.Record(cmdList);
+		mStats.FileBytes += item.Upload.GetStats().FileBytes;
+		mStats.UploadBytes += item.Upload.GetStats().UploadBytes;
+	}
+	mStats.Textures = mItems.size();
+	mStats.RecordMilliseconds = MillisecondsSince(start);
+	return true;
+}
+
+bool TextureBatch::Prepare(ID3D12Device* device, Item& item)
+{
+	if (item.Data == nullptr && !item.GenerateMips)
+		return item.Upload.Prepare(device, item.Path, item.MaxSize, &item.Error);
+
+	MappedFile file;
+	const void* data = item.Data;
+	size_t size = item.Size;
+	if (data == nullptr)
+	{
+		if (!file.Open(item.Path))
+		{
+			item.Error = "cannot open the file";
+			return false;
+		}
+		data = file.Data();
+		size = file.Size();
+	}
+
+	// The chain is only held until its rows are in the upload heap.  Each texture already
+	// has a worker of its own, so MipChain runs on this one.
+	DDSFile::Info info;
+	std::vector<std::uint8_t> chain;
+	if (item.GenerateMips && DDSFile::Parse(data, std::min(size, DDSFile::MaxHeaderBytes), size, info) &&
+		MipChain::NeedsMips(info))
+	{
+		MipChain::Options options;
+		options.Parallel = false;
+		if (!MipChain::Generate(data, size, chain, options, nullptr, &item.Error))
+			return false;
+		data = chain.data();
+		size = chain.size();
+	}
+	return item.Upload.Prepare(device, data, size, item.MaxSize, &item.Error);
+}
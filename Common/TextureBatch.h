@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "DDSUpload.h"
+
+// Loads many DDS textures together.  ParallelFor workers map, parse and copy each file
+// into its own upload heap (see DDSUpload); only recording the copies, which needs the
+// command list, is left to the calling thread.  Loading the files one after another
+// leaves every core but one idle while the upload heaps are filled.
+class TextureBatch
+{
+public:
+	using uint64 = std::uint64_t;
+
+	struct Stats
+	{
+		size_t Textures = 0;
+		uint64 FileBytes = 0;
+		uint64 UploadBytes = 0;
+		// Wall time of the parallel part, and of recording the copies.
+		double PrepareMilliseconds = 0.0;
+		double RecordMilliseconds = 0.0;
+	};
+
+	// Returns the texture's index, for Get() after Load().  With 'generateMips', a texture
+	// that has no mips and is in a format MipChain filters gets a box-filtered chain on its
+	// worker before the upload; any other loads as it is.
+	size_t Add(const std::wstring& path, size_t maxSize = 0, bool generateMips = false);
+	// A DDS already in memory, such as a pack entry; it must stay valid until Load()
+	// returns.  'name' is only used in errors.
+	size_t Add(const void* data, size_t size, const std::wstring& name, size_t maxSize = 0,
+		bool generateMips = false);
+
+	// Prepares every texture added so far and records their copies on 'cmdList', in the
+	// order they were added.  On failure nothing is recorded and 'error' names the first
+	// file that failed.
+	bool Load(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, std::string* error = nullptr);
+
+	size_t Count() const { return mItems.size(); }
+	const DDSUpload& Get(size_t index) const { return mItems[index].Upload; }
+	const Stats& GetStats() const { return mStats; }
+
+private:
+	struct Item
+	{
+		std::wstring Path;
+		const void* Data = nullptr;
+		size_t Size = 0;
+		size_t MaxSize = 0;
+		bool GenerateMips = false;
+		DDSUpload Upload;
+		std::string Error;
+		bool Ok = false;
+	};
+
+	static bool Prepare(ID3D12Device* device, Item& item);
+
+	std::vector<Item> mItems;
+	Stats mStats;
+};
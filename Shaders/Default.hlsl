@@ -76,6 +76,24 @@ struct VertexOut
     float2 TexC : TEXCOORD;
 };
 
+struct PositionOut
+{
+    float4 PosH : SV_POSITION;
+    float3 PosW : POSITIONT;
+};
+
+// Reads only the packed position stream, for depth, stencil and flat-colored passes.
+PositionOut PositionOnlyVS(float3 PosL : POSITION)
+{
+    PositionOut vout;
+    
+    float4 posW = mul(float4(PosL, 1.0f), gWorld);
+    vout.PosW = posW.xyz;
+    vout.PosH = mul(posW, gViewProj);
+    
+    return vout;
+}
+
 VertexOut VS(VertexIn vin)
 {
     VertexOut vout = (VertexOut)0.0f;
@@ -123,3 +141,17 @@ float4 PS(VertexOut pin) : SV_Target
     
     return float4(destColor, diffuseAlbedo.a);
 }
+
+// Unlit material color, e.g. for planar shadows.
+float4 FlatPS(PositionOut pin) : SV_Target
+{
+    float4 color = gDiffuseAlbedo;
+    
+#ifdef FOG
+    float distToEye = length(gEyePosW - pin.PosW);
+    float fogAmount = saturate((distToEye - gFogStart) / gFogRange);
+    color.rgb = lerp(color.rgb, gFogColor.rgb, fogAmount);
+#endif
+    
+    return color;
+}
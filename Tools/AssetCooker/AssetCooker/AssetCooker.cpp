@@ -0,0 +1,799 @@
+// Offline asset cooker: converts the loose assets the samples open at startup into one
+// AssetPack.  Text, OBJ and PLY models become MeshFile images (welded, as StencilDemo
+// does), DDS files are validated and stored whole, and anything else named on the command
+// line is stored as raw bytes.  HLSL files are stored with their #includes inlined.  The
+// samples map the pack and fall back to loose files when it is absent.
+//
+//	AssetCooker [--lz4] [--bench] [--tangents] [--no-weld] [--list] [--full]
+//	            [--cache <dir> [--cache-mb <n>]] [--flipbook <pattern>]...
+//	            [--mips <box|kaiser|lanczos>] [--bc <bc1|bc3|bc4|bc5|bc7> [--bc-fast]]
+//	            <root> <output.lpak> [asset ...]
+//
+// Asset paths are relative to <root> and become the entry names; with none given, every
+// .txt, .obj and .ply under Models/, .dds under Textures/ and .hlsl under Shaders/ is
+// cooked.  Cooks are incremental: <output.lpak>.deps records what each entry was cooked
+// from, including shader include chains, and only entries whose sources or settings
+// changed are cooked again, in parallel; the rest are copied from the previous pack.
+// --full ignores the previous pack.  --lz4 stores entries as LZ4
+// blocks where that saves space, and --bench then times reading them back against copying
+// the same bytes uncompressed.  --cache <dir> keeps cooked models, and textures given mips
+// or blocks, in a ContentCache keyed by their source bytes and the settings that shaped
+// them, so assets that have not changed are not cooked again, on this machine or any other
+// sharing the directory; --cache-mb caps it (1024 by default).  --flipbook joins a numbered
+// DDS sequence such as Textures/BoltAnim/Bolt%03d.dds, counted from 1, into one texture
+// array stored as Textures/BoltAnim/Bolt.dds (see Flipbook); its frames are then not
+// packed on their own.  --mips gives textures without mips, in a format MipChain filters,
+// a full chain made with the named filter.  --bc then block-compresses textures in 8-bit
+// RGBA, BGRA, R or RG formats whose sizes are multiples of 4 (see BlockCompression), in its
+// high quality mode unless --bc-fast is given.  Builds on Windows from the project, or on
+// Linux with
+//
+//	g++ -std=c++17 -O2 -pthread -I<DirectXMath> -I<dxgiformat.h> -ICommon
+//	    Tools/AssetCooker/AssetCooker/AssetCooker.cpp Common/AssetPack.cpp Common/MappedFile.cpp
+//	    Common/MeshFile.cpp Common/ModelLoader.cpp Common/MeshWelder.cpp Common/IndexBuilder.cpp
+//	    Common/MeshBounds.cpp Common/GeometryGenerator.cpp Common/GeometryTables.cpp Common/Lz4.cpp
+//	    Common/MeshImporter.cpp Common/TangentSpace.cpp Common/Sha256.cpp Common/ContentCache.cpp
+//	    Common/DependencyGraph.cpp Common/DDSFile.cpp Common/Flipbook.cpp Common/MipChain.cpp
+//	    Common/BlockCompression.cpp
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include "../../../Common/AssetPack.h"
+#include "../../../Common/BlockCompression.h"
+#include "../../../Common/ContentCache.h"
+#include "../../../Common/DDSFile.h"
+#include "../../../Common/DependencyGraph.h"
+#include "../../../Common/Flipbook.h"
+#include "../../../Common/MappedFile.h"
+#include "../../../Common/MeshFile.h"
+#include "../../../Common/MeshImporter.h"
+#include "../../../Common/MeshWelder.h"
+#include "../../../Common/MipChain.h"
+#include "../../../Common/ModelLoader.h"
+#include "../../../Common/TangentSpace.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+	using Clock = chrono::high_resolution_clock;
+
+	struct Options
+	{
+		bool Tangents = false;
+		bool Weld = true;
+		bool List = false;
+		bool Compress = false;
+		bool Bench = false;
+		bool Full = false;
+		string CacheDirectory;
+		uint64_t CacheMegabytes = 1024;
+		vector<string> Flipbooks;
+		// A MipChain filter by name; empty leaves textures as they are.
+		string Mips;
+		// A BlockCompression format by name; empty leaves textures uncompressed.
+		string Blocks;
+		bool BlocksFast = false;
+	};
+
+	// Part of every cache key and signature; bump it when a change to the cooking changes
+	// its output.
+	const char* const CookerVersion = "AssetCooker 2";
+
+	// One per asset.  Its build fills it on a worker thread, and the pack is written from it
+	// once every build has finished.
+	struct Cooked
+	{
+		string Asset;
+		string Name;
+		AssetPack::Type Type = AssetPack::Raw;
+		vector<uint8_t> Bytes;
+		string Note;
+		DependencyGraph::Node Node = 0;
+	};
+
+	bool ReadFile(const fs::path& path, vector<uint8_t>& bytes)
+	{
+		MappedFile file;
+		if (!file.Open(path.wstring()))
+			return false;
+
+		bytes.assign(file.Data(), file.Data() + file.Size());
+		return true;
+	}
+
+	// Everything the loaders check, so a bad texture fails here rather than at run time,
+	// and no more mips than the largest dimension allows.
+	bool ValidateDDS(const vector<uint8_t>& bytes, string& error)
+	{
+		DDSFile::Info info;
+		if (!DDSFile::Parse(bytes.data(), bytes.size(), bytes.size(), info, 0, &error))
+			return false;
+
+		uint32_t maxMips = 1;
+		for (uint32_t size = max({ info.Width, info.Height, info.Depth }); size > 1; size >>= 1)
+			++maxMips;
+		if (info.MipCount > maxMips)
+			return error = "more mips than the texture has levels", false;
+		return true;
+	}
+
+	bool ParseMipFilter(const string& name, MipChain::Filter& filter)
+	{
+		if (name == "box")
+			filter = MipChain::Box;
+		else if (name == "kaiser")
+			filter = MipChain::Kaiser;
+		else if (name == "lanczos")
+			filter = MipChain::Lanczos;
+		else
+			return false;
+		return true;
+	}
+
+	// Replaces a texture that has no mips with one that has the full chain, when --mips is
+	// given and MipChain can filter its format.  Builds already run in parallel, so the
+	// chain is made on this worker alone.
+	bool AddMips(const Options& options, vector<uint8_t>& bytes, string& note, string& error)
+	{
+		DDSFile::Info info;
+		MipChain::Options mips;
+		if (!ParseMipFilter(options.Mips, mips.Kernel) ||
+			!DDSFile::Parse(bytes.data(), bytes.size(), bytes.size(), info) || !MipChain::NeedsMips(info))
+			return true;
+
+		mips.Parallel = false;
+		vector<uint8_t> chain;
+		MipChain::Stats stats;
+		if (!MipChain::Generate(bytes.data(), bytes.size(), chain, mips, &stats, &error))
+			return false;
+
+		bytes.swap(chain);
+		note += (note.empty() ? "" : ", ") + to_string(stats.Levels) + " mips generated (" + options.Mips + ")";
+		return true;
+	}
+
+	bool ParseBlockFormat(const string& name, DXGI_FORMAT& format)
+	{
+		if (name == "bc1")
+			format = DXGI_FORMAT_BC1_UNORM;
+		else if (name == "bc3")
+			format = DXGI_FORMAT_BC3_UNORM;
+		else if (name == "bc4")
+			format = DXGI_FORMAT_BC4_UNORM;
+		else if (name == "bc5")
+			format = DXGI_FORMAT_BC5_UNORM;
+		else if (name == "bc7")
+			format = DXGI_FORMAT_BC7_UNORM;
+		else
+			return false;
+		return true;
+	}
+
+	// Replaces a texture BlockCompression can encode with its blocks, when --bc is given.
+	// Runs after AddMips, so the chain is filtered from the uncompressed texels, and on this
+	// worker alone for the same reason.
+	bool AddBlocks(const Options& options, vector<uint8_t>& bytes, string& note, string& error)
+	{
+		DDSFile::Info info;
+		DXGI_FORMAT format;
+		if (!ParseBlockFormat(options.Blocks, format) ||
+			!DDSFile::Parse(bytes.data(), bytes.size(), bytes.size(), info) || !BlockCompression::CanCompress(info))
+			return true;
+
+		BlockCompression::Options blocks;
+		blocks.Mode = options.BlocksFast ? BlockCompression::Fast : BlockCompression::High;
+		blocks.Parallel = false;
+		vector<uint8_t> compressed;
+		BlockCompression::Stats stats;
+		if (!BlockCompression::Compress(bytes.data(), bytes.size(), format, compressed, blocks, &stats, &error))
+			return false;
+
+		bytes.swap(compressed);
+		char rate[32];
+		snprintf(rate, sizeof(rate), "%.1f MB/s", stats.SourceBytes / 1e6 / max(stats.Milliseconds / 1000.0, 1e-6));
+		note += (note.empty() ? "" : ", ") + options.Blocks + (options.BlocksFast ? " fast" : "") + " (" + rate + ")";
+		return true;
+	}
+
+	bool IsModel(const string& extension)
+	{
+		return extension == ".txt" || extension == ".obj" || extension == ".ply";
+	}
+
+	bool CookModel(const fs::path& path, const string& name, const Options& options, vector<uint8_t>& bytes,
+		string& error, string& note)
+	{
+		GeometryGenerator::MeshData mesh;
+		bool hasNormals = true;
+		if (path.extension() == ".txt")
+		{
+			ModelLoader::Stats load;
+			if (!ModelLoader::Load(path.wstring(), mesh, &load))
+				return error = load.Error, false;
+		}
+		else
+		{
+			MeshImporter::Stats import;
+			if (!MeshImporter::Import(path.wstring(), mesh, &import))
+				return error = import.Error, false;
+			hasNormals = import.HasNormals;
+		}
+
+		if (options.Weld)
+		{
+			MeshWelder::Stats weld = MeshWelder::Weld(mesh);
+			note = "welded " + to_string(weld.VerticesBefore) + " -> " + to_string(weld.VerticesAfter) + " vertices";
+		}
+
+		// After welding, so corners the source split only for lack of normals are smoothed.
+		if (!hasNormals || options.Tangents)
+		{
+			TangentSpace::Options tangents;
+			tangents.ComputeNormals = !hasNormals;
+			tangents.ComputeTangents = options.Tangents;
+			TangentSpace::Generate(mesh, tangents);
+			if (!hasNormals)
+				note += note.empty() ? "normals generated" : ", normals generated";
+		}
+
+		uint32_t attributes = MeshFile::Normal | MeshFile::TexC;
+		if (options.Tangents)
+			attributes |= MeshFile::TangentU;
+
+		return MeshFile::Write(mesh, fs::path(name).stem().string(), attributes, bytes, &error);
+	}
+
+	// Everything besides the source that shapes an asset's cooked bytes.
+	string CookParameters(const Options& options, const string& extension)
+	{
+		string parameters = string(CookerVersion) + " " + extension;
+		if (IsModel(extension))
+		{
+			parameters += " mesh " + to_string(MeshFile::FileVersion);
+			parameters += options.Weld ? " weld" : "";
+			parameters += options.Tangents ? " tangents" : "";
+		}
+		if (extension == ".dds" && !options.Mips.empty())
+			parameters += " mips " + options.Mips;
+		if (extension == ".dds" && !options.Blocks.empty())
+			parameters += " bc " + options.Blocks + (options.BlocksFast ? " fast" : " high");
+		return parameters;
+	}
+
+	// The key of what 'kind' cooks from 'sources' with 'parameters'; empty, so nothing is
+	// cached, when the cache is closed or a source cannot be read.
+	string CacheKey(const ContentCache& cache, const char* kind, const string& parameters,
+		const vector<wstring>& sources)
+	{
+		if (!cache.IsOpen())
+			return string();
+
+		ContentCache::KeyBuilder builder;
+		builder.Add(kind).Add(parameters);
+		for (const wstring& source : sources)
+		{
+			if (!builder.AddFile(source))
+				return string();
+		}
+		return builder.Key();
+	}
+
+	// Takes the cooked bytes from the cache under 'key', or cooks them and stores them there.
+	template<typename Cook>
+	bool CookCached(ContentCache& cache, const string& key, Cooked& cooked, Cook cook)
+	{
+		if (!key.empty() && cache.Load(key, cooked.Bytes))
+		{
+			cooked.Note = "cached";
+			return true;
+		}
+		if (!cook())
+			return false;
+
+		// A cache that cannot be written only costs the next run a cook.
+		string cacheError;
+		if (!key.empty() && !cache.Store(key, cooked.Bytes.data(), cooked.Bytes.size(), &cacheError))
+			fprintf(stderr, "%s: not cached: %s\n", cooked.Asset.c_str(), cacheError.c_str());
+		return true;
+	}
+
+	// A texture is worth caching when --mips or --bc may change it; otherwise its cook is
+	// only a validation.
+	bool CachesTextures(const Options& options)
+	{
+		return !options.Mips.empty() || !options.Blocks.empty();
+	}
+
+	// "#include "name"" gives the name; angle-bracket includes are left to the compiler.
+	bool ParseInclude(const string& line, string& name)
+	{
+		size_t i = line.find_first_not_of(" \t");
+		if (i == string::npos || line[i] != '#')
+			return false;
+		i = line.find_first_not_of(" \t", i + 1);
+		if (i == string::npos || line.compare(i, 7, "include") != 0)
+			return false;
+		i = line.find_first_not_of(" \t", i + 7);
+		if (i == string::npos || line[i] != '"')
+			return false;
+
+		const size_t end = line.find('"', i + 1);
+		if (end == string::npos)
+			return false;
+		name = line.substr(i + 1, end - i - 1);
+		return true;
+	}
+
+	// Appends the file with its includes inlined, each resolved against the directory of
+	// the file naming it.  #line directives keep the compiler's messages pointing at the
+	// original files.
+	bool InlineIncludes(const fs::path& path, int depth, string& text, vector<wstring>& includes, string& error)
+	{
+		if (depth > 16)
+			return error = path.generic_string() + ": includes nested too deeply", false;
+
+		ifstream fin(path, ios::binary);
+		if (!fin)
+			return error = "cannot read " + path.generic_string(), false;
+
+		const string file = path.filename().generic_string();
+		text += "#line 1 \"" + file + "\"\n";
+
+		string line, include;
+		for (int number = 1; getline(fin, line); ++number)
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			if (!ParseInclude(line, include))
+			{
+				text += line;
+				text += '\n';
+				continue;
+			}
+
+			const fs::path included = path.parent_path() / fs::u8path(include);
+			includes.push_back(included.wstring());
+			if (!InlineIncludes(included, depth + 1, text, includes, error))
+				return false;
+			text += "#line " + to_string(number + 1) + " \"" + file + "\"\n";
+		}
+		return true;
+	}
+
+	bool CookAsset(const fs::path& path, Cooked& cooked, const Options& options, ContentCache& cache,
+		DependencyGraph::Step& step)
+	{
+		const string extension = path.extension().string();
+		string& error = step.Error;
+
+		if (IsModel(extension))
+		{
+			const string key = CacheKey(cache, "mesh", CookParameters(options, extension), { path.wstring() });
+			return CookCached(cache, key, cooked, [&]()
+			{
+				return CookModel(path, cooked.Name, options, cooked.Bytes, error, cooked.Note);
+			});
+		}
+
+		if (extension == ".dds")
+		{
+			const string key = CachesTextures(options) ?
+				CacheKey(cache, "texture", CookParameters(options, extension), { path.wstring() }) : string();
+			return CookCached(cache, key, cooked, [&]()
+			{
+				if (!ReadFile(path, cooked.Bytes))
+					return error = "cannot read the file", false;
+				return ValidateDDS(cooked.Bytes, error) && AddMips(options, cooked.Bytes, cooked.Note, error) &&
+					AddBlocks(options, cooked.Bytes, cooked.Note, error);
+			});
+		}
+
+		if (extension == ".hlsl")
+		{
+			string text;
+			if (!InlineIncludes(path, 0, text, step.Discovered, error))
+				return false;
+			cooked.Bytes.assign(text.begin(), text.end());
+			if (!step.Discovered.empty())
+				cooked.Note = to_string(step.Discovered.size()) + " includes inlined";
+			return true;
+		}
+
+		if (!ReadFile(path, cooked.Bytes))
+			return error = "cannot read the file", false;
+		return true;
+	}
+
+	// An entry of the previous pack, kept in the form it was stored in when that matches
+	// this pack's compression.
+	bool Reuse(const AssetPack& previous, const Cooked& cooked, bool compress, AssetPack::Writer& writer, string& error)
+	{
+		const AssetPack::Entry& entry = *previous.Find(cooked.Name);
+		if (AssetPack::IsCompressed(entry) == compress)
+		{
+			const uint8_t* stored = static_cast<const uint8_t*>(previous.Data(entry));
+			return writer.AddStored(cooked.Name, cooked.Type, (AssetPack::Compression)entry.Compression,
+				entry.RawSize, vector<uint8_t>(stored, stored + entry.Size), &error);
+		}
+
+		vector<uint8_t> bytes((size_t)entry.RawSize);
+		if (!previous.Read(entry, bytes.data()))
+			return error = "the previous pack is corrupt", false;
+		return writer.Add(cooked.Name, cooked.Type, move(bytes), &error);
+	}
+
+	void FindDefaultAssets(const fs::path& root, vector<string>& assets)
+	{
+		const pair<const char*, bool (*)(const string&)> sources[] =
+		{
+			{ "Models", IsModel },
+			{ "Textures", [](const string& extension) { return extension == ".dds"; } },
+			{ "Shaders", [](const string& extension) { return extension == ".hlsl"; } }
+		};
+		for (const auto& source : sources)
+		{
+			error_code ec;
+			for (fs::recursive_directory_iterator it(root / source.first, ec), end; !ec && it != end; it.increment(ec))
+			{
+				if (it->is_regular_file() && source.second(it->path().extension().string()))
+					assets.push_back(fs::relative(it->path(), root).generic_string());
+			}
+		}
+		sort(assets.begin(), assets.end());
+	}
+
+	// Best of several runs, in milliseconds.
+	template<typename Fn>
+	double Time(int runs, Fn fn)
+	{
+		double best = 1e30;
+		for (int i = 0; i < runs; ++i)
+		{
+			auto start = Clock::now();
+			fn();
+			double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+			best = ms < best ? ms : best;
+		}
+		return best;
+	}
+
+	void ListPack(const AssetPack& pack, const map<string, string>& notes)
+	{
+		vector<const AssetPack::Entry*> entries;
+		for (uint32_t i = 0; i < pack.Count(); ++i)
+			entries.push_back(&pack.GetEntry(i));
+		sort(entries.begin(), entries.end(), [&](const AssetPack::Entry* a, const AssetPack::Entry* b)
+		{
+			return pack.Name(*a) < pack.Name(*b);
+		});
+
+		for (const AssetPack::Entry* entry : entries)
+		{
+			const string name = pack.Name(*entry);
+			auto note = notes.find(name);
+			printf("  %-40s %10llu -> %10llu bytes %5.1f%%  %s\n", name.c_str(), (unsigned long long)entry->RawSize,
+				(unsigned long long)entry->Size, 100.0 * entry->Size / max<uint64_t>(entry->RawSize, 1),
+				note != notes.end() ? note->second.c_str() : "");
+		}
+	}
+
+	// Decompressing every compressed entry against copying the same bytes once they are
+	// plain, both from memory, so the difference is the codec's cost alone.
+	bool BenchPack(const AssetPack& pack)
+	{
+		uint64_t rawBytes = 0;
+		vector<const AssetPack::Entry*> entries;
+		for (uint32_t i = 0; i < pack.Count(); ++i)
+		{
+			if (AssetPack::IsCompressed(pack.GetEntry(i)))
+			{
+				entries.push_back(&pack.GetEntry(i));
+				rawBytes += pack.GetEntry(i).RawSize;
+			}
+		}
+		if (entries.empty())
+		{
+			printf("no compressed entries\n");
+			return true;
+		}
+
+		vector<vector<uint8_t>> plain(entries.size()), copies(entries.size());
+		bool ok = true;
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			plain[i].resize((size_t)entries[i]->RawSize);
+			copies[i].resize((size_t)entries[i]->RawSize);
+		}
+
+		double decompress = Time(5, [&]()
+		{
+			for (size_t i = 0; i < entries.size(); ++i)
+				ok = pack.Read(*entries[i], plain[i].data()) && ok;
+		});
+		double copy = Time(5, [&]()
+		{
+			for (size_t i = 0; i < entries.size(); ++i)
+				memcpy(copies[i].data(), plain[i].data(), plain[i].size());
+		});
+
+		const double gb = rawBytes / 1e9;
+		printf("  %zu compressed entries, %.1f MB\n", entries.size(), rawBytes / 1e6);
+		printf("  lz4 read      %8.2f ms  %6.2f GB/s%s\n", decompress, gb / decompress * 1000.0, ok ? "" : "  CORRUPT");
+		printf("  raw copy      %8.2f ms  %6.2f GB/s\n", copy, gb / copy * 1000.0);
+		return ok;
+	}
+
+	int Usage()
+	{
+		printf("usage: AssetCooker [--lz4] [--bench] [--tangents] [--no-weld] [--list] [--full]\n"
+			"                   [--cache <dir> [--cache-mb <n>]] [--flipbook <pattern>]...\n"
+			"                   [--mips <box|kaiser|lanczos>] [--bc <bc1|bc3|bc4|bc5|bc7> [--bc-fast]]\n"
+			"                   <root> <output.lpak> [asset ...]\n");
+		return 2;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	vector<string> args;
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if (arg == "--tangents")
+			options.Tangents = true;
+		else if (arg == "--no-weld")
+			options.Weld = false;
+		else if (arg == "--list")
+			options.List = true;
+		else if (arg == "--lz4")
+			options.Compress = true;
+		else if (arg == "--bench")
+			options.Bench = true;
+		else if (arg == "--full")
+			options.Full = true;
+		else if (arg == "--cache" && i + 1 < argc)
+			options.CacheDirectory = argv[++i];
+		else if (arg == "--cache-mb" && i + 1 < argc)
+			options.CacheMegabytes = strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--flipbook" && i + 1 < argc)
+			options.Flipbooks.push_back(argv[++i]);
+		else if (arg == "--mips" && i + 1 < argc)
+		{
+			MipChain::Filter filter;
+			options.Mips = argv[++i];
+			if (!ParseMipFilter(options.Mips, filter))
+				return Usage();
+		}
+		else if (arg == "--bc" && i + 1 < argc)
+		{
+			DXGI_FORMAT format;
+			options.Blocks = argv[++i];
+			if (!ParseBlockFormat(options.Blocks, format))
+				return Usage();
+		}
+		else if (arg == "--bc-fast")
+			options.BlocksFast = true;
+		else if (arg.size() > 1 && arg[0] == '-')
+			return Usage();
+		else
+			args.push_back(arg);
+	}
+
+	if (args.size() < 2)
+		return Usage();
+
+	const fs::path root = args[0];
+	const fs::path output = args[1];
+	vector<string> assets(args.begin() + 2, args.end());
+	if (assets.empty())
+		FindDefaultAssets(root, assets);
+
+	// A flipbook's frames are packed only as part of its array.
+	vector<vector<wstring>> flipbookFrames;
+	for (const string& pattern : options.Flipbooks)
+	{
+		vector<wstring> frames = Flipbook::FramePaths((root / pattern).wstring());
+		if (frames.empty())
+		{
+			fprintf(stderr, "%s: no frames\n", pattern.c_str());
+			return 1;
+		}
+
+		for (const wstring& frame : frames)
+		{
+			const string asset = fs::relative(frame, root).generic_string();
+			assets.erase(remove(assets.begin(), assets.end(), asset), assets.end());
+		}
+		flipbookFrames.push_back(move(frames));
+	}
+
+	ContentCache cache;
+	if (!options.CacheDirectory.empty())
+	{
+		string error;
+		if (!cache.Open(fs::path(options.CacheDirectory).wstring(), options.CacheMegabytes << 20, &error))
+		{
+			fprintf(stderr, "%s: %s\n", options.CacheDirectory.c_str(), error.c_str());
+			return 1;
+		}
+	}
+
+	auto start = Clock::now();
+
+	// What the previous run cooked, and from what.
+	const wstring depsPath = output.wstring() + L".deps";
+	DependencyGraph graph;
+	AssetPack previous;
+	if (!options.Full)
+	{
+		graph.Load(depsPath);
+		previous.Open(output.wstring());
+	}
+
+	vector<Cooked> cooked(assets.size() + flipbookFrames.size());
+	size_t sourceBytes = 0;
+	for (size_t i = 0; i < assets.size(); ++i)
+	{
+		Cooked& item = cooked[i];
+		const fs::path path = root / assets[i];
+		const string extension = path.extension().string();
+
+		item.Asset = assets[i];
+		item.Name = assets[i];
+		if (IsModel(extension))
+		{
+			item.Name = fs::path(assets[i]).replace_extension(".lmesh").generic_string();
+			item.Type = AssetPack::Mesh;
+		}
+		else if (extension == ".dds")
+		{
+			item.Type = AssetPack::Texture;
+		}
+		else if (extension == ".hlsl")
+		{
+			item.Type = AssetPack::Shader;
+		}
+
+		error_code ec;
+		sourceBytes += (size_t)fs::file_size(path, ec);
+
+		const string name = AssetPack::NormalizeName(item.Name);
+		item.Node = graph.AddOutput(name, CookParameters(options, extension), [&, path](DependencyGraph::Step& step)
+		{
+			return CookAsset(path, item, options, cache, step);
+		});
+		graph.AddInput(item.Node, graph.AddFile(path.wstring()));
+
+		// Nothing to copy, so it is cooked whatever the record says.
+		if (!previous.IsOpen() || previous.Find(name) == nullptr)
+			graph.Invalidate(item.Node);
+	}
+
+	for (size_t i = 0; i < flipbookFrames.size(); ++i)
+	{
+		Cooked& item = cooked[assets.size() + i];
+		const vector<wstring>& frames = flipbookFrames[i];
+		item.Asset = options.Flipbooks[i];
+		item.Name = Flipbook::ArrayName(options.Flipbooks[i]);
+		item.Type = AssetPack::Texture;
+
+		// The frame count is part of the parameters, so a frame added to the end recooks it.
+		const string name = AssetPack::NormalizeName(item.Name);
+		const string parameters = CookParameters(options, ".dds") + " flipbook " + to_string(frames.size());
+		item.Node = graph.AddOutput(name, parameters, [&item, &frames, &options, &cache, parameters](
+			DependencyGraph::Step& step)
+		{
+			const string key = CachesTextures(options) ? CacheKey(cache, "flipbook", parameters, frames) : string();
+			return CookCached(cache, key, item, [&]()
+			{
+				if (!Flipbook::Build(frames, item.Bytes, &step.Error) || !ValidateDDS(item.Bytes, step.Error))
+					return false;
+				item.Note = to_string(frames.size()) + " frames";
+				return AddMips(options, item.Bytes, item.Note, step.Error) &&
+					AddBlocks(options, item.Bytes, item.Note, step.Error);
+			});
+		});
+
+		for (const wstring& frame : frames)
+		{
+			error_code ec;
+			sourceBytes += (size_t)fs::file_size(frame, ec);
+			graph.AddInput(item.Node, graph.AddFile(frame));
+		}
+
+		if (!previous.IsOpen() || previous.Find(name) == nullptr)
+			graph.Invalidate(item.Node);
+	}
+
+	bool ok = graph.Build();
+
+	AssetPack::Writer writer(options.Compress ? AssetPack::Lz4Blocks : AssetPack::None);
+	map<string, string> notes;
+	size_t cookedBytes = 0;
+
+	for (Cooked& item : cooked)
+	{
+		string error = graph.GetError(item.Node);
+		if (ok && !graph.WasRebuilt(item.Node))
+		{
+			cookedBytes += (size_t)previous.Find(item.Name)->RawSize;
+			notes[AssetPack::NormalizeName(item.Name)] = "unchanged";
+			Reuse(previous, item, options.Compress, writer, error);
+		}
+		else if (ok)
+		{
+			cookedBytes += item.Bytes.size();
+			notes[AssetPack::NormalizeName(item.Name)] = item.Note;
+			writer.Add(item.Name, item.Type, move(item.Bytes), &error);
+		}
+
+		if (!error.empty())
+		{
+			fprintf(stderr, "%s: %s\n", item.Asset.c_str(), error.c_str());
+			ok = false;
+		}
+	}
+
+	if (!ok)
+		return 1;
+
+	// The pack is about to be replaced.
+	previous.Close();
+
+	string error;
+	if (!writer.Save(output.wstring(), &error))
+	{
+		fprintf(stderr, "%s: %s\n", output.string().c_str(), error.c_str());
+		return 1;
+	}
+
+	// Only once the pack holds what it records.  Without it the next run cooks everything.
+	if (!graph.Save(depsPath, &error))
+		fprintf(stderr, "%s.deps: %s\n", output.string().c_str(), error.c_str());
+
+	double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+
+	// Read back what was written, which also validates it.
+	AssetPack pack;
+	if (!pack.Open(output.wstring(), &error))
+	{
+		fprintf(stderr, "%s: %s\n", output.string().c_str(), error.c_str());
+		return 1;
+	}
+
+	if (options.List)
+		ListPack(pack, notes);
+
+	const size_t packedBytes = (size_t)fs::file_size(output);
+	printf("%s: %zu assets, %zu source bytes, %zu cooked -> %zu bytes packed (%.1f%%), %.1f ms\n",
+		output.string().c_str(), writer.Count(), sourceBytes, cookedBytes, packedBytes,
+		100.0 * packedBytes / max<size_t>(cookedBytes, 1), ms);
+
+	const DependencyGraph::Stats& graphStats = graph.GetStats();
+	printf("%zu of %zu assets cooked, %zu of %zu files hashed, %.1f ms\n", graphStats.Rebuilt, graphStats.Outputs,
+		graphStats.FilesHashed, graphStats.Files, graphStats.Milliseconds);
+
+	if (cache.IsOpen())
+	{
+		const uint64_t cacheBytes = cache.Trim();
+		const ContentCache::Stats stats = cache.GetStats();
+		printf("cache: %zu hits, %zu misses, %zu stored, %zu corrupt, %zu evicted (%.1f MB), %.1f MB held\n",
+			stats.Hits, stats.Misses, stats.Stores, stats.Corrupt, stats.Evictions, stats.EvictedBytes / 1e6,
+			cacheBytes / 1e6);
+	}
+
+	if (options.Bench && !BenchPack(pack))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,632 @@
+// Console benchmarks for the mesh processing code in Common.  Run from the project
+// directory (the Visual Studio default) so the models resolve, or pass the Models
+// directory as the first argument.  The second argument sizes the synthetic text model
+// for the parse scaling run (1e6 vertices by default; 1e7 needs about 1 GB), and the third
+// the OBJ and PLY files written for the import run, in MB (100 by default).
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include "../../../Common/GeometryGenerator.h"
+#include "../../../Common/HalfEdgeMesh.h"
+#include "../../../Common/IndexBuilder.h"
+#include "../../../Common/MeshBVH.h"
+#include "../../../Common/MeshFile.h"
+#include "../../../Common/MeshImporter.h"
+#include "../../../Common/MeshWelder.h"
+#include "../../../Common/ModelLoader.h"
+#include "../../../Common/ParallelFor.h"
+#include "../../../Common/TangentSpace.h"
+
+using namespace std;
+
+namespace
+{
+	using Clock = chrono::high_resolution_clock;
+
+	// Best of several runs, in milliseconds.
+	template<typename Fn>
+	double Time(int runs, Fn fn)
+	{
+		double best = 1e30;
+		for (int i = 0; i < runs; ++i)
+		{
+			auto start = Clock::now();
+			fn();
+			double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+			best = ms < best ? ms : best;
+		}
+		return best;
+	}
+
+	// The ifstream reader the samples used before ModelLoader, kept as its baseline.
+	bool LoadModelWithStream(const string& path, GeometryGenerator::MeshData& mesh)
+	{
+		ifstream fin(path);
+		if (!fin)
+			return false;
+
+		size_t vcount = 0;
+		size_t tcount = 0;
+		string ignore;
+
+		fin >> ignore >> vcount;
+		fin >> ignore >> tcount;
+		fin >> ignore >> ignore >> ignore >> ignore;
+
+		mesh.Vertices.resize(vcount);
+		for (auto& v : mesh.Vertices)
+		{
+			fin >> v.Position.x >> v.Position.y >> v.Position.z;
+			fin >> v.Normal.x >> v.Normal.y >> v.Normal.z;
+			v.TangentU = { 0.0f, 0.0f, 0.0f };
+			v.TexC = { 0.0f, 0.0f };
+		}
+
+		fin >> ignore >> ignore >> ignore;
+
+		mesh.Indices32.resize(tcount * 3);
+		for (auto& i : mesh.Indices32)
+			fin >> i;
+
+		return !fin.fail();
+	}
+
+	// The usual first attempt at adjacency, for comparison with the hashed build.
+	size_t BuildTwinsWithMap(const vector<uint32_t>& indices, vector<uint32_t>& twins)
+	{
+		map<pair<uint32_t, uint32_t>, uint32_t> edges;
+		for (uint32_t he = 0; he < (uint32_t)indices.size(); ++he)
+		{
+			uint32_t next = he % 3 == 2 ? he - 2 : he + 1;
+			edges[make_pair(indices[he], indices[next])] = he;
+		}
+
+		size_t matched = 0;
+		twins.assign(indices.size(), HalfEdgeMesh::Invalid);
+		for (uint32_t he = 0; he < (uint32_t)indices.size(); ++he)
+		{
+			uint32_t next = he % 3 == 2 ? he - 2 : he + 1;
+			auto it = edges.find(make_pair(indices[next], indices[he]));
+			if (it != edges.end())
+			{
+				twins[he] = it->second;
+				++matched;
+			}
+		}
+		return matched;
+	}
+
+	bool LoadModel(const string& path, GeometryGenerator::MeshData& mesh)
+	{
+		ModelLoader::Stats stats;
+		if (ModelLoader::Load(wstring(path.begin(), path.end()), mesh, &stats))
+			return true;
+
+		printf("%s: %s\n", path.c_str(), stats.Error.c_str());
+		return false;
+	}
+
+	void BenchLoading(const string& path)
+	{
+		GeometryGenerator::MeshData streamed, mapped;
+		double stream = Time(3, [&]() { LoadModelWithStream(path, streamed); });
+		double loader = Time(3, [&]() { LoadModel(path, mapped); });
+
+		bool same = streamed.Indices32 == mapped.Indices32 && streamed.Vertices.size() == mapped.Vertices.size();
+		for (size_t i = 0; same && i < mapped.Vertices.size(); ++i)
+		{
+			same = memcmp(&streamed.Vertices[i].Position, &mapped.Vertices[i].Position, sizeof(DirectX::XMFLOAT3)) == 0 &&
+				memcmp(&streamed.Vertices[i].Normal, &mapped.Vertices[i].Normal, sizeof(DirectX::XMFLOAT3)) == 0;
+		}
+
+		printf("%s\n", path.c_str());
+		printf("  ifstream              %8.2f ms\n", stream);
+		printf("  mapped + from_chars   %8.2f ms  %.1fx, %s\n", loader, stream / loader,
+			same ? "identical" : "DIFFERENT");
+	}
+
+	// Text parse against opening the cooked .lmesh.  Both run with the file in the page
+	// cache; the mapping is read once so its pages are actually faulted in.
+	void BenchMeshFile(const string& path, const GeometryGenerator::MeshData& reference)
+	{
+		wstring textPath(path.begin(), path.end());
+		filesystem::path cooked = filesystem::temp_directory_path() /
+			(filesystem::path(path).stem().string() + ".lmesh");
+
+		string error;
+		if (!MeshFile::ConvertTextModel(textPath, cooked.wstring(), "mesh", MeshFile::Normal, &error))
+		{
+			printf("%s: %s\n", path.c_str(), error.c_str());
+			return;
+		}
+
+		GeometryGenerator::MeshData parsed;
+		double text = Time(5, [&]() { LoadModel(path, parsed); });
+
+		MeshFile file;
+		uint32_t checksum = 0;
+		double binary = Time(5, [&]() {
+			file.Open(cooked.wstring());
+			const unsigned char* p = static_cast<const unsigned char*>(file.Positions());
+			const unsigned char* end = static_cast<const unsigned char*>(file.Indices()) + file.IndexBytes();
+			for (; p < end; p += 4096)
+				checksum += *p;
+		});
+
+		bool same = file.IsOpen() && file.GetHeader().VertexCount == reference.Vertices.size() &&
+			file.WidenIndices() == reference.Indices32;
+		const DirectX::XMFLOAT3* positions = same ? static_cast<const DirectX::XMFLOAT3*>(file.Positions()) : nullptr;
+		for (size_t i = 0; same && i < reference.Vertices.size(); ++i)
+			same = memcmp(&positions[i], &reference.Vertices[i].Position, sizeof(DirectX::XMFLOAT3)) == 0;
+
+		printf("%s -> %s (%zu bytes, %u-bit indices)\n", path.c_str(), cooked.string().c_str(),
+			(size_t)filesystem::file_size(cooked), file.IndexSize() * 8);
+		printf("  text parse            %8.2f ms\n", text);
+		printf("  .lmesh open + touch   %8.3f ms  %.0fx, %s\n", binary, text / binary,
+			same ? "identical" : "DIFFERENT");
+
+		file.Close();
+		filesystem::remove(cooked);
+	}
+
+	// A text model of about 'vertexCount' vertices made of copies of 'mesh', parsed on one
+	// thread and then on every worker.
+	void BenchParseScaling(const GeometryGenerator::MeshData& mesh, size_t vertexCount)
+	{
+		const size_t copies = max<size_t>(vertexCount / mesh.Vertices.size(), 1);
+		const size_t vcount = copies * mesh.Vertices.size();
+		const size_t tcount = copies * mesh.Indices32.size() / 3;
+
+		string text = "VertexCount: " + to_string(vcount) + "\nTriangleCount: " + to_string(tcount) +
+			"\nVertexList (pos, normal)\n{\n";
+		char line[128];
+		for (size_t c = 0; c < copies; ++c)
+		{
+			for (const auto& v : mesh.Vertices)
+			{
+				snprintf(line, sizeof(line), "\t%g %g %g %g %g %g\n", v.Position.x + c, v.Position.y, v.Position.z,
+					v.Normal.x, v.Normal.y, v.Normal.z);
+				text += line;
+			}
+		}
+		text += "}\nTriangleList\n{\n";
+		for (size_t c = 0; c < copies; ++c)
+		{
+			const size_t base = c * mesh.Vertices.size();
+			for (size_t i = 0; i < mesh.Indices32.size(); i += 3)
+			{
+				snprintf(line, sizeof(line), "\t%zu %zu %zu\n", base + mesh.Indices32[i], base + mesh.Indices32[i + 1],
+					base + mesh.Indices32[i + 2]);
+				text += line;
+			}
+		}
+		text += "}\n";
+
+		ModelLoader::Header header;
+		ModelLoader::Stats stats;
+		ModelLoader::ParseHeader(text.data(), text.size(), header, stats);
+
+		vector<DirectX::XMFLOAT3> serialPositions(vcount), parallelPositions(vcount);
+		vector<uint32_t> serialIndices(tcount * 3), parallelIndices(tcount * 3);
+		ModelLoader::VertexLayout layout;
+		layout.Stride = sizeof(DirectX::XMFLOAT3);
+
+		ModelLoader::Stats serialStats, parallelStats;
+		double serial = Time(3, [&]() {
+			ModelLoader::Parse(text.data(), text.size(), header, serialPositions.data(), layout, serialIndices.data(),
+				serialStats, false);
+		});
+		double parallel = Time(3, [&]() {
+			ModelLoader::Parse(text.data(), text.size(), header, parallelPositions.data(), layout, parallelIndices.data(),
+				parallelStats, true);
+		});
+
+		bool same = serialStats.Error.empty() && parallelStats.Error.empty() && serialIndices == parallelIndices &&
+			memcmp(serialPositions.data(), parallelPositions.data(), vcount * sizeof(DirectX::XMFLOAT3)) == 0;
+
+		const double mb = text.size() / (1024.0 * 1024.0);
+		printf("synthetic: %zu vertices, %zu triangles, %.0f MB, %u workers\n", vcount, tcount, mb,
+			ParallelFor::WorkerCount());
+		printf("  1 thread              %8.2f ms  %6.0f MB/s\n", serial, mb / serial * 1000.0);
+		printf("  %2zu chunks             %8.2f ms  %6.0f MB/s  %.1fx, %s\n", parallelStats.Chunks, parallel,
+			mb / parallel * 1000.0, serial / parallel, same ? "identical" : "DIFFERENT");
+	}
+
+	// Copies of 'mesh' written out as an OBJ (separate v/vt/vn pools, every corner a full
+	// triplet) and a binary PLY of about 'megabytes' each, then imported.  The PLY holds
+	// the exact floats, so its import must reproduce the copies bit for bit.
+	void BenchImport(const GeometryGenerator::MeshData& mesh, size_t megabytes)
+	{
+		const filesystem::path dir = filesystem::temp_directory_path();
+		const filesystem::path objPath = dir / "MeshBench.obj";
+		const filesystem::path plyPath = dir / "MeshBench.ply";
+		const size_t target = megabytes * 1024 * 1024;
+
+		size_t copies = 0;
+		{
+			ofstream obj(objPath, ios::binary);
+			string chunk;
+			// Room for a face of nine 20-character indices.
+			char line[256];
+			for (size_t written = 0; written < target; ++copies)
+			{
+				chunk.clear();
+				for (const auto& v : mesh.Vertices)
+				{
+					snprintf(line, sizeof(line), "v %g %g %g\nvt %g %g\nvn %g %g %g\n", v.Position.x + copies,
+						v.Position.y, v.Position.z, v.Position.x * 0.1f, v.Position.y * 0.1f, v.Normal.x, v.Normal.y,
+						v.Normal.z);
+					chunk += line;
+				}
+				// Relative indices are the same in every copy.
+				const long long n = (long long)mesh.Vertices.size();
+				for (size_t i = 0; i < mesh.Indices32.size(); i += 3)
+				{
+					const long long a = mesh.Indices32[i] - n, b = mesh.Indices32[i + 1] - n, c = mesh.Indices32[i + 2] - n;
+					snprintf(line, sizeof(line), "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n", a, a, a, b, b, b, c, c, c);
+					chunk += line;
+				}
+				obj.write(chunk.data(), chunk.size());
+				written += chunk.size();
+			}
+		}
+
+		// 36-byte vertices and 13-byte faces.
+		const size_t plyCopies = max<size_t>(target / (mesh.Vertices.size() * 36 + mesh.Indices32.size() / 3 * 13), 1);
+		{
+			ofstream ply(plyPath, ios::binary);
+			ply << "ply\nformat binary_little_endian 1.0\ncomment MeshBench\n"
+				<< "element vertex " << plyCopies * mesh.Vertices.size() << "\n"
+				<< "property float x\nproperty float y\nproperty float z\n"
+				<< "property float nx\nproperty float ny\nproperty float nz\n"
+				<< "property float u\nproperty float v\nproperty uchar red\n"
+				<< "element face " << plyCopies * mesh.Indices32.size() / 3 << "\n"
+				<< "property list uchar int vertex_indices\nend_header\n";
+
+			vector<char> chunk;
+			for (size_t c = 0; c < plyCopies; ++c)
+			{
+				chunk.clear();
+				for (const auto& v : mesh.Vertices)
+				{
+					const float values[8] = { v.Position.x + c, v.Position.y, v.Position.z, v.Normal.x, v.Normal.y,
+						v.Normal.z, v.Position.x * 0.1f, v.Position.y * 0.1f };
+					chunk.insert(chunk.end(), (const char*)values, (const char*)(values + 8));
+					chunk.push_back((char)c);
+				}
+				ply.write(chunk.data(), chunk.size());
+			}
+			for (size_t c = 0; c < plyCopies; ++c)
+			{
+				chunk.clear();
+				for (size_t i = 0; i < mesh.Indices32.size(); i += 3)
+				{
+					const uint32_t face[3] = { (uint32_t)(c * mesh.Vertices.size() + mesh.Indices32[i]),
+						(uint32_t)(c * mesh.Vertices.size() + mesh.Indices32[i + 1]),
+						(uint32_t)(c * mesh.Vertices.size() + mesh.Indices32[i + 2]) };
+					chunk.push_back(3);
+					chunk.insert(chunk.end(), (const char*)face, (const char*)(face + 3));
+				}
+				ply.write(chunk.data(), chunk.size());
+			}
+		}
+
+		MeshImporter::Options raw;
+		raw.ConvertHandedness = false;
+		raw.FlipV = false;
+
+		GeometryGenerator::MeshData imported;
+		MeshImporter::Stats objStats, plyStats;
+		double obj = Time(3, [&]() { MeshImporter::Import(objPath.wstring(), imported, &objStats, raw); });
+		bool objOk = objStats.Error.empty() && objStats.VertexCount == copies * mesh.Vertices.size() &&
+			objStats.TriangleCount == copies * mesh.Indices32.size() / 3;
+
+		double ply = Time(3, [&]() { MeshImporter::Import(plyPath.wstring(), imported, &plyStats, raw); });
+		bool plyOk = plyStats.Error.empty() && imported.Vertices.size() == plyCopies * mesh.Vertices.size() &&
+			imported.Indices32.size() == plyCopies * mesh.Indices32.size();
+		for (size_t i = 0; plyOk && i < imported.Indices32.size(); ++i)
+		{
+			const size_t c = i / mesh.Indices32.size();
+			plyOk = imported.Indices32[i] == c * mesh.Vertices.size() + mesh.Indices32[i % mesh.Indices32.size()];
+		}
+		for (size_t i = 0; plyOk && i < imported.Vertices.size(); ++i)
+		{
+			const auto& v = mesh.Vertices[i % mesh.Vertices.size()];
+			const auto& w = imported.Vertices[i];
+			plyOk = w.Position.x == v.Position.x + i / mesh.Vertices.size() && w.Position.y == v.Position.y &&
+				w.Normal.z == v.Normal.z && w.TexC.y == v.Position.y * 0.1f;
+		}
+
+		const string objError = objStats.Error.empty() ? string("wrong counts") : objStats.Error;
+		const string plyError = plyStats.Error.empty() ? string("DIFFERENT") : plyStats.Error;
+		printf("import: %zu MB window, %u-byte vertices\n", MeshImporter::BufferSize / (1024 * 1024),
+			(unsigned)sizeof(GeometryGenerator::Vertex));
+		printf("  OBJ  %4.0f MB %9zu vertices  %8.2f ms  %6.0f MB/s  %s\n", objStats.Bytes / (1024.0 * 1024.0),
+			objStats.VertexCount, obj, objStats.Bytes / (1024.0 * 1024.0) / obj * 1000.0, objOk ? "ok" : objError.c_str());
+		printf("  PLY  %4.0f MB %9zu vertices  %8.2f ms  %6.0f MB/s  %s\n", plyStats.Bytes / (1024.0 * 1024.0),
+			plyStats.VertexCount, ply, plyStats.Bytes / (1024.0 * 1024.0) / ply * 1000.0, plyOk ? "identical" : plyError.c_str());
+
+		filesystem::remove(objPath);
+		filesystem::remove(plyPath);
+	}
+
+	void BenchHalfEdge(const char* name, GeometryGenerator::MeshData mesh)
+	{
+		MeshWelder::Weld(mesh);
+
+		printf("%s: %zu vertices, %zu triangles\n", name, mesh.Vertices.size(), mesh.Indices32.size() / 3);
+
+		HalfEdgeMesh heMesh;
+		double hashed = Time(10, [&]() { heMesh = HalfEdgeMesh(mesh); });
+
+		vector<uint32_t> twins;
+		double mapped = Time(3, [&]() { BuildTwinsWithMap(mesh.Indices32, twins); });
+
+		printf("  adjacency (hash)      %8.2f ms  %zu border, %zu non-manifold half-edges\n",
+			hashed, heMesh.BoundaryHalfEdgeCount(), heMesh.NonManifoldHalfEdgeCount());
+		printf("  adjacency (std::map)  %8.2f ms\n", mapped);
+
+		const HalfEdgeMesh::Scheme schemes[] = { HalfEdgeMesh::Scheme::Midpoint, HalfEdgeMesh::Scheme::Loop };
+		const char* schemeNames[] = { "midpoint", "loop" };
+		for (int s = 0; s < 2; ++s)
+		{
+			HalfEdgeMesh level = heMesh;
+			for (int k = 1; k <= 2; ++k)
+			{
+				HalfEdgeMesh next;
+				double ms = Time(3, [&]() { next = level.Subdivide(schemes[s]); });
+				printf("  %-8s level %d     %8.2f ms  %zu triangles\n", schemeNames[s], k, ms, next.FaceCount());
+				level = std::move(next);
+			}
+		}
+	}
+
+	// Reference for checking the BVH: every triangle against the ray.
+	MeshBVH::Hit PickBruteForce(const GeometryGenerator::MeshData& mesh, const MeshBVH::Ray& ray)
+	{
+		MeshBVH::Hit hit;
+		hit.T = ray.MaxT;
+
+		const DirectX::XMFLOAT3& o = ray.Origin;
+		const DirectX::XMFLOAT3& d = ray.Direction;
+		for (size_t i = 0; i + 2 < mesh.Indices32.size(); i += 3)
+		{
+			const DirectX::XMFLOAT3& v0 = mesh.Vertices[mesh.Indices32[i + 0]].Position;
+			const DirectX::XMFLOAT3& v1 = mesh.Vertices[mesh.Indices32[i + 1]].Position;
+			const DirectX::XMFLOAT3& v2 = mesh.Vertices[mesh.Indices32[i + 2]].Position;
+
+			float e1[3] = { v1.x - v0.x, v1.y - v0.y, v1.z - v0.z };
+			float e2[3] = { v2.x - v0.x, v2.y - v0.y, v2.z - v0.z };
+			float p[3] = { d.y * e2[2] - d.z * e2[1], d.z * e2[0] - d.x * e2[2], d.x * e2[1] - d.y * e2[0] };
+			float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+			if (fabsf(det) < 1e-20f)
+				continue;
+
+			float invDet = 1.0f / det;
+			float s[3] = { o.x - v0.x, o.y - v0.y, o.z - v0.z };
+			float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+			if (u < 0.0f || u > 1.0f)
+				continue;
+
+			float q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+			float v = (d.x * q[0] + d.y * q[1] + d.z * q[2]) * invDet;
+			if (v < 0.0f || u + v > 1.0f)
+				continue;
+
+			float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+			if (t >= 0.0f && t < hit.T)
+			{
+				hit.Triangle = (uint32_t)(i / 3);
+				hit.T = t;
+				hit.U = u;
+				hit.V = v;
+			}
+		}
+		return hit;
+	}
+
+	// Rays from a sphere around the model towards random points of its bounding box.
+	vector<MeshBVH::Ray> MakeRays(const GeometryGenerator::MeshData& mesh, size_t count)
+	{
+		DirectX::XMFLOAT3 lo(1e30f, 1e30f, 1e30f);
+		DirectX::XMFLOAT3 hi(-1e30f, -1e30f, -1e30f);
+		for (const auto& v : mesh.Vertices)
+		{
+			lo = DirectX::XMFLOAT3(min(lo.x, v.Position.x), min(lo.y, v.Position.y), min(lo.z, v.Position.z));
+			hi = DirectX::XMFLOAT3(max(hi.x, v.Position.x), max(hi.y, v.Position.y), max(hi.z, v.Position.z));
+		}
+
+		DirectX::XMFLOAT3 c(0.5f * (lo.x + hi.x), 0.5f * (lo.y + hi.y), 0.5f * (lo.z + hi.z));
+		float radius = sqrtf((hi.x - lo.x) * (hi.x - lo.x) + (hi.y - lo.y) * (hi.y - lo.y) + (hi.z - lo.z) * (hi.z - lo.z));
+
+		uint32_t state = 12345;
+		auto random = [&]()
+		{
+			state = state * 1664525u + 1013904223u;
+			return (state >> 8) * (1.0f / 16777216.0f);
+		};
+
+		vector<MeshBVH::Ray> rays(count);
+		for (auto& ray : rays)
+		{
+			float z = 2.0f * random() - 1.0f;
+			float phi = 6.2831853f * random();
+			float r = sqrtf(1.0f - z * z);
+			ray.Origin = DirectX::XMFLOAT3(c.x + radius * r * cosf(phi), c.y + radius * r * sinf(phi), c.z + radius * z);
+
+			DirectX::XMFLOAT3 target(lo.x + (hi.x - lo.x) * random(), lo.y + (hi.y - lo.y) * random(), lo.z + (hi.z - lo.z) * random());
+			ray.Direction = DirectX::XMFLOAT3(target.x - ray.Origin.x, target.y - ray.Origin.y, target.z - ray.Origin.z);
+		}
+		return rays;
+	}
+
+	void BenchBVH(const char* name, const GeometryGenerator::MeshData& mesh)
+	{
+		printf("%s: %zu triangles\n", name, mesh.Indices32.size() / 3);
+
+		MeshBVH bvh;
+		double build = Time(5, [&]() { bvh.Build(mesh); });
+		printf("  bvh build             %8.2f ms  %zu nodes, %zu leaves\n",
+			build, bvh.GetStats().NodeCount, bvh.GetStats().LeafCount);
+
+		vector<MeshBVH::Ray> rays = MakeRays(mesh, 1 << 20);
+		size_t hits = 0;
+		double traced = Time(3, [&]()
+		{
+			hits = 0;
+			for (const auto& ray : rays)
+				hits += bvh.Pick(ray).Valid() ? 1 : 0;
+		});
+		printf("  bvh pick              %8.2f Mrays/s  %.1f%% hit\n",
+			rays.size() / traced / 1000.0, 100.0 * hits / rays.size());
+
+		const size_t checked = 2000;
+		size_t mismatches = 0;
+		double brute = Time(1, [&]()
+		{
+			for (size_t i = 0; i < checked; ++i)
+			{
+				MeshBVH::Hit expected = PickBruteForce(mesh, rays[i]);
+				MeshBVH::Hit actual = bvh.Pick(rays[i]);
+				if (expected.Valid() != actual.Valid() ||
+					(expected.Valid() && fabsf(expected.T - actual.T) > 1e-5f * max(1.0f, expected.T)))
+					++mismatches;
+			}
+		});
+		printf("  brute force           %8.4f Mrays/s  %zu/%zu mismatches\n",
+			checked / brute / 1000.0, mismatches, checked);
+	}
+
+	// Splits the mesh into 16-bit batches as MeshPacker does, checks that every index
+	// comes back from its batch, and times it against the 32-bit copy it replaces.
+	void BenchIndices(const char* name, const GeometryGenerator::MeshData& mesh)
+	{
+		const vector<uint32_t>& indices = mesh.Indices32;
+		vector<IndexBuilder::Batch> batches;
+		const bool narrow = IndexBuilder::Build(indices.data(), indices.size(), mesh.Vertices.size(), batches);
+		if (!narrow)
+		{
+			printf("%s: %zu vertices, %zu triangles, too scattered for 16-bit batches, stays R32_UINT\n", name,
+				mesh.Vertices.size(), indices.size() / 3);
+			return;
+		}
+
+		vector<uint16_t> narrowed(indices.size());
+		double ms = Time(5, [&]()
+		{
+			IndexBuilder::Build(indices.data(), indices.size(), mesh.Vertices.size(), batches);
+			IndexBuilder::Write16(indices.data(), batches, narrowed.data());
+		});
+		vector<uint32_t> copied(indices.size());
+		double copyMs = Time(5, [&]() { copy(indices.begin(), indices.end(), copied.begin()); });
+
+		size_t mismatches = 0;
+		uint32_t covered = 0;
+		for (const IndexBuilder::Batch& batch : batches)
+		{
+			mismatches += batch.StartIndexLocation != covered ? 1 : 0;
+			covered += batch.IndexCount;
+			for (uint32_t i = batch.StartIndexLocation; i < batch.StartIndexLocation + batch.IndexCount; ++i)
+			{
+				const uint32_t local = narrowed[i];
+				mismatches += local + batch.BaseVertexLocation != indices[i] || local >= batch.VertexCount ? 1 : 0;
+			}
+		}
+		mismatches += covered != indices.size() ? 1 : 0;
+
+		printf("%s: %zu vertices, %zu triangles, %zu 16-bit batches, %.1f MB of indices instead of %.1f\n", name,
+			mesh.Vertices.size(), indices.size() / 3, batches.size(), narrowed.size() * 2 / (1024.0 * 1024.0),
+			copied.size() * 4 / (1024.0 * 1024.0));
+		printf("  split + narrow        %8.2f ms  32-bit copy %.2f ms  %zu mismatches\n", ms, copyMs, mismatches);
+	}
+
+	// Recomputes the skull's normals against the ones it ships with, then times normals
+	// and tangents on the skull subdivided to about a million triangles.
+	void BenchTangents(const char* name, GeometryGenerator::MeshData mesh)
+	{
+		MeshWelder::Weld(mesh);
+
+		// Spherical texture coordinates, so every triangle has a tangent frame.
+		auto mapSphere = [](GeometryGenerator::MeshData& m)
+		{
+			for (auto& v : m.Vertices)
+			{
+				const DirectX::XMFLOAT3& p = v.Position;
+				float r = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+				v.TexC.x = atan2f(p.z, p.x) * (0.5f / 3.1415927f) + 0.5f;
+				v.TexC.y = r > 0.0f ? acosf(p.y / r) / 3.1415927f : 0.0f;
+			}
+		};
+
+		GeometryGenerator::MeshData recomputed = mesh;
+		TangentSpace::Options normalsOnly;
+		normalsOnly.ComputeTangents = false;
+		TangentSpace::Generate(recomputed, normalsOnly);
+
+		double agreement = 0.0;
+		for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+		{
+			const DirectX::XMFLOAT3& a = mesh.Vertices[i].Normal;
+			const DirectX::XMFLOAT3& b = recomputed.Vertices[i].Normal;
+			float la = sqrtf(a.x * a.x + a.y * a.y + a.z * a.z);
+			agreement += la > 0.0f ? (a.x * b.x + a.y * b.y + a.z * b.z) / la : 1.0;
+		}
+		printf("%s: recomputed normals, mean cosine to the shipped ones %.4f\n", name,
+			agreement / max<size_t>(mesh.Vertices.size(), 1));
+
+		HalfEdgeMesh level(mesh);
+		level = level.Subdivide(HalfEdgeMesh::Scheme::Midpoint).Subdivide(HalfEdgeMesh::Scheme::Midpoint);
+		GeometryGenerator::MeshData dense = level.ToMeshData();
+		mapSphere(dense);
+
+		TangentSpace::Stats stats;
+		double ms = Time(3, [&]() { stats = TangentSpace::Generate(dense); });
+		printf("  normals + tangents    %8.2f ms  %zu vertices, %zu triangles, %zu without uv area\n",
+			ms, stats.VertexCount, stats.TriangleCount, stats.DegenerateTexCoords);
+
+		double normalMs = Time(3, [&]() { TangentSpace::Generate(dense, normalsOnly); });
+		printf("  normals only          %8.2f ms\n", normalMs);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	string models = argc > 1 ? argv[1] : "../../../Models";
+	size_t parseVertices = argc > 2 ? (size_t)atof(argv[2]) : 1000000;
+	size_t importMegabytes = argc > 3 ? (size_t)atof(argv[3]) : 100;
+
+	GeometryGenerator::MeshData skull;
+	if (!LoadModel(models + "/skull.txt", skull))
+		return 1;
+
+	GeometryGenerator::MeshData car;
+	if (!LoadModel(models + "/car.txt", car))
+		return 1;
+
+	BenchLoading(models + "/skull.txt");
+	BenchLoading(models + "/car.txt");
+	BenchMeshFile(models + "/skull.txt", skull);
+	BenchMeshFile(models + "/car.txt", car);
+	BenchParseScaling(skull, parseVertices);
+	BenchImport(skull, importMegabytes);
+	BenchHalfEdge("skull", skull);
+	BenchBVH("skull", skull);
+	BenchBVH("car", car);
+	BenchTangents("skull", skull);
+
+	GeometryGenerator geoGen;
+	BenchIndices("skull", skull);
+	BenchIndices("grid 512x512", geoGen.CreateGrid(100.0f, 100.0f, 512, 512));
+	BenchIndices("skull x16 (midpoint)",
+		HalfEdgeMesh(skull).Subdivide(HalfEdgeMesh::Scheme::Midpoint).Subdivide(HalfEdgeMesh::Scheme::Midpoint).ToMeshData());
+
+	return 0;
+}
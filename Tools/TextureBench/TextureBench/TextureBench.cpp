@@ -0,0 +1,671 @@
+// Console benchmarks for the texture code in Common.  Run from the project directory (the
+// Visual Studio default) so the textures resolve, or pass the Textures directory as the
+// first argument.  Needs no D3D device: DDSFile, MipChain and BlockCompression are
+// platform-independent, so this also builds on Linux against a copy of dxgiformat.h.
+// Also fuzzes DDSFile's header parsing, and exits non-zero if it accepts a layout that
+// does not fit its file; build with -fsanitize=address to catch reads past the header.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../../../Common/BlockCompression.h"
+#include "../../../Common/DDSFile.h"
+#include "../../../Common/MappedFile.h"
+#include "../../../Common/MipChain.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+	using Clock = chrono::high_resolution_clock;
+
+	// Best of several runs, in milliseconds.
+	template<typename Fn>
+	double Time(int runs, Fn fn)
+	{
+		double best = 1e30;
+		for (int i = 0; i < runs; ++i)
+		{
+			auto start = Clock::now();
+			fn();
+			double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+			best = ms < best ? ms : best;
+		}
+		return best;
+	}
+
+	// What DDSTextureLoader does before it can look at the header: read the whole file.
+	bool ReadWhole(const fs::path& path, vector<uint8_t>& bytes)
+	{
+		ifstream file(path, ios::binary | ios::ate);
+		if (!file)
+			return false;
+		bytes.resize((size_t)file.tellg());
+		file.seekg(0);
+		return (bool)file.read(reinterpret_cast<char*>(bytes.data()), (streamsize)bytes.size());
+	}
+
+	// A DX10 header for the shape, and the size of the file it describes.  Only the header
+	// is built: Parse() and Footprints() need no pixel data.
+	struct Shape
+	{
+		const char* Name;
+		DXGI_FORMAT Format;
+		uint32_t Dimension;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Depth;
+		uint32_t MipCount;
+		uint32_t ArraySize;
+		bool Cube;
+	};
+
+	uint64_t MakeHeader(const Shape& shape, vector<uint8_t>& header)
+	{
+		uint32_t words[37] = {};
+		words[0] = DDSFile::Magic;
+		words[1] = 124;
+		words[2] = 0x1007 | (shape.MipCount > 1 ? 0x20000 : 0) | (shape.Dimension == DDSFile::Texture3D ? 0x800000 : 0);
+		words[3] = shape.Height;
+		words[4] = shape.Width;
+		words[6] = shape.Depth;
+		words[7] = shape.MipCount;
+		words[19] = 32;
+		words[20] = 0x4;
+		memcpy(&words[21], "DX10", 4);
+		words[32] = shape.Format;
+		words[33] = shape.Dimension;
+		words[34] = shape.Cube ? 0x4 : 0;
+		words[35] = shape.ArraySize;
+		header.assign(reinterpret_cast<const uint8_t*>(words), reinterpret_cast<const uint8_t*>(words) + sizeof(words));
+
+		uint64_t size = sizeof(words);
+		const uint32_t slices = shape.ArraySize * (shape.Cube ? 6 : 1);
+		for (uint32_t slice = 0; slice < slices; ++slice)
+		{
+			uint32_t w = shape.Width, h = shape.Height, d = shape.Depth;
+			for (uint32_t mip = 0; mip < shape.MipCount; ++mip)
+			{
+				size_t bytes = 0;
+				DDSFile::SurfaceInfo(w, h, shape.Format, &bytes, nullptr, nullptr);
+				size += (uint64_t)bytes * d;
+				w = max(w >> 1, 1u);
+				h = max(h >> 1, 1u);
+				d = max(d >> 1, 1u);
+			}
+		}
+		return size;
+	}
+
+	const Shape Shapes[] =
+	{
+		{ "2D RGBA8 1024 mips", DXGI_FORMAT_R8G8B8A8_UNORM, DDSFile::Texture2D, 1024, 1024, 1, 11, 1, false },
+		{ "2D BC1 1000x600 mips", DXGI_FORMAT_BC1_UNORM, DDSFile::Texture2D, 1000, 600, 1, 10, 1, false },
+		{ "2D BC7 array of 64", DXGI_FORMAT_BC7_UNORM, DDSFile::Texture2D, 512, 512, 1, 10, 64, false },
+		{ "cube RGBA16F 256 mips", DXGI_FORMAT_R16G16B16A16_FLOAT, DDSFile::Texture2D, 256, 256, 1, 9, 1, true },
+		{ "cube array BC3 x4", DXGI_FORMAT_BC3_UNORM, DDSFile::Texture2D, 128, 128, 1, 8, 4, true },
+		{ "1D array R32F", DXGI_FORMAT_R32_FLOAT, DDSFile::Texture1D, 4096, 1, 1, 13, 16, false },
+		{ "volume R8 128^3 mips", DXGI_FORMAT_R8_UNORM, DDSFile::Texture3D, 128, 128, 128, 8, 1, false },
+		{ "volume BC4 odd sizes", DXGI_FORMAT_BC4_UNORM, DDSFile::Texture3D, 75, 33, 17, 7, 1, false },
+		{ "2D YUY2 odd width", DXGI_FORMAT_YUY2, DDSFile::Texture2D, 641, 480, 1, 1, 1, false },
+		{ "2D R1 bitmap", DXGI_FORMAT_R1_UNORM, DDSFile::Texture2D, 1000, 8, 1, 1, 1, false }
+	};
+
+	// The rules CopyTextureRegion holds a buffer footprint to: aligned offsets and pitches,
+	// rows that fit their pitch, and subresources that do not overlap.
+	bool CheckFootprints(const DDSFile::Info& info, const vector<DDSFile::Footprint>& footprints, uint64_t total)
+	{
+		uint64_t end = 0;
+		for (size_t i = 0; i < footprints.size(); ++i)
+		{
+			const DDSFile::Footprint& f = footprints[i];
+			const DDSFile::Subresource& sub = info.Subresources[i];
+			if (f.Offset % DDSFile::PlacementAlignment != 0 || f.RowPitch % DDSFile::RowPitchAlignment != 0 ||
+				f.RowPitch < f.RowBytes || f.Offset < end || f.RowBytes != sub.RowBytes || f.Width < sub.Width ||
+				f.Height < sub.Height)
+				return false;
+			end = f.Offset + ((uint64_t)f.RowCount * f.Depth - 1) * f.RowPitch + f.RowBytes;
+		}
+		return end == total;
+	}
+
+	void BenchShapes()
+	{
+		printf("synthetic headers: parse + footprints, no pixel data\n");
+		for (const Shape& shape : Shapes)
+		{
+			vector<uint8_t> header;
+			const uint64_t fileSize = MakeHeader(shape, header);
+
+			DDSFile::Info info;
+			vector<DDSFile::Footprint> footprints;
+			string error;
+			if (!DDSFile::Parse(header.data(), header.size(), fileSize, info, 0, &error))
+			{
+				printf("  %-24s %s\n", shape.Name, error.c_str());
+				continue;
+			}
+
+			const int iterations = 1000;
+			uint64_t total = 0;
+			double ms = Time(3, [&]()
+			{
+				for (int i = 0; i < iterations; ++i)
+				{
+					DDSFile::Parse(header.data(), header.size(), fileSize, info, 0, nullptr);
+					total = DDSFile::Footprints(info, footprints);
+				}
+			});
+
+			const bool consistent = info.Subresources.back().Offset + info.Subresources.back().SliceBytes *
+				info.Subresources.back().Depth == fileSize && CheckFootprints(info, footprints, total);
+			printf("  %-24s %4zu subresources  %8.0f KB file  %8.0f KB upload  %6.2f us  %s\n", shape.Name,
+				info.Subresources.size(), fileSize / 1024.0, total / 1024.0, ms * 1000.0 / iterations,
+				consistent ? "consistent" : "INCONSISTENT");
+		}
+	}
+
+	// Whether an accepted file's layout stays inside it: subresources in order from
+	// DataOffset, none past fileSize, and footprints CopyTextureRegion would take.
+	bool FitsInFile(const DDSFile::Info& info, uint64_t fileSize, string& problem)
+	{
+		if (info.Subresources.empty() || info.DataOffset > fileSize)
+		{
+			problem = "no subresources, or data past the end";
+			return false;
+		}
+		uint64_t end = info.DataOffset;
+		for (const DDSFile::Subresource& sub : info.Subresources)
+		{
+			const uint64_t bytes = (uint64_t)sub.SliceBytes * sub.Depth;
+			if (sub.Offset < end || sub.Offset > fileSize || bytes > fileSize - sub.Offset ||
+				sub.SliceBytes < (uint64_t)sub.RowBytes * sub.RowCount)
+			{
+				problem = "subresource outside the file";
+				return false;
+			}
+			end = sub.Offset + bytes;
+		}
+
+		vector<DDSFile::Footprint> footprints;
+		const uint64_t total = DDSFile::Footprints(info, footprints);
+		if (footprints.size() != info.Subresources.size() || !CheckFootprints(info, footprints, total))
+		{
+			problem = "footprints break CopyTextureRegion's rules";
+			return false;
+		}
+		return true;
+	}
+
+	// Deterministic mutations of the synthetic headers, and of legacy headers made from
+	// them: header fields set to edge values or bit-flipped, the file size moved, and the
+	// bytes cut short.  Each case is parsed from a buffer of exactly the bytes it has, so
+	// under AddressSanitizer a read past 'size' stops the run; everything accepted must
+	// lay out inside the file.
+	bool FuzzHeaders()
+	{
+		const uint32_t edges[] = { 0, 1, 2, 3, 4, 6, 15, 16, 17, 124, 127, 128, 2048, 2049, 16384, 16385,
+			0x7FFFFFFF, 0x80000000, 0xFFFFFFFE, 0xFFFFFFFF };
+		const char* fourCCs[] = { "DXT1", "DXT3", "DXT5", "ATI1", "ATI2", "BC4U", "BC5S", "RGBG", "DX10", "XXXX" };
+		const int iterations = 200000;
+
+		uint64_t state = 0x9E3779B97F4A7C15ull;
+		auto next = [&state]()
+		{
+			// xorshift64*, so every platform mutates the same way.
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return (uint32_t)((state * 0x2545F4914F6CDD1Dull) >> 32);
+		};
+
+		size_t accepted = 0;
+		size_t failures = 0;
+		auto start = Clock::now();
+		for (int i = 0; i < iterations; ++i)
+		{
+			const Shape& shape = Shapes[next() % size(Shapes)];
+			vector<uint8_t> header;
+			uint64_t fileSize = MakeHeader(shape, header);
+			uint32_t words[37];
+			memcpy(words, header.data(), sizeof(words));
+
+			// A legacy header in a quarter of the cases: a FourCC or RGB masks, no extension.
+			size_t length = sizeof(words);
+			if (next() % 4 == 0)
+			{
+				if (next() % 2 == 0)
+				{
+					memcpy(&words[21], fourCCs[next() % size(fourCCs)], 4);
+				}
+				else
+				{
+					words[20] = 0x41;
+					words[21] = 0;
+					words[22] = 32;
+					words[23] = 0xFF;
+					words[24] = 0xFF00;
+					words[25] = 0xFF0000;
+					words[26] = 0xFF000000;
+				}
+				words[28] = next() % 2 == 0 ? 0 : 0xFE00 >> (next() % 2);
+				length = DDSFile::HeaderBytes;
+			}
+
+			const int mutations = 1 + next() % 4;
+			for (int m = 0; m < mutations; ++m)
+			{
+				const uint32_t word = next() % 37;
+				switch (next() % 3)
+				{
+				case 0: words[word] = edges[next() % size(edges)]; break;
+				case 1: words[word] ^= 1u << (next() % 32); break;
+				default: words[word] = next(); break;
+				}
+			}
+
+			switch (next() % 5)
+			{
+			case 0: fileSize = next() % (sizeof(words) + 64); break;
+			case 1: fileSize = fileSize - min<uint64_t>(fileSize, 1 + next() % 4096); break;
+			case 2: fileSize += next() % 4096; break;
+			case 3: fileSize = ((uint64_t)next() << 32) | next(); break;
+			default: break;
+			}
+
+			// The bytes the caller has: the whole header, or a file cut short inside it.
+			if (next() % 4 == 0)
+				length = next() % (length + 1);
+			length = (size_t)min<uint64_t>(length, fileSize);
+			vector<uint8_t> bytes(reinterpret_cast<const uint8_t*>(words), reinterpret_cast<const uint8_t*>(words) + length);
+			bytes.shrink_to_fit();
+
+			const size_t maxSize = next() % 3 == 0 ? 1u << (next() % 15) : 0;
+			DDSFile::Info info;
+			if (!DDSFile::Parse(bytes.data(), bytes.size(), fileSize, info, maxSize))
+				continue;
+
+			++accepted;
+			string problem;
+			if (!FitsInFile(info, fileSize, problem))
+			{
+				if (failures++ < 10)
+					printf("  case %d (%s, %llu bytes): %s\n", i, shape.Name, (unsigned long long)fileSize,
+						problem.c_str());
+			}
+		}
+		double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+
+		printf("mutated headers: %d cases, %zu accepted, %zu outside their file  %.0f ms  %s\n", iterations, accepted,
+			failures, ms, failures == 0 ? "ok" : "FAILED");
+		return failures == 0;
+	}
+
+	// Sizing an upload from the header alone against reading each file first.
+	void BenchFiles(const string& textures)
+	{
+		vector<fs::path> paths;
+		error_code ec;
+		for (fs::recursive_directory_iterator it(textures, ec), end; it != end; it.increment(ec))
+		{
+			if (it->is_regular_file() && it->path().extension() == ".dds")
+				paths.push_back(it->path());
+		}
+		sort(paths.begin(), paths.end());
+		if (paths.empty())
+		{
+			printf("%s: no .dds files\n", textures.c_str());
+			return;
+		}
+
+		uint64_t fileBytes = 0;
+		uint64_t uploadBytes = 0;
+		size_t failures = 0;
+		size_t inconsistent = 0;
+		for (const fs::path& path : paths)
+		{
+			MappedFile file(path.wstring());
+			DDSFile::Info info;
+			vector<DDSFile::Footprint> footprints;
+			string error;
+			if (!file.IsOpen() || !DDSFile::Parse(file.Data(), file.Size(), file.Size(), info, 0, &error))
+			{
+				printf("  %s: %s\n", path.string().c_str(), file.IsOpen() ? error.c_str() : "cannot open");
+				++failures;
+				continue;
+			}
+
+			const uint64_t total = DDSFile::Footprints(info, footprints);
+			const DDSFile::Subresource& last = info.Subresources.back();
+			if (last.Offset + last.SliceBytes * last.Depth != file.Size() || !CheckFootprints(info, footprints, total))
+				++inconsistent;
+			fileBytes += file.Size();
+			uploadBytes += total;
+		}
+
+		vector<uint8_t> bytes;
+		double whole = Time(3, [&]()
+		{
+			for (const fs::path& path : paths)
+				ReadWhole(path, bytes);
+		});
+		double header = Time(3, [&]()
+		{
+			DDSFile::Info info;
+			vector<DDSFile::Footprint> footprints;
+			for (const fs::path& path : paths)
+			{
+				MappedFile file(path.wstring());
+				if (DDSFile::Parse(file.Data(), min(file.Size(), DDSFile::MaxHeaderBytes), file.Size(), info))
+					DDSFile::Footprints(info, footprints);
+			}
+		});
+
+		printf("%s: %zu files, %.1f MB, %.1f MB of upload heap, %zu failed, %zu inconsistent\n", textures.c_str(),
+			paths.size(), fileBytes / (1024.0 * 1024.0), uploadBytes / (1024.0 * 1024.0), failures, inconsistent);
+		printf("  read whole files      %8.2f ms\n", whole);
+		printf("  map + header layout   %8.2f ms  %.1fx\n", header, whole / header);
+	}
+
+	// A single-mip DDS of 'format' filled with a pattern that has both smooth gradients
+	// and texel-sized detail, which is where filters differ.
+	vector<uint8_t> MakeTexture(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t arraySize, bool cube)
+	{
+		DDSFile::Info info;
+		info.Format = format;
+		info.ResourceDimension = height == 1 ? DDSFile::Texture1D : DDSFile::Texture2D;
+		info.Width = width;
+		info.Height = height;
+		info.Depth = 1;
+		info.MipCount = 1;
+		info.ArraySize = arraySize * (cube ? 6 : 1);
+		info.IsCubeMap = cube;
+
+		vector<uint8_t> dds;
+		DDSFile::WriteHeader(info, dds);
+		const size_t header = dds.size();
+		const size_t texelBytes = DDSFile::BitsPerPixel(format) / 8;
+		const bool isFloat = format == DXGI_FORMAT_R32_FLOAT || format == DXGI_FORMAT_R32G32B32A32_FLOAT;
+		const size_t values = (size_t)width * height * info.ArraySize * texelBytes / (isFloat ? 4 : 1);
+		dds.resize(header + values * (isFloat ? 4 : 1));
+
+		uint32_t seed = 12345;
+		for (size_t i = 0; i < values; ++i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			const size_t texel = i * (isFloat ? 4 : 1) / texelBytes;
+			const double x = (double)(texel % width) / width, y = (double)(texel / width % height) / height;
+			const double smooth = 0.5 + 0.5 * sin(6.0 * x + 4.0 * y + (double)(i % 4));
+			const double v = (texel / 7 + texel / width / 5) % 3 == 0 ? (seed >> 24) / 255.0 : smooth;
+			if (isFloat)
+			{
+				const float f = (float)(v * 4.0 - 1.0);
+				memcpy(dds.data() + header + i * 4, &f, 4);
+			}
+			else
+			{
+				dds[header + i] = (uint8_t)(v * 255.0 + 0.5);
+			}
+		}
+		return dds;
+	}
+
+	// The largest difference between two chains with the same layout, in 8-bit steps or,
+	// for float formats, in value.
+	double MaxDifference(const vector<uint8_t>& a, const vector<uint8_t>& b, bool isFloat)
+	{
+		DDSFile::Info info;
+		if (a.size() != b.size() || !DDSFile::Parse(a.data(), a.size(), a.size(), info))
+			return 1e30;
+
+		double worst = 0.0;
+		for (size_t i = (size_t)info.DataOffset; i < a.size(); i += isFloat ? 4 : 1)
+		{
+			if (isFloat)
+			{
+				float fa, fb;
+				memcpy(&fa, &a[i], 4);
+				memcpy(&fb, &b[i], 4);
+				worst = max(worst, (double)fabs(fa - fb));
+			}
+			else
+			{
+				worst = max(worst, (double)abs(a[i] - b[i]));
+			}
+		}
+		return worst;
+	}
+
+	// MipChain::Generate against its reference implementation, on synthetic textures and on
+	// those under 'textures' that have no mips.
+	void BenchMips(const string& textures)
+	{
+		struct Case
+		{
+			string Name;
+			vector<uint8_t> DDS;
+			bool Float;
+		};
+		vector<Case> cases;
+		cases.push_back({ "RGBA8 sRGB 512", MakeTexture(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 512, 512, 1, false), false });
+		cases.push_back({ "BGRA8 cube 128", MakeTexture(DXGI_FORMAT_B8G8R8A8_UNORM, 128, 128, 1, true), false });
+		cases.push_back({ "R8 1000x600", MakeTexture(DXGI_FORMAT_R8_UNORM, 1000, 600, 1, false), false });
+		cases.push_back({ "RG8 array 75x33 x8", MakeTexture(DXGI_FORMAT_R8G8_UNORM, 75, 33, 8, false), false });
+		cases.push_back({ "RGBA32F 256", MakeTexture(DXGI_FORMAT_R32G32B32A32_FLOAT, 256, 256, 1, false), true });
+		cases.push_back({ "R32F 1D 4096", MakeTexture(DXGI_FORMAT_R32_FLOAT, 4096, 1, 1, false), true });
+
+		error_code ec;
+		for (fs::recursive_directory_iterator it(textures, ec), end; it != end; it.increment(ec))
+		{
+			if (!it->is_regular_file() || it->path().extension() != ".dds")
+				continue;
+			MappedFile file(it->path().wstring());
+			DDSFile::Info info;
+			if (file.IsOpen() && DDSFile::Parse(file.Data(), file.Size(), file.Size(), info) && MipChain::NeedsMips(info))
+			{
+				const bool isFloat = info.Format == DXGI_FORMAT_R32_FLOAT || info.Format == DXGI_FORMAT_R32G32_FLOAT ||
+					info.Format == DXGI_FORMAT_R32G32B32_FLOAT || info.Format == DXGI_FORMAT_R32G32B32A32_FLOAT;
+				cases.push_back({ it->path().filename().string(), vector<uint8_t>(file.Data(), file.Data() + file.Size()),
+					isFloat });
+			}
+		}
+
+		const pair<MipChain::Filter, const char*> filters[] =
+		{
+			{ MipChain::Box, "box" }, { MipChain::Kaiser, "kaiser" }, { MipChain::Lanczos, "lanczos" }
+		};
+
+		printf("mip chains: generated against the reference, max difference in 8-bit steps (or value)\n");
+		for (const Case& test : cases)
+		{
+			for (const auto& filter : filters)
+			{
+				for (bool wrap : { false, true })
+				{
+					MipChain::Options options;
+					options.Kernel = filter.first;
+					options.Wrap = wrap;
+
+					vector<uint8_t> fast, serial, reference;
+					MipChain::Stats stats;
+					string error;
+					if (!MipChain::Generate(test.DDS.data(), test.DDS.size(), fast, options, &stats, &error))
+					{
+						printf("  %-22s %s\n", test.Name.c_str(), error.c_str());
+						break;
+					}
+
+					const double parallelMs = Time(3, [&]()
+					{
+						MipChain::Generate(test.DDS.data(), test.DDS.size(), fast, options);
+					});
+					options.Parallel = false;
+					const double serialMs = Time(3, [&]()
+					{
+						MipChain::Generate(test.DDS.data(), test.DDS.size(), serial, options);
+					});
+					const double referenceMs = Time(1, [&]()
+					{
+						MipChain::GenerateReference(test.DDS.data(), test.DDS.size(), reference, options);
+					});
+
+					const double difference = max(MaxDifference(fast, reference, test.Float), MaxDifference(fast, serial, test.Float));
+					const bool matches = test.Float ? difference <= 1e-4 : difference <= 1.0;
+					printf("  %-22s %-7s %-5s %2u mips x %-3u %8.2f ms  %8.2f ms serial  %9.1f ms reference  %-8g %s\n",
+						test.Name.c_str(), filter.second, wrap ? "wrap" : "clamp", stats.Levels, stats.Slices, parallelMs,
+						serialMs, referenceMs, difference, matches ? "matches" : "DIFFERS");
+				}
+			}
+		}
+	}
+
+	// An 8-bit RGBA image for the block encoders.
+	struct Image
+	{
+		string Name;
+		uint32_t Width;
+		uint32_t Height;
+		vector<uint8_t> RGBA;
+	};
+
+	// The top level of every slice of a DDS in R8G8B8A8 stacked into one image, or an empty
+	// image when the slices differ in width or the height is not a multiple of 4.
+	Image StackSlices(const string& name, const vector<uint8_t>& dds)
+	{
+		Image image = { name, 0, 0, {} };
+		DDSFile::Info info;
+		if (!DDSFile::Parse(dds.data(), dds.size(), dds.size(), info) || info.Format != DXGI_FORMAT_R8G8B8A8_UNORM ||
+			info.Height % 4 != 0)
+			return image;
+
+		image.Width = info.Width;
+		for (uint32_t slice = 0; slice < info.ArraySize; ++slice)
+		{
+			const DDSFile::Subresource& top = info.Subresources[slice * info.MipCount];
+			const uint8_t* texels = dds.data() + top.Offset;
+			image.RGBA.insert(image.RGBA.end(), texels, texels + (size_t)top.RowBytes * top.Height);
+			image.Height += top.Height;
+		}
+		return image;
+	}
+
+	// Peak signal to noise over 'channels' of the texels the format is expected to keep:
+	// BC1 drops the color of texels below half alpha.
+	double PSNR(const Image& source, const vector<uint8_t>& decoded, uint32_t channels, bool skipTransparent)
+	{
+		double sum = 0.0;
+		size_t count = 0;
+		for (size_t i = 0; i < source.RGBA.size(); i += 4)
+		{
+			if (skipTransparent && source.RGBA[i + 3] < 128)
+				continue;
+			for (uint32_t c = 0; c < channels; ++c)
+			{
+				const double d = (double)source.RGBA[i + c] - decoded[i + c];
+				sum += d * d;
+			}
+			count += channels;
+		}
+		if (sum == 0.0)
+			return 99.0;
+		return 10.0 * log10(255.0 * 255.0 * count / sum);
+	}
+
+	// BlockCompression on a synthetic image and on the textures in 'textures' (not the
+	// flipbook frames below it), the block-compressed ones decoded first: speed of both qualities, quality of what decodes,
+	// and that the parallel and serial encoders agree.
+	void BenchBlocks(const string& textures)
+	{
+		vector<Image> images;
+		vector<uint8_t> synthetic = MakeTexture(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 1, false);
+		images.push_back(StackSlices("synthetic 256", synthetic));
+
+		error_code ec;
+		for (fs::directory_iterator it(textures, ec), end; it != end; it.increment(ec))
+		{
+			if (!it->is_regular_file() || it->path().extension() != ".dds")
+				continue;
+			vector<uint8_t> bytes;
+			DDSFile::Info info;
+			if (!ReadWhole(it->path(), bytes) || !DDSFile::Parse(bytes.data(), bytes.size(), bytes.size(), info))
+				continue;
+			if (BlockCompression::IsSupported(info.Format))
+			{
+				vector<uint8_t> decoded;
+				if (!BlockCompression::Decompress(bytes.data(), bytes.size(), decoded))
+					continue;
+				bytes.swap(decoded);
+			}
+			Image image = StackSlices(it->path().filename().string(), bytes);
+			if (!image.RGBA.empty())
+				images.push_back(image);
+		}
+
+		const pair<DXGI_FORMAT, const char*> formats[] =
+		{
+			{ DXGI_FORMAT_BC1_UNORM, "BC1" }, { DXGI_FORMAT_BC3_UNORM, "BC3" }, { DXGI_FORMAT_BC4_UNORM, "BC4" },
+			{ DXGI_FORMAT_BC5_UNORM, "BC5" }, { DXGI_FORMAT_BC7_UNORM, "BC7" }
+		};
+
+		printf("block compression: MB/s of RGBA encoded, PSNR of the channels each format keeps\n");
+		for (const Image& image : images)
+		{
+			for (const auto& format : formats)
+			{
+				const uint32_t channels = format.first == DXGI_FORMAT_BC4_UNORM ? 1 :
+					format.first == DXGI_FORMAT_BC5_UNORM ? 2 : format.first == DXGI_FORMAT_BC1_UNORM ? 3 : 4;
+				const size_t blockBytes = (size_t)(image.Width / 4) * (image.Height / 4) *
+					BlockCompression::BlockBytes(format.first);
+				const double megabytes = image.RGBA.size() / (1024.0 * 1024.0);
+
+				for (BlockCompression::Quality quality : { BlockCompression::Fast, BlockCompression::High })
+				{
+					BlockCompression::Options options;
+					options.Mode = quality;
+
+					vector<uint8_t> blocks(blockBytes), serial(blockBytes), decoded(image.RGBA.size());
+					const bool slow = quality == BlockCompression::High && format.first == DXGI_FORMAT_BC7_UNORM;
+					const double parallelMs = Time(slow ? 1 : 3, [&]()
+					{
+						BlockCompression::Encode(image.RGBA.data(), image.Width, image.Height, image.Width * 4,
+							format.first, blocks.data(), options);
+					});
+					options.Parallel = false;
+					BlockCompression::Encode(image.RGBA.data(), image.Width, image.Height, image.Width * 4, format.first,
+						serial.data(), options);
+					const double decodeMs = Time(3, [&]()
+					{
+						BlockCompression::Decode(blocks.data(), image.Width, image.Height, format.first, decoded.data(),
+							image.Width * 4);
+					});
+
+					printf("  %-18s %s %-4s %8.2f MB/s  decode %8.2f MB/s  %6.2f dB  %s\n", image.Name.c_str(),
+						format.second, quality == BlockCompression::Fast ? "fast" : "high", megabytes / (parallelMs / 1000.0),
+						megabytes / (decodeMs / 1000.0), PSNR(image, decoded, channels, format.first == DXGI_FORMAT_BC1_UNORM),
+						blocks == serial ? "matches" : "DIFFERS");
+				}
+			}
+		}
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	string textures = argc > 1 ? argv[1] : "../../../Textures";
+
+	BenchShapes();
+	const bool fuzzed = FuzzHeaders();
+	BenchFiles(textures);
+	BenchMips(textures);
+	BenchBlocks(textures);
+
+	return fuzzed ? 0 : 1;
+}